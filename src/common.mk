@@ -62,6 +62,10 @@ CFLAGS += -D_GNU_SOURCE
 ifdef HUGETUPLE
   CFLAGS += -DHUGETUPLE
 endif
+# place keys in new hash tables with wshash64 instead of evahash64
+ifdef WSHASH_TABLES
+  CFLAGS += -DWS_WSHASH_TABLES
+endif
 
 ifdef USEM64
   CFLAGS += -m64
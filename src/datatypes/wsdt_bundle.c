@@ -46,13 +46,8 @@ static void wsdt_delete_bundle(wsdata_t * wsdata) {
                wsdata_delete(my_bundle->wsd[i]);
           }
 
-          if (wsdata->dependency) {
-               wsdata_t * parent;
-               //remove references to parent
-               while ((parent = wsstack_remove(wsdata->dependency)) != NULL) {
-                    parent->dtype->delete_func(parent);
-               }
-          }
+          //remove references to parent
+          wsdata_release_dependencies(wsdata);
           //add to child free_q
           wsdata_moveto_freeq(wsdata);
           //fprintf(stderr,"waterslidedata: data dereferenced\n");
@@ -60,11 +55,20 @@ static void wsdt_delete_bundle(wsdata_t * wsdata) {
 }
 
 
+static void wsdt_publish_bundle(wsdata_t * wsdata) {
+     wsdt_bundle_t * my_bundle = (wsdt_bundle_t *)wsdata->data;
+     int i;
+     for (i=0; i < my_bundle->len; i++) {
+          wsdata_publish(my_bundle->wsd[i]);
+     }
+}
+
 int datatypeloader_init(void * type_list) {
      wsdatatype_t *fsdt = wsdatatype_register_generic(type_list,
                                                       WSDT_BUNDLE_STR,
                                                       sizeof(wsdt_bundle_t));
      fsdt->init_func = wsdt_init_bundle;
      fsdt->delete_func = wsdt_delete_bundle;    
+     fsdt->publish_func = wsdt_publish_bundle;
      return 1;
 }
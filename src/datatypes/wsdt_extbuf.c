@@ -0,0 +1,115 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdint.h>
+#include <stddef.h>
+#include "wsdt_extbuf.h"
+#include "datatypeloader.h"
+#include "waterslidedata.h"
+#include "sysutil.h"
+
+ws_hashloc_t * wsdt_extbuf_hash(wsdata_t*);
+
+static int wsdt_print_extbuf_wsdata(FILE * stream, wsdata_t * wsdata,
+                                    uint32_t printtype) {
+     wsdt_extbuf_t * eb = (wsdt_extbuf_t*)wsdata->data;
+     if (!eb->buf) {
+          return 0;
+     }
+     int rtn = 0;
+     switch (printtype) {
+     case WS_PRINTTYPE_HTML:
+          fprintf(stream,"\n");
+          sysutil_print_content_web(stream, (uint8_t*)eb->buf, eb->len); 
+          return 1;
+          break;
+     case WS_PRINTTYPE_TEXT:
+          fprintf(stream,"\n");
+          sysutil_print_content(stream, (uint8_t*)eb->buf, eb->len); 
+          return 1;
+          break;
+     case WS_PRINTTYPE_BINARY:
+          rtn = fwrite(&eb->len, sizeof(int), 1, stream);
+          rtn += fwrite(eb->buf, eb->len, 1, stream);
+          return rtn;
+          break;
+     default:
+          return 0;
+     }
+}
+
+// hand the buffer back to its owner as soon as nothing references it,
+// rather than when the wsdata is next reused from the free queue
+static void wsdt_extbuf_delete(wsdata_t * wsdata) {
+     int tmp = wsdata_remove_reference(wsdata);
+
+     if (tmp <= 0) {
+          wsdt_extbuf_t * eb = (wsdt_extbuf_t*)wsdata->data;
+          if (eb->release) {
+               eb->release(eb->owner);
+          }
+          eb->len = 0;
+          eb->buf = NULL;
+          eb->release = NULL;
+          eb->owner = NULL;
+          wsdata_release_dependencies(wsdata);
+          wsdata_moveto_freeq(wsdata);
+     }
+}
+
+static int wsdt_to_string_extbuf(wsdata_t *wsdata, char **buf, int*len) {
+     wsdt_extbuf_t *eb = (wsdt_extbuf_t*)wsdata->data;
+
+     *buf = eb->buf; 
+     *len = eb->len;
+     return 1;           
+}
+
+int datatypeloader_init(void * tl) {
+     wsdatatype_t * bdt = wsdatatype_register(tl,
+                                              WSDT_EXTBUF_STR, sizeof(wsdt_extbuf_t),
+                                              wsdt_extbuf_hash,
+                                              wsdatatype_default_init,
+                                              wsdt_extbuf_delete,
+                                              wsdt_print_extbuf_wsdata,
+                                              wsdatatype_default_snprint,
+                                              wsdatatype_default_copy,
+                                              wsdatatype_default_serialize);
+
+     bdt->to_string = wsdt_to_string_extbuf;
+
+     wsdatatype_register_subelement(bdt, tl,
+                                    "LENGTH", "INT_TYPE",
+                                    offsetof(wsdt_extbuf_t, len));
+
+     return 1;
+}
+
+ws_hashloc_t* wsdt_extbuf_hash(wsdata_t * wsdata) {
+     if (!wsdata->has_hashloc) {
+          wsdt_extbuf_t *eb = (wsdt_extbuf_t*)wsdata->data;
+          wsdata->hashloc.offset = eb->buf; 
+          wsdata->hashloc.len = eb->len;
+          wsdata->has_hashloc = 1;
+     }
+     return &wsdata->hashloc;
+}
@@ -67,19 +67,23 @@ void wsdt_tuple_custom_delete(wsdata_t * wsdata) {
                }
           }
 
-          if (wsdata->dependency) {
-               wsdata_t * parent;
-               //remove references to parent
-               while ((parent = wsstack_remove(wsdata->dependency)) != NULL) {
-                    parent->dtype->delete_func(parent);
-               }
-          }
+          //remove references to parent
+          wsdata_release_dependencies(wsdata);
 
           wsdt_tuple_recover(wsdata);
           wsdata_moveto_freeq(wsdata);
      }
 }
 
+//members are reachable from any thread the tuple is handed to
+static void wsdt_tuple_publish(wsdata_t * wsdata) {
+     wsdt_tuple_t * tuple = (wsdt_tuple_t*)wsdata->data;
+     int i;
+     for (i = 0; i < tuple->len; i++) {
+          wsdata_publish(tuple->member[i]);
+     }
+}
+
 static void* tuple_allocator_small(void *foo) {
      wsdt_tuple_freeq_t *fq = (wsdt_tuple_freeq_t*) foo;
      wsdt_tuple_t * tmp = wsdt_tuple_internal_alloc(fq, WSDT_TUPLE_SMALL_LEN);
@@ -112,6 +116,7 @@ int datatypeloader_init(void * type_list) {
      fsdt->print_func = wsdt_print_tuple_wsdata;
      fsdt->init_func = wsdt_init_tuple;
      fsdt->delete_func = wsdt_tuple_custom_delete;
+     fsdt->publish_func = wsdt_tuple_publish;
 
      wsdt_tuple_freeq_t * fq =
           (wsdt_tuple_freeq_t*)calloc(1, sizeof(wsdt_tuple_freeq_t));
@@ -43,7 +43,8 @@ SOFTWARE.
 #include "wstypes.h"
 #include "wsqueue.h"
 #include "assert.h"
-#include "evahash64.h"
+#include "wshash64.h"
+#include "wsmem.h"
 
 #define WSDT_TUPLE_STR "TUPLE_TYPE"
 
@@ -139,6 +140,7 @@ static inline wsdt_tuple_t * wsdt_tuple_internal_alloc(wsdt_tuple_freeq_t *tfq,
      if (!vtup) {
           return NULL;
      }
+     wsmem_add(WSMEM_TUPLE, tuplesize);
      newtup = (wsdt_tuple_t * )vtup;
 
      newtup->max = newlen;
@@ -169,6 +171,8 @@ again:
                if (newtup->index_len != tfq->index_len) {
                     dprint("index size has been modified");
                     // don't use this tuple, index size has been modified
+                    wsmem_add(WSMEM_TUPLE, -(int64_t)TUPLE_ALLOC_SIZE(newtup->max,
+                                                                     newtup->index_len));
                     free(newtup);
                     goto again;
                }
@@ -216,6 +220,8 @@ static inline int wsdt_tuple_recover(wsdata_t * tdata) {
           }
           //a for huge tuple
           else {
+               wsmem_add(WSMEM_TUPLE, -(int64_t)TUPLE_ALLOC_SIZE(tuple->max,
+                                                                tuple->index_len));
                free(tuple);
                wsdt_tuple_freeq_t *tfq = (wsdt_tuple_freeq_t*)tdata->dtype->instance;
 #ifdef USE_ATOMICS
@@ -370,6 +376,9 @@ static inline int add_tuple_member(wsdata_t * tdata, wsdata_t *member) {
 #endif
     
      dprint("add_tuple_member %d", tuple->len); 
+     if (tdata->owner == WSDATA_OWNER_SHARED) {
+          wsdata_publish(member);
+     }
      wsdata_add_reference(member);
      dprint("add_tuple_member: attach labels"); 
      tuple_attach_member_labels(tdata, member);
@@ -853,7 +862,7 @@ static inline wsdata_t * tuple_dupe_binary(wsdata_t * tdata,
 
 //return hashed value of string
 static inline uint64_t tuple_hash_string(uint8_t * str, int len) {
-     return evahash64(str, len, 0x5EED5EED);
+     return ws_table_hash64(str, len, 0x5EED5EED);
 }
 
 static inline int tuple_hash_member_into(wsdata_t * tdata, wslabel_t * label, 
@@ -879,8 +888,8 @@ static inline int tuple_hash_member_into(wsdata_t * tdata, wslabel_t * label,
                          hashloc =
                               tuple->member[i]->dtype->hash_func(tuple->member[i]);
                          if (hashloc->offset) {
-                              *hash += evahash64((uint8_t*)hashloc->offset,
-                                                 hashloc->len, 0x5EED5EED);
+                              *hash += ws_table_hash64(hashloc->offset,
+                                                       hashloc->len, 0x5EED5EED);
                               found = 1;
                               break;
                          }
@@ -1036,8 +1045,8 @@ static inline uint32_t tuple_find_label_hash_ordered(wsdata_t * tdata,
                          hashloc =
                               members[j]->dtype->hash_func(members[j]);
                          if (hashloc->offset) {
-                              *hash += evahash64((uint8_t*)hashloc->offset,
-                                                 hashloc->len, key + i);
+                              *hash += ws_table_hash64(hashloc->offset,
+                                                       hashloc->len, key + i);
                               found++;
                          }
                     }
@@ -1065,8 +1074,8 @@ static inline uint32_t tuple_find_label_hash(wsdata_t * tdata,
                          hashloc =
                               members[j]->dtype->hash_func(members[j]);
                          if (hashloc && hashloc->offset && hashloc->len) {
-                              *hash += evahash64((uint8_t*)hashloc->offset,
-                                                 hashloc->len, key);
+                              *hash += ws_table_hash64(hashloc->offset,
+                                                       hashloc->len, key);
                               found++;
                          }
                     }
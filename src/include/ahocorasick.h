@@ -200,6 +200,25 @@ int ac_searchstr(ahoc_t *           /* init & loaded ahoc tree */,
 
 void ac_free(ahoc_t *ac);
 
+/**
+  \brief writes a finalized tree to a file
+
+  \return 1 on success
+  \return 0 on failure
+ */
+int ac_save(ahoc_t * /* init, loaded & finalized ahoc tree */,
+            FILE *   /* open for writing */);
+
+/**
+  \brief reads a tree written by ac_save, ready for searching
+
+  the tree must come from ac_init with no keywords loaded
+  \return 1 on success
+  \return 0 on failure, leaving the tree empty
+ */
+int ac_load(ahoc_t * /* initialized, empty ahoc tree */,
+            FILE *   /* open for reading */);
+
 /**
   \brief searches buffer for keyword matches
 
@@ -31,6 +31,7 @@ CPP_OPEN
 #endif // __cplusplus
 
 #include "evahash64.h"
+#include "wshash64.h"
 #include "waterslide.h"
 #include "waterslidedata.h"
 
@@ -45,6 +46,18 @@ static inline uint64_t evahash64_data(wsdata_t * wsd, uint32_t seed) {
      return res;
 }
 
+//same, for keys that only live in in-memory tables
+static inline uint64_t ws_table_hash64_data(wsdata_t * wsd, uint32_t seed) {
+     uint64_t res = 0;
+     if ( wsd ) {
+          ws_hashloc_t *hashloc = wsd->dtype->hash_func(wsd);
+          if ( hashloc && hashloc->offset ) {
+               res = ws_table_hash64(hashloc->offset, hashloc->len, seed);
+          }
+     }
+     return res;
+}
+
 #ifdef __cplusplus
 CPP_CLOSE
 #endif // __cplusplus
@@ -28,6 +28,7 @@ SOFTWARE.
 #include <stdlib.h>
 #include <string.h>
 #include "error_print.h"
+#include "wsmem.h"
 #include "cppwrap.h"
 
 #ifdef __cplusplus
@@ -133,6 +134,7 @@ static inline fq_node_t* fqueue_add(failoverqueue_t *qp, void *data1, void *data
                error_print("failed fqueue_add calloc of new_node");
                return NULL;
           }
+          wsmem_add(WSMEM_QUEUE, sizeof(fq_node_t));
      }
      new_node->data1 = data1;
      new_node->data2 = data2;
@@ -180,6 +182,7 @@ static inline fq_node_t* fqueue_add_front(failoverqueue_t *qp, void *data1, void
                error_print("failed fqueue_add_front calloc of new_node");
                return NULL;
           }
+          wsmem_add(WSMEM_QUEUE, sizeof(fq_node_t));
      }
      new_node->data1 = data1;
      new_node->data2 = data2;
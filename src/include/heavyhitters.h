@@ -84,6 +84,7 @@ static int hh_node_compair(void * vfirst, void * vsecond) {
 
 static void hh_node_replace(void * vnode, void * vreplace, void * aux);
 typedef void (* heavyhitters_release)(void * /*data*/);
+typedef void (* heavyhitters_mergedata)(void * /*dst data*/, void * /*src data*/);
 
 typedef struct _heavyhitters_t
 {
@@ -258,15 +259,10 @@ static void hh_node_replace(void * vnode, void * vreplace, void * vhh) {
 }
 
 
-//returns data at increment position
-static inline hh_node_t * heavyhitters_increment(heavyhitters_t * hh,
-                                                 const void * key_data,
-                                                 size_t key_length,
-                                                 uint64_t value) {
-     dprint("hh_increment");
-     //hash key data
-     uint64_t key = evahash64((uint8_t *)key_data, key_length, hh->seed);
-
+//returns data at increment position, key is an already hashed key
+static inline hh_node_t * heavyhitters_increment_key(heavyhitters_t * hh,
+                                                     uint64_t key,
+                                                     uint64_t value) {
      //look up key in hashtable
      uint64_t hindex = key % hh->max;
      dprint("key %"PRIx64" hindex %"PRIu64, key, hindex);
@@ -292,6 +288,50 @@ static inline hh_node_t * heavyhitters_increment(heavyhitters_t * hh,
      return (hh_node_t*)wsheap_insert_replace(hh->heap, &node);
 }
 
+//returns data at increment position
+static inline hh_node_t * heavyhitters_increment(heavyhitters_t * hh,
+                                                 const void * key_data,
+                                                 size_t key_length,
+                                                 uint64_t value) {
+     dprint("hh_increment");
+     //hash key data
+     uint64_t key = evahash64((uint8_t *)key_data, key_length, hh->seed);
+
+     return heavyhitters_increment_key(hh, key, value);
+}
+
+//sketches must share a seed to be merged
+static inline void heavyhitters_set_seed(heavyhitters_t * hh, uint32_t seed) {
+     hh->seed = seed;
+}
+
+//fold the counters of src into dst as weighted increments.
+//src is left untouched, mergedata is called for each surviving node so the
+//caller can carry over (and reference) its per-key data
+static inline int heavyhitters_merge(heavyhitters_t * dst, heavyhitters_t * src,
+                                     heavyhitters_mergedata mergedata) {
+     if (!dst || !src) {
+          return 0;
+     }
+     if (dst->seed != src->seed) {
+          error_print("cannot merge heavyhitters with different seeds");
+          return 0;
+     }
+     uint64_t i;
+     for (i = 0; i < src->heap->count; i++) {
+          hh_node_t * node = (hh_node_t*)src->heap->heap[i];
+          if (!node->value) {
+               continue;
+          }
+          hh_node_t * dnode = heavyhitters_increment_key(dst, node->key,
+                                                         node->value);
+          if (dnode && mergedata) {
+               mergedata(dnode->data, node->data);
+          }
+     }
+     return 1;
+}
+
 #ifdef __cplusplus
 CPP_CLOSE
 #endif // __cplusplus
@@ -0,0 +1,135 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _HYPERLOGLOG_H
+#define _HYPERLOGLOG_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "evahash64.h"
+#include "cppwrap.h"
+
+#ifdef __cplusplus
+CPP_OPEN
+#endif // __cplusplus
+
+/* Fixed size HyperLogLog distinct counter (Flajolet et al. 2007).
+   The sketch is a flat register array so it can live directly inside a
+   stringhash record; a zeroed hll_t is an empty sketch.  Two sketches built
+   with the same precision and seed merge by taking the register-wise max,
+   so partial sketches from other threads or processes can be combined. */
+
+#define HLL_PRECISION (10)
+#define HLL_REGISTERS (1 << HLL_PRECISION)
+#define HLL_SEED      (0x5EED4C4C)
+#define HLL_MAGIC     (0x484C4C31) // "HLL1"
+
+typedef struct _hll_t {
+     uint8_t reg[HLL_REGISTERS];
+} hll_t;
+
+//serialized form: magic followed by the registers
+#define HLL_SERIAL_LEN (sizeof(uint32_t) + sizeof(hll_t))
+
+//finalizer to spread evahash64 bits over the whole word
+static inline uint64_t hll_mix64(uint64_t h) {
+     h ^= h >> 33;
+     h *= 0xff51afd7ed558ccdULL;
+     h ^= h >> 33;
+     h *= 0xc4ceb9fe1a85ec53ULL;
+     h ^= h >> 33;
+     return h;
+}
+
+static inline void hll_add_hash(hll_t * hll, uint64_t hash) {
+     uint32_t index = (uint32_t)(hash >> (64 - HLL_PRECISION));
+     //guard bit bounds the rank when the remaining bits are all zero
+     uint64_t rest = (hash << HLL_PRECISION) |
+          ((uint64_t)1 << (HLL_PRECISION - 1));
+     uint8_t rank = (uint8_t)__builtin_clzll(rest) + 1;
+     if (rank > hll->reg[index]) {
+          hll->reg[index] = rank;
+     }
+}
+
+static inline void hll_add(hll_t * hll, const void * buf, uint32_t len) {
+     hll_add_hash(hll, hll_mix64(evahash64((uint8_t *)buf, len, HLL_SEED)));
+}
+
+static inline void hll_merge(hll_t * dst, const hll_t * src) {
+     int i;
+     for (i = 0; i < HLL_REGISTERS; i++) {
+          if (src->reg[i] > dst->reg[i]) {
+               dst->reg[i] = src->reg[i];
+          }
+     }
+}
+
+static inline double hll_estimate(const hll_t * hll) {
+     double m = (double)HLL_REGISTERS;
+     double alpha = 0.7213 / (1.0 + 1.079 / m);
+     double sum = 0;
+     int zeros = 0;
+     int i;
+     for (i = 0; i < HLL_REGISTERS; i++) {
+          sum += ldexp(1.0, -(int)hll->reg[i]);
+          if (!hll->reg[i]) {
+               zeros++;
+          }
+     }
+     double est = alpha * m * m / sum;
+
+     //small range correction via linear counting
+     if ((est <= 2.5 * m) && zeros) {
+          est = m * log(m / (double)zeros);
+     }
+     return est;
+}
+
+//buf must hold HLL_SERIAL_LEN bytes
+static inline void hll_serialize(const hll_t * hll, char * buf) {
+     uint32_t magic = HLL_MAGIC;
+     memcpy(buf, &magic, sizeof(uint32_t));
+     memcpy(buf + sizeof(uint32_t), hll, sizeof(hll_t));
+}
+
+//returns 1 if buf held a sketch that was merged into hll
+static inline int hll_merge_serialized(hll_t * hll, const char * buf, int len) {
+     uint32_t magic;
+     if (len != (int)HLL_SERIAL_LEN) {
+          return 0;
+     }
+     memcpy(&magic, buf, sizeof(uint32_t));
+     if (magic != HLL_MAGIC) {
+          return 0;
+     }
+     hll_merge(hll, (const hll_t *)(buf + sizeof(uint32_t)));
+     return 1;
+}
+
+#ifdef __cplusplus
+CPP_CLOSE
+#endif // __cplusplus
+
+#endif // _HYPERLOGLOG_H
@@ -54,6 +54,7 @@ struct _ws_proc_module_t {
      proc_init_finish_t proc_init_finish_f;
      proc_input_set_t proc_input_set_f; 
      proc_destroy_t proc_destroy_f;
+     proc_batch_t * batch_table; // optional proc_batch[] export
      int use_count; 
      int did_init;
      int strdup_set;
@@ -92,6 +93,11 @@ struct _ws_proc_instance_t {
      struct _ws_proc_instance_t * next;
      char * srclabel_name; // will be NULL if there's no src_label (on the ws_subscriber_t pointing to me)
      int input_valid;
+     uint64_t plan_calls; // calls seen during placement calibration
+     uint64_t plan_samples; // calls timed during placement calibration
+     uint64_t plan_ns; // time spent in timed calls
+     ws_label_demand_t label_reads; // labels looked up during init
+     uint32_t demand_walk; // last demand walk to visit this kid
 };
 
 int ws_init_proc_graph(mimo_t *);
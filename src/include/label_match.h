@@ -40,18 +40,37 @@ CPP_OPEN
 
 #define LABEL_MATCH_MAX_LABELS 2000
 
+// a match file or single string waiting for label_match_build
+typedef struct _label_match_src_t {
+     char * file;  // NULL for a single string
+     char * str;
+     int len;
+     char * label; // label of a single string, NULL for none
+     struct _label_match_src_t * next;
+} label_match_src_t;
+
 // instance data structure
 typedef struct _label_match_t {
      ahoc_t * ac_struct;
      wslabel_t * label[LABEL_MATCH_MAX_LABELS];
      int label_cnt;
      void * type_table;
+     label_match_src_t * src_head;
+     label_match_src_t * src_tail;
 } label_match_t;
 
      //initialize variables
 label_match_t* label_match_create(void * type_table);
 int label_match_loadfile(label_match_t *, char *);
 ahoc_t * label_match_finalize(label_match_t *);
+
+// queue sources in proc_init and build from them in proc_init_finish, which
+// runs on the kid's own thread concurrently with other threads' kids.  When
+// WATERSLIDE_CACHE_DIR is set, built tables are saved there keyed by a hash
+// of the sources and reloaded on later runs instead of being rebuilt.
+int label_match_queue_file(label_match_t *, const char *);
+int label_match_queue_string(label_match_t *, const char *, int, const char *);
+ahoc_t * label_match_build(label_match_t *);
 wslabel_t * label_match_get_label(label_match_t *, int);
 int label_match_make_label(label_match_t * lm, const char * str);
 void label_match_destroy(label_match_t *);
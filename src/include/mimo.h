@@ -47,6 +47,7 @@ typedef struct _mimo_datalists_t {
      listhash_t * label_table;
      listhash_t * kidshare_table;
      uint32_t index_len;
+     uint32_t label_serials; // labels created so far
      uint32_t monitors;
 } mimo_datalists_t;
 
@@ -87,8 +88,7 @@ struct _mimo_t {
      listhash_t * deprecated_list;
 
      // local thread queues
-     nhqueue_t ** jobq;
-     nhqueue_t ** jobq_freeq;
+     ws_jobring_t ** jobq;
      nhqueue_t ** sink_freeq; // data to hand off
 
 #ifdef WS_PTHREADS
@@ -122,6 +122,9 @@ struct _mimo_t {
      int no_flush_on_exit;
      uint32_t thread_id; // should simply be zero for non-pthreads run
      int thread_global_offset; // thread ids are offset by this value
+     FILE * plan_fp; // thread placement plan output
+     uint32_t plan_threads; // number of threads to plan for
+     char * plan_profile; // saved profile to plan from instead of running
 };
 
 struct _mimo_source_t {
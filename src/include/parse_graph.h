@@ -45,6 +45,7 @@ typedef struct _parse_node_proc_t {
      uint32_t  argc;
      char ** argv;
      uint64_t num_calls;
+     uint64_t num_out; // events emitted, for thread placement
      int     rank;
      double  time;
      double  pct;
@@ -40,6 +40,11 @@ int procbuffer_init(void *, void *);
 
 int procbuffer_decode(void *, wsdata_t *, wsdata_t *, uint8_t * buf, int len);
 
+// optional: a kid that exports
+//   int procbuffer_demand_offset = offsetof(proc_instance_t, demand);
+// gets a ws_label_demand_t ** in that field pointing at the labels read
+// downstream of its output (NULL demand means everything is read)
+
 #ifdef __cplusplus
 CPP_CLOSE
 #endif // __cplusplus
@@ -75,6 +75,11 @@ static inline int ws_kidshare_put(void * v_type_table, const char * label, void
      }
      ks->cnt++;
      ks->data = data;
+#ifdef WS_PTHREADS
+     // data stored in shared state can reach other threads without being
+     // published, so every reference count has to take the shared path
+     wsdata_refs_shared = 1;
+#endif // WS_PTHREADS
      return 1;
 }
 
@@ -120,6 +120,7 @@ CPP_OPEN
 WS_MUTEX_EXTERN(startlock)
 WS_MUTEX_EXTERN(endgame_lock)
 WS_MUTEX_EXTERN(exit_lock)
+WS_MUTEX_EXTERN(label_lock)
 extern pthread_mutexattr_t mutex_attr;
 
 // Create and destroy a set of locks for parallel execution
@@ -135,6 +136,9 @@ static inline int lock_init(void) {
      WS_MUTEX_INIT(&endgame_lock, mutex_attr)
      //exit_lock used in clean_exit()
      WS_MUTEX_INIT(&exit_lock, mutex_attr)
+     //label_lock guards the label registry, which kids may extend from
+     //their own threads in proc_init_finish
+     WS_MUTEX_INIT(&label_lock, mutex_attr)
 
      //test the mutex locks
 #ifdef WS_LOCK_DBG
@@ -151,7 +155,7 @@ static inline int lock_init(void) {
 
 static inline void lock_destroy(void) {
 
-// Do not destroy exit_lock!
+// Do not destroy exit_lock or label_lock!
      WS_MUTEX_DESTROY(&startlock)
      WS_MUTEX_DESTROY(&endgame_lock)
 }
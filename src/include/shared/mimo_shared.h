@@ -277,7 +277,6 @@ static inline void * mimo_run_threaded_graph(mimo_work_order_t *arglist) {
 
           for (cursor = mimo->proc_instance_head; cursor; cursor = cursor->next) {
                cursor->doutput.local_jobq = mimo->jobq[nrank];
-               cursor->doutput.local_job_freeq = mimo->jobq_freeq[nrank];
                // we are done with shared_jobq_array, so nullify them (seg fault will
                // be an obvious sign of some jobs not going to the local jobq[nrank]
                // as intended)
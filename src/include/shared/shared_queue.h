@@ -249,6 +249,11 @@ static inline void shared_queue_exit(shared_queue_t * q) {
      free(q);
 }
 
+// a racy snapshot for the reader or any other thread: nothing waiting
+static inline int shared_queue_empty(shared_queue_t * q) {
+     return (q->head == q->tail) && (NULL == q->work_queue_head);
+}
+
 static inline void reset_shq_type(shared_queue_t * q) {
      assert(q != NULL);
 
@@ -499,6 +504,11 @@ static inline void shared_queue_exit(shared_queue_t * q) {
      free(q);
 }
 
+// a racy snapshot for the reader or any other thread: nothing waiting
+static inline int shared_queue_empty(shared_queue_t * q) {
+     return (0 == q->length);
+}
+
 // this function in the non-ATOMICS is intentionally left blank; it's also the code seen
 // by SERIAL (as well as the less efficient mutex-lock based PTHREADS)
 static inline void reset_shq_type(shared_queue_t * q) {
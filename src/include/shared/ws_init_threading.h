@@ -28,6 +28,8 @@ SOFTWARE.
 #include "shared/getrank.h"
 #include "shared/barrier_init.h"
 #include "shared/mimo_shared.h"
+#include "shared/ws_numa.h"
+#include "wsjobring.h"
 
 #ifdef USE_HWLOC
 #include "shared/ws_select_cpus.h"
@@ -43,6 +45,7 @@ CPP_OPEN
 #define FREE_THREADID_STUFF()
 #define REGISTER_SHQ_WRITER(src_tid,sub_tid) 1
 #define REPORT_SHQ_WRITERS(mimo)
+#define REPORT_NUMA_PLACEMENT(mimo)
 #define REARRANGE_AND_REMOVE_INVALID_USERID(mimo)
 #define SET_PINST_TID(mimo,proc)
 #define EDGE_TRANS(mimo,src,edge,dst,thread_trans,thread_context,twoD_placement)
@@ -51,6 +54,7 @@ CPP_OPEN
 #define FREE_THREADID_STUFF() free_threadid_stuff()
 #define REGISTER_SHQ_WRITER(src_tid,sub_tid) register_shq_writer(src_tid,sub_tid)
 #define REPORT_SHQ_WRITERS(mimo) report_shq_writers(mimo)
+#define REPORT_NUMA_PLACEMENT(mimo) ws_report_numa_placement(mimo)
 #define REARRANGE_AND_REMOVE_INVALID_USERID(mimo) rearrange_and_remove_invalid_userid(mimo)
 #define SET_PINST_TID(mimo,proc) set_pinst_tid(mimo,proc)
 #define EDGE_TRANS(mimo,src,edge,dst,thread_trans,thread_context,twoD_placement) edge_trans(mimo,src,edge,dst,thread_trans,thread_context,twoD_placement)
@@ -555,11 +559,38 @@ static inline void ws_recast_proc_ids(mimo_t * mimo) {
      for (cursor = mimo->proc_instance_head; cursor; cursor = cursor->next) {
           cursor->thread_id = get_thread_realid(cursor->thread_id);
           cursor->doutput.local_jobq = mimo->jobq[cursor->thread_id];
-          cursor->doutput.local_job_freeq = mimo->jobq_freeq[cursor->thread_id];
      }
 
 }
 
+// The job ring and shared input queue for each thread are created by the
+// main thread before any thread is pinned, so their pages come from the
+// main thread's node.  Nothing has been queued yet, so the owning thread
+// replaces them with its own copies, first-touched on its own node.
+static inline int ws_localize_thread_queues(mimo_t * mimo, int nrank) {
+     if (ws_numa_nodes() <= 1) {
+          return 1;
+     }
+
+     ws_jobring_t * jobq = jobring_init();
+     if (!jobq) {
+          error_print("failed ws_localize_thread_queues jobring_init");
+          return 0;
+     }
+     jobring_exit(mimo->jobq[nrank]);
+     mimo->jobq[nrank] = jobq;
+
+     shared_queue_t * shq = shared_queue_init();
+     if (!shq) {
+          error_print("failed ws_localize_thread_queues shared_queue_init");
+          return 0;
+     }
+     shared_queue_exit(mimo->shared_jobq[nrank]);
+     mimo->shared_jobq[nrank] = shq;
+
+     return 1;
+}
+
 // pins threads to their respective cpus.
 static inline void rebase_threads_to_cpu(mimo_t * mimo) {
 
@@ -588,19 +619,43 @@ static inline void rebase_threads_to_cpu(mimo_t * mimo) {
           exit(-111);
      }
 
-     status_print("Thread %d (User thread %d) set to run on CPU: %d",
-               nrank, cpu_thread_mapper.utid_for_thread[nrank], my_id);
+     status_print("Thread %d (User thread %d) set to run on CPU: %d (NUMA node %d)",
+               nrank, cpu_thread_mapper.utid_for_thread[nrank], my_id,
+               ws_numa_node_of_cpu(my_id));
+
+     // now that we are pinned, rebuild the queues this thread reads from
+     if (!ws_localize_thread_queues(mimo, nrank)) {
+          exit(-111);
+     }
+     BARRIER_WAIT(barrier1);
 
      if(0 == nrank) {
           ws_recast_proc_ids(mimo);
      }
      BARRIER_WAIT(barrier1);
 }
+
+// report which NUMA node each kid's thread (and so its state) lives on
+static inline void ws_report_numa_placement(mimo_t * mimo) {
+     ws_proc_instance_t * cursor;
+     const uint32_t nodes = ws_numa_nodes();
+
+     if (nodes <= 1 && !mimo->verbose) {
+          return;
+     }
+     status_print("NUMA placement across %u node(s):", nodes);
+     for (cursor = mimo->proc_instance_head; cursor; cursor = cursor->next) {
+          int cpu = cpu_thread_mapper.cpu_for_thread[cursor->thread_id];
+          status_print("  %s.%d on thread %u, CPU %d, node %d",
+                       cursor->name, cursor->version, cursor->thread_id, cpu,
+                       ws_numa_node_of_cpu(cpu));
+     }
+}
 #endif // WS_PTHREADS
 
 #ifndef WS_PTHREADS
 static inline void rebase_threads_to_cpu(mimo_t * mimo) { 
-     // need to set the local_jobq and local_job_freeq correctly
+     // need to set the local_jobq correctly
      // to avoid memory leaks!
      //
      // ws_recast_proc_ids(mimo);
@@ -608,7 +663,6 @@ static inline void rebase_threads_to_cpu(mimo_t * mimo) {
 
      for (cursor = mimo->proc_instance_head; cursor; cursor = cursor->next) {
           cursor->doutput.local_jobq = mimo->jobq[0];
-          cursor->doutput.local_job_freeq = mimo->jobq_freeq[0];
      }
 }
 #endif // WS_PTHREADS
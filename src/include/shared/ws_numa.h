@@ -0,0 +1,136 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _WS_NUMA_H
+#define _WS_NUMA_H
+
+// NUMA helpers for waterslide-parallel.  Thread-owned memory (job queues,
+// free lists, per-kid state) is placed by first touch: it is allocated by
+// its owning thread after that thread is pinned to a cpu.  Memory that
+// every thread hits, such as shared hash tables, is interleaved across all
+// nodes instead.  Everything here is a no-op on serial builds, on
+// non-linux systems and on single node machines.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <unistd.h>
+#include "tool_print.h"
+#include "cppwrap.h"
+
+#if defined(WS_PTHREADS) && defined(__linux)
+#include <dirent.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef __cplusplus
+CPP_OPEN
+#endif // __cplusplus
+
+#define WS_NUMA_MAX_NODES 64
+#define WS_NUMA_MPOL_INTERLEAVE 3 // from linux/mempolicy.h
+
+#if defined(WS_PTHREADS) && defined(__linux)
+
+// number of memory nodes; 1 on machines without NUMA
+static inline uint32_t ws_numa_nodes(void) {
+     static uint32_t nodes = 0;
+     if (!nodes) {
+          uint32_t n;
+          char path[64];
+          for (n = 0; n < WS_NUMA_MAX_NODES; n++) {
+               snprintf(path, sizeof(path), "/sys/devices/system/node/node%u", n);
+               if (access(path, F_OK) != 0) {
+                    break;
+               }
+          }
+          nodes = n ? n : 1;
+     }
+     return nodes;
+}
+
+// node that owns a cpu's local memory, -1 if unknown
+static inline int ws_numa_node_of_cpu(int cpu) {
+     char path[64];
+     struct dirent * ent;
+     int node = -1;
+
+     snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+     DIR * dir = opendir(path);
+     if (!dir) {
+          return -1;
+     }
+     while ((ent = readdir(dir)) != NULL) {
+          if (sscanf(ent->d_name, "node%d", &node) == 1) {
+               break;
+          }
+          node = -1;
+     }
+     closedir(dir);
+     return node;
+}
+
+// spread the not-yet-touched pages of a region round-robin over all nodes;
+// only whole pages inside the region are rebound so neighbouring heap
+// allocations keep their placement.  Returns 1 if the policy was applied.
+static inline int ws_numa_interleave(void * addr, size_t len) {
+     uint32_t nodes = ws_numa_nodes();
+     if (nodes <= 1 || !addr) {
+          return 0;
+     }
+     const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+     uintptr_t start = ((uintptr_t)addr + page - 1) & ~(page - 1);
+     uintptr_t end = ((uintptr_t)addr + len) & ~(page - 1);
+     if (end <= start) {
+          return 0;
+     }
+     unsigned long mask = (nodes >= 8 * sizeof(unsigned long)) ?
+          ~0UL : ((1UL << nodes) - 1);
+     if (syscall(SYS_mbind, (void *)start, end - start, WS_NUMA_MPOL_INTERLEAVE,
+                 &mask, (unsigned long)nodes + 1, 0) != 0) {
+          return 0;
+     }
+     return 1;
+}
+
+#else // !(WS_PTHREADS && __linux)
+
+static inline uint32_t ws_numa_nodes(void) {
+     return 1;
+}
+
+static inline int ws_numa_node_of_cpu(int cpu) {
+     return -1;
+}
+
+static inline int ws_numa_interleave(void * addr, size_t len) {
+     return 0;
+}
+
+#endif // WS_PTHREADS && __linux
+
+#ifdef __cplusplus
+CPP_CLOSE
+#endif // __cplusplus
+
+#endif // _WS_NUMA_H
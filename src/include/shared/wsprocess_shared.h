@@ -37,6 +37,7 @@ SOFTWARE.
 #include "wsprocess.h"
 #include "init.h"
 #include "wsperf.h"
+#include "wsplan.h"
 #include "shared/getrank.h"
 #include "setup_exit.h"
 #include "shared/barrier_init.h"
@@ -55,6 +56,7 @@ extern uint32_t spinning_on_jobs;
 
 static inline int ws_add_external_job_source(mimo_t * mimo, wsdata_t * data, ws_subscriber_t * sub) {
      ws_subscriber_t * scursor;
+     wsdata_publish(data);
      for(scursor = sub; scursor; scursor = scursor->next) { //sub is the external subscriber(s)
           if (!scursor->src_label ||
                wsdata_check_label(data, scursor->src_label)) {
@@ -78,6 +80,7 @@ static inline int ws_do_external_jobs(mimo_t * mimo, shared_queue_t * jobq) {
      int cnt = 0;
      WSPERF_NRANK();
      WSPERF_LOCAL_INIT();
+     WSPLAN_LOCAL_INIT();
 
      //fprintf(stderr,"walking jobs\n");
      void * vdata;
@@ -97,7 +100,9 @@ static inline int ws_do_external_jobs(mimo_t * mimo, shared_queue_t * jobq) {
           dprint("running data %s thru %s", data->dtype->name, sub->proc_instance->name);
 
           WSPERF_TIME0(sub->proc_instance->kid.uid-1);
+          WSPLAN_TIME0(sub->proc_instance);
           sub->proc_func(sub->local_instance, data, sub->doutput, sub->input_index);
+          WSPLAN_TIME(sub->proc_instance);
 
           WSPERF_PROC_COUNT(sub->proc_instance->kid.uid-1);
           WSPERF_TIME(sub->proc_instance->kid.uid-1);
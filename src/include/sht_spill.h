@@ -0,0 +1,82 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Overflow store for records evicted from a full stringhash table.
+//
+// When WATERSLIDE_SPILL_DIR is set, a kid can enable spilling on its
+// (unshared) stringhash5 tables.  A record pushed out of a full bucket is
+// then appended to a log file in that directory instead of being dropped,
+// and is read back into the table the next time its key is attached to.
+// Records are kept byte for byte, so anything a record points to stays in
+// memory; what moves to disk is the table slot itself.
+//
+// Records are found by a 64 bit id built from the bucket and digest the
+// table stored them under.  The id index is a file-backed map the kernel
+// can page out, and a bloom filter in front of it lets lookups of keys
+// that were never spilled skip the index entirely.  Once the index is
+// three quarters full, further evictions are dropped as before.
+
+#ifndef _SHT_SPILL_H
+#define _SHT_SPILL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cppwrap.h"
+
+#ifdef __cplusplus
+CPP_OPEN
+#endif // __cplusplus
+
+struct _sht_spill_t;
+typedef struct _sht_spill_t sht_spill_t;
+
+typedef void (*sht_spill_callback)(void * /*record*/, void * /*calldata*/);
+
+// NULL if WATERSLIDE_SPILL_DIR is unset or the files cannot be created
+sht_spill_t * sht_spill_open(size_t /* record_len */,
+                             uint64_t /* table records */);
+void sht_spill_close(sht_spill_t *);
+
+// store a record under id, returns 0 if the store is full
+int sht_spill_put(sht_spill_t *, uint64_t /* id */, void * /* record */);
+
+// copy the record stored under id and remove it, returns 0 if not stored
+int sht_spill_take(sht_spill_t *, uint64_t /* id */, void * /* record */);
+
+// copy the record stored under id and leave it stored, returns 0 if not
+// stored
+int sht_spill_peek(sht_spill_t *, uint64_t /* id */, void * /* record */);
+
+int sht_spill_contains(sht_spill_t *, uint64_t /* id */);
+int sht_spill_remove(sht_spill_t *, uint64_t /* id */);
+
+// call cb on a copy of every stored record; with keep set the record is
+// written back afterwards, otherwise the store is emptied
+void sht_spill_scour(sht_spill_t *, sht_spill_callback, void *, int /* keep */);
+void sht_spill_clear(sht_spill_t *);
+
+#ifdef __cplusplus
+CPP_CLOSE
+#endif // __cplusplus
+
+#endif // _SHT_SPILL_H
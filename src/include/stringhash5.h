@@ -50,7 +50,10 @@ SOFTWARE.
 // void * stringhash5_find(stringhash5_t * sht, uint8_t * key, int keylen);
 //   Locates a record at a given key.  Returns a pointer to the data alloc'd to
 //   this record or NULL if not found.  The LRU for a given table index'd bucket
-//   is adjusted/sorted to mark searched record as most recent.
+//   is adjusted/sorted to mark searched record as most recent.  A find never
+//   inserts or evicts: a record found in the spill store is returned as a
+//   copy that is only good until the next find on the table, and changes to
+//   it are not kept.
 //
 // void * stringhash5_find_attach(stringhash5_t * sht, uint8_t * key, int keylen);
 //   Locates a record at a given key.  Returns a pointer to the data alloc'd to
@@ -62,6 +65,13 @@ SOFTWARE.
 //   using stringhash5_set_callback, then prior to records being deleted/reused
 //   the callback will be called.
 //
+// void stringhash5_prefetch_wsdata_batch(stringhash5_t * sht, wsdata_t ** keys,
+//                                        int n, sh5_prefetch_t * pf);
+// void * stringhash5_find_attach_prefetched(stringhash5_t * sht, sh5_prefetch_t * pf);
+//   Hashes n keys up front and prefetches their buckets and records, then
+//   each key is looked up in order with find_attach_prefetched, which acts
+//   like find_attach.  Used by kids that are handed a batch of events.
+//
 // void * stringhash5_delete(stringhash5_t * sht, uint8_t * key, int keylen);
 //   Deletes a record at a given key.  Marks this deleted record as least
 //   recently used.
@@ -125,15 +135,18 @@ SOFTWARE.
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
-#include "evahash64.h"
+#include "wshash64.h"
 #include "sysutil.h"
+#include "wshugepage.h"
 #include "sht_registry.h"
+#include "sht_spill.h"
 #include "tool_print.h"
 #include "error_print.h"
 #include "shared/getrank.h"
 #include "shared/lock_init.h"
 #include "shared/sht_lock_init.h"
 #include "shared/kidshare.h"
+#include "shared/ws_numa.h"
 
 #ifdef __cplusplus
 CPP_OPEN
@@ -143,8 +156,11 @@ CPP_OPEN
 #ifndef SHT_ID_SIZE
 #define SHT_ID_SIZE 13
 #endif // SHT_ID_SIZE
+//dump ids; the W ids mark tables whose keys were placed with wshash64
 #define SHT5_ID   "STRINGHASH5 "
 #define SHT9A_ID  "STRINGHASH9A"
+#define SHT5W_ID  "STRINGHASH5W"
+#define SHT9W_ID  "STRINGHASH9W"
 #define SH5_DEPTH 16 //should be matched with cache line size..
 #define SH5_DEPTH_BITS 4 //log2 of depth
 
@@ -159,6 +175,9 @@ CPP_OPEN
 #define SH5_DATA_BIN         28
 #define SH5_DATA_BIN_MASK    0xF0000000U
 
+// key for a record in the spill store, digests are never 0
+#define SH5_SPILL_ID(h,d)    (((uint64_t)(h) << 32) | (uint64_t)(d))
+
 //macros internal to stringhash5
 #define SET_NRANK const int nrank = GETRANK();
 #define CURRENT_LOCK_VALUE(sht,h) (sht)->curr_lock[GETRANK()] = (h) >> (sht)->mutex_index_shift; 
@@ -253,6 +272,7 @@ typedef struct _stringhash5_t {
      uint32_t index_size;
      uint32_t all_index_size;
      uint32_t hash_seed;
+     int hash_family; // WS_TABLE_HASH_* that places keys in this table
      stringhash5_callback callback;
      void ** cb_vproc;
      uint8_t epoch;
@@ -265,6 +285,8 @@ typedef struct _stringhash5_t {
      uint32_t num_walkers;
      uint32_t * walker_row;
      uint64_t nextval;
+     sht_spill_t * spill;
+     uint8_t * spill_peek; // copy of a spilled record handed out by find
 
      int is_shared;
      char * sharelabel;
@@ -327,11 +349,13 @@ static inline void * stringhash5_jump_to_entry(stringhash5_t *, uint32_t, uint32
 static inline void stringhash5_mark_as_used(stringhash5_t *, uint32_t, uint32_t);
 static inline uint64_t stringhash5_drop_cnt(stringhash5_t *);
 static inline void * stringhash5_find_attach(stringhash5_t *, void *, int);
+static inline void * stringhash5_find_attach_serial(stringhash5_t *, void *, int);
 static inline int stringhash5_delete(stringhash5_t *, void *, int);
 static inline void stringhash5_flush(stringhash5_t *);
 static inline void stringhash5_destroy(stringhash5_t *);
 static inline void stringhash5_scour(stringhash5_t *, stringhash5_callback, void *);
 static inline void stringhash5_scour_and_destroy(stringhash5_t *, stringhash5_callback, void *);
+static inline int stringhash5_enable_spill(stringhash5_t *);
 static inline stringhash5_t * stringhash5_read(FILE *);
 static inline stringhash5_t * stringhash5_read_with_ptrs(FILE *, sh5dataread_callback_t);
 static inline int stringhash5_dump(stringhash5_t *, FILE *);
@@ -664,11 +688,12 @@ static inline stringhash5_t * stringhash5_create(uint32_t is_shared, uint64_t ma
      sht->data_alloc = stringhash5_pad_alloc(data_alloc);
 
      sht->hash_seed = (uint32_t)rand();
+     sht->hash_family = WS_TABLE_HASH;
      sht->epoch = 1;
 
      // now to allocate memory...
-     sht->buckets = (sh5_bucket_t *)calloc(sht->all_index_size,
-                                           sizeof(sh5_bucket_t));
+     sht->buckets = (sh5_bucket_t *)ws_huge_calloc(sht->all_index_size,
+                                                   sizeof(sh5_bucket_t));
 
      if (!sht->buckets) {
           free(sht);
@@ -676,14 +701,23 @@ static inline stringhash5_t * stringhash5_create(uint32_t is_shared, uint64_t ma
           return NULL;
      }
 
-     sht->data = (uint8_t*)calloc(sht->max_records, sht->data_alloc);
+     sht->data = (uint8_t*)ws_huge_calloc(sht->max_records, sht->data_alloc);
      if (!sht->data) {
-          free(sht->buckets);
+          ws_huge_free(sht->buckets);
           free(sht);
           error_print("failed calloc of stringhash5_mway data");
           return NULL;
      }
 
+     // a shared table is hit from every thread, so spread it over all NUMA
+     // nodes before anything touches it
+     if (is_shared &&
+         ws_numa_interleave(sht->buckets, sht->all_index_size * sizeof(sh5_bucket_t)) &&
+         ws_numa_interleave(sht->data, (uint64_t)sht->max_records * sht->data_alloc)) {
+          tool_print("sh5 shared table interleaved across %u NUMA nodes",
+                     ws_numa_nodes());
+     }
+
      sh5_init_buckets(sht);
 
      // tally up the hash table memory use
@@ -702,6 +736,26 @@ static inline void stringhash5_clean_data_field(stringhash5_t * sht) {
      memset(sht->data, 0, sht->max_records * sht->data_alloc);
 }
 
+// back an unshared table with the on-disk spill store, if one is configured;
+// records evicted from full buckets are kept there instead of expired
+static inline int stringhash5_enable_spill(stringhash5_t * sht) {
+     if (!sht || sht->is_shared || sht->spill) {
+          return 0;
+     }
+     sht->spill_peek = (uint8_t *)malloc(sht->data_alloc);
+     if (!sht->spill_peek) {
+          error_print("failed stringhash5_enable_spill malloc of spill_peek");
+          return 0;
+     }
+     sht->spill = sht_spill_open(sht->data_alloc, sht->max_records);
+     if (!sht->spill) {
+          free(sht->spill_peek);
+          sht->spill_peek = NULL;
+          return 0;
+     }
+     return 1;
+}
+
 //DEPRECATED
 // wrapper function for the deprecated stringhash5_create_shared
 static inline int stringhash5_create_shared(void * v_type_table, void ** table, 
@@ -1008,7 +1062,8 @@ static inline void sh5_gethash(stringhash5_t * sht,
                                uint32_t *h1, uint32_t *h2,
                                uint32_t *pd1, uint32_t *pd2) {
 
-     uint64_t m = evahash64((uint8_t*)key, keylen, sht->hash_seed);
+     uint64_t m = ws_table_hash64_family(sht->hash_family, key, keylen,
+                                         sht->hash_seed);
      uint64_t p1 = m * SH5_PERMUTE1;
      uint64_t p2 = m * SH5_PERMUTE2;
      uint64_t lh1, lh2;
@@ -1161,6 +1216,14 @@ static inline void * stringhash5_find_serial(stringhash5_t * sht,
                                ((size_t)h2 << SH5_DEPTH_BITS)));
      }
 
+     // only find_attach faults a spilled record back in, since that can
+     // evict; a find just reads a copy of it
+     if (sht->spill &&
+         (sht_spill_peek(sht->spill, SH5_SPILL_ID(h1, d1), sht->spill_peek) ||
+          sht_spill_peek(sht->spill, SH5_SPILL_ID(h2, d2), sht->spill_peek))) {
+          return sht->spill_peek;
+     }
+
      return NULL;
 }
 
@@ -1324,15 +1387,14 @@ static inline uint64_t stringhash5_drop_cnt(stringhash5_t * sht) {
 }
 
 //find records using hashkeys.. return 1 if found
-static inline void * stringhash5_find_attach_shared(stringhash5_t * sht,
-                                             void * key, int keylen) {
+static inline void * stringhash5_find_attach_posthash_shared(stringhash5_t * sht,
+                                                             uint32_t h1, uint32_t h2,
+                                                             uint32_t d1, uint32_t d2) {
 
-     uint32_t h1, h2, d1, d2, pairflag;
+     uint32_t pairflag;
      uint32_t databin, digestbin;
      SET_NRANK
 
-     sh5_gethash(sht, (uint8_t*)key, keylen, &h1, &h2, &d1, &d2);
-
      SH5_SHIFT_KEY(h1, k1)
      SH5_SHIFT_KEY(h2, k2)
      SH5_LOCK_PAIR(sht,k1,k2,pairflag)
@@ -1405,14 +1467,12 @@ static inline void * stringhash5_find_attach_shared(stringhash5_t * sht,
      return data;
 }
 
-static inline void * stringhash5_find_attach_serial(stringhash5_t * sht,
-                                                    void * key, int keylen) {
+static inline void * stringhash5_find_attach_posthash_serial(stringhash5_t * sht,
+                                                             uint32_t h1, uint32_t h2,
+                                                             uint32_t d1, uint32_t d2) {
 
-     uint32_t h1, h2, d1, d2;
      uint32_t databin, digestbin;
 
-     sh5_gethash(sht, (uint8_t*)key, keylen, &h1, &h2, &d1, &d2);
-
      sh5_bucket_t * bucket1 = &sht->buckets[h1];
 
      if (sh5_lookup_bucket(bucket1, d1, &databin, &digestbin)) {
@@ -1444,9 +1504,10 @@ static inline void * stringhash5_find_attach_serial(stringhash5_t * sht,
                                    ((size_t)databin +
                                     ((size_t)ih << SH5_DEPTH_BITS)));
 
-     if (sht->callback) {
-          sh5_digest_t od = ibucket->digest[SH5_DEPTH -1] & SH5_DIGEST_MASK;
-          if (od) {
+     sh5_digest_t od = ibucket->digest[SH5_DEPTH -1] & SH5_DIGEST_MASK;
+     // a spilled record has only moved, so the kid is not told it expired
+     if (od && !(sht->spill && sht_spill_put(sht->spill, SH5_SPILL_ID(ih, od), data))) {
+          if (sht->callback) {
                sht->callback(data, sht->cb_vproc[0]);
           }
      }     
@@ -1461,9 +1522,43 @@ static inline void * stringhash5_find_attach_serial(stringhash5_t * sht,
      sh5_sort_lru_noepoch(ibucket->digest, SH5_DEPTH-1);
      sh5_set_epoch(sht, ibucket->digest);
 
+     // the record may have been spilled under either bucket
+     if (sht->spill && !sht_spill_take(sht->spill, SH5_SPILL_ID(h1, d1), data)) {
+          sht_spill_take(sht->spill, SH5_SPILL_ID(h2, d2), data);
+     }
+
      return data;
 }
 
+static inline void * stringhash5_find_attach_posthash(stringhash5_t * sht,
+                                                      uint32_t h1, uint32_t h2,
+                                                      uint32_t d1, uint32_t d2) {
+     if (sht->is_shared) {
+          return stringhash5_find_attach_posthash_shared(sht, h1, h2, d1, d2);
+     }
+     else {
+          return stringhash5_find_attach_posthash_serial(sht, h1, h2, d1, d2);
+     }
+}
+
+static inline void * stringhash5_find_attach_shared(stringhash5_t * sht,
+                                                    void * key, int keylen) {
+     uint32_t h1, h2, d1, d2;
+
+     sh5_gethash(sht, (uint8_t*)key, keylen, &h1, &h2, &d1, &d2);
+
+     return stringhash5_find_attach_posthash_shared(sht, h1, h2, d1, d2);
+}
+
+static inline void * stringhash5_find_attach_serial(stringhash5_t * sht,
+                                                    void * key, int keylen) {
+     uint32_t h1, h2, d1, d2;
+
+     sh5_gethash(sht, (uint8_t*)key, keylen, &h1, &h2, &d1, &d2);
+
+     return stringhash5_find_attach_posthash_serial(sht, h1, h2, d1, d2);
+}
+
 static inline void * stringhash5_find_attach(stringhash5_t * sht,
                                       void * key, int keylen) {
      if (sht->is_shared) {
@@ -1474,6 +1569,102 @@ static inline void * stringhash5_find_attach(stringhash5_t * sht,
      }
 }
 
+// batched lookups: stringhash5_prefetch_*_batch hashes a run of keys and
+// starts pulling their buckets into cache, so the misses overlap instead of
+// stalling one key at a time; each key is then resolved in order with
+// stringhash5_find_attach_prefetched, which behaves exactly like
+// stringhash5_find_attach (including holding the lock on a shared table)
+typedef struct _sh5_prefetch_t {
+     uint32_t h1, h2, d1, d2;
+     int valid;
+} sh5_prefetch_t;
+
+#ifdef __GNUC__
+#define SH5_PREFETCH(addr) __builtin_prefetch((addr), 1, 3)
+#else
+#define SH5_PREFETCH(addr)
+#endif
+
+static inline void sh5_prefetch_key(stringhash5_t * sht,
+                                    void * key, int keylen,
+                                    sh5_prefetch_t * pf) {
+     sh5_gethash(sht, (uint8_t*)key, keylen, &pf->h1, &pf->h2,
+                 &pf->d1, &pf->d2);
+     pf->valid = 1;
+     SH5_PREFETCH(&sht->buckets[pf->h1]);
+     SH5_PREFETCH(&sht->buckets[pf->h2]);
+}
+
+// second pass once the buckets are on their way: fetch the record a key
+// already owns.  Only done on serial tables since shared buckets cannot be
+// read without their lock
+static inline void sh5_prefetch_data(stringhash5_t * sht, sh5_prefetch_t * pf) {
+     uint32_t databin, digestbin;
+
+     if (sh5_lookup_bucket(&sht->buckets[pf->h1], pf->d1, &databin, &digestbin)) {
+          SH5_PREFETCH(sht->data + (sht->data_alloc *
+                                    ((size_t)databin +
+                                     ((size_t)pf->h1 << SH5_DEPTH_BITS))));
+     }
+     else if (sh5_lookup_bucket(&sht->buckets[pf->h2], pf->d2, &databin, &digestbin)) {
+          SH5_PREFETCH(sht->data + (sht->data_alloc *
+                                    ((size_t)databin +
+                                     ((size_t)pf->h2 << SH5_DEPTH_BITS))));
+     }
+}
+
+static inline void stringhash5_prefetch_loc_batch(stringhash5_t * sht,
+                                                  ws_hashloc_t ** locs, int n,
+                                                  sh5_prefetch_t * pf) {
+     int i;
+     for (i = 0; i < n; i++) {
+          if (locs[i] && locs[i]->len) {
+               sh5_prefetch_key(sht, locs[i]->offset, locs[i]->len, &pf[i]);
+          }
+          else {
+               pf[i].valid = 0;
+          }
+     }
+     if (!sht->is_shared) {
+          for (i = 0; i < n; i++) {
+               if (pf[i].valid) {
+                    sh5_prefetch_data(sht, &pf[i]);
+               }
+          }
+     }
+}
+
+static inline void stringhash5_prefetch_wsdata_batch(stringhash5_t * sht,
+                                                     wsdata_t ** wsd, int n,
+                                                     sh5_prefetch_t * pf) {
+     ws_hashloc_t * loc;
+     int i;
+     for (i = 0; i < n; i++) {
+          loc = wsd[i]->dtype->hash_func(wsd[i]);
+          if (loc) {
+               sh5_prefetch_key(sht, loc->offset, loc->len, &pf[i]);
+          }
+          else {
+               pf[i].valid = 0;
+          }
+     }
+     if (!sht->is_shared) {
+          for (i = 0; i < n; i++) {
+               if (pf[i].valid) {
+                    sh5_prefetch_data(sht, &pf[i]);
+               }
+          }
+     }
+}
+
+static inline void * stringhash5_find_attach_prefetched(stringhash5_t * sht,
+                                                        sh5_prefetch_t * pf) {
+     if (!pf->valid) {
+          return NULL;
+     }
+     return stringhash5_find_attach_posthash(sht, pf->h1, pf->h2, pf->d1, pf->d2);
+}
+
 static inline void sh5_delete_lru(sh5_digest_t * d, uint8_t item) {
      uint32_t data = d[item] & SH5_ANTI_DIGEST_MASK;
      uint32_t i;
@@ -1511,6 +1702,11 @@ static inline int stringhash5_delete(stringhash5_t * sht, void * key, int keylen
      if (sh5_delete_bucket(&sht->buckets[h2], d2)) {
           return 1;
      }
+
+     if (sht->spill) {
+          return sht_spill_remove(sht->spill, SH5_SPILL_ID(h1, d1)) ||
+               sht_spill_remove(sht->spill, SH5_SPILL_ID(h2, d2));
+     }
      
      return 0;
 }
@@ -1523,6 +1719,9 @@ static inline void stringhash5_flush(stringhash5_t * sht) {
      SH5_ALL_LOCK(sht)
      sh5_init_buckets(sht);
      SH5_ALL_UNLOCK(sht)
+     if (sht->spill) {
+          sht_spill_clear(sht->spill);
+     }
 }
 
 static inline void stringhash5_destroy(stringhash5_t * sht) {
@@ -1555,9 +1754,13 @@ static inline void stringhash5_destroy(stringhash5_t * sht) {
                }
                free(sht->walkers);
           }
+          if (sht->spill) {
+               sht_spill_close(sht->spill);
+               free(sht->spill_peek);
+          }
           free(sht->cb_vproc);
-          free(sht->buckets);
-          free(sht->data);
+          ws_huge_free(sht->buckets);
+          ws_huge_free(sht->data);
           free(sht);
      }
      //something BAD happened with shared table accounting, so report this!
@@ -1590,6 +1793,9 @@ static inline void stringhash5_scour(stringhash5_t * sht,
           }
      }
      SH5_ALL_UNLOCK(sht)
+     if (sht->spill) {
+          sht_spill_scour(sht->spill, cb, vproc, 1);
+     }
 }
 
 static inline void stringhash5_scour_and_flush(stringhash5_t * sht,
@@ -1618,6 +1824,9 @@ static inline void stringhash5_scour_and_flush(stringhash5_t * sht,
           }
      }
      SH5_ALL_UNLOCK(sht)
+     if (sht->spill) {
+          sht_spill_scour(sht->spill, cb, vproc, 0);
+     }
 }
 
 static inline int stringhash5_clean_sharing (void * sht_generic, int * index) {
@@ -1688,9 +1897,13 @@ static inline void stringhash5_scour_and_destroy(stringhash5_t * sht,
                }
                free(sht->walkers);
           }
+          if (sht->spill) {
+               sht_spill_close(sht->spill);
+               free(sht->spill_peek);
+          }
           free(sht->cb_vproc);
-          free(sht->buckets);
-          free(sht->data);
+          ws_huge_free(sht->buckets);
+          ws_huge_free(sht->data);
           free(sht);
      }
      //something BAD happened with shared table accounting, so report this!
@@ -1736,10 +1949,16 @@ static inline stringhash5_t * stringhash5_read(FILE * fp) {
      if (!fread(&sht_id, SHT_ID_SIZE, 1, fp)) {
           return NULL;
      }
-     if (strncmp(sht_id, SHT5_ID, SHT_ID_SIZE) != 0) {
+     // unlabeled and older tables were all placed with evahash64
+     sht->hash_family = WS_TABLE_HASH_EVA;
+     if (strncmp(sht_id, SHT5W_ID, SHT_ID_SIZE) == 0) {
+          sht->hash_family = WS_TABLE_HASH_WS;
+     }
+     else if (strncmp(sht_id, SHT5_ID, SHT_ID_SIZE) != 0) {
 
           //failure - this is a stringhash9a table
-          if (strncmp(sht_id, SHT9A_ID, SHT_ID_SIZE) == 0) {
+          if ((strncmp(sht_id, SHT9A_ID, SHT_ID_SIZE) == 0) ||
+              (strncmp(sht_id, SHT9W_ID, SHT_ID_SIZE) == 0)) {
                error_print("attempting to read hash table type %s instead of type %s",
                            sht_id, SHT5_ID);
                return NULL;
@@ -1779,14 +1998,14 @@ static inline stringhash5_t * stringhash5_read(FILE * fp) {
           return NULL;
      }
 
-     sht->buckets = (sh5_bucket_t *)calloc(sht->all_index_size,
-                                           sizeof(sh5_bucket_t));
+     sht->buckets = (sh5_bucket_t *)ws_huge_calloc(sht->all_index_size,
+                                                   sizeof(sh5_bucket_t));
      if (!sht->buckets) {
           error_print("failed calloc of stringhash5_mway buckets");
           return NULL;
      }
 
-     sht->data = (uint8_t*)calloc(sht->max_records, sht->data_alloc);
+     sht->data = (uint8_t*)ws_huge_calloc(sht->max_records, sht->data_alloc);
      if (!sht->data) {
           error_print("failed calloc of stringhash5_mway data");
           return NULL;
@@ -1845,10 +2064,16 @@ static inline stringhash5_t * stringhash5_read_with_ptrs(FILE * fp,
      if (!fread(&sht_id, SHT_ID_SIZE, 1, fp)) {
           return NULL;
      }
-     if (strncmp(sht_id, SHT5_ID, SHT_ID_SIZE) != 0) {
+     // unlabeled and older tables were all placed with evahash64
+     sht->hash_family = WS_TABLE_HASH_EVA;
+     if (strncmp(sht_id, SHT5W_ID, SHT_ID_SIZE) == 0) {
+          sht->hash_family = WS_TABLE_HASH_WS;
+     }
+     else if (strncmp(sht_id, SHT5_ID, SHT_ID_SIZE) != 0) {
 
           //failure - this is a stringhash9a table
-          if (strncmp(sht_id, SHT9A_ID, SHT_ID_SIZE) == 0) {
+          if ((strncmp(sht_id, SHT9A_ID, SHT_ID_SIZE) == 0) ||
+              (strncmp(sht_id, SHT9W_ID, SHT_ID_SIZE) == 0)) {
                error_print("attempting to read hash table type %s instead of type %s",
                            sht_id, SHT5_ID);
                return NULL;
@@ -1888,14 +2113,14 @@ static inline stringhash5_t * stringhash5_read_with_ptrs(FILE * fp,
           return NULL;
      }
 
-     sht->buckets = (sh5_bucket_t *)calloc(sht->all_index_size,
-                                           sizeof(sh5_bucket_t));
+     sht->buckets = (sh5_bucket_t *)ws_huge_calloc(sht->all_index_size,
+                                                   sizeof(sh5_bucket_t));
      if (!sht->buckets) {
           error_print("failed calloc of stringhash5_mway buckets");
           return NULL;
      }
 
-     sht->data = (uint8_t*)calloc(sht->max_records, sht->data_alloc);
+     sht->data = (uint8_t*)ws_huge_calloc(sht->max_records, sht->data_alloc);
      if (!sht->data) {
           error_print("failed calloc of stringhash5_mway data");
           return NULL;
@@ -1952,6 +2177,10 @@ static inline int stringhash5_dump(stringhash5_t * sht, FILE * fp) {
      char sht_id[SHT_ID_SIZE] = SHT5_ID;
      int rtn;
 
+     if (sht->hash_family == WS_TABLE_HASH_WS) {
+          memcpy(sht_id, SHT5W_ID, SHT_ID_SIZE);
+     }
+
      SH5_ALL_LOCK(sht)
      rtn = fwrite(&sht_id, SHT_ID_SIZE, 1, fp);
      rtn += fwrite(&sht->nextval, sizeof(uint64_t), 1, fp);
@@ -1984,6 +2213,10 @@ static inline int stringhash5_dump_with_ptrs(stringhash5_t * sht, FILE * fp,
      char sht_id[SHT_ID_SIZE] = SHT5_ID;
      int rtn;
 
+     if (sht->hash_family == WS_TABLE_HASH_WS) {
+          memcpy(sht_id, SHT5W_ID, SHT_ID_SIZE);
+     }
+
      SH5_ALL_LOCK(sht)
      rtn = fwrite(&sht_id, SHT_ID_SIZE, 1, fp);
      rtn += fwrite(&sht->nextval, sizeof(uint64_t), 1, fp);
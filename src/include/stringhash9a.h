@@ -30,13 +30,15 @@ SOFTWARE.
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
-#include "evahash64.h"
+#include "wshash64.h"
 #include "sysutil.h"
+#include "wshugepage.h"
 #include "sht_registry.h"
 #include "tool_print.h"
 #include "error_print.h"
 #include "shared/kidshare.h"
 #include "shared/sht_lock_init.h"
+#include "shared/ws_numa.h"
 #include "cppwrap.h"
 
 #ifdef __cplusplus
@@ -47,8 +49,11 @@ CPP_OPEN
 #ifndef SHT_ID_SIZE
 #define SHT_ID_SIZE 13
 #endif // SHT_ID_SIZE
+//dump ids; the W ids mark tables whose keys were placed with wshash64
 #define SHT9A_ID  "STRINGHASH9A"
 #define SHT5_ID   "STRINGHASH5 "
+#define SHT9W_ID  "STRINGHASH9W"
+#define SHT5W_ID  "STRINGHASH5W"
 #define SH9A_DEPTH 16 //should be matched with cache line size..
 
 #define SH9A_DIGEST_MASK 0xFFFFFF00U
@@ -167,6 +172,7 @@ typedef struct _stringhash9a_t {
      uint32_t ibits;
      uint32_t index_size;
      uint32_t hash_seed;
+     int hash_family; // WS_TABLE_HASH_* that places keys in this table
      uint64_t drops;
      uint8_t epoch;
      uint32_t insert_cnt;
@@ -365,11 +371,12 @@ static inline stringhash9a_t * sh9a_create_ibits(uint32_t ibits) {
      sht->max_records = sht->index_size * 21 * 2;
 
      sht->hash_seed = (uint32_t)rand();
+     sht->hash_family = WS_TABLE_HASH;
      sht->epoch = 1;
 
      // now to allocate memory...
-     sht->buckets = (sh9a_bucket_t *)calloc(sht->index_size * 2,
-                                            sizeof(sh9a_bucket_t));
+     sht->buckets = (sh9a_bucket_t *)ws_huge_calloc(sht->index_size * 2,
+                                                    sizeof(sh9a_bucket_t));
 
      if (!sht->buckets) {
           free(sht);
@@ -405,6 +412,14 @@ static inline stringhash9a_t * stringhash9a_create(uint32_t is_shared, uint32_t
           return NULL;
      }
 
+     // a shared table is hit from every thread, so spread it over all NUMA
+     // nodes; calloc'd table pages are still untouched at this point
+     if (is_shared &&
+         ws_numa_interleave(sht->buckets, 2 * (uint64_t)sht->index_size * sizeof(sh9a_bucket_t))) {
+          tool_print("sh9a shared table interleaved across %u NUMA nodes",
+                     ws_numa_nodes());
+     }
+
 #ifndef TOOL_NAME
      if (!is_shared) {
            if (!enroll_in_sht_registry(sht, "sh9a", sht->mem_used, sht->hash_seed)) {
@@ -820,7 +835,8 @@ static inline void sh9a_gethash(stringhash9a_t * sht,
                                 uint32_t *h1, uint32_t *h2,
                                 uint32_t *pd1, uint32_t *pd2) {
 
-     uint64_t m = evahash64(key, keylen, sht->hash_seed);
+     uint64_t m = ws_table_hash64_family(sht->hash_family, key, keylen,
+                                         sht->hash_seed);
      uint64_t p1 = m * SH9A_PERMUTE1;
      uint64_t p2 = m * SH9A_PERMUTE2;
      uint64_t lh1, lh2;
@@ -844,7 +860,8 @@ static inline void sh9a_gethash2(stringhash9a_t * sht,
                                  uint32_t *pd1, uint32_t *pd2,
                                  uint64_t *hash) {
 
-     uint64_t m = evahash64(key, keylen, sht->hash_seed);
+     uint64_t m = ws_table_hash64_family(sht->hash_family, key, keylen,
+                                         sht->hash_seed);
      *hash = m;
      uint64_t p1 = m * SH9A_PERMUTE1;
      uint64_t p2 = m * SH9A_PERMUTE2;
@@ -1205,6 +1222,66 @@ static inline int stringhash9a_set_hash(stringhash9a_t * sht,
      return stringhash9a_set_posthash(sht, h1, h2, d1, d2);
 }
 
+// batched lookups: every key in a window is hashed and both of its buckets
+// prefetched before any of them is resolved, so the cache misses overlap.
+// Keys are resolved in order, so a key repeated within a batch sees the
+// earlier set just as it would one call at a time
+#define SH9A_BATCH_WINDOW 16
+
+#ifdef __GNUC__
+#define SH9A_PREFETCH(addr) __builtin_prefetch((addr), 1, 3)
+#else
+#define SH9A_PREFETCH(addr)
+#endif
+
+typedef struct _sh9a_prefetch_t {
+     uint32_t h1, h2, d1, d2;
+} sh9a_prefetch_t;
+
+static inline void sh9a_prefetch_window(stringhash9a_t * sht,
+                                        void ** keys, int * keylens, int n,
+                                        sh9a_prefetch_t * pf) {
+     int i;
+     for (i = 0; i < n; i++) {
+          sh9a_gethash(sht, (uint8_t*)keys[i], keylens[i],
+                       &pf[i].h1, &pf[i].h2, &pf[i].d1, &pf[i].d2);
+          SH9A_PREFETCH(&sht->buckets[pf[i].h1]);
+          SH9A_PREFETCH(&sht->buckets[pf[i].h2]);
+     }
+}
+
+//found[i] is set to what stringhash9a_check would return for key i
+static inline void stringhash9a_check_batch(stringhash9a_t * sht,
+                                            void ** keys, int * keylens,
+                                            int n, int * found) {
+     sh9a_prefetch_t pf[SH9A_BATCH_WINDOW];
+     int i, j, w;
+     for (i = 0; i < n; i += w) {
+          w = ((n - i) < SH9A_BATCH_WINDOW) ? (n - i) : SH9A_BATCH_WINDOW;
+          sh9a_prefetch_window(sht, keys + i, keylens + i, w, pf);
+          for (j = 0; j < w; j++) {
+               found[i + j] = stringhash9a_check_posthash(sht, pf[j].h1, pf[j].h2,
+                                                          pf[j].d1, pf[j].d2);
+          }
+     }
+}
+
+//found[i] is set to what stringhash9a_set would return for key i
+static inline void stringhash9a_set_batch(stringhash9a_t * sht,
+                                          void ** keys, int * keylens,
+                                          int n, int * found) {
+     sh9a_prefetch_t pf[SH9A_BATCH_WINDOW];
+     int i, j, w;
+     for (i = 0; i < n; i += w) {
+          w = ((n - i) < SH9A_BATCH_WINDOW) ? (n - i) : SH9A_BATCH_WINDOW;
+          sh9a_prefetch_window(sht, keys + i, keylens + i, w, pf);
+          for (j = 0; j < w; j++) {
+               found[i + j] = stringhash9a_set_posthash(sht, pf[j].h1, pf[j].h2,
+                                                        pf[j].d1, pf[j].d2);
+          }
+     }
+}
+
 
 
 //move mru item to front.. for lower 16 items in a bucket
@@ -1522,7 +1599,7 @@ static inline void stringhash9a_destroy(stringhash9a_t * sht) {
           }
 #endif // WS_PTHREADS && !OWMR_TABLES
           free(sht->sharelabel);
-          free(sht->buckets);
+          ws_huge_free(sht->buckets);
           free(sht);
      }
      //something BAD happened with shared table accounting, so report this!
@@ -1543,10 +1620,16 @@ static inline stringhash9a_t * stringhash9a_read(FILE * fp) {
      if (!fread(&sht_id, SHT_ID_SIZE, 1, fp)) {
           return NULL;
      }
-     if (strncmp(sht_id, SHT9A_ID, SHT_ID_SIZE) != 0) {
+     // unlabeled and older tables were all placed with evahash64
+     int hash_family = WS_TABLE_HASH_EVA;
+     if (strncmp(sht_id, SHT9W_ID, SHT_ID_SIZE) == 0) {
+          hash_family = WS_TABLE_HASH_WS;
+     }
+     else if (strncmp(sht_id, SHT9A_ID, SHT_ID_SIZE) != 0) {
 
-          //failure - this is a stringhash9a table
-          if (strncmp(sht_id, SHT5_ID, SHT_ID_SIZE) == 0) {
+          //failure - this is a stringhash5 table
+          if ((strncmp(sht_id, SHT5_ID, SHT_ID_SIZE) == 0) ||
+              (strncmp(sht_id, SHT5W_ID, SHT_ID_SIZE) == 0)) {
                error_print("attempting to read hash table type %s instead of type %s",
                            sht_id, SHT9A_ID);
                return NULL;
@@ -1572,6 +1655,7 @@ static inline stringhash9a_t * stringhash9a_read(FILE * fp) {
      stringhash9a_t * sht = sh9a_create_ibits(ibits);
 
      sht->hash_seed = hash_seed;
+     sht->hash_family = hash_family;
      uint32_t total_buckets = sht->index_size * 2;
      uint32_t i = 0;
      while (i < total_buckets) {
@@ -1593,6 +1677,10 @@ static inline int stringhash9a_dump(stringhash9a_t * sht, FILE * fp) {
      int rtn;
      char sht_id[SHT_ID_SIZE] = SHT9A_ID;
 
+     if (sht->hash_family == WS_TABLE_HASH_WS) {
+          memcpy(sht_id, SHT9W_ID, SHT_ID_SIZE);
+     }
+
      SH9A_LOCK_ALL(sht)
      rtn = fwrite(&sht_id, SHT_ID_SIZE, 1, fp);
      rtn = fwrite(&sht->ibits, sizeof(uint32_t), 1, fp);
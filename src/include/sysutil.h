@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include <stdint.h>
 #include <time.h>
+#include <sys/time.h>
 #include <netinet/in.h>
 #include "cppwrap.h"
 
@@ -113,6 +114,73 @@ int sysutil_prepend_config_path(char**);
 
 int sysutil_decode_hex_escapes(char * /*str*/, int * /*len*/);
 
+/*
+ *    time service - kids read the clock through these rather than calling
+ *    time()/gettimeofday() per event.  Each thread keeps a cached copy of the
+ *    clock that the executor refreshes once per pass through the graph
+ *    (sysutil_clock_tick).
+ *
+ *    The event clock (sysutil_time, sysutil_gettime) is the wall clock on a
+ *    live run.  In replay mode it is the newest event timestamp reported
+ *    through sysutil_clock_observe, so time windows close the same way when
+ *    a capture is replayed as when it was seen live; until the first event
+ *    is observed it falls back to the wall clock.  The wall clock
+ *    (sysutil_walltime, sysutil_getwalltime) always follows the system
+ *    clock, for things like polling that must track real time.
+ *
+ *    sysutil_clock_ns is a monotonic nanosecond clock for measuring costs;
+ *    in tsc mode it reads the cycle counter, calibrated at startup.
+ */
+typedef struct _sysutil_clock_t {
+     struct timeval now;    //event clock
+     struct timeval wall;   //system clock at the last tick
+} sysutil_clock_t;
+
+extern __thread sysutil_clock_t sysutil_clock;
+extern int sysutil_clock_replay;
+extern int sysutil_clock_tsc;   //set once the cycle counter is calibrated
+
+//mode is a comma separated list of "tsc" and "replay"; returns 0 if invalid
+int sysutil_clock_set_mode(const char * /*mode*/);
+void sysutil_clock_tick(void);
+void sysutil_clock_observe_replay(time_t /*sec*/, time_t /*usec*/);
+uint64_t sysutil_clock_ns(void);
+
+//report the timestamp of an event being processed
+static inline void sysutil_clock_observe(time_t sec, time_t usec) {
+     if (sysutil_clock_replay) {
+          sysutil_clock_observe_replay(sec, usec);
+     }
+}
+
+static inline void sysutil_gettime(struct timeval * tv) {
+     if (!sysutil_clock.wall.tv_sec) {
+          sysutil_clock_tick();
+     }
+     *tv = sysutil_clock.now;
+}
+
+static inline time_t sysutil_time(void) {
+     if (!sysutil_clock.wall.tv_sec) {
+          sysutil_clock_tick();
+     }
+     return sysutil_clock.now.tv_sec;
+}
+
+static inline void sysutil_getwalltime(struct timeval * tv) {
+     if (!sysutil_clock.wall.tv_sec) {
+          sysutil_clock_tick();
+     }
+     *tv = sysutil_clock.wall;
+}
+
+static inline time_t sysutil_walltime(void) {
+     if (!sysutil_clock.wall.tv_sec) {
+          sysutil_clock_tick();
+     }
+     return sysutil_clock.wall.tv_sec;
+}
+
 #ifdef __cplusplus
 CPP_CLOSE
 #endif // __cplusplus
@@ -0,0 +1,268 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _TDIGEST_H
+#define _TDIGEST_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cppwrap.h"
+
+#ifdef __cplusplus
+CPP_OPEN
+#endif // __cplusplus
+
+/* Fixed size merging t-digest (Dunning & Ertl) for streaming quantiles.
+   Values are buffered and folded into a bounded set of centroids using the
+   arcsine scale function, which keeps centroids small near the tails so
+   extreme quantiles (p99, p999) stay accurate.  The structure has no
+   pointers, a zeroed tdigest_t is an empty digest, and two digests merge by
+   recompressing their combined centroids. */
+
+#define TDIGEST_CENTROIDS (64)
+#define TDIGEST_BUFFER    (32)
+//compression is chosen so that a compress never needs more centroids
+#define TDIGEST_DELTA     ((double)(TDIGEST_CENTROIDS - 2))
+#define TDIGEST_MAGIC     (0x54444731) // "TDG1"
+
+typedef struct _tdigest_centroid_t {
+     double mean;
+     double weight;
+} tdigest_centroid_t;
+
+typedef struct _tdigest_t {
+     double min;
+     double max;
+     double total;        //weight held in centroids
+     uint32_t ncentroids;
+     uint32_t nbuffer;
+     tdigest_centroid_t c[TDIGEST_CENTROIDS];
+     double buffer[TDIGEST_BUFFER];
+} tdigest_t;
+
+#define TDIGEST_SERIAL_LEN (sizeof(uint32_t) + sizeof(tdigest_t))
+
+static inline double tdigest_count(const tdigest_t * td) {
+     return td->total + (double)td->nbuffer;
+}
+
+static int tdigest_centroid_cmp(const void * va, const void * vb) {
+     const tdigest_centroid_t * a = (const tdigest_centroid_t *)va;
+     const tdigest_centroid_t * b = (const tdigest_centroid_t *)vb;
+     if (a->mean < b->mean) {
+          return -1;
+     }
+     return (a->mean > b->mean) ? 1 : 0;
+}
+
+static inline double tdigest_scale(double q) {
+     return TDIGEST_DELTA / (2.0 * M_PI) * asin(2.0 * q - 1.0);
+}
+
+//fold buffered values and any extra centroids into the digest
+static inline void tdigest_compress_with(tdigest_t * td,
+                                         const tdigest_centroid_t * extra,
+                                         uint32_t nextra) {
+     tdigest_centroid_t pts[2 * (TDIGEST_CENTROIDS + TDIGEST_BUFFER)];
+     uint32_t n = 0;
+     uint32_t i;
+     double total = 0;
+
+     for (i = 0; i < td->ncentroids; i++) {
+          pts[n++] = td->c[i];
+          total += td->c[i].weight;
+     }
+     for (i = 0; i < td->nbuffer; i++) {
+          pts[n].mean = td->buffer[i];
+          pts[n].weight = 1.0;
+          total += 1.0;
+          n++;
+     }
+     for (i = 0; i < nextra; i++) {
+          pts[n++] = extra[i];
+          total += extra[i].weight;
+     }
+     td->nbuffer = 0;
+     if (!n) {
+          return;
+     }
+     qsort(pts, n, sizeof(tdigest_centroid_t), tdigest_centroid_cmp);
+
+     uint32_t out = 0;
+     tdigest_centroid_t cur = pts[0];
+     double wsofar = 0;
+     double kleft = tdigest_scale(0);
+     for (i = 1; i < n; i++) {
+          double proposed = cur.weight + pts[i].weight;
+          double qright = (wsofar + proposed) / total;
+          if (qright > 1.0) {
+               qright = 1.0;
+          }
+          if ((tdigest_scale(qright) - kleft <= 1.0) ||
+              (out == TDIGEST_CENTROIDS - 1)) {
+               cur.mean += (pts[i].mean - cur.mean) * pts[i].weight / proposed;
+               cur.weight = proposed;
+          }
+          else {
+               td->c[out++] = cur;
+               wsofar += cur.weight;
+               kleft = tdigest_scale(wsofar / total);
+               cur = pts[i];
+          }
+     }
+     td->c[out++] = cur;
+     td->ncentroids = out;
+     td->total = total;
+}
+
+static inline void tdigest_compress(tdigest_t * td) {
+     tdigest_compress_with(td, NULL, 0);
+}
+
+static inline void tdigest_add(tdigest_t * td, double value) {
+     if (tdigest_count(td) == 0) {
+          td->min = value;
+          td->max = value;
+     }
+     else if (value < td->min) {
+          td->min = value;
+     }
+     else if (value > td->max) {
+          td->max = value;
+     }
+     td->buffer[td->nbuffer++] = value;
+     if (td->nbuffer == TDIGEST_BUFFER) {
+          tdigest_compress(td);
+     }
+}
+
+static inline void tdigest_merge(tdigest_t * dst, const tdigest_t * src) {
+     if (tdigest_count(src) == 0) {
+          return;
+     }
+     tdigest_centroid_t extra[TDIGEST_CENTROIDS + TDIGEST_BUFFER];
+     uint32_t n = 0;
+     uint32_t i;
+     for (i = 0; i < src->ncentroids; i++) {
+          extra[n++] = src->c[i];
+     }
+     for (i = 0; i < src->nbuffer; i++) {
+          extra[n].mean = src->buffer[i];
+          extra[n].weight = 1.0;
+          n++;
+     }
+     if (tdigest_count(dst) == 0) {
+          dst->min = src->min;
+          dst->max = src->max;
+     }
+     else {
+          if (src->min < dst->min) {
+               dst->min = src->min;
+          }
+          if (src->max > dst->max) {
+               dst->max = src->max;
+          }
+     }
+     tdigest_compress_with(dst, extra, n);
+}
+
+//q in [0,1]; interpolates between centroid midpoints, min and max
+static inline double tdigest_quantile(tdigest_t * td, double q) {
+     if (td->nbuffer) {
+          tdigest_compress(td);
+     }
+     if (!td->ncentroids) {
+          return 0;
+     }
+     if (q <= 0) {
+          return td->min;
+     }
+     if (q >= 1) {
+          return td->max;
+     }
+     if (td->ncentroids == 1) {
+          return td->c[0].mean;
+     }
+
+     double target = q * td->total;
+     double first_mid = td->c[0].weight / 2.0;
+     if (target < first_mid) {
+          return td->min + (td->c[0].mean - td->min) * target / first_mid;
+     }
+
+     double cum = 0;
+     uint32_t i;
+     for (i = 0; i < td->ncentroids - 1; i++) {
+          double mid = cum + td->c[i].weight / 2.0;
+          double next_mid = cum + td->c[i].weight + td->c[i + 1].weight / 2.0;
+          if (target < next_mid) {
+               double frac = (target - mid) / (next_mid - mid);
+               return td->c[i].mean + (td->c[i + 1].mean - td->c[i].mean) * frac;
+          }
+          cum += td->c[i].weight;
+     }
+
+     //past the last midpoint
+     tdigest_centroid_t * last = &td->c[td->ncentroids - 1];
+     double last_mid = td->total - last->weight / 2.0;
+     double span = td->total - last_mid;
+     double frac = (span > 0) ? (target - last_mid) / span : 0;
+     return last->mean + (td->max - last->mean) * frac;
+}
+
+//buf must hold TDIGEST_SERIAL_LEN bytes; native byte order
+static inline void tdigest_serialize(tdigest_t * td, char * buf) {
+     uint32_t magic = TDIGEST_MAGIC;
+     tdigest_compress(td);
+     memcpy(buf, &magic, sizeof(uint32_t));
+     memcpy(buf + sizeof(uint32_t), td, sizeof(tdigest_t));
+}
+
+//returns 1 if buf held a digest that was merged into td
+static inline int tdigest_merge_serialized(tdigest_t * td, const char * buf,
+                                           int len) {
+     uint32_t magic;
+     tdigest_t src;
+     if (len != (int)TDIGEST_SERIAL_LEN) {
+          return 0;
+     }
+     memcpy(&magic, buf, sizeof(uint32_t));
+     if (magic != TDIGEST_MAGIC) {
+          return 0;
+     }
+     memcpy(&src, buf + sizeof(uint32_t), sizeof(tdigest_t));
+     if ((src.ncentroids > TDIGEST_CENTROIDS) ||
+         (src.nbuffer > TDIGEST_BUFFER)) {
+          return 0;
+     }
+     tdigest_merge(td, &src);
+     return 1;
+}
+
+#ifdef __cplusplus
+CPP_CLOSE
+#endif // __cplusplus
+
+#endif // _TDIGEST_H
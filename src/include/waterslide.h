@@ -44,6 +44,7 @@ SOFTWARE.
 #include "tool_print.h"
 #include "dprint.h"
 #include "cppwrap.h"
+#include "shared/getrank.h"
 
 #if defined(__linux__)
 #include <sys/stat.h>
@@ -66,6 +67,9 @@ SOFTWARE.
 #define ENV_WS_ALIAS_PATH "WATERSLIDE_ALIAS_PATH"
 #define ENV_WS_CONFIG_PATH "WATERSLIDE_CONFIG_PATH"
 #define ENV_WS_BASE_DIR "WATERSLIDE_BASE_DIR"
+#define ENV_WS_CACHE_DIR "WATERSLIDE_CACHE_DIR"
+#define ENV_WS_HUGEPAGES "WATERSLIDE_HUGEPAGES"
+#define ENV_WS_SPILL_DIR "WATERSLIDE_SPILL_DIR"
 
 #define WS_STATESTORE_MAX "WS_STATESTORE_MAX"
 #define WS_STATESTORE_DEFAULT 350000
@@ -273,6 +277,7 @@ void mimo_set_verbose(mimo_t *);
 void mimo_set_valgrind(mimo_t *);
 void mimo_set_input_validate(mimo_t *);
 void mimo_set_noexitflush(mimo_t *);
+void mimo_set_direct_dispatch(mimo_t *);
 
 // this loads a processing graph from a config file
 int mimo_load_graph_file(mimo_t *, char * /*filename*/);
@@ -302,6 +307,8 @@ void * mimo_collect_data(mimo_sink_t *, char *);
 
 //use the following to print out graph upon loading of file or command line
 void mimo_output_graphviz(mimo_t *, FILE *);
+void mimo_output_placement(mimo_t *, FILE *, uint32_t /*nthreads*/);
+void mimo_set_placement_profile(mimo_t *, const char *);
 void mimo_output_p_graphviz(mimo_t *, FILE *);
 
 int mimo_flush_graph(mimo_t * mimo);
@@ -309,8 +316,15 @@ int mimo_flush_graph(mimo_t * mimo);
 
 void mimo_add_aliases(mimo_t * mimo, char * filename);
 
+// what a kid reads from the tuples handed to it; decoders upstream skip
+// members that nothing downstream reads (see ws_init_label_demand)
+#define WSKID_READS_ALL    0 // may read any member (default)
+#define WSKID_READS_LABELS 1 // reads only labels it looked up, forwards input
+#define WSKID_READS_OWN    2 // reads only labels it looked up, emits new data
+
 typedef struct _wskid_t {
      uint32_t uid;
+     uint32_t reads; // WSKID_READS_*, set by proc_init
 } wskid_t;
 
 //macro for specifying uint64_t in a print statement.. architecture dependant..
@@ -360,16 +374,41 @@ typedef struct _wslabel_t {
      uint8_t registered;
      uint8_t search;
      uint16_t index_id;
+     uint32_t serial; // order of creation, starting at 1
      uint64_t hash;
      char * name;  //null terminated string
 } wslabel_t;  //lookup list stored in mimo->datalists->label_table;
 
+// set of labels, by serial, read somewhere downstream of an output type;
+// NULL stands for every label
+typedef struct _ws_label_demand_t {
+     uint32_t nbits;
+     uint64_t * bits;
+} ws_label_demand_t;
+
+// labels created after the graph was initialized are never demanded, since
+// only kids that read everything (a NULL demand) could be looking for them
+static inline int wslabel_demanded(ws_label_demand_t * demand,
+                                   wslabel_t * label) {
+     if (!demand) {
+          return 1;
+     }
+     if (!label || (label->serial >= demand->nbits)) {
+          return 0;
+     }
+     return (demand->bits[label->serial >> 6] >> (label->serial & 63)) & 1;
+}
+
 typedef struct _ws_hashloc_t {
      void * offset;  //offset into data
      int len;     //length of data to hash
 } ws_hashloc_t;
 
 #define WSDATA_MAX_LABELS 20
+#define WSDATA_INLINE_DEPS 2
+
+// owner value of data that has been handed to another thread
+#define WSDATA_OWNER_SHARED (-1)
 
 //generic structure for storing data references
 struct _wsdata_t {
@@ -378,15 +417,37 @@ struct _wsdata_t {
      uint32_t isptr : 1; //flag: is a pointer to a wsdata reference of same type..
      WS_SPINLOCK_DECL(lock)
      int references;  //number of pointer reference to this data
+     int owner; //rank of allocating thread, or WSDATA_OWNER_SHARED once published
      wsdatatype_t * dtype;
      wslabel_t * labels[WSDATA_MAX_LABELS]; //primary label for this data type..
      int label_len; //primary label for this data type..
      int writer_label_len;
      void * data; //allocated buffer.. of size dtype->len
-     wsstack_t * dependency; // whether this is a or child of another
+     int dep_len; //number of parents held in deps
+     wsdata_t * deps[WSDATA_INLINE_DEPS]; //parents this data depends on
+     wsstack_t * dependency; // parents beyond the inline deps
      ws_hashloc_t hashloc;
 };
 
+// Reference counts are biased toward the thread that allocated the data:
+// until the data is published to another thread (see wsdata_publish) only
+// the owner can see it, so the owner updates the count without atomics.
+// Published data falls back to the atomic (or locked) count.  Kids that
+// share state between threads set wsdata_refs_shared at init, which sends
+// every count down the shared path since data can then cross threads
+// without going through a shared queue.
+#ifdef WS_PTHREADS
+extern uint32_t wsdata_refs_shared;
+#define WSDATA_IS_LOCAL(wsd) \
+     (((wsd)->owner == GETRANK()) && !wsdata_refs_shared)
+#else
+#define WSDATA_IS_LOCAL(wsd) (1)
+#endif // WS_PTHREADS
+
+// mark data (and what it depends on) as visible to other threads; must be
+// called before handing data to another thread
+void wsdata_publish(wsdata_t *);
+
 // add a label to a wsdata element.. return 1 if successful, 0 if fail
 static inline int wsdata_add_label(wsdata_t * data, wslabel_t * label) {
 #ifdef USE_ATOMICS
@@ -415,6 +476,9 @@ static inline int wsdata_add_label(wsdata_t * data, wslabel_t * label) {
 }
 
 static inline int wsdata_get_reference(wsdata_t * wsd) {
+     if (WSDATA_IS_LOCAL(wsd)) {
+          return wsd->references;
+     }
 #ifdef USE_ATOMICS
      return __sync_fetch_and_add(&wsd->references, 0);
 #else
@@ -472,7 +536,17 @@ static inline wslabel_t * wsregister_label_wprefix(void * tt,
 
 int wsregister_label_alias(void *, wslabel_t *, char *);
 
+int wslabel_demand_add(ws_label_demand_t *, wslabel_t *);
+int wslabel_demand_merge(ws_label_demand_t *, ws_label_demand_t *);
+void wslabel_demand_free(ws_label_demand_t *);
+// while set, every label looked up on this thread is added to the recorder
+void wslabel_set_recorder(ws_label_demand_t *);
+
 static inline int wsdata_add_reference(wsdata_t * wsd) {
+     if (WSDATA_IS_LOCAL(wsd)) {
+          wsd->references++;
+          return 1;
+     }
 #ifdef USE_ATOMICS
      (void) __sync_fetch_and_add(&wsd->references, 1);
 #else
@@ -492,7 +566,25 @@ static inline int wsdata_assign_dependency(wsdata_t* parent, wsdata_t * child) {
 
      wsdata_add_reference(parent);
 
+     if (WSDATA_IS_LOCAL(child)) {
+          if (child->dep_len < WSDATA_INLINE_DEPS) {
+               child->deps[child->dep_len] = parent;
+               child->dep_len++;
+               return 1;
+          }
+     }
+     else if (child->owner == WSDATA_OWNER_SHARED) {
+          // other threads can reach the parent through the child
+          wsdata_publish(parent);
+     }
+
      WS_SPINLOCK_LOCK(&child->lock);
+     if (child->dep_len < WSDATA_INLINE_DEPS) {
+          child->deps[child->dep_len] = parent;
+          child->dep_len++;
+          WS_SPINLOCK_UNLOCK(&child->lock);
+          return 1;
+     }
      if (!child->dependency) {
           child->dependency = wsstack_init();
           if (!child->dependency) {
@@ -514,6 +606,9 @@ static inline int wsdata_assign_dependency(wsdata_t* parent, wsdata_t * child) {
 
 static inline int wsdata_remove_reference(wsdata_t * wsd) {
      int ret;
+     if (WSDATA_IS_LOCAL(wsd)) {
+          return --wsd->references;
+     }
 #ifdef USE_ATOMICS
      ret = __sync_fetch_and_add(&wsd->references, -1) - 1;
 #else
@@ -549,6 +644,18 @@ typedef struct _ws_input_t ws_input_t;
 //prototype of how a module is to process data and set outputs
 typedef int (*proc_process_t)(void *, wsdata_t*, ws_doutput_t*, int);
 
+//optional batch form: called with several queued events bound for the same
+// input.. the executor keeps the data referenced until the call returns
+typedef int (*proc_process_batch_t)(void *, wsdata_t**, int, ws_doutput_t*,
+                                    int);
+
+//a kid may export proc_batch[] pairing any proc_process_t it returns from
+// proc_input_set with a batch form, ending with {NULL, NULL}
+typedef struct _proc_batch_t {
+     proc_process_t proc_func;
+     proc_process_batch_t batch_func;
+} proc_batch_t;
+
 //functions used by processing modules for setting output datatypes and data
 ws_outtype_t * ws_add_outtype(ws_outlist_t *, wsdatatype_t*, wslabel_t *);
 ws_outtype_t * ws_add_outtype_byname(void *, ws_outlist_t *, const char *, const char *);
@@ -35,6 +35,7 @@ CPP_OPEN
 
 typedef struct _ws_subscriber_t {
      proc_process_t proc_func;
+     proc_process_batch_t proc_batch_func; // NULL if the kid has no batch form
      ws_proc_instance_t * proc_instance;
      void * local_instance;
      wslabel_t * port;   //name of input port
@@ -58,6 +59,7 @@ struct _ws_outtype_t {
      wslabel_t * label;
      ws_subscriber_t * local_subscribers;
      ws_subscriber_t * ext_subscribers;
+     ws_label_demand_t * demand; // labels read downstream, NULL for all
 };
 
 struct _ws_outlist_t {
@@ -70,9 +72,21 @@ typedef struct _ws_job_t {
      ws_subscriber_t * subscribers;
 } ws_job_t;
 
+// ring of ws_job_t records, see wsjobring.h
+struct _ws_jobring_t;
+typedef struct _ws_jobring_t ws_jobring_t;
+
+// bound on nested same-thread calls when direct dispatch is enabled;
+// deeper emits fall back to the local job queue
+#define WS_DIRECT_DISPATCH_MAX_DEPTH 64
+
+// most queued jobs handed to a kid's batch function in one call
+#define WS_BATCH_MAX 32
+
 struct _ws_doutput_t {
-     nhqueue_t * local_jobq;  // a thread's job q
-     nhqueue_t * local_job_freeq;  /// linked with mimo's jobq
+     ws_jobring_t * local_jobq;  // a thread's job q, linked with mimo's jobq
+     uint32_t dispatching;  // nonzero while this kid's emit is being run directly
+     uint64_t plan_emitted; // events emitted during placement calibration
 
 #ifdef WS_PTHREADS
      shared_queue_t ** shared_jobq_array;       // a kid's array of job q's (shared_queue_t). needs to be casted
@@ -82,6 +96,7 @@ struct _ws_doutput_t {
 
 typedef struct _ws_proctype_t {
      proc_process_t proc_func;
+     proc_process_batch_t proc_batch_func;
      wsdatatype_t * dtype;
      wslabel_t * port;
      wslabel_t * src_label;
@@ -57,6 +57,8 @@ typedef void (*wsdatatype_delete)(wsdata_t *);
 
 typedef wsdata_t * (*wsdatatype_copy)(wsdata_t *);
 
+typedef void (*wsdatatype_publish)(wsdata_t *);
+
 typedef uint8_t * (*wsdatatype_serialize)(wsdata_t *, int *);
 
 #define WS_PRINTTYPE_TEXT   1
@@ -116,6 +118,9 @@ struct _wsdatatype_t {
      //used to copy isref data
      wsdatatype_copy copy_func;
 
+     //used to publish data held inside a container type (e.g., tuple members)
+     wsdatatype_publish publish_func;
+
      wsdatatype_to_string to_string;
      wsdatatype_to_uint64 to_uint64;
      wsdatatype_to_uint32 to_uint32;
@@ -219,6 +224,8 @@ static inline int wsdtype_build_subelement_list(wsdatatype_t * dtype,
 
 static inline void wsdata_core_init(wsdata_t * wsdata, wsdatatype_t * dtype) {
      wsdata->references = 0;
+     wsdata->owner = GETRANK();
+     wsdata->dep_len = 0;
      wsdata->has_hashloc = 0;
      wsdata->label_len = 0;
      wsdata->writer_label_len = 0;
@@ -229,6 +236,21 @@ static inline void wsdata_core_init(wsdata_t * wsdata, wsdatatype_t * dtype) {
 //allocate & init new data from datatype -- useful for every module
 static inline wsdata_t * wsdata_alloc(wsdatatype_t *);
 
+//drop the references held on parents once data is no longer referenced
+static inline void wsdata_release_dependencies(wsdata_t * wsdata) {
+     int i;
+     for (i = 0; i < wsdata->dep_len; i++) {
+          wsdata->deps[i]->dtype->delete_func(wsdata->deps[i]);
+     }
+     wsdata->dep_len = 0;
+     if (wsdata->dependency) {
+          wsdata_t * parent;
+          while ((parent = (wsdata_t *)wsstack_remove(wsdata->dependency)) != NULL) {
+               parent->dtype->delete_func(parent);
+          }
+     }
+}
+
 static inline wsdata_t * wsdata_get_subelement(wsdata_t * wsd, wssubelement_t * sub) {
      if (!sub || !wsd) {
           return NULL;
@@ -3,6 +3,7 @@
 #define _WSBASE64_H
 
 #include "cppwrap.h"
+#include "wsstrsimd.h"
 
 #ifdef __cplusplus
 CPP_OPEN
@@ -82,7 +83,10 @@ static inline int wsbase64_encode(unsigned char * inbuf, int inbuflen, unsigned
 
      int target = inbuflen / 3;
 
-     for (j = 0; j < target; j++) {
+     //vector encode whole blocks, scalar for the tail
+     inlen = wsstr_b64encode_blocks(inbuf, inbuflen, outbuf, outbuflen, &outlen);
+
+     for (j = inlen / 3; j < target; j++) {
           if (outbuflen >= (outlen + 4)) {
                wsbase64_encodeblock(inbuf + inlen, outbuf + outlen, 3);
                inlen += 3;
@@ -137,6 +141,17 @@ static inline int wsbase64_decode_buffer(unsigned char * inbuf, int inbuflen, un
      int i = 0;
      int j;
      for (j = 0; j < inbuflen; j++) {
+          if (i == 0) {
+               //vector decode runs of clean quads
+               int produced;
+               j += wsstr_b64decode_blocks(inbuf + j, inbuflen - j,
+                                           outbuf + outlen, outbuflen - outlen,
+                                           &produced, 0);
+               outlen += produced;
+               if (j >= inbuflen) {
+                    break;
+               }
+          }
           v = inbuf[j];
           v = (unsigned char) ((v < 43 || v > 122) ? 0 : cd64[ v - 43 ]);
           if (v) {
@@ -178,6 +193,17 @@ static inline int wsbase64_decode_buffer_rfc4648(unsigned char * inbuf, int inbu
      int i = 0;
      int j;
      for (j = 0; j < inbuflen; j++) {
+          if (i == 0) {
+               //vector decode runs of clean quads
+               int produced;
+               j += wsstr_b64decode_blocks(inbuf + j, inbuflen - j,
+                                           outbuf + outlen, outbuflen - outlen,
+                                           &produced, 1);
+               outlen += produced;
+               if (j >= inbuflen) {
+                    break;
+               }
+          }
           v = inbuf[j];
           if (v == '-') {
                v = '+';
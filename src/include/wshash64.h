@@ -0,0 +1,185 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Fast 64-bit hash for in-memory tables.
+//
+// wshash64 is a multiply-mix hash in the style of wyhash: keys of up to
+// 16 bytes take two overlapping loads and one 128-bit multiply, longer keys
+// are consumed 16 bytes at a time, and keys over 48 bytes run three
+// independent lanes so the multiplies overlap in the pipeline.
+//
+// ws_table_hash64 is what hash tables and key hashing use.  It stays
+// evahash64 unless the tree is built with WSHASH_TABLES=1.  Either way,
+// stringhash tables keep the family that placed their keys, so dumps from
+// either hash load in any build.  Only bucket placement carries over: a
+// key that is itself a ws_table_hash64 value (uniq, tuple_find_label_hash
+// callers) differs between the two builds and will not match after
+// switching.  Hashes that leave the process as data (e.g. tuplehash
+// output) are always evahash64.
+
+#ifndef _WSHASH64_H
+#define _WSHASH64_H
+
+#include <stdint.h>
+#include <string.h>
+#include "evahash64.h"
+#include "cppwrap.h"
+
+#ifdef __cplusplus
+CPP_OPEN
+#endif // __cplusplus
+
+#define WSHASH64_S0 0x2d358dccaa6c78a5ULL
+#define WSHASH64_S1 0x8bb84b93962eacc9ULL
+#define WSHASH64_S2 0x4b33a62ed433d4a3ULL
+#define WSHASH64_S3 0x4d5a2da51de1aa47ULL
+
+//full 64x64 -> 128 bit multiply, low half in *a, high half in *b
+static inline void wshash64_mum(uint64_t * a, uint64_t * b) {
+#ifdef __SIZEOF_INT128__
+     __uint128_t r = (__uint128_t)*a * *b;
+     *a = (uint64_t)r;
+     *b = (uint64_t)(r >> 64);
+#else
+     uint64_t ha = *a >> 32, hb = *b >> 32;
+     uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+     uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+     uint64_t t = rl + (rm0 << 32);
+     uint64_t c = t < rl;
+     uint64_t lo = t + (rm1 << 32);
+     c += lo < t;
+     *a = lo;
+     *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t wshash64_mix(uint64_t a, uint64_t b) {
+     wshash64_mum(&a, &b);
+     return a ^ b;
+}
+
+//unaligned little endian loads; memcpy compiles to a single mov
+static inline uint64_t wshash64_r8(const uint8_t * p) {
+     uint64_t v;
+     memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+     v = __builtin_bswap64(v);
+#endif
+     return v;
+}
+
+static inline uint64_t wshash64_r4(const uint8_t * p) {
+     uint32_t v;
+     memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+     v = __builtin_bswap32(v);
+#endif
+     return v;
+}
+
+static inline uint64_t wshash64(const uint8_t * p, uint32_t len,
+                                uint64_t seed) {
+     uint64_t a, b;
+
+     seed ^= wshash64_mix(seed ^ WSHASH64_S0, WSHASH64_S1);
+     if (len <= 16) {
+          if (len >= 4) {
+               //two overlapping 4 byte reads from each end
+               uint32_t mid = (len >> 3) << 2;
+               a = (wshash64_r4(p) << 32) | wshash64_r4(p + mid);
+               b = (wshash64_r4(p + len - 4) << 32) |
+                    wshash64_r4(p + len - 4 - mid);
+          }
+          else if (len > 0) {
+               a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) |
+                    p[len - 1];
+               b = 0;
+          }
+          else {
+               a = b = 0;
+          }
+     }
+     else {
+          uint32_t i = len;
+          if (i > 48) {
+               uint64_t see1 = seed, see2 = seed;
+               do {
+                    seed = wshash64_mix(wshash64_r8(p) ^ WSHASH64_S1,
+                                        wshash64_r8(p + 8) ^ seed);
+                    see1 = wshash64_mix(wshash64_r8(p + 16) ^ WSHASH64_S2,
+                                        wshash64_r8(p + 24) ^ see1);
+                    see2 = wshash64_mix(wshash64_r8(p + 32) ^ WSHASH64_S3,
+                                        wshash64_r8(p + 40) ^ see2);
+                    p += 48;
+                    i -= 48;
+               } while (i > 48);
+               seed ^= see1 ^ see2;
+          }
+          while (i > 16) {
+               seed = wshash64_mix(wshash64_r8(p) ^ WSHASH64_S1,
+                                   wshash64_r8(p + 8) ^ seed);
+               i -= 16;
+               p += 16;
+          }
+          //last 16 bytes, overlapping what was already consumed
+          a = wshash64_r8(p + i - 16);
+          b = wshash64_r8(p + i - 8);
+     }
+     a ^= WSHASH64_S1;
+     b ^= seed;
+     wshash64_mum(&a, &b);
+     return wshash64_mix(a ^ WSHASH64_S0 ^ len, b ^ WSHASH64_S1);
+}
+
+//hash families a table can place its keys with; a table remembers its
+// family, so a dumped table is read back with the hash that wrote it
+#define WS_TABLE_HASH_EVA 0
+#define WS_TABLE_HASH_WS  1
+
+#ifdef WS_WSHASH_TABLES
+#define WS_TABLE_HASH      WS_TABLE_HASH_WS
+#define WS_TABLE_HASH_NAME "wshash64"
+#else
+#define WS_TABLE_HASH      WS_TABLE_HASH_EVA
+#define WS_TABLE_HASH_NAME "evahash64"
+#endif // WS_WSHASH_TABLES
+
+static inline uint64_t ws_table_hash64_family(int family, const void * k,
+                                              uint32_t len, uint32_t seed) {
+     if (family == WS_TABLE_HASH_WS) {
+          return wshash64((const uint8_t *)k, len, seed);
+     }
+     return evahash64((uint8_t *)k, len, seed);
+}
+
+//the family new tables and key hashing use
+static inline uint64_t ws_table_hash64(const void * k, uint32_t len,
+                                       uint32_t seed) {
+     return ws_table_hash64_family(WS_TABLE_HASH, k, len, seed);
+}
+
+#ifdef __cplusplus
+CPP_CLOSE
+#endif // __cplusplus
+
+#endif // _WSHASH64_H
@@ -216,6 +216,18 @@ static inline void * wsheap_insert_replace(wsheap_t *h, void *data) {
      return wsheap_replace_root(h, data);
 }
 
+// removes the smallest element, the returned slot stays valid until the
+// next insert
+static inline void * wsheap_remove_root(wsheap_t *h) {
+     if (!h->count) {
+          return NULL;
+     }
+     h->count--;
+     wsheap_swap(&h->heap[0], &h->heap[h->count]);
+     wsheap_demote(h, 0);
+     return h->heap[h->count];
+}
+
 //destroys heap property
 static inline void wsheap_sort_inplace(wsheap_t *h) {
      uint64_t total = h->count;
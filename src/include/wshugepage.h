@@ -0,0 +1,94 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Huge page backing for large state tables and wsdata_t pools.
+//
+// WATERSLIDE_HUGEPAGES (or -H) selects the page size to ask for:
+//   thp  transparent huge pages: 2MB aligned anonymous maps with
+//        madvise(MADV_HUGEPAGE)
+//   2M   hugetlbfs pages reserved in /proc/sys/vm/nr_hugepages,
+//        falling back to thp
+//   1G   1GB hugetlbfs pages for tables of at least 512MB, then as 2M
+// Every step falls back to the next one and finally to calloc, so a
+// missing reservation only costs performance.  The mode is read once, on
+// first use, so the flag must be given before any table is created.
+//
+// ws_huge_calloc() is used for stringhash tables; memory from it must be
+// released with ws_huge_free().  wsdata_t pool elements are carved from
+// per-thread 2MB slabs by ws_huge_pool_alloc() and are never freed
+// individually; the slabs are released at exit.
+
+#ifndef _WSHUGEPAGE_H
+#define _WSHUGEPAGE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "cppwrap.h"
+
+#ifdef __cplusplus
+CPP_OPEN
+#endif // __cplusplus
+
+enum {
+     WS_HUGE_OFF = 0,
+     WS_HUGE_THP,
+     WS_HUGE_2M,
+     WS_HUGE_1G
+};
+
+#define WS_HUGE_2M_SIZE ((size_t)1 << 21)
+#define WS_HUGE_1G_SIZE ((size_t)1 << 30)
+
+#ifndef TOOL_NAME
+// mode from WATERSLIDE_HUGEPAGES, latched on the first call
+int ws_huge_mode(void);
+
+// zeroed memory for a table of nmemb * size bytes
+void * ws_huge_calloc(size_t /* nmemb */, size_t /* size */);
+void ws_huge_free(void *);
+#else
+// standalone tools are not linked against libwaterslide, so the tables
+// they build from the header-only hashes stay on the plain heap
+static inline void * ws_huge_calloc(size_t nmemb, size_t size) {
+     return calloc(nmemb, size);
+}
+static inline void ws_huge_free(void * ptr) {
+     free(ptr);
+}
+#endif // TOOL_NAME
+
+// pool element from the calling thread's slab; NULL when huge pages are off
+void * ws_huge_pool_alloc(size_t);
+// frees every pool slab; called once at exit after the pools are torn down
+void ws_huge_pool_release(void);
+
+// what was requested and what the kernel actually gave us
+void ws_huge_print(FILE *);
+
+#ifdef __cplusplus
+CPP_CLOSE
+#endif // __cplusplus
+
+#endif // _WSHUGEPAGE_H
@@ -0,0 +1,145 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _WSJOBRING_H
+#define _WSJOBRING_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "waterslide_io.h"
+#include "error_print.h"
+#include "wsmem.h"
+#include "cppwrap.h"
+
+#ifdef __cplusplus
+CPP_OPEN
+#endif // __cplusplus
+
+/* per-thread local job queue: a growable ring of job records stored inline,
+ * so queueing a job is a store into the ring rather than a malloc'd
+ * ws_job_t hung off a linked list node.  Only ever touched by the owning
+ * thread, so there is no locking. */
+
+#define WS_JOBRING_INITIAL 1024 // must be a power of 2
+
+struct _ws_jobring_t {
+     ws_job_t *jobs;
+     uint32_t  head;  /* records removed from here */
+     uint32_t  size;  /* records queued */
+     uint32_t  mask;  /* capacity - 1 */
+};
+
+static inline ws_jobring_t * jobring_init(void)
+{
+     ws_jobring_t * ring = (ws_jobring_t*)calloc(1, sizeof(ws_jobring_t));
+     if (!ring) {
+          error_print("failed jobring_init calloc of ring");
+          return NULL;
+     }
+     ring->jobs = (ws_job_t*)malloc(WS_JOBRING_INITIAL * sizeof(ws_job_t));
+     if (!ring->jobs) {
+          error_print("failed jobring_init malloc of jobs");
+          free(ring);
+          return NULL;
+     }
+     ring->mask = WS_JOBRING_INITIAL - 1;
+     wsmem_add(WSMEM_QUEUE, WS_JOBRING_INITIAL * sizeof(ws_job_t));
+     return ring;
+}
+
+static inline void jobring_exit(ws_jobring_t * ring)
+{
+     if (ring) {
+          free(ring->jobs);
+          free(ring);
+     }
+}
+
+/* double the ring, unwrapping queued records to the front */
+static inline int jobring_grow(ws_jobring_t * ring)
+{
+     uint32_t cap = ring->mask + 1;
+     ws_job_t * jobs = (ws_job_t*)malloc(2 * cap * sizeof(ws_job_t));
+     if (!jobs) {
+          error_print("failed jobring_grow malloc of jobs");
+          return 0;
+     }
+     uint32_t first = cap - ring->head;
+     if (first > ring->size) {
+          first = ring->size;
+     }
+     memcpy(jobs, ring->jobs + ring->head, first * sizeof(ws_job_t));
+     memcpy(jobs + first, ring->jobs, (ring->size - first) * sizeof(ws_job_t));
+     free(ring->jobs);
+     ring->jobs = jobs;
+     ring->head = 0;
+     ring->mask = 2 * cap - 1;
+     wsmem_add(WSMEM_QUEUE, cap * sizeof(ws_job_t));
+     return 1;
+}
+
+/* returns 1 on success, 0 on allocation failure */
+static inline int jobring_add(ws_jobring_t * ring, wsdata_t * data,
+                              ws_subscriber_t * subscribers)
+{
+     if (ring->size > ring->mask) {
+          if (!jobring_grow(ring)) {
+               return 0;
+          }
+     }
+     ws_job_t * job = &ring->jobs[(ring->head + ring->size) & ring->mask];
+     job->data = data;
+     job->subscribers = subscribers;
+     ring->size++;
+     return 1;
+}
+
+/* copies out the oldest job; returns 0 if the ring is empty.  The record
+ * is copied because running it may queue more jobs and grow the ring. */
+static inline int jobring_remove(ws_jobring_t * ring, ws_job_t * job)
+{
+     if (!ring->size) {
+          return 0;
+     }
+     *job = ring->jobs[ring->head];
+     ring->head = (ring->head + 1) & ring->mask;
+     ring->size--;
+     return 1;
+}
+
+/* the oldest job left in place, or NULL if the ring is empty; only valid
+ * until the next add */
+static inline ws_job_t * jobring_peek(ws_jobring_t * ring)
+{
+     if (!ring->size) {
+          return NULL;
+     }
+     return &ring->jobs[ring->head];
+}
+
+#ifdef __cplusplus
+CPP_CLOSE
+#endif // __cplusplus
+
+#endif // _WSJOBRING_H
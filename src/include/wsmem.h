@@ -0,0 +1,91 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Global memory accounting and the -M memory budget.
+//
+// Memory that grows with load is tallied per subsystem as it is reserved:
+// free-list pools of wsdata_t, pooled tuple member arrays, stringhash state
+// tables and the job queues.  The tallies only rise on slow paths (a pool
+// allocating a new element, a table being created, a queue growing), so the
+// hot paths that recycle pooled memory are not touched.  Pools keep what
+// they reserve until exit, so the totals track the RSS that waterslide
+// itself is responsible for.
+//
+// With a budget set, a thread whose accounted total is at or above the
+// budget stops calling its source kids while any emitted data is still in
+// flight in a job queue.  Sources then wait for the graph to drain, and
+// the data already pooled is recycled instead of new elements being
+// reserved.  Kill -USR1 prints the tallies while running.
+
+#ifndef _WSMEM_H
+#define _WSMEM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "cppwrap.h"
+
+#ifdef __cplusplus
+CPP_OPEN
+#endif // __cplusplus
+
+enum {
+     WSMEM_FREELIST = 0, // pooled wsdata_t and their payloads
+     WSMEM_TUPLE,        // pooled tuple member arrays
+     WSMEM_STATE,        // stringhash state tables
+     WSMEM_QUEUE,        // local job rings and failover queues
+     WSMEM_SUBSYSTEMS
+};
+
+extern int64_t wsmem_bytes[WSMEM_SUBSYSTEMS];
+extern uint64_t wsmem_budget;
+extern uint64_t wsmem_throttled;
+extern volatile uint32_t wsmem_report_pending;
+
+static inline void wsmem_add(int subsystem, int64_t bytes) {
+     (void)__sync_fetch_and_add(&wsmem_bytes[subsystem], bytes);
+}
+
+static inline uint64_t wsmem_total(void) {
+     int64_t total = 0;
+     int i;
+     for (i = 0; i < WSMEM_SUBSYSTEMS; i++) {
+          total += wsmem_bytes[i];
+     }
+     return (total > 0) ? (uint64_t)total : 0;
+}
+
+static inline int wsmem_over_budget(void) {
+     return wsmem_budget && (wsmem_total() >= wsmem_budget);
+}
+
+// parses a size such as 512M or 2G into wsmem_budget; returns 0 if invalid
+int wsmem_set_budget(const char *);
+void wsmem_print(FILE *);
+// SIGUSR1 handler; the report is printed from thread 0's run loop
+void wsmem_report_signal(int);
+
+#ifdef __cplusplus
+CPP_CLOSE
+#endif // __cplusplus
+
+#endif // _WSMEM_H
@@ -54,6 +54,11 @@ CPP_OPEN
 #define WSPERF_PROC_COUNT(uid) (kidcount[nrank][uid])++;
 #define WSPERF_FLUSH_COUNT(uid) (flushcount[nrank][uid])++;
 #define WSPERF_TIME(uid) if (!(numcalls[uid]%WSPERF_INTERVAL)) (kidcycle[nrank][uid]) += (get_cycle_count()-mon_base);
+// batch forms: a batch of n calls is sampled when it spans an interval
+// boundary, and charged the per-call share of its time
+#define WSPERF_TIME0_N(uid,n) numcalls[uid]+=(n); if ((numcalls[uid]%WSPERF_INTERVAL) < (uint64_t)(n)) mon_base=get_cycle_count();
+#define WSPERF_PROC_COUNT_N(uid,n) (kidcount[nrank][uid])+=(n);
+#define WSPERF_TIME_N(uid,n) if ((numcalls[uid]%WSPERF_INTERVAL) < (uint64_t)(n)) (kidcycle[nrank][uid]) += (get_cycle_count()-mon_base)/(n);
 #define GET_CYCLE_COUNT() get_cycle_count()
 #define INIT_WSPERF() init_wsperf()
 #define INIT_WSPERF_KID_NAME(uid,name) init_wsperf_kid_name(uid,name)
@@ -68,6 +73,9 @@ CPP_OPEN
 #define WSPERF_PROC_COUNT(uid) 
 #define WSPERF_FLUSH_COUNT(uid) 
 #define WSPERF_TIME(uid) 
+#define WSPERF_TIME0_N(uid,n)
+#define WSPERF_PROC_COUNT_N(uid,n)
+#define WSPERF_TIME_N(uid,n)
 #define GET_CYCLE_COUNT() 0
 #define INIT_WSPERF() 1
 #define INIT_WSPERF_KID_NAME(uid,name) 1
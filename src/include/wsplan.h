@@ -0,0 +1,117 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Profile-guided thread placement.
+//
+// A calibration run (-O) samples how long each kid spends per call and how
+// many events each kid emits.  At exit the graph is partitioned across N
+// threads so that the estimated per-thread load is balanced while the
+// events that must cross a shared queue are kept low, and the result is
+// written out as a graph annotated with %thread() blocks.  The measured
+// profile is saved in the same file so a later run can re-plan for a
+// different thread count (-I) without processing any data.
+
+#ifndef _WSPLAN_H
+#define _WSPLAN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "waterslide.h"
+#include "init.h"
+#include "mimo.h"
+#include "parse_graph.h"
+#include "sysutil.h"
+#include "cppwrap.h"
+
+#ifdef __cplusplus
+CPP_OPEN
+#endif // __cplusplus
+
+// time one in every (WSPLAN_SAMPLE_MASK+1) calls of a kid
+#define WSPLAN_SAMPLE_MASK (0x3f)
+
+// estimated cost of moving one event through a shared queue: the enqueue
+// on the writer and dequeue (plus cache misses) on the reader
+#define WSPLAN_HOP_SEC (250e-9)
+
+// refinement passes over single-kid moves after the greedy assignment
+#define WSPLAN_REFINE_PASSES (16)
+
+// prefix of saved profile lines in a plan file
+#define WSPLAN_PROFILE_TAG "#@kid"
+
+extern uint32_t ws_plan_calibrate;
+
+static inline uint64_t wsplan_now(void) {
+     return sysutil_clock_ns();
+}
+
+// Sampling hooks around a kid's proc_func; these cost a single flag test
+// when no calibration was requested.  With direct dispatch the sampled time
+// includes kids called further down the chain, as with WSPERF.
+#define WSPLAN_LOCAL_INIT() uint64_t plan_base = 0;
+#define WSPLAN_TIME0(pinst) \
+     if (ws_plan_calibrate && \
+         !((pinst)->plan_calls++ & WSPLAN_SAMPLE_MASK)) { \
+          plan_base = wsplan_now(); \
+     }
+#define WSPLAN_TIME(pinst) \
+     if (plan_base) { \
+          (pinst)->plan_ns += wsplan_now() - plan_base; \
+          (pinst)->plan_samples++; \
+          plan_base = 0; \
+     }
+// batch forms: n calls share one timing, sampled when the batch covers a
+// sampling slot
+#define WSPLAN_TIME0_N(pinst,n) \
+     if (ws_plan_calibrate && \
+         ((((pinst)->plan_calls += (n)) - 1) & WSPLAN_SAMPLE_MASK) < \
+         (uint64_t)(n)) { \
+          plan_base = wsplan_now(); \
+     }
+#define WSPLAN_TIME_N(pinst,n) \
+     if (plan_base) { \
+          (pinst)->plan_ns += wsplan_now() - plan_base; \
+          (pinst)->plan_samples += (n); \
+          plan_base = 0; \
+     }
+#define WSPLAN_EMIT(doutput) \
+     if (ws_plan_calibrate) { \
+          (doutput)->plan_emitted++; \
+     }
+
+// copy calibration counters into the parse graph
+void ws_plan_collect(parse_graph_t *);
+
+// read a saved profile into the parse graph; returns number of kids found
+int ws_plan_load_profile(parse_graph_t *, const char *);
+
+// partition the parse graph and write the annotated graph; closes fp
+int ws_plan_write(parse_graph_t *, uint32_t, FILE *);
+
+#ifdef __cplusplus
+CPP_CLOSE
+#endif // __cplusplus
+
+#endif // _WSPLAN_H
@@ -56,6 +56,7 @@ typedef struct _wsprocbuffer_kid_t {
      wsprocbuffer_sub_destroy destroy_func;
      int pass_not_found; // flag to indicate if tuple should be passed if LABEL does not exist in that tuple
      int instance_len;
+     int demand_offset; // where the kid wants its output demand, -1 for none
      char * name;
      char * option_str;
      proc_labeloffset_t * labeloffset;
@@ -84,6 +84,9 @@ proc_process_t wsprockeystate_input_set(void *, wsdatatype_t *, wslabel_t *,
                                         ws_outlist_t*, int, void *);
 int wsprockeystate_destroy(void *);
 
+//batch forms of the processing functions handed out by wsprockeystate_input_set
+extern proc_batch_t wsprockeystate_batch[];
+
 #ifdef __cplusplus
 CPP_CLOSE
 #endif // __cplusplus
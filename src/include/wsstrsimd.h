@@ -0,0 +1,402 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef _WSSTRSIMD_H
+#define _WSSTRSIMD_H
+
+// vectorized byte-string kernels shared by the string transform kids
+// (tr, asciihex, strings, base64 encode/decode).
+//
+// every kernel has a scalar fallback; the vector paths are compiled with
+// per-function target attributes and selected at runtime from the cpu
+// feature bits, so kids do not need special compiler flags.  setting the
+// environment variable WS_NO_SIMD forces the scalar paths.
+//
+// the bulk kernels only ever process whole vector blocks that satisfy the
+// fast-path condition and report how much input they consumed; callers
+// finish with their existing scalar loop so output is byte-identical to the
+// scalar code.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "cppwrap.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define WSSTR_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef __cplusplus
+CPP_OPEN
+#endif // __cplusplus
+
+#define WSSTR_SCALAR 0
+#define WSSTR_SSSE3  1
+#define WSSTR_AVX2   2
+
+#define ENV_WS_NO_SIMD "WS_NO_SIMD"
+
+//returns the best kernel level supported by this cpu, cached after first use
+static inline int wsstr_simd_level(void) {
+#ifdef WSSTR_X86
+     static int level = -1;
+     if (level < 0) {
+          int l = WSSTR_SCALAR;
+          if (!getenv(ENV_WS_NO_SIMD)) {
+               __builtin_cpu_init();
+               if (__builtin_cpu_supports("avx2")) {
+                    l = WSSTR_AVX2;
+               }
+               else if (__builtin_cpu_supports("ssse3")) {
+                    l = WSSTR_SSSE3;
+               }
+          }
+          level = l;
+     }
+     return level;
+#else
+     return WSSTR_SCALAR;
+#endif
+}
+
+static inline int wsstr_isprint(uint8_t c) {
+     return (c >= 0x20) && (c <= 0x7e);
+}
+
+/*-------------------------------------------------------------------------
+ * ascii lowercase: out may equal in
+ *-------------------------------------------------------------------------*/
+#ifdef WSSTR_X86
+__attribute__((target("avx2")))
+static inline int wsstr_tolower_avx2(const uint8_t * in, uint8_t * out, int len) {
+     const __m256i lo = _mm256_set1_epi8('A' - 1);
+     const __m256i hi = _mm256_set1_epi8('Z' + 1);
+     const __m256i bit = _mm256_set1_epi8(0x20);
+     int i = 0;
+     for (; i + 32 <= len; i += 32) {
+          __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+          __m256i m = _mm256_and_si256(_mm256_cmpgt_epi8(v, lo),
+                                       _mm256_cmpgt_epi8(hi, v));
+          _mm256_storeu_si256((__m256i *)(out + i),
+                              _mm256_add_epi8(v, _mm256_and_si256(m, bit)));
+     }
+     return i;
+}
+
+__attribute__((target("sse2")))
+static inline int wsstr_tolower_sse2(const uint8_t * in, uint8_t * out, int len) {
+     const __m128i lo = _mm_set1_epi8('A' - 1);
+     const __m128i hi = _mm_set1_epi8('Z' + 1);
+     const __m128i bit = _mm_set1_epi8(0x20);
+     int i = 0;
+     for (; i + 16 <= len; i += 16) {
+          __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+          __m128i m = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+          _mm_storeu_si128((__m128i *)(out + i),
+                           _mm_add_epi8(v, _mm_and_si128(m, bit)));
+     }
+     return i;
+}
+#endif
+
+static inline void wsstr_tolower(const uint8_t * in, uint8_t * out, int len) {
+     int i = 0;
+#ifdef WSSTR_X86
+     int level = wsstr_simd_level();
+     if (level == WSSTR_AVX2) {
+          i = wsstr_tolower_avx2(in, out, len);
+     }
+     else if (level != WSSTR_SCALAR) {
+          i = wsstr_tolower_sse2(in, out, len);
+     }
+#endif
+     for (; i < len; i++) {
+          uint8_t c = in[i];
+          out[i] = ((c >= 'A') && (c <= 'Z')) ? (c | 0x20) : c;
+     }
+}
+
+/*-------------------------------------------------------------------------
+ * 256-entry table translate: out may equal in
+ *-------------------------------------------------------------------------*/
+static inline void wsstr_translate(const uint8_t * in, uint8_t * out, int len,
+                                   const uint8_t * table) {
+     int i = 0;
+     for (; i + 4 <= len; i += 4) {
+          uint8_t a = table[in[i]];
+          uint8_t b = table[in[i + 1]];
+          uint8_t c = table[in[i + 2]];
+          uint8_t d = table[in[i + 3]];
+          out[i] = a;
+          out[i + 1] = b;
+          out[i + 2] = c;
+          out[i + 3] = d;
+     }
+     for (; i < len; i++) {
+          out[i] = table[in[i]];
+     }
+}
+
+//translate and drop bytes that map to zero; returns output length
+static inline int wsstr_translate_remove(const uint8_t * in, uint8_t * out,
+                                         int len, const uint8_t * table) {
+     int olen = 0;
+     int i;
+     for (i = 0; i < len; i++) {
+          uint8_t t = table[in[i]];
+          out[olen] = t;
+          olen += (t != 0);
+     }
+     return olen;
+}
+
+/*-------------------------------------------------------------------------
+ * printable ascii run scanning (0x20 .. 0x7e, as isprint in the C locale)
+ *-------------------------------------------------------------------------*/
+#ifdef WSSTR_X86
+//returns bitmask of printable bytes in a 32 byte block
+__attribute__((target("avx2")))
+static inline uint32_t wsstr_printmask_avx2(const uint8_t * buf) {
+     __m256i v = _mm256_loadu_si256((const __m256i *)buf);
+     __m256i m = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(0x1f)),
+                                  _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7f), v));
+     return (uint32_t)_mm256_movemask_epi8(m);
+}
+
+__attribute__((target("avx2")))
+static inline int wsstr_span_avx2(const uint8_t * buf, int len, int printable) {
+     uint32_t want = printable ? 0xffffffffU : 0;
+     int i = 0;
+     for (; i + 32 <= len; i += 32) {
+          uint32_t diff = wsstr_printmask_avx2(buf + i) ^ want;
+          if (diff) {
+               return i + __builtin_ctz(diff);
+          }
+     }
+     return i;
+}
+
+__attribute__((target("sse2")))
+static inline int wsstr_span_sse2(const uint8_t * buf, int len, int printable) {
+     uint32_t want = printable ? 0xffffU : 0;
+     int i = 0;
+     for (; i + 16 <= len; i += 16) {
+          __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+          __m128i m = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x1f)),
+                                    _mm_cmplt_epi8(v, _mm_set1_epi8(0x7f)));
+          uint32_t diff = (uint32_t)_mm_movemask_epi8(m) ^ want;
+          if (diff) {
+               return i + __builtin_ctz(diff);
+          }
+     }
+     return i;
+}
+#endif
+
+static inline int wsstr_span(const uint8_t * buf, int len, int printable) {
+     int i = 0;
+#ifdef WSSTR_X86
+     int level = wsstr_simd_level();
+     if (level == WSSTR_AVX2) {
+          i = wsstr_span_avx2(buf, len, printable);
+     }
+     else if (level != WSSTR_SCALAR) {
+          i = wsstr_span_sse2(buf, len, printable);
+     }
+#endif
+     //a vector mismatch stops this loop on its first pass
+     for (; i < len; i++) {
+          if (wsstr_isprint(buf[i]) != printable) {
+               break;
+          }
+     }
+     return i;
+}
+
+//length of leading run of printable bytes
+static inline int wsstr_print_span(const uint8_t * buf, int len) {
+     return wsstr_span(buf, len, 1);
+}
+
+//length of leading run of non-printable bytes
+static inline int wsstr_nonprint_span(const uint8_t * buf, int len) {
+     return wsstr_span(buf, len, 0);
+}
+
+/*-------------------------------------------------------------------------
+ * hex pair decode - decodes 16 byte blocks made up entirely of hex digits
+ * into 8 bytes each; returns number of input bytes consumed
+ *-------------------------------------------------------------------------*/
+#ifdef WSSTR_X86
+__attribute__((target("ssse3")))
+static inline int wsstr_hexdecode_ssse3(const uint8_t * in, int len, uint8_t * out) {
+     const __m128i zero_m1 = _mm_set1_epi8('0' - 1);
+     const __m128i nine_p1 = _mm_set1_epi8('9' + 1);
+     const __m128i a_m1 = _mm_set1_epi8('a' - 1);
+     const __m128i f_p1 = _mm_set1_epi8('f' + 1);
+     const __m128i lcase = _mm_set1_epi8(0x20);
+     const __m128i weights = _mm_set1_epi16(0x0110);
+     int i = 0;
+     for (; i + 16 <= len; i += 16) {
+          __m128i c = _mm_loadu_si128((const __m128i *)(in + i));
+          __m128i l = _mm_or_si128(c, lcase);
+          __m128i isdig = _mm_and_si128(_mm_cmpgt_epi8(c, zero_m1),
+                                        _mm_cmplt_epi8(c, nine_p1));
+          __m128i isalp = _mm_and_si128(_mm_cmpgt_epi8(l, a_m1),
+                                        _mm_cmplt_epi8(l, f_p1));
+          if (_mm_movemask_epi8(_mm_or_si128(isdig, isalp)) != 0xffff) {
+               break;
+          }
+          __m128i val = _mm_or_si128(
+               _mm_and_si128(isdig, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+               _mm_andnot_si128(isdig, _mm_sub_epi8(l, _mm_set1_epi8('a' - 10))));
+          //hi nibble * 16 + lo nibble for each pair
+          __m128i pairs = _mm_maddubs_epi16(val, weights);
+          _mm_storel_epi64((__m128i *)(out + (i >> 1)), _mm_packus_epi16(pairs, pairs));
+     }
+     return i;
+}
+#endif
+
+static inline int wsstr_hexdecode_blocks(const uint8_t * in, int len, uint8_t * out) {
+#ifdef WSSTR_X86
+     if (wsstr_simd_level() != WSSTR_SCALAR) {
+          return wsstr_hexdecode_ssse3(in, len, out);
+     }
+#endif
+     return 0;
+}
+
+/*-------------------------------------------------------------------------
+ * base64 - 12 bytes in / 16 chars out per block.  the decoder only accepts
+ * blocks made up entirely of alphabet characters so padding, line breaks
+ * and noise are left for the caller's scalar loop.  both kernels store a
+ * full 16 bytes, callers must guarantee that much output room.
+ *-------------------------------------------------------------------------*/
+#ifdef WSSTR_X86
+__attribute__((target("ssse3")))
+static inline int wsstr_b64encode_ssse3(const uint8_t * in, int inlen,
+                                        uint8_t * out, int outlen, int * produced) {
+     const __m128i shuf = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                       4, 5, 3, 4, 1, 2, 0, 1);
+     const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '+' - 62,
+                                             '/' - 63, 'A', 0, 0);
+     int i = 0;
+     int o = 0;
+     //16 byte loads, so keep 4 bytes of slack on the input
+     for (; (i + 16 <= inlen) && (o + 16 <= outlen); i += 12, o += 16) {
+          __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+          v = _mm_shuffle_epi8(v, shuf);
+          __m128i t0 = _mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00));
+          __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+          __m128i t2 = _mm_and_si128(v, _mm_set1_epi32(0x003f03f0));
+          __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+          __m128i idx = _mm_or_si128(t1, t3);
+          __m128i r = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+          __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), idx);
+          r = _mm_or_si128(r, _mm_and_si128(less, _mm_set1_epi8(13)));
+          r = _mm_shuffle_epi8(shift_lut, r);
+          _mm_storeu_si128((__m128i *)(out + o), _mm_add_epi8(r, idx));
+     }
+     *produced = o;
+     return i;
+}
+
+__attribute__((target("ssse3")))
+static inline int wsstr_b64decode_ssse3(const uint8_t * in, int inlen,
+                                        uint8_t * out, int outlen, int * produced,
+                                        int urlsafe) {
+     const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+                                          0x1b, 0x1b, 0x1b, 0x1a);
+     const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+                                          0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                          0x10, 0x10, 0x10, 0x10);
+     const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                            0, 0, 0, 0, 0, 0, 0, 0);
+     const __m128i mask_2f = _mm_set1_epi8(0x2f);
+     const __m128i zero = _mm_setzero_si128();
+     int i = 0;
+     int o = 0;
+     for (; (i + 16 <= inlen) && (o + 16 <= outlen); i += 16, o += 12) {
+          __m128i str = _mm_loadu_si128((const __m128i *)(in + i));
+          if (urlsafe) {
+               //map '-' to '+' and '_' to '/'
+               __m128i dash = _mm_cmpeq_epi8(str, _mm_set1_epi8('-'));
+               __m128i uscore = _mm_cmpeq_epi8(str, _mm_set1_epi8('_'));
+               str = _mm_sub_epi8(str, _mm_and_si128(dash, _mm_set1_epi8('-' - '+')));
+               str = _mm_sub_epi8(str, _mm_and_si128(uscore, _mm_set1_epi8('_' - '/')));
+          }
+          __m128i hi_nib = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+          __m128i lo_nib = _mm_and_si128(str, mask_2f);
+          __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nib);
+          __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nib);
+          if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), zero)) != 0xffff) {
+               break;
+          }
+          __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f);
+          __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nib));
+          str = _mm_add_epi8(str, roll);
+          //pack four 6-bit values into three bytes
+          str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+          str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+          str = _mm_shuffle_epi8(str, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                                    14, 13, 12, -1, -1, -1, -1));
+          _mm_storeu_si128((__m128i *)(out + o), str);
+     }
+     *produced = o;
+     return i;
+}
+#endif
+
+static inline int wsstr_b64encode_blocks(const uint8_t * in, int inlen,
+                                         uint8_t * out, int outlen, int * produced) {
+#ifdef WSSTR_X86
+     if (wsstr_simd_level() != WSSTR_SCALAR) {
+          return wsstr_b64encode_ssse3(in, inlen, out, outlen, produced);
+     }
+#endif
+     *produced = 0;
+     return 0;
+}
+
+static inline int wsstr_b64decode_blocks(const uint8_t * in, int inlen,
+                                         uint8_t * out, int outlen, int * produced,
+                                         int urlsafe) {
+#ifdef WSSTR_X86
+     if (wsstr_simd_level() != WSSTR_SCALAR) {
+          return wsstr_b64decode_ssse3(in, inlen, out, outlen, produced, urlsafe);
+     }
+#endif
+     *produced = 0;
+     return 0;
+}
+
+#ifdef __cplusplus
+CPP_CLOSE
+#endif // __cplusplus
+
+#endif // _WSSTRSIMD_H
@@ -39,6 +39,7 @@ SOFTWARE.
 #include "datatypes/wsdt_tinystring.h"
 #include "datatypes/wsdt_flush.h"
 #include "datatypes/wsdt_mmap.h"
+#include "datatypes/wsdt_extbuf.h"
 #include "datatypes/wsdt_uint.h"
 #include "datatypes/wsdt_uint64.h"
 #include "datatypes/wsdt_uint16.h"
@@ -86,6 +87,7 @@ EXT wsdatatype_t * dtype_monitor;
 EXT wsdatatype_t * dtype_labelset;
 EXT wsdatatype_t * dtype_label;
 EXT wsdatatype_t * dtype_mmap;
+EXT wsdatatype_t * dtype_extbuf;
 EXT wsdatatype_t * dtype_flush;
 EXT wsdatatype_t * dtype_array_uint;
 EXT wsdatatype_t * dtype_array_double;
@@ -1029,3 +1029,253 @@ void ac_free(ahoc_t *ac)
      if(ac->root) FreeTreeHelper(ac->root);
      free(ac);
 }
+
+/* saved tree image: a header, then every node in breadth-first order with
+ * its fail node and children given as node numbers, so a finalized tree
+ * can be rebuilt without re-reading keywords or recomputing fail nodes */
+#define AC_IMAGE_MAGIC   0x31434157  /* "WAC1" */
+
+typedef struct _ac_node_index_t {
+     treenode_t * node;
+     uint32_t     id;
+} ac_node_index_t;
+
+static int ac_node_index_cmp(const void * a, const void * b)
+{
+     const treenode_t * na = ((const ac_node_index_t *)a)->node;
+     const treenode_t * nb = ((const ac_node_index_t *)b)->node;
+     return (na < nb) ? -1 : (na > nb);
+}
+
+static uint32_t ac_node_id(ac_node_index_t * index, uint32_t cnt,
+                           treenode_t * node)
+{
+     ac_node_index_t key;
+     ac_node_index_t * found;
+
+     key.node = node;
+     found = (ac_node_index_t *)bsearch(&key, index, cnt,
+                                        sizeof(ac_node_index_t),
+                                        ac_node_index_cmp);
+     return found ? found->id : 0;
+}
+
+int ac_save(ahoc_t *ac, FILE *fp)
+{
+     treenode_t **order;
+     ac_node_index_t *index;
+     uint32_t cap = 1024, cnt = 1, head, id, len;
+     uint32_t magic = AC_IMAGE_MAGIC;
+     uint16_t nlinks;
+     int c, rtn = 0;
+
+     if(!ac || !ac->root) {
+          return 0;
+     }
+     order = (treenode_t **) malloc(cap * sizeof(treenode_t *));
+     if (!order) {
+          error_print("failed ac_save malloc of order");
+          return 0;
+     }
+     order[0] = ac->root;
+     for(head = 0; head < cnt; head++) {
+          for(c = 0; c < NUMCHAR; c++) {
+               if(!order[head]->nodes[c]) {
+                    continue;
+               }
+               if (cnt == cap) {
+                    treenode_t **grow = (treenode_t **) realloc(order,
+                                             2 * cap * sizeof(treenode_t *));
+                    if (!grow) {
+                         error_print("failed ac_save realloc of order");
+                         free(order);
+                         return 0;
+                    }
+                    order = grow;
+                    cap *= 2;
+               }
+               order[cnt++] = order[head]->nodes[c];
+          }
+     }
+
+     index = (ac_node_index_t *) malloc(cnt * sizeof(ac_node_index_t));
+     if (!index) {
+          error_print("failed ac_save malloc of index");
+          free(order);
+          return 0;
+     }
+     for(id = 0; id < cnt; id++) {
+          index[id].node = order[id];
+          index[id].id = id;
+     }
+     qsort(index, cnt, sizeof(ac_node_index_t), ac_node_index_cmp);
+
+     fwrite(&magic, sizeof(uint32_t), 1, fp);
+     fwrite(&ac->max_shift, sizeof(uint32_t), 1, fp);
+     fwrite(ac->cshift, sizeof(uint32_t), NUMCHAR, fp);
+     fwrite(&ac->max_pattern_len, sizeof(uint32_t), 1, fp);
+     fwrite(&ac->case_insensitive, sizeof(uint8_t), 1, fp);
+     fwrite(&ac->below_threshold, sizeof(uint8_t), 1, fp);
+     fwrite(&cnt, sizeof(uint32_t), 1, fp);
+
+     for(id = 0; id < cnt; id++) {
+          treenode_t *cur = order[id];
+          uint32_t fail = ac_node_id(index, cnt, cur->fail_node);
+          uint8_t has_match = cur->match ? 1 : 0;
+
+          fwrite(&cur->alpha, sizeof(u_char), 1, fp);
+          fwrite(&cur->buflen, sizeof(uint8_t), 1, fp);
+          fwrite(&fail, sizeof(uint32_t), 1, fp);
+          fwrite(&has_match, sizeof(uint8_t), 1, fp);
+          if (has_match) {
+               len = cur->match->key ? strlen((char *)cur->match->key) : 0;
+               fwrite(&cur->match->keymapval, sizeof(int), 1, fp);
+               fwrite(&cur->match->len, sizeof(int), 1, fp);
+               fwrite(&len, sizeof(uint32_t), 1, fp);
+               fwrite(cur->match->key, 1, len, fp);
+          }
+          /* the children field wraps at 256, so count the links written */
+          nlinks = 0;
+          for(c = 0; c < NUMCHAR; c++) {
+               if(cur->nodes[c]) {
+                    nlinks++;
+               }
+          }
+          fwrite(&cur->children, sizeof(uint8_t), 1, fp);
+          fwrite(&nlinks, sizeof(uint16_t), 1, fp);
+          for(c = 0; c < NUMCHAR; c++) {
+               if(cur->nodes[c]) {
+                    uint8_t alpha = (uint8_t)c;
+                    uint32_t child = ac_node_id(index, cnt, cur->nodes[c]);
+                    fwrite(&alpha, sizeof(uint8_t), 1, fp);
+                    fwrite(&child, sizeof(uint32_t), 1, fp);
+               }
+          }
+     }
+     rtn = !ferror(fp);
+
+     free(index);
+     free(order);
+     return rtn;
+}
+
+#define AC_READ(ptr, size, n) \
+     if (fread((ptr), (size), (n), fp) != (size_t)(n)) goto bad_image;
+
+int ac_load(ahoc_t *ac, FILE *fp)
+{
+     treenode_t **nodes = NULL;
+     uint32_t magic, cnt = 0, id, fail, len, child;
+     uint16_t nlinks, i;
+     uint8_t has_match, alpha;
+     ahoc_t hdr;
+
+     if(!ac || !ac->root || ac->root->children) {
+          error_print("ac_load needs an initialized, empty Aho-Corasick tree");
+          return 0;
+     }
+
+     AC_READ(&magic, sizeof(uint32_t), 1);
+     if (magic != AC_IMAGE_MAGIC) {
+          return 0;
+     }
+     AC_READ(&hdr.max_shift, sizeof(uint32_t), 1);
+     AC_READ(hdr.cshift, sizeof(uint32_t), NUMCHAR);
+     AC_READ(&hdr.max_pattern_len, sizeof(uint32_t), 1);
+     AC_READ(&hdr.case_insensitive, sizeof(uint8_t), 1);
+     AC_READ(&hdr.below_threshold, sizeof(uint8_t), 1);
+     AC_READ(&cnt, sizeof(uint32_t), 1);
+     if (!cnt) {
+          return 0;
+     }
+
+     nodes = (treenode_t **) calloc(cnt, sizeof(treenode_t *));
+     if (!nodes) {
+          error_print("failed ac_load calloc of nodes");
+          return 0;
+     }
+     nodes[0] = ac->root;
+     for(id = 1; id < cnt; id++) {
+          nodes[id] = (treenode_t *) calloc(1, sizeof(treenode_t));
+          if (!nodes[id]) {
+               error_print("failed ac_load calloc of node");
+               goto bad_image;
+          }
+     }
+
+     for(id = 0; id < cnt; id++) {
+          treenode_t *cur = nodes[id];
+          AC_READ(&cur->alpha, sizeof(u_char), 1);
+          AC_READ(&cur->buflen, sizeof(uint8_t), 1);
+          AC_READ(&fail, sizeof(uint32_t), 1);
+          if (fail >= cnt) {
+               goto bad_image;
+          }
+          cur->fail_node = nodes[fail];
+          AC_READ(&has_match, sizeof(uint8_t), 1);
+          if (has_match) {
+               cur->match = (term_info_t *) calloc(1, sizeof(term_info_t));
+               if (!cur->match) {
+                    error_print("failed ac_load calloc of match");
+                    goto bad_image;
+               }
+               AC_READ(&cur->match->keymapval, sizeof(int), 1);
+               AC_READ(&cur->match->len, sizeof(int), 1);
+               AC_READ(&len, sizeof(uint32_t), 1);
+               cur->match->key = (u_char *) calloc(1, len + 1);
+               if (!cur->match->key) {
+                    error_print("failed ac_load calloc of key");
+                    goto bad_image;
+               }
+               AC_READ(cur->match->key, 1, len);
+          }
+          AC_READ(&cur->children, sizeof(uint8_t), 1);
+          AC_READ(&nlinks, sizeof(uint16_t), 1);
+          if (nlinks > NUMCHAR) {
+               goto bad_image;
+          }
+          for(i = 0; i < nlinks; i++) {
+               AC_READ(&alpha, sizeof(uint8_t), 1);
+               AC_READ(&child, sizeof(uint32_t), 1);
+               if (!child || (child >= cnt)) {
+                    goto bad_image;
+               }
+               cur->nodes[alpha] = nodes[child];
+          }
+     }
+
+     ac->max_shift = hdr.max_shift;
+     memcpy(ac->cshift, hdr.cshift, sizeof(hdr.cshift));
+     ac->max_pattern_len = hdr.max_pattern_len;
+     ac->case_insensitive = hdr.case_insensitive;
+     ac->below_threshold = hdr.below_threshold;
+     ac_search = ac->below_threshold ? &ac_searchstr_skip : &ac_searchstr;
+
+     free(nodes);
+     return 1;
+
+bad_image:
+     /* unhook whatever was attached to the root, then free every node */
+     if (nodes) {
+          memset(ac->root->nodes, 0, sizeof(ac->root->nodes));
+          ac->root->children = 0;
+          if (ac->root->match) {
+               free(ac->root->match->key);
+               free(ac->root->match);
+               ac->root->match = NULL;
+          }
+          ac->root->fail_node = ac->root;
+          for(id = 1; id < cnt; id++) {
+               if (nodes[id]) {
+                    if (nodes[id]->match) {
+                         free(nodes[id]->match->key);
+                         free(nodes[id]->match);
+                    }
+                    free(nodes[id]);
+               }
+          }
+          free(nodes);
+     }
+     error_print("ac_load found a truncated or corrupt tree image");
+     return 0;
+}
@@ -446,6 +446,7 @@ void* ASTKidList::dispatch(ASTDispatch &target)       { return target.processNod
 void* ASTVar::dispatch(ASTDispatch &target)           { return target.processNode(*this); }
 void* ASTVarList::dispatch(ASTDispatch &target)       { return target.processNode(*this); }
 void* ASTThreadDecl::dispatch(ASTDispatch &target)    { return target.processNode(*this); }
+void* ASTReplicateDecl::dispatch(ASTDispatch &target) { return target.processNode(*this); }
 void* ASTFuncDecl::dispatch(ASTDispatch &target)      { return target.processNode(*this); }
 void* ASTFuncCall::dispatch(ASTDispatch &target)      { return target.processNode(*this); }
 void* ASTPipeline::dispatch(ASTDispatch &target)      { return target.processNode(*this); }
@@ -433,6 +433,30 @@ public:
 };
 
 
+/* %replicate(N, KEY...) { ... }: N copies of the body, each on its own
+ * thread, with input streams hash partitioned on the KEY labels */
+class ASTReplicateDecl : public ASTNode
+{
+public:
+     ASTReplicateDecl(long long count) : ASTNode(), count(count) { }
+     ~ASTReplicateDecl() {
+          while ( !keys.empty() ) {
+               free(keys.back());
+               keys.pop_back();
+          }
+     }
+     virtual void *dispatch(ASTDispatch &target);
+     virtual void repr() { snprintf(reprBuf, 255, "Replicate(%lld)", count); }
+     void addKey(char *key) { keys.push_back(key); }
+     void setBody(ASTNode *body) { addChild(body); }
+     const std::list<char *>& getKeys() const { return keys; }
+     long long count;
+     ASTStatementList* getBody() { return static_cast<ASTStatementList*>(children[0]); }
+protected:
+     std::list<char *> keys;
+};
+
+
 class ASTFuncDecl : public ASTNode
 {
 public:
@@ -601,6 +625,7 @@ struct ASTDispatch {
      virtual void* processNode(ASTVar &node)           { return NULL; }
      virtual void* processNode(ASTVarList &node)       { return NULL; }
      virtual void* processNode(ASTThreadDecl &node)    { return NULL; }
+     virtual void* processNode(ASTReplicateDecl &node) { return NULL; }
      virtual void* processNode(ASTFuncDecl &node)      { return NULL; }
      virtual void* processNode(ASTFuncCall &node)      { return NULL; }
      virtual void* processNode(ASTPipeline &node)      { return NULL; }
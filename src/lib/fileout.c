@@ -657,7 +657,7 @@ file_cycle(fpdata_t *fpdata, wsdata_t *input, filespec_t *fs, time_t tm)
      // deal with timecycle first...
      if (fs->timespec) {
 	  if (!tm) {
-	       tm = time(NULL); // get current time
+	       tm = sysutil_time(); // get current time
 	  }
 	  currenttime = tm - (tm % fs->timeslice);
      }
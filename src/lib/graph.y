@@ -40,13 +40,13 @@ uint32_t gInFuncDecl = 0;
 
 %token INCLUDE
 %token LPAREN RPAREN LBRACE RBRACE PERIOD COLON ENDSTMT ATSIGN
-%token THREAD FUNC EXTERN DOUBLEPIPE PIPE ATDOUBLEPIPE COMMA ARROW PERCENT
+%token THREAD REPLICATE FUNC EXTERN DOUBLEPIPE PIPE ATDOUBLEPIPE COMMA ARROW PERCENT
 %token <sval> WORD STRINGLIT VARREF
 %token <ival> NUMBER
 %left WORD NUMBER STRINGLIT
 %type <ival> pipe_sep
 %type <node> statement_list scoped_statements statement
-%type <node> thread_decl func_decl func_header func_call extern_decl pipeline pipe_source
+%type <node> thread_decl replicate_decl replicate_header func_decl func_header func_call extern_decl pipeline pipe_source
 %type <node> sourceVars sourceVar varList varRef kid_list sinkVar kid_def
 %type <node> optSourceVars optVarList
 %type <sval> varFilter
@@ -66,6 +66,7 @@ scoped_statements:  LBRACE statement_list RBRACE { $$ = $2; }
                  ;
 
 statement: thread_decl { $$ = $1; }
+         | replicate_decl { $$ = $1; }
          | func_decl { $$ = $1; }
          | func_call { $$ = $1; }
          | extern_decl { $$ = $1; }
@@ -82,6 +83,13 @@ thread_decl: THREAD LPAREN NUMBER COMMA NUMBER RPAREN scoped_statements { unsign
            | THREAD LPAREN NUMBER RPAREN scoped_statements { $$ = new ASTThreadDecl($3, false, $5); }
            ;
 
+replicate_decl: replicate_header RPAREN scoped_statements { ((ASTReplicateDecl*)$1)->setBody($3); $$ = $1; }
+              ;
+
+replicate_header: REPLICATE LPAREN NUMBER { $$ = new ASTReplicateDecl($3); }
+                | replicate_header COMMA WORD { ((ASTReplicateDecl*)$1)->addKey($3); $$ = $1; }
+                ;
+
 extern_decl: EXTERN varList {
                     ASTVarList *l = (ASTVarList*)$2;
                     for ( size_t n = 0 ; n < l->childCount() ; n++ ) {
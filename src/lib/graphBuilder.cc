@@ -20,6 +20,7 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
+#include <set>
 #include "ast.h"
 #include "graph.tab.hh"
 #include "wsqueue.h"
@@ -66,6 +67,31 @@ class GraphBuilder {
      };
 
 
+     /* Largest user thread id, so %replicate can place its replicas on
+      * threads that no %thread block uses */
+     struct ThreadCounter : public ASTWalker {
+          unsigned long long maxTid;
+          ThreadCounter() : maxTid(0) { }
+          virtual void operator()(ASTNode *n) {
+               ASTThreadDecl *t = dynamic_cast<ASTThreadDecl*>(n);
+               if ( t && !t->twoD && t->tid > maxTid ) maxTid = t->tid;
+          }
+     };
+
+
+     /* Streams written by the pipelines inside a block */
+     struct SinkCollector : public ASTWalker {
+          std::set<parse_node_var_t*> vars;
+          virtual void operator()(ASTNode *n) {
+               ASTPipeline *p = dynamic_cast<ASTPipeline*>(n);
+               if ( p && !p->getSink()->isNull() ) {
+                    StreamVar *svar = p->getSink()->getStreamVar();
+                    if ( svar ) vars.insert(svar->getParseNode());
+               }
+          }
+     };
+
+
      struct Dispatcher : public ASTDispatch {
           parse_graph_t *pg;
           SymbolTable *symtab;
@@ -77,12 +103,26 @@ class GraphBuilder {
           std::map<std::string, int> funcCounts;
           uint32_t tempStreamCount;
 
-          Dispatcher(parse_graph_t *pg) : ASTDispatch(), pg(pg), debug(false)
+          /* %replicate state */
+          ASTReplicateDecl *replicate;
+          uint32_t replica;
+          uint32_t replicateCount;
+          unsigned long long replicaThreadBase;
+          unsigned long long outerContext;
+          std::map<std::string, parse_node_proc_t*> partitioners;
+          std::set<parse_node_var_t*> replicaSinks;
+
+          Dispatcher(parse_graph_t *pg, unsigned long long threadBase) : ASTDispatch(), pg(pg), debug(false)
           {
                errors = 0;
                thread_context = -1;
                twoD_placement = false;
                tempStreamCount = 0;
+               replicate = NULL;
+               replica = 0;
+               replicateCount = 0;
+               replicaThreadBase = threadBase;
+               outerContext = -1;
                symtab = getGB()->symtab;
                symtab->setParseGraph(pg);
           }
@@ -112,6 +152,11 @@ class GraphBuilder {
           void* processNode(ASTThreadDecl &node)
           {
                if ( debug ) fprintf(stderr, "GB Dispatch: processNode(ASTThreadDecl)\n");
+               if ( replicate ) {
+                    error_print("%%thread cannot be used inside %%replicate; each replica has its own thread");
+                    errors++;
+                    return NULL;
+               }
                thread_context = node.tid;
                twoD_placement = node.twoD;
 
@@ -123,6 +168,133 @@ class GraphBuilder {
           }
 
 
+          void* processNode(ASTReplicateDecl &node)
+          {
+               if ( debug ) fprintf(stderr, "GB Dispatch: processNode(ASTReplicateDecl)\n");
+               if ( replicate ) {
+                    error_print("%%replicate blocks cannot be nested");
+                    errors++;
+                    return NULL;
+               }
+               if ( node.count < 1 ) {
+                    error_print("%%replicate needs a replica count of at least 1");
+                    errors++;
+                    return NULL;
+               }
+               /* without keys the partitioner would deal events round robin,
+                * splitting the state of every keyed kid across replicas */
+               if ( node.getKeys().empty() ) {
+                    error_print("%%replicate(%lld) needs at least one KEY label to partition on",
+                                node.count);
+                    errors++;
+                    return NULL;
+               }
+
+               /* streams written inside the block stay inside each replica,
+                * so they cannot also be read there */
+               SinkCollector sinks;
+               node.getBody()->walk(sinks);
+               replicaSinks = sinks.vars;
+
+               replicate = &node;
+               outerContext = thread_context;
+               partitioners.clear();
+               for ( replica = 0 ; replica < (uint32_t)node.count ; replica++ ) {
+                    thread_context = replicaThreadBase++;
+                    node.getBody()->dispatch(*this);
+               }
+
+               thread_context = outerContext;
+               replicate = NULL;
+               replicaSinks.clear();
+               replicateCount++;
+               return NULL;
+          }
+
+
+          /* Partitioning kid for one input stream of a %replicate block.
+           * Every partitioner of a block uses the same seed, so a key
+           * lands on the same replica no matter which input it comes from. */
+          parse_node_proc_t* replicaPartitioner(ASTVar *var, StreamVar *svar)
+          {
+               std::string key = var->getFullName();
+               if ( var->getFilter() ) {
+                    key += ".";
+                    key += var->getFilter();
+               }
+               parse_node_proc_t *proc = partitioners[key];
+               if ( proc ) return proc;
+
+               const char *kidName = "loadbalance";
+               uint32_t version = procCounts[kidName]++;
+               char mungedName[64];
+               snprintf(mungedName, 63, "%s.%d", kidName, version);
+               proc = (parse_node_proc_t*)listhash_find_attach(pg->procs, mungedName, strlen(mungedName));
+
+               const std::list<char *> &keys = replicate->getKeys();
+               char count[32], prefix[32];
+               snprintf(count, sizeof(count), "%lld", replicate->count);
+               snprintf(prefix, sizeof(prefix), "REPLICA%u_", replicateCount);
+
+               proc->name = strdup(kidName);
+               proc->version = version;
+               proc->thread_context = outerContext;
+               proc->argv = (char**)calloc(7 + keys.size(), sizeof(char*));
+               proc->argc = 0;
+               proc->argv[proc->argc++] = strdup(kidName);
+               proc->argv[proc->argc++] = strdup("-N");
+               proc->argv[proc->argc++] = strdup(count);
+               proc->argv[proc->argc++] = strdup("-L");
+               proc->argv[proc->argc++] = strdup(prefix);
+               proc->argv[proc->argc++] = strdup("-s");
+               proc->argv[proc->argc++] = strdup("1");
+               for ( std::list<char*>::const_iterator i = keys.begin() ; i != keys.end() ; ++i ) {
+                    proc->argv[proc->argc++] = strdup(*i);
+               }
+
+               parse_edge_t *edge = (parse_edge_t*)calloc(1, sizeof(parse_edge_t));
+               if ( !edge ) { errors++; return NULL; }
+               edge->edgetype = PARSE_EDGE_TYPE_VARPROC;
+               edge->src = svar->getParseNode();
+               edge->src_label = var->getFilter();
+               edge->dst = proc;
+               edge->thread_context = outerContext;
+               queue_add(pg->edges, edge);
+
+               partitioners[key] = proc;
+               return proc;
+          }
+
+
+          void createReplicaEdge(ASTVar *var, StreamVar *svar, ASTKidDef *kid)
+          {
+               if ( replicaSinks.count(svar->getParseNode()) ) {
+                    error_print("stream %s is both written and read inside %%replicate; "
+                                "only streams from outside the block can be partitioned",
+                                var->getName());
+                    errors++;
+                    return;
+               }
+               parse_node_proc_t *part = replicaPartitioner(var, svar);
+               if ( !part ) return;
+
+               char label[48];
+               snprintf(label, sizeof(label), "REPLICA%u_%u", replicateCount, replica);
+
+               parse_edge_t *edge = (parse_edge_t*)calloc(1, sizeof(parse_edge_t));
+               if ( !edge ) { errors++; return; }
+               edge->edgetype = PARSE_EDGE_TYPE_PROCPROC;
+               edge->src = part;
+               edge->dst = kid->getParseNode();
+               edge->src_label = strdup(label);
+               edge->port = var->getTargetPort();
+               if ( kid->getSourcePort() )
+                    edge->port = kid->getSourcePort();
+               edge->thread_context = thread_context;
+               queue_add(pg->edges, edge);
+          }
+
+
           void* processNode(ASTFuncDecl &node)
           {
                if ( debug ) fprintf(stderr, "GB Dispatch: processNode(ASTFuncDecl)\n");
@@ -164,12 +336,9 @@ class GraphBuilder {
           }
 
 
-          void createVarProcEdge(ASTVar *var, ASTKidDef *kid)
+          void createVarProcEdge(ASTVar *var, ASTKidDef *kid, bool partition=true)
           {
                if ( debug ) fprintf(stderr, "GB Dispatch: CreateVarProcEdge\n");
-               parse_edge_t *edge = (parse_edge_t*)calloc(1, sizeof(parse_edge_t));
-               if ( !edge ) { errors++; return; }
-
                StreamVar *svar = symtab->findStreamVariable(var);
                if ( !svar ) {
                     error_print("Unable to find stream Variable %s", var->getFullName());
@@ -177,6 +346,14 @@ class GraphBuilder {
                     return;
                }
 
+               if ( replicate && partition ) {
+                    createReplicaEdge(var, svar, kid);
+                    return;
+               }
+
+               parse_edge_t *edge = (parse_edge_t*)calloc(1, sizeof(parse_edge_t));
+               if ( !edge ) { errors++; return; }
+
                edge->edgetype = PARSE_EDGE_TYPE_VARPROC;
                edge->src = svar->getParseNode();
                edge->src_label = var->getFilter();
@@ -253,7 +430,7 @@ class GraphBuilder {
 
                ASTVar *sourceVar = new ASTVar(strdup(tempStreamName), symtab);
                sourceVar->setSource(target);
-               createVarProcEdge(sourceVar, target);
+               createVarProcEdge(sourceVar, target, false);
 
                sinkVar->deregisterStream();
                delete sinkVar;
@@ -467,7 +644,10 @@ public:
 		pg->vars = listhash_create(PARSE_GRAPH_MAXLIST, sizeof(parse_node_var_t));
 		pg->procs = listhash_create(PARSE_GRAPH_MAXLIST, sizeof(parse_node_proc_t));
 
-          Dispatcher builder(pg);
+          ThreadCounter threads;
+          astRoot->walk(threads);
+
+          Dispatcher builder(pg, threads.maxTid + 1);
           astRoot->dispatch(builder);
           if ( !builder.success() ) {
                error_print("Failed to build graph from AST");
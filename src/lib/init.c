@@ -226,6 +226,22 @@ static int add_uniq_sub(ws_subscriber_t ** list, ws_subscriber_t * sub) {
      return 1;
 }
 
+// find the batch form a kid exported for one of its processing functions
+static proc_process_batch_t ws_find_batch_func(ws_proc_module_t * module,
+                                               proc_process_t proc_func) {
+     proc_batch_t * bt;
+
+     if (!module->batch_table) {
+          return NULL;
+     }
+     for (bt = module->batch_table; bt->proc_func; bt++) {
+          if (bt->proc_func == proc_func) {
+               return bt->batch_func;
+          }
+     }
+     return NULL;
+}
+
 static int ws_init_instance_input(mimo_t * mimo, ws_outtype_t * ocursor, 
                            wslabel_t * port, wslabel_t * src_label,
                            ws_proc_instance_t * dst, ws_proc_instance_t * src,
@@ -261,6 +277,7 @@ static int ws_init_instance_input(mimo_t * mimo, ws_outtype_t * ocursor,
                     return 0;
                }
                sub->proc_func = ptcursor->proc_func;
+               sub->proc_batch_func = ptcursor->proc_batch_func;
                sub->input_index = ptcursor->input_index;
                sub->port = port;
                sub->src_label = src_label;
@@ -312,12 +329,14 @@ static int ws_init_instance_input(mimo_t * mimo, ws_outtype_t * ocursor,
           //there is now at least one kid that does this in proc_input_set
           save_proc_name(dst->name);
 
+          wslabel_set_recorder(&dst->label_reads);
           proc_func = dst->module->proc_input_set_f(dst->instance,
                                                     ocursor->dtype,
                                                     port,
                                                     &dst->output_type_list,
                                                     dst->input_index,
                                                     &mimo->datalists);
+          wslabel_set_recorder(NULL);
           
 //fprintf(stderr,"proc_input_set_f returned proc_func %p dst->name %s ocursor->dtype %p\n",proc_func,dst->name,ocursor->dtype);
           if (!proc_func) {
@@ -353,6 +372,8 @@ static int ws_init_instance_input(mimo_t * mimo, ws_outtype_t * ocursor,
                }
                queue_add(mimo->subs, sub);
                sub->proc_func = proc_func;
+               sub->proc_batch_func = ws_find_batch_func(dst->module,
+                                                         proc_func);
                sub->input_index = dst->input_index;
                sub->port = port;
                sub->src_label = src_label;
@@ -391,6 +412,7 @@ static int ws_init_instance_input(mimo_t * mimo, ws_outtype_t * ocursor,
                }
                queue_add(mimo->subs, pt);
                pt->proc_func = proc_func;
+               pt->proc_batch_func = sub->proc_batch_func;
                pt->dtype = ocursor->dtype;
                pt->port = port;
                pt->input_index = dst->input_index;
@@ -652,6 +674,89 @@ static int ws_init_from_sources(mimo_t * mimo) {
      return 1;
 }
 
+// add the labels read by kids downstream of subs to demand,
+// returns 0 if any of them may read every label
+static int ws_walk_label_demand(ws_subscriber_t * subs,
+                                ws_label_demand_t * demand, uint32_t walk) {
+     ws_subscriber_t * sub;
+     for (sub = subs; sub; sub = sub->next) {
+          ws_proc_instance_t * dst = sub->proc_instance;
+          if (sub->sink || !dst || (dst->kid.reads == WSKID_READS_ALL)) {
+               return 0;
+          }
+          if (dst->demand_walk == walk) {
+               continue;
+          }
+          dst->demand_walk = walk;
+          if (!wslabel_demand_merge(demand, &dst->label_reads)) {
+               return 0;
+          }
+          if ((dst->kid.reads != WSKID_READS_LABELS) ||
+              !dst->output_type_list.outtype_q) {
+               continue;
+          }
+          q_node_t * qnode;
+          for (qnode = dst->output_type_list.outtype_q->head; qnode;
+               qnode = qnode->next) {
+               ws_outtype_t * otype = (ws_outtype_t *)qnode->data;
+               if (!ws_walk_label_demand(otype->local_subscribers, demand,
+                                         walk) ||
+                   !ws_walk_label_demand(otype->ext_subscribers, demand,
+                                         walk)) {
+                    return 0;
+               }
+          }
+     }
+     return 1;
+}
+
+static void ws_set_label_demand(mimo_t * mimo, ws_outtype_t * otype,
+                                ws_proc_instance_t * src) {
+     static uint32_t walk;
+     ws_label_demand_t * demand =
+          (ws_label_demand_t *)calloc(1, sizeof(ws_label_demand_t));
+     if (!demand) {
+          error_print("failed ws_set_label_demand calloc of demand");
+          return;
+     }
+     walk++;
+     if (!ws_walk_label_demand(otype->local_subscribers, demand, walk) ||
+         !ws_walk_label_demand(otype->ext_subscribers, demand, walk)) {
+          wslabel_demand_free(demand);
+          free(demand);
+          return;
+     }
+     otype->demand = demand;
+     if (mimo->verbose) {
+          uint32_t i, cnt = 0;
+          for (i = 0; i < demand->nbits / 64; i++) {
+               cnt += __builtin_popcountll(demand->bits[i]);
+          }
+          status_print("%s.%d output reads only %u labels", src->name,
+                       src->version, cnt);
+     }
+}
+
+// work out which labels are read downstream of each output so decoders can
+// skip building members nobody looks at
+static void ws_init_label_demand(mimo_t * mimo) {
+     ws_proc_instance_t * cursor;
+     for (cursor = mimo->proc_instance_head; cursor; cursor = cursor->next) {
+          if (!cursor->output_type_list.outtype_q) {
+               continue;
+          }
+          q_node_t * qnode;
+          for (qnode = cursor->output_type_list.outtype_q->head; qnode;
+               qnode = qnode->next) {
+               ws_set_label_demand(mimo, (ws_outtype_t *)qnode->data, cursor);
+          }
+     }
+     ws_source_list_t * scursor;
+     for (scursor = mimo->proc_sources; scursor; scursor = scursor->next) {
+          ws_set_label_demand(mimo, &scursor->outtype, scursor->pinstance);
+     }
+}
+
 static void ws_print_flush(mimo_t * mimo) {
 
      int i;
@@ -732,6 +837,7 @@ int ws_init_proc_graph(mimo_t * mimo) {
                             cursor->thread_id);
                }
                optind = 1; // reset argument reader...
+               wslabel_set_recorder(&cursor->label_reads);
                //check if specialty kid
                if (cursor->module->pbkid) {
                     if (!wsprocbuffer_init(cursor->argc, cursor->argv,
@@ -766,6 +872,7 @@ int ws_init_proc_graph(mimo_t * mimo) {
                          return 0;
                     }
                }
+               wslabel_set_recorder(NULL);
           }
      } 
 
@@ -794,11 +901,13 @@ int ws_init_proc_graph(mimo_t * mimo) {
 
           if (NULL == cursor->module->proc_init_finish_f) continue;
 
+          wslabel_set_recorder(&cursor->label_reads);
           if (!cursor->module->proc_init_finish_f(cursor->instance)) {
                error_print("proc_init_finish() initializing kid: '%s'\n",
                        cursor->name);
                return 0;
           }
+          wslabel_set_recorder(NULL);
      }
 
      // Ensure final proc initialized before any source initialization occurs
@@ -815,6 +924,7 @@ int ws_init_proc_graph(mimo_t * mimo) {
                ws_print_flush(mimo);
           }
           ws_init_from_monitors(mimo);
+          ws_init_label_demand(mimo);
 
           // compute the number of threads with sources
           int thread_index;
@@ -829,6 +939,7 @@ int ws_init_proc_graph(mimo_t * mimo) {
           // at this point.  Shared queue writers are reported here and
           // queue types RESET to single-writer-single-reader as needed
           REPORT_SHQ_WRITERS(mimo);
+          REPORT_NUMA_PLACEMENT(mimo);
      }
 
      // sync up here between preprocessing phases
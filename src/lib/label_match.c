@@ -28,10 +28,14 @@ SOFTWARE.
 #include <stdio.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <limits.h>
+#include <inttypes.h>
 #include "ahocorasick.h"
 #include "label_match.h"
 #include "waterslide.h"
 #include "sysutil.h"
+#include "status_print.h"
+#include "shared/getrank.h"
 
 //change hex string into character string
 static int process_hex_string(char * matchstr, int matchlen) {
@@ -205,9 +209,232 @@ ahoc_t * label_match_finalize(label_match_t * task) {
      return task->ac_struct;
 }
 
+static label_match_src_t * label_match_queue(label_match_t * task) {
+     label_match_src_t * src =
+          (label_match_src_t *)calloc(1, sizeof(label_match_src_t));
+     if (!src) {
+          error_print("failed label_match_queue calloc of src");
+          return NULL;
+     }
+     if (task->src_tail) {
+          task->src_tail->next = src;
+     }
+     else {
+          task->src_head = src;
+     }
+     task->src_tail = src;
+     return src;
+}
+
+int label_match_queue_file(label_match_t * task, const char * thefile) {
+     label_match_src_t * src = label_match_queue(task);
+     if (!src) {
+          return 0;
+     }
+     src->file = strdup(thefile);
+     return (src->file != NULL);
+}
+
+int label_match_queue_string(label_match_t * task, const char * str, int len,
+                             const char * label) {
+     label_match_src_t * src = label_match_queue(task);
+     if (!src) {
+          return 0;
+     }
+     //keep a terminator, ac_loadkeyword copies the keyword as a string
+     src->str = (char *)calloc(1, len + 1);
+     if (!src->str) {
+          error_print("failed label_match_queue_string calloc of str");
+          return 0;
+     }
+     memcpy(src->str, str, len);
+     src->len = len;
+     if (label) {
+          src->label = strdup(label);
+     }
+     return 1;
+}
+
+static void label_match_free_sources(label_match_t * task) {
+     label_match_src_t * src = task->src_head;
+     while (src) {
+          label_match_src_t * next = src->next;
+          free(src->file);
+          free(src->str);
+          free(src->label);
+          free(src);
+          src = next;
+     }
+     task->src_head = NULL;
+     task->src_tail = NULL;
+}
+
+#define LABEL_MATCH_CACHE_MAGIC 0x314d4c57  // "WLM1"
+
+static inline uint64_t label_match_fnv(uint64_t h, const void * buf,
+                                       size_t len) {
+     const uint8_t * p = (const uint8_t *)buf;
+     size_t i;
+     for (i = 0; i < len; i++) {
+          h ^= p[i];
+          h *= 0x100000001b3ULL;
+     }
+     return h;
+}
+
+// key over everything that shapes the built table; 0 if a file is missing
+static uint64_t label_match_cache_key(label_match_t * task) {
+     uint64_t h = 0xcbf29ce484222325ULL;
+     label_match_src_t * src;
+     char buf[65536];
+     size_t n;
+
+     h = label_match_fnv(h, &task->ac_struct->case_insensitive,
+                         sizeof(uint8_t));
+     for (src = task->src_head; src; src = src->next) {
+          if (src->file) {
+               uint64_t flen = 0;
+               FILE * fp = sysutil_config_fopen(src->file, "r");
+               if (!fp) {
+                    return 0;
+               }
+               h = label_match_fnv(h, "F", 1);
+               while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+                    h = label_match_fnv(h, buf, n);
+                    flen += n;
+               }
+               sysutil_config_fclose(fp);
+               h = label_match_fnv(h, &flen, sizeof(uint64_t));
+          }
+          else {
+               h = label_match_fnv(h, "R", 1);
+               h = label_match_fnv(h, &src->len, sizeof(int));
+               h = label_match_fnv(h, src->str, src->len);
+               if (src->label) {
+                    h = label_match_fnv(h, src->label, strlen(src->label) + 1);
+               }
+               else {
+                    h = label_match_fnv(h, "", 1);
+               }
+          }
+     }
+     return h ? h : 1;
+}
+
+static int label_match_cache_load(label_match_t * task, const char * path,
+                                  uint64_t key) {
+     FILE * fp;
+     uint32_t magic, nlabels, i;
+     uint64_t fkey;
+     uint16_t len;
+     char name[65536];
+
+     if ((fp = fopen(path, "r")) == NULL) {
+          return 0;
+     }
+     if ((fread(&magic, sizeof(uint32_t), 1, fp) != 1) ||
+         (magic != LABEL_MATCH_CACHE_MAGIC) ||
+         (fread(&fkey, sizeof(uint64_t), 1, fp) != 1) || (fkey != key) ||
+         (fread(&nlabels, sizeof(uint32_t), 1, fp) != 1)) {
+          fclose(fp);
+          return 0;
+     }
+     //labels go back in their saved order so keymap values still line up
+     for (i = 1; i <= nlabels; i++) {
+          if ((fread(&len, sizeof(uint16_t), 1, fp) != 1) ||
+              (fread(name, 1, len, fp) != len)) {
+               fclose(fp);
+               return 0;
+          }
+          name[len] = '\0';
+          if (label_match_make_label(task, name) != (int)i) {
+               fclose(fp);
+               return 0;
+          }
+     }
+     if (!ac_load(task->ac_struct, fp)) {
+          fclose(fp);
+          return 0;
+     }
+     fclose(fp);
+     return 1;
+}
+
+// written under a private name and renamed so readers never see a partial
+// file, even with several kids or runs saving the same table
+static void label_match_cache_save(label_match_t * task, const char * path,
+                                   uint64_t key) {
+     char tmp[PATH_MAX + 64];
+     FILE * fp;
+     uint32_t magic = LABEL_MATCH_CACHE_MAGIC;
+     uint32_t nlabels = task->label_cnt - 1;
+     uint32_t i;
+     int ok;
+
+     snprintf(tmp, sizeof(tmp), "%s.%d.%d.tmp", path, (int)getpid(),
+              (int)GETRANK());
+     if ((fp = fopen(tmp, "w")) == NULL) {
+          error_print("unable to write match table cache %s", tmp);
+          return;
+     }
+     fwrite(&magic, sizeof(uint32_t), 1, fp);
+     fwrite(&key, sizeof(uint64_t), 1, fp);
+     fwrite(&nlabels, sizeof(uint32_t), 1, fp);
+     for (i = 1; i <= nlabels; i++) {
+          uint16_t len = (uint16_t)strlen(task->label[i]->name);
+          fwrite(&len, sizeof(uint16_t), 1, fp);
+          fwrite(task->label[i]->name, 1, len, fp);
+     }
+     ok = ac_save(task->ac_struct, fp);
+     if (fclose(fp) || !ok || rename(tmp, path)) {
+          error_print("unable to write match table cache %s", path);
+          unlink(tmp);
+     }
+}
+
+ahoc_t * label_match_build(label_match_t * task) {
+     const char * dir = getenv(ENV_WS_CACHE_DIR);
+     char path[PATH_MAX];
+     uint64_t key = 0;
+     label_match_src_t * src;
+
+     if (dir && dir[0] && task->src_head) {
+          key = label_match_cache_key(task);
+     }
+     if (key) {
+          snprintf(path, sizeof(path), "%s/label_match-%016" PRIx64 ".wsac",
+                   dir, key);
+          if (label_match_cache_load(task, path, key)) {
+               status_print("label_match loaded cached table %s", path);
+               label_match_free_sources(task);
+               return task->ac_struct;
+          }
+     }
+
+     for (src = task->src_head; src; src = src->next) {
+          if (src->file) {
+               if (label_match_loadfile(task, src->file)) {
+                    status_print("label_match read file %s", src->file);
+               }
+          }
+          else {
+               int lid = src->label ? label_match_make_label(task, src->label) : 0;
+               ac_loadkeyword(task->ac_struct, src->str, src->len, lid);
+          }
+     }
+     label_match_free_sources(task);
+     ac_finalize(task->ac_struct);
+
+     if (key) {
+          label_match_cache_save(task, path, key);
+     }
+     return task->ac_struct;
+}
+
 void label_match_destroy(label_match_t * task) {
      if (task) {
           ac_free(task->ac_struct);
+          label_match_free_sources(task);
 
           free(task);
      }
@@ -26,6 +26,7 @@ SOFTWARE.
 #include "waterslide.h"
 #include "waterslidedata.h"
 #include "waterslide_io.h"
+#include "wsjobring.h"
 #include "so_loader.h"
 #include "sysutil.h"
 #include "shared/shared_queue.h"
@@ -33,6 +34,9 @@ SOFTWARE.
 #include "mimo.h"
 #include "wsprocess.h"
 #include "wsperf.h"
+#include "wsplan.h"
+#include "wsmem.h"
+#include "wshugepage.h"
 #include "parse_graph.h"
 #include "init.h"
 #include "shared/getrank.h"
@@ -54,12 +58,16 @@ uint32_t ready_to_flush = 0, ready_to_exit = 0;
 uint32_t spinning_on_jobs = 0;
 uint32_t flushes_aborted = 0;
 uint32_t graph_has_cycle = 0;
+uint32_t ws_direct_dispatch = 0; // call same-thread subscribers depth-first
+uint32_t wsdata_refs_shared = 0; // kids share state, no biased refcounts
+uint32_t ws_plan_calibrate = 0; // sample kid costs for thread placement
 extern uint32_t work_size;
 #ifdef WS_PTHREADS
 pthread_mutexattr_t mutex_attr;
 WS_MUTEX_DECL(startlock);
 WS_MUTEX_DECL(endgame_lock);
 WS_MUTEX_DECL(exit_lock);
+WS_MUTEX_DECL(label_lock);
 mimo_work_order_t ** arglist;
 pthread_t ** thread;
 __thread int thread_rank;
@@ -94,16 +102,11 @@ mimo_t * mimo_init(void) {
      mimo->verbose = 0;
 
      // alloc and init job queues
-     mimo->jobq = (nhqueue_t **)calloc(1, sizeof(nhqueue_t *));
+     mimo->jobq = (ws_jobring_t **)calloc(1, sizeof(ws_jobring_t *));
      if (!mimo->jobq) {
           error_print("failed mimo_init calloc of mimo->jobq");
           return 0;
      }
-     mimo->jobq_freeq = (nhqueue_t **)calloc(1, sizeof(nhqueue_t *));
-     if (!mimo->jobq_freeq) {
-          error_print("failed mimo_init calloc of mimo->jobq_freeq");
-          return 0;
-     }
      mimo->sink_freeq = (nhqueue_t **)calloc(1, sizeof(nhqueue_t *));
      if (!mimo->sink_freeq) {
           error_print("failed mimo_init calloc of mimo->sink_freeq");
@@ -111,14 +114,9 @@ mimo_t * mimo_init(void) {
      }
 
      i = 0;
-     mimo->jobq[i] = queue_init();
+     mimo->jobq[i] = jobring_init();
      if (!mimo->jobq[i]) {
-          error_print("failed mimo_init queue_init of mimo->jobq");
-          return NULL;
-     }
-     mimo->jobq_freeq[i] = queue_init();
-     if (!mimo->jobq_freeq[i]) {
-          error_print("failed mimo_init queue_init of mimo->jobq_freeq");
+          error_print("failed mimo_init jobring_init of mimo->jobq");
           return NULL;
      }
 
@@ -161,18 +159,12 @@ int mimo_init_localq(mimo_t * mimo) {
      int i;
 
      // Realloc the following to their full size (cf. mimo_init())
-     mimo->jobq = (nhqueue_t **)realloc(mimo->jobq,
-                                        work_size*sizeof(nhqueue_t *));
+     mimo->jobq = (ws_jobring_t **)realloc(mimo->jobq,
+                                           work_size*sizeof(ws_jobring_t *));
      if (!mimo->jobq) {
           error_print("failed realloc of mimo->jobq");
           return 0;
      }
-     mimo->jobq_freeq = (nhqueue_t **)realloc(mimo->jobq_freeq,
-                                              work_size*sizeof(nhqueue_t *));
-     if (!mimo->jobq_freeq) {
-          error_print("failed realloc of mimo->jobq_freeq");
-          return 0;
-     }
      mimo->sink_freeq = (nhqueue_t **)realloc(mimo->sink_freeq,
                                               work_size*sizeof(nhqueue_t *));
      if (!mimo->sink_freeq) {
@@ -181,17 +173,9 @@ int mimo_init_localq(mimo_t * mimo) {
      }
 
      for(i = 1; i < work_size; i++) {
-          mimo->jobq[i] = queue_init();
+          mimo->jobq[i] = jobring_init();
           if (!mimo->jobq[i]) {
-               error_print("failed queue_init of mimo->jobq[i]");
-               return 0;
-          }
-     }
-
-     for(i = 1; i < work_size; i++) {
-          mimo->jobq_freeq[i] = queue_init();
-          if (!mimo->jobq_freeq[i]) {
-               error_print("failed queue_init of mimo->jobq_freeq[i]");
+               error_print("failed jobring_init of mimo->jobq[i]");
                return 0;
           }
      }
@@ -247,6 +231,9 @@ int mimo_destroy(mimo_t* mimo) {
           mimo_print_deprecated(mimo);
           // clean up the rest of the parsed graph stuff
           mimo_cleanup_pg(mimo->parsed_graph);
+          if (mimo->plan_profile) {
+               free(mimo->plan_profile);
+          }
 
           // free misc. sysutil stuff
           free_sysutil_pConfigPath();
@@ -288,8 +275,7 @@ int mimo_destroy(mimo_t* mimo) {
           // free mimo queues
           int i;
           for(i = 0; i < work_size; i++) {
-               queue_exit(mimo->jobq[i]);
-               queue_exit(mimo->jobq_freeq[i]);
+               jobring_exit(mimo->jobq[i]);
                queue_exit(mimo->sink_freeq[i]);
 #ifdef WS_PTHREADS
                if(mimo->tg->num_scc) {
@@ -299,7 +285,6 @@ int mimo_destroy(mimo_t* mimo) {
 #endif // WS_PTHREADS
           }
           free(mimo->jobq);
-          free(mimo->jobq_freeq);
           free(mimo->sink_freeq);
 #ifdef WS_PTHREADS
           for(i = 0; i < mimo->tg->num_scc; i++) {
@@ -535,6 +520,19 @@ int mimo_compile_graph(mimo_t * mimo) {
           exit(0);
      }
 
+     if (mimo->plan_fp && mimo->plan_profile) {
+          if (!ws_plan_load_profile(mimo->parsed_graph, mimo->plan_profile)) {
+               error_print("no kids of this graph found in profile %s",
+                           mimo->plan_profile);
+               return 0;
+          }
+          ws_plan_write(mimo->parsed_graph, mimo->plan_threads, mimo->plan_fp);
+          fprintf(stderr,"exiting graph after compile.. placement only\n");
+          pg_cleanup();
+          exit(0);
+     }
+     ws_plan_calibrate = (mimo->plan_fp != NULL);
+
      tmp = optind;
      load_parsed_graph(mimo, mimo->parsed_graph);
      optind = tmp;
@@ -624,6 +622,18 @@ int mimo_compile_graph_internal(mimo_t * mimo) {
 
      // mimo is not modified by verify_procs_have_inputs().  If mimo must be
      // modified here, then we must ensure the function is thread-safe!
+     if(0 == nrank && ws_huge_mode() != WS_HUGE_OFF) {
+          ws_huge_print(stderr);
+     }
+
+     if(0 == nrank && wsmem_budget) {
+          wsmem_print(stderr);
+          if (wsmem_bytes[WSMEM_STATE] >= (int64_t)wsmem_budget) {
+               error_print("state tables alone exceed the memory budget; "
+                           "reduce WS_STATESTORE_MAX or the kids' table sizes");
+          }
+     }
+
      if(0 == nrank) {
           pg_cleanup();
           mimo_print_deprecated(mimo);
@@ -714,6 +724,10 @@ void mimo_set_noexitflush(mimo_t * mimo) {
      mimo->no_flush_on_exit = 1;
 }
 
+void mimo_set_direct_dispatch(mimo_t * mimo) {
+     ws_direct_dispatch = 1;
+}
+
 // let the user collect data from the data sink..
 void * mimo_collect_data(mimo_sink_t * sink, char * dtype_name) {
      wsdata_t * wsdata;
@@ -733,6 +747,18 @@ void mimo_output_graphviz(mimo_t * mimo, FILE * fp) {
      mimo->graphviz_fp = fp;
 }
 
+void mimo_output_placement(mimo_t * mimo, FILE * fp, uint32_t nthreads) {
+     mimo->plan_fp = fp;
+     mimo->plan_threads = nthreads;
+}
+
+void mimo_set_placement_profile(mimo_t * mimo, const char * profile) {
+     if (mimo->plan_profile) {
+          free(mimo->plan_profile);
+     }
+     mimo->plan_profile = strdup(profile);
+}
+
 void mimo_output_p_graphviz(mimo_t * mimo, FILE * fp) {
      mimo->graphviz_p_fp = fp;
 }
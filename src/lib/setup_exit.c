@@ -33,6 +33,9 @@ SOFTWARE.
 #include "shared/getrank.h"
 #include "shared/barrier_init.h"
 #include "wsperf.h"
+#include "wsplan.h"
+#include "wsmem.h"
+#include "wshugepage.h"
 #include "shared/lock_init.h"
 #include "shared/ws_init_threading.h"
 #include "shared/wsperf_global.h"
@@ -80,6 +83,10 @@ void setup_exit_signals(void) {
      sigaction(SIGQUIT, action, NULL);      // kill -3
      sigaction(SIGABRT, action, NULL);      // kill -6
 
+     // kill -USR1 reports memory use without stopping
+     action->sa_handler = wsmem_report_signal;
+     sigaction(SIGUSR1, action, NULL);
+
      free(action);
 }
 
@@ -113,6 +120,13 @@ int ws_cleanup(mimo_t * mimo) {
           free_sht_registry();
      }
 
+     if (0 == nrank && (wsmem_budget || mimo->verbose)) {
+          wsmem_print(stderr);
+     }
+     if (0 == nrank && ws_huge_mode() != WS_HUGE_OFF) {
+          ws_huge_print(stderr);
+     }
+
      // print profiling summary (if activated internally by WSPERF)
      if (!PRINT_WSPERF(mimo)) {
           return 0;
@@ -127,6 +141,12 @@ int ws_cleanup(mimo_t * mimo) {
           wsprint_graph_dot(mimo->parsed_graph,mimo->graphviz_p_fp);
      }
 
+     // partition the graph using what was measured during this run
+     if (0 == nrank && mimo->plan_fp) {
+          ws_plan_collect(mimo->parsed_graph);
+          ws_plan_write(mimo->parsed_graph, mimo->plan_threads, mimo->plan_fp);
+     }
+
      // save verbose and valgrind_dbg flags for use after mimo is destroyed
      uint32_t verbose = mimo->verbose;
      uint32_t valgrind_dbg = mimo->valgrind_dbg;
@@ -163,6 +183,7 @@ int ws_cleanup(mimo_t * mimo) {
 
           FREE_THREADID_STUFF();
           FREE_WSPERF();
+          ws_huge_pool_release();
 
           // free dlopen file handles...unless we are trying to run Valgrind
           // in which case we need the trace information for the datatypes
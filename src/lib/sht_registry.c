@@ -28,6 +28,7 @@ SOFTWARE.
 #include "stringhash9a.h"
 #include "sht_expire_cnt.h"
 #include "sht_registry.h"
+#include "wsmem.h"
 
 #define MAX_CHARS_TYPE 12 // space for longest table type: sh9a_shared
 #define MAX_CHARS_NAME 28 // space for longest kid name: keyadd_initial_custom_shared
@@ -121,7 +122,8 @@ int move_sht_to_local_registry(void * sht, int * index) {
           return 0;
      }
      else {
-          // enroll as a local hash table
+          // enroll as a local hash table; enrolling tallies the size again
+          wsmem_add(WSMEM_STATE, -(int64_t)sh_registry[*index].size);
           save_proc_name(sh_registry[*index].sh_kidname);
           if(!enroll_in_sht_registry(sht, sh_registry[*index].sh_type, sh_registry[*index].size, 
                            sh_registry[*index].hash_seed)) {
@@ -214,6 +216,7 @@ int enroll_shared_in_sht_registry(void * sht, const char * sh_type, const char *
 
      sh_registry[n_sh_register].sht = sht;
      sh_registry[n_sh_register].size = size;
+     wsmem_add(WSMEM_STATE, size);
      // sh3, which has no hash seed, is not a shared hash table, so the following is ok
      sh_registry[n_sh_register].hash_seed = hash_seed;
      sh_registry[n_sh_register].sh_type = (char *)calloc(MAX_CHARS_TYPE, sizeof(char));
@@ -289,6 +292,7 @@ int enroll_in_sht_registry(void * sht, const char * sh_type, const uint64_t size
 
      loc_registry[nrank][n_loc_registered].sht = sht;
      loc_registry[nrank][n_loc_registered].size = size;
+     wsmem_add(WSMEM_STATE, size);
      loc_registry[nrank][n_loc_registered].sh_type = (char *)calloc(MAX_CHARS_TYPE, sizeof(char));
      // sh3 has no hash_seed
      if (strncmp(sh_type, "sh3", 3) == 0) {
@@ -0,0 +1,375 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// spill store for stringhash tables.  See sht_spill.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "waterslide.h"
+#include "sht_spill.h"
+
+// index slots per table record; up to three quarters of them are used, so
+// a table can spill six times what it holds in memory
+#define SPILL_SLOTS_PER_RECORD 8
+
+#define SPILL_HASH1 0x9E3779B97F4A7C15ULL
+#define SPILL_HASH2 0xC2B2AE3D27D4EB4FULL
+
+typedef struct _spill_slot_t {
+     uint64_t id; // 0 when the slot is empty
+     uint64_t rec; // position of the record in the log
+} spill_slot_t;
+
+struct _sht_spill_t {
+     size_t record_len;
+     int log_fd;
+     uint64_t log_recs; // record positions handed out so far
+
+     int index_fd;
+     void * map;
+     size_t map_len;
+     spill_slot_t * index;
+     uint32_t index_bits;
+     uint64_t mask;
+     uint32_t * free_recs; // positions given back by takes
+     uint64_t free_cnt;
+     uint64_t live;
+     uint64_t max_live;
+
+     uint8_t * bloom;
+     uint32_t bloom_bits;
+     uint64_t bloom_stale; // removals since the filter was rebuilt
+
+     uint64_t puts;
+     uint64_t takes;
+     uint64_t full;
+     uint64_t bloom_skips;
+};
+
+static int spill_tmpfile(const char * dir, const char * what) {
+     char path[1024];
+     snprintf(path, sizeof(path), "%s/ws_spill_%s.XXXXXX", dir, what);
+     int fd = mkstemp(path);
+     if (fd < 0) {
+          error_print("unable to create spill file in %s", dir);
+          return -1;
+     }
+     // nothing else needs the name, and the space goes away with us
+     unlink(path);
+     return fd;
+}
+
+static inline uint64_t spill_home(sht_spill_t * sp, uint64_t id) {
+     return (id * SPILL_HASH1) >> (64 - sp->index_bits);
+}
+
+static inline void spill_bloom_bits(sht_spill_t * sp, uint64_t id,
+                                    uint64_t * b) {
+     uint64_t h1 = id * SPILL_HASH1;
+     uint64_t h2 = id * SPILL_HASH2;
+     b[0] = h1 >> (64 - sp->bloom_bits);
+     b[1] = h2 >> (64 - sp->bloom_bits);
+     b[2] = (h1 ^ (h2 >> 17)) & ((1ULL << sp->bloom_bits) - 1);
+}
+
+static inline void spill_bloom_add(sht_spill_t * sp, uint64_t id) {
+     uint64_t b[3];
+     int i;
+     spill_bloom_bits(sp, id, b);
+     for (i = 0; i < 3; i++) {
+          sp->bloom[b[i] >> 3] |= 1 << (b[i] & 7);
+     }
+}
+
+static inline int spill_bloom_test(sht_spill_t * sp, uint64_t id) {
+     uint64_t b[3];
+     int i;
+     spill_bloom_bits(sp, id, b);
+     for (i = 0; i < 3; i++) {
+          if (!(sp->bloom[b[i] >> 3] & (1 << (b[i] & 7)))) {
+               return 0;
+          }
+     }
+     return 1;
+}
+
+// removals leave bits set behind them; rebuild from the index once they
+// could account for a good share of the filter
+static void spill_bloom_rebuild(sht_spill_t * sp) {
+     memset(sp->bloom, 0, (size_t)1 << (sp->bloom_bits - 3));
+     uint64_t i;
+     if (sp->live) {
+          for (i = 0; i <= sp->mask; i++) {
+               if (sp->index[i].id) {
+                    spill_bloom_add(sp, sp->index[i].id);
+               }
+          }
+     }
+     sp->bloom_stale = 0;
+}
+
+sht_spill_t * sht_spill_open(size_t record_len, uint64_t records) {
+     const char * dir = getenv(ENV_WS_SPILL_DIR);
+     if (!dir || !dir[0] || !record_len) {
+          return NULL;
+     }
+     sht_spill_t * sp = (sht_spill_t *)calloc(1, sizeof(sht_spill_t));
+     if (!sp) {
+          error_print("failed sht_spill_open calloc of sp");
+          return NULL;
+     }
+     sp->record_len = record_len;
+     sp->index_bits = 10;
+     while (((uint64_t)1 << sp->index_bits) <
+            records * SPILL_SLOTS_PER_RECORD) {
+          sp->index_bits++;
+     }
+     sp->mask = ((uint64_t)1 << sp->index_bits) - 1;
+     sp->max_live = (sp->mask + 1) / 4 * 3;
+     if (sp->max_live > UINT32_MAX) {
+          sp->max_live = UINT32_MAX;
+     }
+
+     // one byte of filter per slot: ~11 bits per key at full load
+     sp->bloom_bits = sp->index_bits + 3;
+     sp->bloom = (uint8_t *)calloc((size_t)1 << sp->index_bits, 1);
+
+     sp->log_fd = spill_tmpfile(dir, "log");
+     sp->index_fd = spill_tmpfile(dir, "index");
+     sp->map_len = (sp->mask + 1) * sizeof(spill_slot_t) +
+          sp->max_live * sizeof(uint32_t);
+     if (!sp->bloom || (sp->log_fd < 0) || (sp->index_fd < 0) ||
+         (ftruncate(sp->index_fd, sp->map_len) != 0)) {
+          error_print("failed to set up spill store in %s", dir);
+          sht_spill_close(sp);
+          return NULL;
+     }
+     sp->map = mmap(NULL, sp->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    sp->index_fd, 0);
+     if (sp->map == MAP_FAILED) {
+          error_print("failed to map spill index in %s", dir);
+          sp->map = NULL;
+          sht_spill_close(sp);
+          return NULL;
+     }
+     sp->index = (spill_slot_t *)sp->map;
+     sp->free_recs = (uint32_t *)(sp->index + sp->mask + 1);
+
+     status_print("spilling %zu byte records to %s, up to %" PRIu64,
+                  record_len, dir, sp->max_live);
+     return sp;
+}
+
+void sht_spill_close(sht_spill_t * sp) {
+     if (!sp) {
+          return;
+     }
+     if (sp->puts) {
+          status_print("spill store: %" PRIu64 " spilled, %" PRIu64
+                       " read back, %" PRIu64 " dropped when full, %"
+                       PRIu64 " misses skipped by filter",
+                       sp->puts, sp->takes, sp->full, sp->bloom_skips);
+     }
+     if (sp->map) {
+          munmap(sp->map, sp->map_len);
+     }
+     if (sp->index_fd >= 0) {
+          close(sp->index_fd);
+     }
+     if (sp->log_fd >= 0) {
+          close(sp->log_fd);
+     }
+     free(sp->bloom);
+     free(sp);
+}
+
+static inline int64_t spill_find(sht_spill_t * sp, uint64_t id) {
+     uint64_t i = spill_home(sp, id);
+     while (sp->index[i].id) {
+          if (sp->index[i].id == id) {
+               return (int64_t)i;
+          }
+          i = (i + 1) & sp->mask;
+     }
+     return -1;
+}
+
+// linear probing delete: pull later entries of the run back into the hole
+static void spill_delete_slot(sht_spill_t * sp, uint64_t pos) {
+     sp->free_recs[sp->free_cnt++] = (uint32_t)sp->index[pos].rec;
+     uint64_t hole = pos;
+     uint64_t i = (pos + 1) & sp->mask;
+     while (sp->index[i].id) {
+          uint64_t home = spill_home(sp, sp->index[i].id);
+          if (((i - home) & sp->mask) >= ((i - hole) & sp->mask)) {
+               sp->index[hole] = sp->index[i];
+               hole = i;
+          }
+          i = (i + 1) & sp->mask;
+     }
+     sp->index[hole].id = 0;
+     sp->live--;
+
+     if (!sp->live) {
+          sht_spill_clear(sp);
+     }
+     else if (++sp->bloom_stale > sp->max_live / 2) {
+          spill_bloom_rebuild(sp);
+     }
+}
+
+int sht_spill_put(sht_spill_t * sp, uint64_t id, void * record) {
+     int64_t pos = spill_find(sp, id);
+     uint64_t rec;
+     if (pos >= 0) {
+          rec = sp->index[pos].rec;
+     }
+     else if (sp->live >= sp->max_live) {
+          sp->full++;
+          return 0;
+     }
+     else {
+          rec = sp->free_cnt ? sp->free_recs[--sp->free_cnt] : sp->log_recs++;
+     }
+     if (pwrite(sp->log_fd, record, sp->record_len,
+                (off_t)(rec * sp->record_len)) != (ssize_t)sp->record_len) {
+          error_print("failed writing spilled record");
+          if (pos < 0) {
+               sp->free_recs[sp->free_cnt++] = (uint32_t)rec;
+          }
+          return 0;
+     }
+     if (pos < 0) {
+          uint64_t i = spill_home(sp, id);
+          while (sp->index[i].id) {
+               i = (i + 1) & sp->mask;
+          }
+          sp->index[i].id = id;
+          sp->index[i].rec = rec;
+          sp->live++;
+          spill_bloom_add(sp, id);
+     }
+     sp->puts++;
+     return 1;
+}
+
+// bloom filter first, so keys that were never spilled stay off the index
+static inline int64_t spill_lookup(sht_spill_t * sp, uint64_t id) {
+     if (!sp->live) {
+          return -1;
+     }
+     if (!spill_bloom_test(sp, id)) {
+          sp->bloom_skips++;
+          return -1;
+     }
+     return spill_find(sp, id);
+}
+
+int sht_spill_contains(sht_spill_t * sp, uint64_t id) {
+     return spill_lookup(sp, id) >= 0;
+}
+
+static inline int spill_read(sht_spill_t * sp, int64_t pos, void * record) {
+     if (pread(sp->log_fd, record, sp->record_len,
+               (off_t)(sp->index[pos].rec * sp->record_len)) !=
+         (ssize_t)sp->record_len) {
+          error_print("failed reading spilled record");
+          return 0;
+     }
+     return 1;
+}
+
+int sht_spill_peek(sht_spill_t * sp, uint64_t id, void * record) {
+     int64_t pos = spill_lookup(sp, id);
+     return (pos >= 0) && spill_read(sp, pos, record);
+}
+
+int sht_spill_take(sht_spill_t * sp, uint64_t id, void * record) {
+     int64_t pos = spill_lookup(sp, id);
+     if ((pos < 0) || !spill_read(sp, pos, record)) {
+          return 0;
+     }
+     spill_delete_slot(sp, (uint64_t)pos);
+     sp->takes++;
+     return 1;
+}
+
+int sht_spill_remove(sht_spill_t * sp, uint64_t id) {
+     int64_t pos = spill_lookup(sp, id);
+     if (pos < 0) {
+          return 0;
+     }
+     spill_delete_slot(sp, (uint64_t)pos);
+     return 1;
+}
+
+void sht_spill_scour(sht_spill_t * sp, sht_spill_callback cb, void * vproc,
+                     int keep) {
+     if (!sp->live) {
+          return;
+     }
+     void * record = malloc(sp->record_len);
+     if (!record) {
+          error_print("failed sht_spill_scour malloc of record");
+          return;
+     }
+     uint64_t i;
+     for (i = 0; i <= sp->mask; i++) {
+          if (!sp->index[i].id) {
+               continue;
+          }
+          off_t off = (off_t)(sp->index[i].rec * sp->record_len);
+          if (pread(sp->log_fd, record, sp->record_len, off) !=
+              (ssize_t)sp->record_len) {
+               error_print("failed reading spilled record");
+               continue;
+          }
+          cb(record, vproc);
+          if (keep && (pwrite(sp->log_fd, record, sp->record_len, off) !=
+                       (ssize_t)sp->record_len)) {
+               error_print("failed writing spilled record");
+          }
+     }
+     free(record);
+     if (!keep) {
+          sht_spill_clear(sp);
+     }
+}
+
+void sht_spill_clear(sht_spill_t * sp) {
+     if (sp->live) {
+          memset(sp->index, 0, (sp->mask + 1) * sizeof(spill_slot_t));
+     }
+     memset(sp->bloom, 0, (size_t)1 << (sp->bloom_bits - 3));
+     sp->live = 0;
+     sp->free_cnt = 0;
+     sp->log_recs = 0;
+     sp->bloom_stale = 0;
+     if (ftruncate(sp->log_fd, 0) != 0) {
+          error_print("failed truncating spill log");
+     }
+}
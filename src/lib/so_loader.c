@@ -353,6 +353,9 @@ static int so_load_wsprocbuffer(void * sh_file_handle,
           module->pbkid->instance_len = *isize;
      }
 
+     int * doffset = (int *)dlsym(sh_file_handle,"procbuffer_demand_offset");
+     module->pbkid->demand_offset = doffset ? *doffset : -1;
+
      module->proc_init_f = NULL;
      module->proc_input_set_f = wsprocbuffer_input_set;
      module->proc_destroy_f = wsprocbuffer_destroy;
@@ -448,6 +451,7 @@ static int so_load_wsprockeystate(void * sh_file_handle,
 
      module->proc_init_f = NULL;
      module->proc_input_set_f = wsprockeystate_input_set;
+     module->batch_table = wsprockeystate_batch;
      module->proc_destroy_f = wsprockeystate_destroy;
      if (!module->name) {
           module->name = (char *) dlsym(sh_file_handle,"proc_name");
@@ -554,6 +558,8 @@ ws_proc_module_t * ws_proc_module_dlopen(mimo_t * mimo, const char * fullname, c
                (proc_input_set_t) dlsym(sh_file_handle,"proc_input_set");
           module->proc_destroy_f =
                (proc_destroy_t) dlsym(sh_file_handle,"proc_destroy");
+          module->batch_table =
+               (proc_batch_t *) dlsym(sh_file_handle,"proc_batch");
           if (!module->name) {
                module->name = (char *) dlsym(sh_file_handle,"proc_name");
           }
@@ -34,6 +34,12 @@ SOFTWARE.
 #include "waterslide.h"
 #include <limits.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SIZEOF_INT128__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#define SYSUTIL_HAS_TSC 1
+#endif // x86 with 128-bit multiply
+
 #define SCRATCHPAD_LEN 1500
 
 #define MAX_PATH_COUNT 31
@@ -789,3 +795,139 @@ int sysutil_decode_hex_escapes(char * str, int * len) {
 }
 
 
+
+/*
+ * TIME SERVICE
+ */
+
+__thread sysutil_clock_t sysutil_clock;
+int sysutil_clock_replay = 0;
+int sysutil_clock_tsc = 0;
+
+//newest event time seen in replay mode, in usec
+static uint64_t sysutil_replay_usec = 0;
+
+#ifdef SYSUTIL_HAS_TSC
+
+static uint64_t sysutil_tsc_base;
+static uint64_t sysutil_tsc_base_ns;
+static uint64_t sysutil_tsc_mult;   //ns per tick, 32.32 fixed point
+#endif // SYSUTIL_HAS_TSC
+
+static inline uint64_t sysutil_monotonic_ns(void) {
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#ifdef SYSUTIL_HAS_TSC
+//the counter has to tick at a constant rate through frequency and sleep
+// state changes to be usable as a clock
+static int sysutil_tsc_calibrate(void) {
+     unsigned int eax, ebx, ecx, edx;
+
+     if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) ||
+         !(edx & (1 << 8))) {
+          error_print("cpu has no invariant TSC, keeping the system clock");
+          return 0;
+     }
+
+     uint64_t ns0 = sysutil_monotonic_ns();
+     uint64_t t0 = __rdtsc();
+     usleep(20000);
+     uint64_t ns1 = sysutil_monotonic_ns();
+     uint64_t t1 = __rdtsc();
+
+     if ((t1 <= t0) || (ns1 <= ns0)) {
+          error_print("unable to calibrate TSC, keeping the system clock");
+          return 0;
+     }
+
+     sysutil_tsc_mult = (uint64_t)((((unsigned __int128)(ns1 - ns0)) << 32) /
+                                   (t1 - t0));
+     sysutil_tsc_base = t1;
+     sysutil_tsc_base_ns = ns1;
+     sysutil_clock_tsc = 1;
+     status_print("TSC clock calibrated at %.3f GHz",
+                  (double)(t1 - t0) / (double)(ns1 - ns0));
+     return 1;
+}
+#endif // SYSUTIL_HAS_TSC
+
+int sysutil_clock_set_mode(const char * mode) {
+     const char * p = mode;
+     size_t len;
+
+     while (*p) {
+          len = strcspn(p, ",");
+          if ((len == 3) && (strncmp(p, "tsc", 3) == 0)) {
+#ifdef SYSUTIL_HAS_TSC
+               sysutil_tsc_calibrate();
+#else
+               error_print("no TSC clock on this platform, keeping the system clock");
+#endif // SYSUTIL_HAS_TSC
+          }
+          else if ((len == 6) && (strncmp(p, "replay", 6) == 0)) {
+               sysutil_clock_replay = 1;
+          }
+          else {
+               error_print("unknown clock mode '%.*s'", (int)len, p);
+               return 0;
+          }
+          p += len;
+          if (*p == ',') {
+               p++;
+          }
+     }
+     return 1;
+}
+
+void sysutil_clock_tick(void) {
+     gettimeofday(&sysutil_clock.wall, NULL);
+
+     if (!sysutil_clock_replay) {
+          sysutil_clock.now = sysutil_clock.wall;
+     }
+     else {
+          uint64_t usec = sysutil_replay_usec;
+          //until an event timestamp is seen, run on the wall clock
+          if (!usec) {
+               sysutil_clock.now = sysutil_clock.wall;
+          }
+          else {
+               sysutil_clock.now.tv_sec = usec / 1000000;
+               sysutil_clock.now.tv_usec = usec % 1000000;
+          }
+     }
+}
+
+void sysutil_clock_observe_replay(time_t sec, time_t usec) {
+     uint64_t t = (uint64_t)sec * 1000000 + usec;
+     uint64_t cur = sysutil_replay_usec;
+
+     //replay time only moves forward
+     while (t > cur) {
+          if (__sync_bool_compare_and_swap(&sysutil_replay_usec, cur, t)) {
+               break;
+          }
+          cur = sysutil_replay_usec;
+     }
+     //take the newest replay time seen by any thread; this also replaces
+     //the wall clock stand-in used before the first event
+     if (cur > t) {
+          t = cur;
+     }
+     sysutil_clock.now.tv_sec = t / 1000000;
+     sysutil_clock.now.tv_usec = t % 1000000;
+}
+
+uint64_t sysutil_clock_ns(void) {
+#ifdef SYSUTIL_HAS_TSC
+     if (sysutil_clock_tsc) {
+          return sysutil_tsc_base_ns +
+               (uint64_t)(((unsigned __int128)(__rdtsc() - sysutil_tsc_base) *
+                           sysutil_tsc_mult) >> 32);
+     }
+#endif // SYSUTIL_HAS_TSC
+     return sysutil_monotonic_ns();
+}
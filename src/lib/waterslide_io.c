@@ -25,11 +25,22 @@ SOFTWARE.
 #include "wsqueue.h"
 #include "waterslide.h"
 #include "waterslide_io.h"
+#include "wsjobring.h"
 #include "init.h"
 #include "mimo.h"
 #include "shared/mimo_shared.h"
+#include "wsperf.h"
+#include "wsplan.h"
 
 extern uint32_t graph_has_cycle, deadlock_firehose_shutoff;
+extern uint32_t ws_direct_dispatch;
+
+// nesting of direct dispatch calls on this thread
+#ifdef WS_PTHREADS
+static __thread uint32_t direct_depth;
+#else // !WS_PTHREADS
+static uint32_t direct_depth;
+#endif // WS_PTHREADS
 ws_outtype_t * ws_find_outtype(ws_outlist_t * olist, wsdatatype_t* dtype,
                                wslabel_t * label) {
      if (olist->outtype_q == NULL) {
@@ -97,44 +108,88 @@ wsdata_t* ws_get_outdata(ws_outtype_t* otype) {
      return wsd;
 }
 
+// check whether an emit can call its same-thread subscribers directly.
+// A subscriber that is itself mid-emit further up the stack means the
+// graph cycles on this thread, so that edge has to go through the queue.
+static inline int ws_can_direct_dispatch(ws_subscriber_t * subs) {
+     if (!ws_direct_dispatch ||
+         (direct_depth >= WS_DIRECT_DISPATCH_MAX_DEPTH)) {
+          return 0;
+     }
+     for (; subs; subs = subs->next) {
+          if (subs->doutput->dispatching) {
+               return 0;
+          }
+     }
+     return 1;
+}
+
+// depth-first delivery to same-thread subscribers in place of a local job;
+// consumes the reference the caller took for the job
+static void ws_direct_dispatch_local(wsdata_t * wsdata,
+                                     ws_subscriber_t * subs,
+                                     ws_doutput_t * doutput) {
+     ws_subscriber_t * sub;
+     WSPERF_NRANK();
+     WSPERF_LOCAL_INIT();
+     WSPLAN_LOCAL_INIT();
+
+     doutput->dispatching++;
+     direct_depth++;
+     for (sub = subs; sub; sub = sub->next) {
+          if (!sub->src_label ||
+              wsdata_check_label(wsdata, sub->src_label)) {
+               // timing is inclusive of anything further down the chain
+               WSPERF_TIME0(sub->proc_instance->kid.uid-1);
+               WSPLAN_TIME0(sub->proc_instance);
+               sub->proc_func(sub->local_instance, wsdata,
+                              sub->doutput, sub->input_index);
+               WSPLAN_TIME(sub->proc_instance);
+               WSPERF_PROC_COUNT(sub->proc_instance->kid.uid-1);
+               WSPERF_TIME(sub->proc_instance->kid.uid-1);
+          }
+     }
+     direct_depth--;
+     doutput->dispatching--;
+
+     wsdata_delete(wsdata);
+}
+
 int ws_set_outdata(wsdata_t* wsdata,
                     ws_outtype_t* outtype,
                     ws_doutput_t* doutput) {
 
-     ws_job_t * job;
+     WSPLAN_EMIT(doutput);
 
 // XXX: The #ifdef...#else...#endif below has duplicate code, so remember
 //      to modify both branches when making any applicable changes. Code is
 //      duplicated for performance optimization reasons.
 #ifdef WS_PTHREADS
      int has_subscriber = 0;
+     int direct = 0;
      if (outtype->local_subscribers) {
           has_subscriber = 1;
-          if ((job = queue_remove((nhqueue_t*)doutput->local_job_freeq)) == NULL)
-          {
-               job = (ws_job_t*)malloc(sizeof(ws_job_t));
-               if (!job) {
-                    error_print("failed ws_set_outdata malloc of job");
-                    return 0;
-               }
+          direct = ws_can_direct_dispatch(outtype->local_subscribers);
+          if (!direct && !jobring_add(doutput->local_jobq, wsdata,
+                                      outtype->local_subscribers)) {
+               error_print("failed ws_set_outdata add of job");
+               return 0;
           }
-          job->data = wsdata;
           if (wsdata->references == 0) {
                wsdata->references = 1;
           }
           else {
                wsdata_add_reference(wsdata);
           }
-
-          job->subscribers = outtype->local_subscribers;
-
-          queue_add(doutput->local_jobq, job);
      }
      if (outtype->ext_subscribers) {
           has_subscriber = 1;
           ws_subscriber_t * scursor;
           mimo_t *themimo = (mimo_t *)doutput->mimo;
 
+          // reference counts go atomic before other threads can see the data
+          wsdata_publish(wsdata);
+
           if (wsdata->references == 0) {
                wsdata->references = 1;
           }
@@ -187,21 +242,24 @@ int ws_set_outdata(wsdata_t* wsdata,
           wsdata_add_reference(wsdata);
           wsdata_delete(wsdata);
      }
+     if (direct) {
+          // run after external subscribers are queued; the local reference
+          // taken above keeps the data alive until then
+          ws_direct_dispatch_local(wsdata, outtype->local_subscribers, doutput);
+     }
 #else // !WS_PTHREADS
-     if ((job = queue_remove((nhqueue_t*)doutput->local_job_freeq)) == NULL)
-     {
-          job = (ws_job_t*)malloc(sizeof(ws_job_t));
-          if (!job) {
-               error_print("failed ws_set_outdata malloc of job");
-               return 0;
-          }
+     if (ws_can_direct_dispatch(outtype->local_subscribers)) {
+          wsdata_add_reference(wsdata);
+          ws_direct_dispatch_local(wsdata, outtype->local_subscribers, doutput);
+          return 1;
      }
-     job->data = wsdata;
-     wsdata_add_reference(wsdata);
 
-     job->subscribers = outtype->local_subscribers;
-
-     queue_add(doutput->local_jobq, job);
+     if (!jobring_add(doutput->local_jobq, wsdata,
+                      outtype->local_subscribers)) {
+          error_print("failed ws_set_outdata add of job");
+          return 0;
+     }
+     wsdata_add_reference(wsdata);
 #endif // WS_PTHREADS
 
      return 1;
@@ -31,6 +31,8 @@ SOFTWARE.
 #include "listhash.h"
 #include "waterslide.h"
 #include "waterslidedata.h"
+#include "wsmem.h"
+#include "wshugepage.h"
 #include "mimo.h"
 
 // Globals
@@ -79,6 +81,13 @@ void wsdatatype_profile(void * data, void *ignore) {
      }
 }
 
+// pool elements carved from huge page slabs go back with the slabs
+static inline void wsdata_pool_free(void * ptr) {
+     if (ws_huge_mode() == WS_HUGE_OFF) {
+          free(ptr);
+     }
+}
+
 static inline void free_dtype_freeq_data(wsfree_list_t *fl, int hasdata) {
 
 #ifndef WS_PTHREADS
@@ -90,9 +99,9 @@ static inline void free_dtype_freeq_data(wsfree_list_t *fl, int hasdata) {
                wsstack_destroy(newdata->dependency);
           }
           if (hasdata && newdata->data) {
-               free(newdata->data);
+               wsdata_pool_free(newdata->data);
           }
-          free(node);
+          wsdata_pool_free(node);
           node = wsstack_remove(fl->stack);
      }
 
@@ -108,7 +117,7 @@ static inline void free_dtype_freeq_data(wsfree_list_t *fl, int hasdata) {
                     wsstack_destroy(newdata->dependency);
                }
                if (hasdata && newdata->data) {
-                    free(newdata->data);
+                    wsdata_pool_free(newdata->data);
                }
                node = node->next;
           }
@@ -122,9 +131,9 @@ static inline void free_dtype_freeq_data(wsfree_list_t *fl, int hasdata) {
                wsstack_destroy(newdata->dependency);
           }
           if (hasdata && newdata->data) {
-               free(newdata->data);
+               wsdata_pool_free(newdata->data);
           }
-          free(node);
+          wsdata_pool_free(node);
           node = wsstack_atomic_remove(fl->stack);
      }
 
@@ -139,10 +148,10 @@ static inline void free_dtype_freeq_data(wsfree_list_t *fl, int hasdata) {
                     wsstack_destroy(newdata->dependency);
                }
                if (hasdata && newdata->data) {
-                    free(newdata->data);
+                    wsdata_pool_free(newdata->data);
                }
                element = element->next;
-               free(newdata);
+               wsdata_pool_free(newdata);
           }
           cache = cache->next;
      }
@@ -164,9 +173,9 @@ static inline void free_dtype_hugeblock_freeq_data(wsfree_list_t *fl, int hasdat
                if (hb->buf) {
                     free(hb->buf);
                }
-               free(newdata->data);
+               wsdata_pool_free(newdata->data);
           }
-          free(node);
+          wsdata_pool_free(node);
           node = wsstack_remove(fl->stack);
      }
 
@@ -186,7 +195,7 @@ static inline void free_dtype_hugeblock_freeq_data(wsfree_list_t *fl, int hasdat
                     if (hb->buf) {
                          free(hb->buf);
                     }
-                    free(newdata->data);
+                    wsdata_pool_free(newdata->data);
                }
                node = node->next;
           }
@@ -204,9 +213,9 @@ static inline void free_dtype_hugeblock_freeq_data(wsfree_list_t *fl, int hasdat
                if (hb->buf) {
                     free(hb->buf);
                }
-               free(newdata->data);
+               wsdata_pool_free(newdata->data);
           }
-          free(node);
+          wsdata_pool_free(node);
           node = wsstack_atomic_remove(fl->stack);
      }
 
@@ -225,10 +234,10 @@ static inline void free_dtype_hugeblock_freeq_data(wsfree_list_t *fl, int hasdat
                     if (hb->buf) {
                          free(hb->buf);
                     }
-                    free(newdata->data);
+                    wsdata_pool_free(newdata->data);
                }
                element = element->next;
-               free(newdata);
+               wsdata_pool_free(newdata);
           }
           cache = cache->next;
      }
@@ -325,6 +334,63 @@ int wsregister_label_hash(void * v_type_table, wslabel_t * parent,
 
 }
 
+// labels looked up by the kid being initialized on this thread
+static __thread ws_label_demand_t * label_recorder;
+
+void wslabel_set_recorder(ws_label_demand_t * recorder) {
+     label_recorder = recorder;
+}
+
+int wslabel_demand_add(ws_label_demand_t * demand, wslabel_t * label) {
+     if (!label) {
+          return 0;
+     }
+     if (label->serial >= demand->nbits) {
+          uint32_t nbits = (label->serial + 64) & ~63;
+          uint64_t * bits = (uint64_t*)realloc(demand->bits, nbits / 8);
+          if (!bits) {
+               error_print("failed wslabel_demand_add realloc of bits");
+               return 0;
+          }
+          memset(bits + demand->nbits / 64, 0, (nbits - demand->nbits) / 8);
+          demand->bits = bits;
+          demand->nbits = nbits;
+     }
+     demand->bits[label->serial >> 6] |= (uint64_t)1 << (label->serial & 63);
+     return 1;
+}
+
+int wslabel_demand_merge(ws_label_demand_t * demand, ws_label_demand_t * src) {
+     if (src->nbits > demand->nbits) {
+          uint64_t * bits = (uint64_t*)realloc(demand->bits, src->nbits / 8);
+          if (!bits) {
+               error_print("failed wslabel_demand_merge realloc of bits");
+               return 0;
+          }
+          memset(bits + demand->nbits / 64, 0,
+                 (src->nbits - demand->nbits) / 8);
+          demand->bits = bits;
+          demand->nbits = src->nbits;
+     }
+     uint32_t i;
+     for (i = 0; i < src->nbits / 64; i++) {
+          demand->bits[i] |= src->bits[i];
+     }
+     return 1;
+}
+
+void wslabel_demand_free(ws_label_demand_t * demand) {
+     free(demand->bits);
+     demand->bits = NULL;
+     demand->nbits = 0;
+}
+
+static inline void wslabel_record(wslabel_t * label) {
+     if (label_recorder && label) {
+          wslabel_demand_add(label_recorder, label);
+     }
+}
+
 static inline wslabel_t * wsregister_label_internal(void * v_type_table,
                                                     const char * name){
      dprint("wsregister_label_internal");
@@ -342,8 +408,10 @@ static inline wslabel_t * wsregister_label_internal(void * v_type_table,
      if (!label->name) {
           label->name = strdup(name);
           label->hash = evahash64((uint8_t*)name, namelen, 0x22341133);
+          label->serial = ++mdl->label_serials;
           wsregister_label_hash(v_type_table, label, label->hash);
      }
+     wslabel_record(label);
 
      return label;
 }
@@ -372,12 +440,31 @@ static inline wslabel_t * wsregister_label_internal_len(void * v_type_table,
                return NULL;
           }
           label->hash = evahash64((uint8_t*)name, len, 0x22341133);
+          label->serial = ++mdl->label_serials;
           wsregister_label_hash(v_type_table, label, label->hash);
      }
+     wslabel_record(label);
 
      return label;
 }
 
+// Lock-free lookup for labels that are already set up, so decoders that
+// register a label per field per event do not serialize on label_lock.
+// Returns NULL on a miss or for a label still being set up; the caller
+// then takes the lock.  Entries are only ever added to the label table,
+// and the flags are published last.
+static inline wslabel_t * wslabel_find_ready(void * v_type_table,
+                                             const char * name, int len,
+                                             int search) {
+     mimo_datalists_t * mdl = (mimo_datalists_t *)v_type_table;
+     wslabel_t * label = (wslabel_t*)listhash_find(mdl->label_table, name, len);
+     if (!label || !(search ? label->search : label->registered)) {
+          return NULL;
+     }
+     wslabel_record(label);
+     return label;
+}
+
 static inline void wsset_label_index(void * v_type_table, wslabel_t * label) {
      mimo_datalists_t * mdl = (mimo_datalists_t *)v_type_table;
      if (mdl->index_len < MAX_WSD_SEARCH_TERMS) {
@@ -392,53 +479,82 @@ static inline void wsset_label_index(void * v_type_table, wslabel_t * label) {
 
 wslabel_t * wsregister_label(void * v_type_table, const char * name) {
      dprint("wsregister_label");
-     wslabel_t * label = wsregister_label_internal(v_type_table, name);
+     wslabel_t * label;
+     if (name && (label = wslabel_find_ready(v_type_table, name, strlen(name), 0))) {
+          return label;
+     }
+     WS_MUTEX_LOCK(&label_lock);
+     label = wsregister_label_internal(v_type_table, name);
      if (label && !label->registered) {
-          label->registered = 1;
           if (label->search) {
                wsset_label_index(v_type_table, label);
           }
+          __sync_synchronize();
+          label->registered = 1;
      }
+     WS_MUTEX_UNLOCK(&label_lock);
      return label;
 }
 
 wslabel_t * wsregister_label_len(void * v_type_table, const char * name, int len) {
      dprint("wsregister_label");
-     wslabel_t * label = wsregister_label_internal_len(v_type_table, name, len);
+     wslabel_t * label;
+     if (name && (label = wslabel_find_ready(v_type_table, name, len, 0))) {
+          return label;
+     }
+     WS_MUTEX_LOCK(&label_lock);
+     label = wsregister_label_internal_len(v_type_table, name, len);
      if (label && !label->registered) {
-          label->registered = 1;
           if (label->search) {
                wsset_label_index(v_type_table, label);
           }
+          __sync_synchronize();
+          label->registered = 1;
      }
+     WS_MUTEX_UNLOCK(&label_lock);
      return label;
 }
 
 wslabel_t * wssearch_label(void * v_type_table, const char * name) {
      dprint("wssearch_label");
-     wslabel_t * label = wsregister_label_internal(v_type_table, name);
+     wslabel_t * label;
+     if (name && (label = wslabel_find_ready(v_type_table, name, strlen(name), 1))) {
+          return label;
+     }
+     WS_MUTEX_LOCK(&label_lock);
+     label = wsregister_label_internal(v_type_table, name);
      if (label && !label->search) {
+          wsset_label_index(v_type_table, label);
+          __sync_synchronize();
           label->search = 1;
           label->registered = 1;
-          wsset_label_index(v_type_table, label);
      }
+     WS_MUTEX_UNLOCK(&label_lock);
      return label;
 }
 
 wslabel_t * wssearch_label_len(void * v_type_table, const char * name, int len) {
      dprint("wssearch_label");
-     wslabel_t * label = wsregister_label_internal_len(v_type_table, name, len);
+     wslabel_t * label;
+     if (name && (label = wslabel_find_ready(v_type_table, name, len, 1))) {
+          return label;
+     }
+     WS_MUTEX_LOCK(&label_lock);
+     label = wsregister_label_internal_len(v_type_table, name, len);
      if (label && !label->search) {
+          wsset_label_index(v_type_table, label);
+          __sync_synchronize();
           label->search = 1;
           label->registered = 1;
-          wsset_label_index(v_type_table, label);
      }
+     WS_MUTEX_UNLOCK(&label_lock);
      return label;
 }
 
 wslabel_t * wslabel_find_byhash(void * v_type_table, uint64_t hash) {
      wslabel_t * label;
      mimo_datalists_t * mdl = (mimo_datalists_t *)v_type_table;
+     // left unlocked: this is a per-event lookup in some decoders
      label = (wslabel_t*)listhash_find(mdl->label_table,
                                        (const char *)&hash,
                                        sizeof(uint64_t));
@@ -452,10 +568,12 @@ int wsregister_label_alias(void * v_type_table, wslabel_t * parent,
      }
      wslabel_t * label_alias;
      mimo_datalists_t * mdl = (mimo_datalists_t *)v_type_table;
+     WS_MUTEX_LOCK(&label_lock);
      label_alias = (wslabel_t*)listhash_find_attach_reference(mdl->label_table,
                                                               alias,
                                                               strlen(alias),
                                                               parent);
+     WS_MUTEX_UNLOCK(&label_lock);
      if (!label_alias) {
           return 0;
      }
@@ -483,10 +601,29 @@ static int wsdatatype_default_to_double(wsdata_t * wsd, double* d) {
 }
 
 
+// with huge pages on, the wsdata_t and its payload come from one slab
+// allocation that is never freed on its own
+static void *wsdata_huge_allocator(wsdatatype_t *dtype) {
+     uint8_t *mem = (uint8_t*) ws_huge_pool_alloc(sizeof(wsdata_t) + dtype->len);
+     if (!mem) {
+          error_print("failed wsdata_allocator pool allocation of newdata");
+          return NULL;
+     }
+     wsdata_t *newdata = (wsdata_t*) mem;
+     newdata->data = dtype->len ? (void*) (mem + sizeof(wsdata_t)) : NULL;
+     wsmem_add(WSMEM_FREELIST, sizeof(wsdata_t) + dtype->len);
+
+     return newdata;
+}
+
 static void *wsdata_allocator(void *arg) {
      wsdatatype_t *dtype = (wsdatatype_t*) arg;
      wsdata_t *newdata;
 
+     if (ws_huge_mode() != WS_HUGE_OFF) {
+          return wsdata_huge_allocator(dtype);
+     }
+
      newdata = (wsdata_t*) calloc(1, sizeof(wsdata_t));
      if (!newdata) {
           error_print("failed wsdata_allocator calloc of newdata");
@@ -502,6 +639,7 @@ static void *wsdata_allocator(void *arg) {
      } else {
           newdata->data = NULL;
      }
+     wsmem_add(WSMEM_FREELIST, sizeof(wsdata_t) + dtype->len);
 
      return newdata;
 }
@@ -509,11 +647,17 @@ static void *wsdata_allocator(void *arg) {
 static void *wsdata_ptr_allocator(void *arg) {
      wsdata_t *newdata;
 
-     newdata = (wsdata_t*) calloc(1, sizeof(wsdata_t));
+     if (ws_huge_mode() != WS_HUGE_OFF) {
+          newdata = (wsdata_t*) ws_huge_pool_alloc(sizeof(wsdata_t));
+     }
+     else {
+          newdata = (wsdata_t*) calloc(1, sizeof(wsdata_t));
+     }
      if (!newdata) {
           error_print("failed wsdata_ptr_allocator calloc of newdata");
           return NULL;
      }
+     wsmem_add(WSMEM_FREELIST, sizeof(wsdata_t));
 
      return newdata;
 }
@@ -707,16 +851,37 @@ void wsdatatype_default_delete(wsdata_t * wsdata) {
 
      // no more references.. we can move this data to free q
      if (tmp <= 0) {
+          //remove references to parent
+          wsdata_release_dependencies(wsdata);
+          //add to child free_q
+          wsdata_moveto_freeq(wsdata);
+     }
+}
+
+//switch data over to shared reference counting before it leaves the
+// allocating thread.. parents and container members go along with it
+void wsdata_publish(wsdata_t * wsdata) {
+#ifdef WS_PTHREADS
+     if (wsdata->owner != WSDATA_OWNER_SHARED) {
+          wsdata->owner = WSDATA_OWNER_SHARED;
+          int i;
+          for (i = 0; i < wsdata->dep_len; i++) {
+               wsdata_publish(wsdata->deps[i]);
+          }
           if (wsdata->dependency) {
-               wsdata_t * parent;
-               //remove references to parent
-               while ((parent = wsstack_remove(wsdata->dependency)) != NULL) {
-                    parent->dtype->delete_func(parent);
+               wsstack_node_t * walker;
+               for (walker = wsdata->dependency->head; walker;
+                    walker = walker->next) {
+                    wsdata_publish((wsdata_t *)walker->data);
                }
           }
-          //add to child free_q
-          wsdata_moveto_freeq(wsdata);
      }
+     // containers are walked every time, members may have been added since
+     // the container was last published
+     if (wsdata->dtype->publish_func) {
+          wsdata->dtype->publish_func(wsdata);
+     }
+#endif // WS_PTHREADS
 }
 
 int wsdatatype_default_print(FILE * fp, wsdata_t *data, uint32_t type) {
@@ -748,6 +913,11 @@ wsdata_t * wsdatatype_default_copy(wsdata_t * wsdata){
 
           wsdata_duplicate_labels(wsdata,newdata);
 
+          int i;
+          for (i = 0; i < wsdata->dep_len; i++) {
+               wsdata_assign_dependency(wsdata->deps[i], newdata);
+          }
+
           wsstack_node_t * walker = NULL;
           if (wsdata->dependency) {
                walker = wsdata->dependency->head;
@@ -0,0 +1,285 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+// huge page backing for state tables and wsdata_t pools.  See wshugepage.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include "waterslide.h"
+#include "wshugepage.h"
+
+#ifdef __linux
+#include <sys/mman.h>
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#endif // __linux
+
+// every region starts with a header so that ws_huge_free knows how the
+// memory was obtained; 64 bytes keeps the caller's pointer cache aligned
+#define WS_HUGE_HDR 64
+
+// pool slabs are one 2MB page each
+#define WS_HUGE_SLAB WS_HUGE_2M_SIZE
+
+enum {
+     WS_HUGE_KIND_HEAP = 0,
+     WS_HUGE_KIND_THP,
+     WS_HUGE_KIND_2M,
+     WS_HUGE_KIND_1G,
+     WS_HUGE_KINDS
+};
+
+static const char * ws_huge_kind_names[WS_HUGE_KINDS] = {
+     "4K pages", "thp advised", "2M pages", "1G pages"
+};
+
+typedef struct _ws_huge_hdr_t {
+     void * base;   // start of the mapping
+     size_t maplen; // 0 for heap memory
+     int kind;
+     void * next;   // pool slab list
+} ws_huge_hdr_t;
+
+static int huge_mode = -1;
+static uint64_t huge_bytes[WS_HUGE_KINDS];
+static uint32_t huge_regions[WS_HUGE_KINDS];
+static uint32_t huge_slabs;
+static uint32_t huge_fell_back;
+static void * huge_slab_list;
+
+static __thread uint8_t * slab_cur;
+static __thread size_t slab_left;
+
+int ws_huge_mode(void) {
+     if (huge_mode < 0) {
+          const char * env = getenv(ENV_WS_HUGEPAGES);
+          int mode = WS_HUGE_OFF;
+          if (env && *env && strcasecmp(env, "off") != 0) {
+               if (strcasecmp(env, "thp") == 0) {
+                    mode = WS_HUGE_THP;
+               }
+               else if (strcasecmp(env, "2M") == 0) {
+                    mode = WS_HUGE_2M;
+               }
+               else if (strcasecmp(env, "1G") == 0) {
+                    mode = WS_HUGE_1G;
+               }
+               else {
+                    error_print("unknown %s value %s, expecting thp, 2M or 1G",
+                                ENV_WS_HUGEPAGES, env);
+               }
+          }
+          huge_mode = mode;
+     }
+     return huge_mode;
+}
+
+#ifdef __linux
+// maps len bytes with the given page kind; returns the mapping or NULL
+static void * ws_huge_map(size_t len, int kind, size_t * maplen) {
+     void * map;
+
+     if (kind == WS_HUGE_KIND_1G || kind == WS_HUGE_KIND_2M) {
+          const size_t page = (kind == WS_HUGE_KIND_1G) ? WS_HUGE_1G_SIZE :
+               WS_HUGE_2M_SIZE;
+          const int shift = (kind == WS_HUGE_KIND_1G) ? 30 : 21;
+          *maplen = (len + page - 1) & ~(page - 1);
+          map = mmap(NULL, *maplen, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                     (shift << MAP_HUGE_SHIFT), -1, 0);
+          return (map == MAP_FAILED) ? NULL : map;
+     }
+
+     // transparent huge pages only back 2MB aligned ranges, so map an extra
+     // page and trim the ends back to an aligned region
+     const size_t need = (len + WS_HUGE_2M_SIZE - 1) & ~(WS_HUGE_2M_SIZE - 1);
+     const size_t over = need + WS_HUGE_2M_SIZE;
+     uint8_t * raw = (uint8_t *)mmap(NULL, over, PROT_READ | PROT_WRITE,
+                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+     if ((void *)raw == MAP_FAILED) {
+          return NULL;
+     }
+     uint8_t * aligned = (uint8_t *)(((uintptr_t)raw + WS_HUGE_2M_SIZE - 1) &
+                                     ~(uintptr_t)(WS_HUGE_2M_SIZE - 1));
+     if (aligned > raw) {
+          munmap(raw, aligned - raw);
+     }
+     if (raw + over > aligned + need) {
+          munmap(aligned + need, (raw + over) - (aligned + need));
+     }
+     if (madvise(aligned, need, MADV_HUGEPAGE) != 0) {
+          munmap(aligned, need);
+          return NULL;
+     }
+     *maplen = need;
+     return aligned;
+}
+#endif // __linux
+
+// zeroed region of len bytes behind a header, from the largest pages the
+// mode allows and the system can give
+static void * ws_huge_obtain(size_t len) {
+     const int mode = ws_huge_mode();
+     const size_t total = len + WS_HUGE_HDR;
+     ws_huge_hdr_t * hdr = NULL;
+     int kind = WS_HUGE_KIND_HEAP;
+     size_t maplen = 0;
+
+#ifdef __linux
+     if (mode != WS_HUGE_OFF && total >= WS_HUGE_2M_SIZE) {
+          if (mode == WS_HUGE_1G && total >= WS_HUGE_1G_SIZE / 2) {
+               kind = WS_HUGE_KIND_1G;
+               hdr = (ws_huge_hdr_t *)ws_huge_map(total, kind, &maplen);
+          }
+          if (!hdr && mode >= WS_HUGE_2M) {
+               kind = WS_HUGE_KIND_2M;
+               hdr = (ws_huge_hdr_t *)ws_huge_map(total, kind, &maplen);
+          }
+          if (!hdr) {
+               kind = WS_HUGE_KIND_THP;
+               hdr = (ws_huge_hdr_t *)ws_huge_map(total, kind, &maplen);
+          }
+          if (!hdr || (mode >= WS_HUGE_2M && kind == WS_HUGE_KIND_THP)) {
+               if (__sync_fetch_and_add(&huge_fell_back, 1) == 0) {
+                    status_print("huge pages: fewer than requested are available, "
+                                 "check /proc/sys/vm/nr_hugepages and "
+                                 "/sys/kernel/mm/transparent_hugepage/enabled");
+               }
+          }
+     }
+#endif // __linux
+     if (hdr) {
+          hdr->base = hdr;
+          hdr->maplen = maplen;
+     }
+     else {
+          kind = WS_HUGE_KIND_HEAP;
+          hdr = (ws_huge_hdr_t *)calloc(1, total);
+          if (!hdr) {
+               return NULL;
+          }
+          hdr->base = hdr;
+          hdr->maplen = 0;
+     }
+     hdr->kind = kind;
+     hdr->next = NULL;
+     (void)__sync_fetch_and_add(&huge_bytes[kind], (uint64_t)total);
+     (void)__sync_fetch_and_add(&huge_regions[kind], 1);
+
+     return (uint8_t *)hdr + WS_HUGE_HDR;
+}
+
+void * ws_huge_calloc(size_t nmemb, size_t size) {
+     if (size && nmemb > (SIZE_MAX - WS_HUGE_HDR) / size) {
+          return NULL;
+     }
+     return ws_huge_obtain(nmemb * size);
+}
+
+void ws_huge_free(void * ptr) {
+     if (!ptr) {
+          return;
+     }
+     ws_huge_hdr_t * hdr = (ws_huge_hdr_t *)((uint8_t *)ptr - WS_HUGE_HDR);
+#ifdef __linux
+     if (hdr->maplen) {
+          munmap(hdr->base, hdr->maplen);
+          return;
+     }
+#endif // __linux
+     free(hdr->base);
+}
+
+void * ws_huge_pool_alloc(size_t len) {
+     if (ws_huge_mode() == WS_HUGE_OFF) {
+          return NULL;
+     }
+     len = (len + 15) & ~(size_t)15;
+     if (len > slab_left) {
+          // the rest of an outgrown slab is left unused
+          size_t slab = (len > WS_HUGE_SLAB - WS_HUGE_HDR) ? len :
+               WS_HUGE_SLAB - WS_HUGE_HDR;
+          uint8_t * mem = (uint8_t *)ws_huge_obtain(slab);
+          if (!mem) {
+               return NULL;
+          }
+          ws_huge_hdr_t * hdr = (ws_huge_hdr_t *)(mem - WS_HUGE_HDR);
+          do {
+               hdr->next = huge_slab_list;
+          } while (!__sync_bool_compare_and_swap(&huge_slab_list, hdr->next,
+                                                 (void *)mem));
+          (void)__sync_fetch_and_add(&huge_slabs, 1);
+          slab_cur = mem;
+          slab_left = slab;
+     }
+     void * elem = slab_cur;
+     slab_cur += len;
+     slab_left -= len;
+     return elem;
+}
+
+void ws_huge_pool_release(void) {
+     void * mem = huge_slab_list;
+     while (mem) {
+          ws_huge_hdr_t * hdr = (ws_huge_hdr_t *)((uint8_t *)mem - WS_HUGE_HDR);
+          void * next = hdr->next;
+          ws_huge_free(mem);
+          mem = next;
+     }
+     huge_slab_list = NULL;
+}
+
+void ws_huge_print(FILE * fp) {
+     static const char * mode_names[] = { "off", "thp", "2M", "1G" };
+     int i;
+
+     fprintf(fp, "huge pages %s:", mode_names[ws_huge_mode()]);
+     for (i = WS_HUGE_KINDS - 1; i >= 0; i--) {
+          if (huge_regions[i]) {
+               fprintf(fp, " %u regions %.1f MB on %s,", huge_regions[i],
+                       (double)huge_bytes[i] / (1 << 20), ws_huge_kind_names[i]);
+          }
+     }
+     fprintf(fp, " %u of them pool slabs", huge_slabs);
+
+#ifdef __linux
+     // what the kernel has actually backed with transparent huge pages
+     FILE * smaps = fopen("/proc/self/smaps_rollup", "r");
+     if (smaps) {
+          char line[128];
+          unsigned long kb;
+          while (fgets(line, sizeof(line), smaps)) {
+               if (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+                    fprintf(fp, "; process AnonHugePages %.1f MB",
+                            (double)kb / 1024);
+                    break;
+               }
+          }
+          fclose(smaps);
+     }
+#endif // __linux
+     fprintf(fp, "\n");
+}
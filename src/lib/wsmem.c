@@ -0,0 +1,82 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+// global memory accounting and the -M budget.  See wsmem.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "waterslide.h"
+#include "wsmem.h"
+
+int64_t wsmem_bytes[WSMEM_SUBSYSTEMS];
+uint64_t wsmem_budget = 0;
+uint64_t wsmem_throttled = 0;
+volatile uint32_t wsmem_report_pending = 0;
+
+static const char * wsmem_names[WSMEM_SUBSYSTEMS] = {
+     "freelist", "tuple", "state", "queue"
+};
+
+int wsmem_set_budget(const char * str) {
+     char * end = NULL;
+     uint64_t size = strtoull(str, &end, 10);
+
+     switch (toupper((unsigned char)*end)) {
+     case 'G':
+          size <<= 10;
+          // fall through
+     case 'M':
+          size <<= 10;
+          // fall through
+     case 'K':
+          size <<= 10;
+          end++;
+          break;
+     }
+     if (end == str || *end || !size) {
+          error_print("invalid memory budget %s", str);
+          return 0;
+     }
+     wsmem_budget = size;
+     return 1;
+}
+
+void wsmem_print(FILE * fp) {
+     int i;
+
+     fprintf(fp, "memory:");
+     for (i = 0; i < WSMEM_SUBSYSTEMS; i++) {
+          fprintf(fp, " %s %.1f MB", wsmem_names[i],
+                  (double)wsmem_bytes[i] / (1 << 20));
+     }
+     fprintf(fp, ", total %.1f MB", (double)wsmem_total() / (1 << 20));
+     if (wsmem_budget) {
+          fprintf(fp, " of %.1f MB budget, sources held back %"PRIu64" times",
+                  (double)wsmem_budget / (1 << 20), wsmem_throttled);
+     }
+     fprintf(fp, "\n");
+}
+
+void wsmem_report_signal(int sig) {
+     wsmem_report_pending = 1;
+}
@@ -28,6 +28,7 @@ SOFTWARE.
 #include "shared/lock_init.h"
 #include "wsperf.h"
 #include "parse_graph.h"
+#include "sysutil.h"
 
 #define DEFAULT_PORT "8080"
 #define MAX_CHARS 25
@@ -50,6 +51,12 @@ uint64_t get_cycle_count(void) {
      uint32_t i;
      struct timespec N;
 
+     //the calibrated cycle counter avoids a clock call per sample, at the
+     // cost of counting time the thread spent descheduled
+     if (sysutil_clock_tsc) {
+          return sysutil_clock_ns();
+     }
+
 #if defined(__FreeBSD__)
 // unfortunately, CLOCK_PROCESS_CPUTIME_ID is not defined for FreeBSD, 
 // so we explicitly define it to the best of our knowledge
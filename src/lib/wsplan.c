@@ -0,0 +1,458 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+// profile-guided thread placement: partition a parse graph across threads
+// using measured kid costs, then write it back out as a graph with
+// %thread() blocks.  See wsplan.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include <unistd.h>
+#include "waterslide.h"
+#include "init.h"
+#include "parse_graph.h"
+#include "wsplan.h"
+
+typedef struct _wsplan_node_t {
+     parse_node_proc_t * proc;
+     double cost; // estimated seconds of kid work
+     int thread; // -1 while unassigned
+     uint32_t nin; // number of input edges
+} wsplan_node_t;
+
+typedef struct _wsplan_edge_t {
+     uint32_t src;
+     uint32_t dst;
+     uint64_t events;
+     double hop; // added to both threads when src and dst are split
+     parse_edge_t * pedge;
+} wsplan_edge_t;
+
+typedef struct _wsplan_t {
+     wsplan_node_t * nodes;
+     uint32_t nnodes;
+     wsplan_edge_t * edges;
+     uint32_t nedges;
+     uint32_t nthreads;
+     double * load;
+} wsplan_t;
+
+static void wsplan_collect_proc(void * vproc, void * ignore) {
+     parse_node_proc_t * proc = (parse_node_proc_t *)vproc;
+     ws_proc_instance_t * pinst = proc->pinst;
+
+     if (!pinst) {
+          return;
+     }
+     proc->num_calls = pinst->plan_calls;
+     proc->num_out = pinst->doutput.plan_emitted;
+     proc->time = 0.;
+     if (pinst->plan_samples) {
+          // scale the mean sampled call up to every call seen
+          proc->time = ((double)pinst->plan_ns / (double)pinst->plan_samples) *
+               (double)pinst->plan_calls * 1e-9;
+     }
+}
+
+void ws_plan_collect(parse_graph_t * pg) {
+     listhash_scour(pg->procs, wsplan_collect_proc, NULL);
+}
+
+int ws_plan_load_profile(parse_graph_t * pg, const char * filename) {
+     FILE * fp = fopen(filename, "r");
+     if (!fp) {
+          error_print("unable to open placement profile %s", filename);
+          return 0;
+     }
+
+     char line[1024];
+     char key[256];
+     double time;
+     uint64_t calls, out;
+     int found = 0;
+     const int taglen = strlen(WSPLAN_PROFILE_TAG);
+
+     while (fgets(line, sizeof(line), fp)) {
+          if (strncmp(line, WSPLAN_PROFILE_TAG, taglen) != 0) {
+               continue;
+          }
+          if (sscanf(line + taglen, "%255s %lf %" SCNu64 " %" SCNu64,
+                     key, &time, &calls, &out) != 4) {
+               continue;
+          }
+          parse_node_proc_t * proc =
+               (parse_node_proc_t *)listhash_find(pg->procs, key, strlen(key));
+          if (!proc) {
+               tool_print("profile kid %s is not in this graph", key);
+               continue;
+          }
+          proc->time = time;
+          proc->num_calls = calls;
+          proc->num_out = out;
+          found++;
+     }
+     fclose(fp);
+     return found;
+}
+
+static void wsplan_add_node(void * vproc, void * vplan) {
+     wsplan_t * plan = (wsplan_t *)vplan;
+     parse_node_proc_t * proc = (parse_node_proc_t *)vproc;
+     wsplan_node_t * node = &plan->nodes[plan->nnodes++];
+
+     node->proc = proc;
+     node->cost = proc->time > 0. ? proc->time : 0.;
+     node->thread = -1;
+}
+
+// heaviest kids first
+static int wsplan_node_cmp(const void * va, const void * vb) {
+     const wsplan_node_t * a = (const wsplan_node_t *)va;
+     const wsplan_node_t * b = (const wsplan_node_t *)vb;
+     if (a->cost > b->cost) {
+          return -1;
+     }
+     if (a->cost < b->cost) {
+          return 1;
+     }
+     return strcmp(a->proc->name, b->proc->name);
+}
+
+static int wsplan_find_node(wsplan_t * plan, void * proc) {
+     uint32_t i;
+     for (i = 0; i < plan->nnodes; i++) {
+          if (plan->nodes[i].proc == proc) {
+               return i;
+          }
+     }
+     return -1;
+}
+
+static int wsplan_build(wsplan_t * plan, parse_graph_t * pg, uint32_t nthreads) {
+     q_node_t * qnode;
+
+     plan->nthreads = nthreads;
+     plan->nodes = (wsplan_node_t *)calloc(pg->procs->records + 1,
+                                           sizeof(wsplan_node_t));
+     plan->edges = (wsplan_edge_t *)calloc(pg->edges->size + 1,
+                                           sizeof(wsplan_edge_t));
+     plan->load = (double *)calloc(nthreads, sizeof(double));
+     if (!plan->nodes || !plan->edges || !plan->load) {
+          error_print("failed wsplan_build calloc");
+          return 0;
+     }
+
+     listhash_scour(pg->procs, wsplan_add_node, plan);
+     qsort(plan->nodes, plan->nnodes, sizeof(wsplan_node_t), wsplan_node_cmp);
+
+     for (qnode = pg->edges->head; qnode; qnode = qnode->next) {
+          parse_edge_t * pedge = (parse_edge_t *)qnode->data;
+          if (!pedge || pedge->edgetype != PARSE_EDGE_TYPE_PROCPROC) {
+               continue;
+          }
+          int src = wsplan_find_node(plan, pedge->src);
+          int dst = wsplan_find_node(plan, pedge->dst);
+          if ((src < 0) || (dst < 0)) {
+               continue;
+          }
+          wsplan_edge_t * edge = &plan->edges[plan->nedges++];
+          edge->src = src;
+          edge->dst = dst;
+          edge->pedge = pedge;
+          plan->nodes[dst].nin++;
+     }
+
+     // with a single input the receiver's call count is exactly the edge
+     // traffic; otherwise assume every emitted event reaches it
+     uint32_t i;
+     for (i = 0; i < plan->nedges; i++) {
+          wsplan_edge_t * edge = &plan->edges[i];
+          parse_node_proc_t * sproc = plan->nodes[edge->src].proc;
+          parse_node_proc_t * dproc = plan->nodes[edge->dst].proc;
+          if (plan->nodes[edge->dst].nin == 1) {
+               edge->events = dproc->num_calls;
+          }
+          else {
+               edge->events = (sproc->num_out < dproc->num_calls) ?
+                    sproc->num_out : dproc->num_calls;
+          }
+          edge->hop = (double)edge->events * WSPLAN_HOP_SEC;
+     }
+     return 1;
+}
+
+// fill in per-thread load; returns the busiest thread's load and sets the
+// total queue hop cost in cut
+static double wsplan_loads(wsplan_t * plan, double * cut) {
+     uint32_t i;
+     double span = 0.;
+
+     memset(plan->load, 0, plan->nthreads * sizeof(double));
+     *cut = 0.;
+     for (i = 0; i < plan->nnodes; i++) {
+          if (plan->nodes[i].thread >= 0) {
+               plan->load[plan->nodes[i].thread] += plan->nodes[i].cost;
+          }
+     }
+     for (i = 0; i < plan->nedges; i++) {
+          int st = plan->nodes[plan->edges[i].src].thread;
+          int dt = plan->nodes[plan->edges[i].dst].thread;
+          if ((st >= 0) && (dt >= 0) && (st != dt)) {
+               plan->load[st] += plan->edges[i].hop;
+               plan->load[dt] += plan->edges[i].hop;
+               *cut += plan->edges[i].hop;
+          }
+     }
+     for (i = 0; i < plan->nthreads; i++) {
+          if (plan->load[i] > span) {
+               span = plan->load[i];
+          }
+     }
+     return span;
+}
+
+static inline int wsplan_better(double span, double cut,
+                                double best_span, double best_cut) {
+     const double eps = 1e-12;
+     if (span < best_span - eps) {
+          return 1;
+     }
+     return (span <= best_span + eps) && (cut < best_cut - eps);
+}
+
+static void wsplan_partition(wsplan_t * plan) {
+     uint32_t i, t;
+     int pass;
+     double span, cut, best_span, best_cut;
+
+     // greedy: heaviest kid first onto the thread that keeps the busiest
+     // thread lightest, counting queue hops to kids already placed
+     for (i = 0; i < plan->nnodes; i++) {
+          int best = 0;
+          best_span = best_cut = -1.;
+          for (t = 0; t < plan->nthreads; t++) {
+               plan->nodes[i].thread = t;
+               span = wsplan_loads(plan, &cut);
+               if ((best_span < 0.) ||
+                   wsplan_better(span, cut, best_span, best_cut)) {
+                    best = t;
+                    best_span = span;
+                    best_cut = cut;
+               }
+          }
+          plan->nodes[i].thread = best;
+     }
+
+     // refine by moving single kids while that helps
+     best_span = wsplan_loads(plan, &best_cut);
+     for (pass = 0; pass < WSPLAN_REFINE_PASSES; pass++) {
+          int moved = 0;
+          for (i = 0; i < plan->nnodes; i++) {
+               int orig = plan->nodes[i].thread;
+               for (t = 0; t < plan->nthreads; t++) {
+                    if ((int)t == orig) {
+                         continue;
+                    }
+                    plan->nodes[i].thread = t;
+                    span = wsplan_loads(plan, &cut);
+                    if (wsplan_better(span, cut, best_span, best_cut)) {
+                         best_span = span;
+                         best_cut = cut;
+                         orig = t;
+                         moved = 1;
+                    }
+               }
+               plan->nodes[i].thread = orig;
+          }
+          if (!moved) {
+               break;
+          }
+     }
+}
+
+// stream variable naming the output of a kid
+static void wsplan_print_var(FILE * fp, parse_node_proc_t * proc) {
+     const char * c;
+     fputs("$", fp);
+     for (c = proc->name; *c; c++) {
+          fputc(isalnum((unsigned char)*c) ? *c : '_', fp);
+     }
+     fprintf(fp, "_%u", proc->version);
+}
+
+// print a kid argument so that the graph parser reads it back unchanged
+static void wsplan_print_token(FILE * fp, const char * tok) {
+     const char * c;
+     int plain = (*tok != '\0') && (*tok != '#') && (*tok != ',');
+     for (c = tok; *c && plain; c++) {
+          if (!isalnum((unsigned char)*c) && !strchr("._/-+=*@^~!?&,", *c)) {
+               plain = 0;
+          }
+     }
+     if (plain) {
+          fputs(tok, fp);
+     }
+     else if (strchr(tok, '"') && !strchr(tok, '\'')) {
+          fprintf(fp, "'%s'", tok);
+     }
+     else {
+          fputc('"', fp);
+          for (c = tok; *c; c++) {
+               if (*c == '"') {
+                    fputc('\\', fp);
+               }
+               fputc(*c, fp);
+          }
+          fputc('"', fp);
+     }
+}
+
+static void wsplan_print_kid(FILE * fp, wsplan_t * plan, uint32_t n) {
+     parse_node_proc_t * proc = plan->nodes[n].proc;
+     uint32_t i;
+     int first = 1, has_out = 0;
+
+     fprintf(fp, "     ");
+     for (i = 0; i < plan->nedges; i++) {
+          wsplan_edge_t * edge = &plan->edges[i];
+          if (edge->src == n) {
+               has_out = 1;
+          }
+          if (edge->dst != n) {
+               continue;
+          }
+          if (!first) {
+               fprintf(fp, ", ");
+          }
+          first = 0;
+          wsplan_print_var(fp, plan->nodes[edge->src].proc);
+          if (edge->pedge->src_label) {
+               fprintf(fp, ".%s", edge->pedge->src_label);
+          }
+          if (edge->pedge->port) {
+               fprintf(fp, ":%s", edge->pedge->port);
+          }
+     }
+     if (!first) {
+          fprintf(fp, " | ");
+     }
+     for (i = 0; i < proc->argc; i++) {
+          if (i) {
+               fputc(' ', fp);
+          }
+          wsplan_print_token(fp, proc->argv[i]);
+     }
+     if (has_out) {
+          fprintf(fp, " -> ");
+          wsplan_print_var(fp, proc);
+     }
+     fprintf(fp, "\n");
+}
+
+int ws_plan_write(parse_graph_t * pg, uint32_t nthreads, FILE * fp) {
+     wsplan_t plan;
+     uint32_t i, t;
+     double cut, span, total = 0.;
+     uint64_t cut_events = 0;
+
+     if (!pg || !fp) {
+          return 0;
+     }
+     if (!nthreads) {
+          nthreads = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+     }
+
+     memset(&plan, 0, sizeof(plan));
+     if (!wsplan_build(&plan, pg, nthreads)) {
+          fclose(fp);
+          return 0;
+     }
+     wsplan_partition(&plan);
+     span = wsplan_loads(&plan, &cut);
+     for (t = 0; t < nthreads; t++) {
+          total += plan.load[t];
+     }
+     for (i = 0; i < plan.nedges; i++) {
+          if (plan.nodes[plan.edges[i].src].thread !=
+              plan.nodes[plan.edges[i].dst].thread) {
+               cut_events += plan.edges[i].events;
+          }
+     }
+     if (total <= 0.) {
+          tool_print("no kid time was measured; placement is by graph shape only");
+     }
+
+     fprintf(fp, "# thread placement for %u threads over %u kids\n",
+             nthreads, plan.nnodes);
+     fprintf(fp, "# expected load per thread (kid time plus queue hops):\n");
+     for (t = 0; t < nthreads; t++) {
+          fprintf(fp, "#   thread %u: %10.3f s %6.1f%%  ", t, plan.load[t],
+                  total > 0. ? plan.load[t] / total * 100. : 0.);
+          for (i = 0; i < plan.nnodes; i++) {
+               if (plan.nodes[i].thread == (int)t) {
+                    fprintf(fp, " %s.%u", plan.nodes[i].proc->name,
+                            plan.nodes[i].proc->version);
+               }
+          }
+          fprintf(fp, "\n");
+          status_print("placement thread %u: %.3f s (%.1f%%)", t, plan.load[t],
+                       total > 0. ? plan.load[t] / total * 100. : 0.);
+     }
+     fprintf(fp, "# busiest thread %.3f s; %" PRIu64 " events cross threads"
+             " (%.3f s of queue hops)\n", span, cut_events, cut);
+     status_print("placement: busiest thread %.3f s, %" PRIu64
+                  " events cross threads", span, cut_events);
+
+     fprintf(fp, "#\n# profile (re-plan with -I <this file>):\n");
+     for (i = 0; i < plan.nnodes; i++) {
+          parse_node_proc_t * proc = plan.nodes[i].proc;
+          fprintf(fp, WSPLAN_PROFILE_TAG " %s.%u %.9f %" PRIu64 " %" PRIu64 "\n",
+                  proc->name, proc->version, proc->time, proc->num_calls,
+                  proc->num_out);
+     }
+
+     for (t = 0; t < nthreads; t++) {
+          int open = 0;
+          for (i = 0; i < plan.nnodes; i++) {
+               if (plan.nodes[i].thread != (int)t) {
+                    continue;
+               }
+               if (!open) {
+                    fprintf(fp, "\n%%thread(%u) {\n", t);
+                    open = 1;
+               }
+               wsplan_print_kid(fp, &plan, i);
+          }
+          if (open) {
+               fprintf(fp, "}\n");
+          }
+     }
+     fclose(fp);
+
+     free(plan.nodes);
+     free(plan.edges);
+     free(plan.load);
+     return 1;
+}
@@ -32,6 +32,7 @@ SOFTWARE.
 #include <assert.h>
 #include "waterslide.h"
 #include "waterslidedata.h"
+#include "waterslide_io.h"
 #include "wsprocbuffer.h"
 #include "datatypes/wsdt_tuple.h"
 #include "wstypes.h"
@@ -142,6 +143,13 @@ proc_process_t wsprocbuffer_input_set(void * vinstance, wsdatatype_t * input_typ
 
      if (!proc->outtype_tuple) {
           proc->outtype_tuple = ws_add_outtype(olist, dtype_tuple, NULL);
+          // the demand itself is only known once the whole graph is set up
+          if (proc->outtype_tuple && proc->kproc &&
+              (proc->kid->demand_offset >= 0)) {
+               *(ws_label_demand_t ***)((uint8_t *)proc->kproc +
+                                        proc->kid->demand_offset) =
+                    &proc->outtype_tuple->demand;
+          }
      }
 
      if (input_type == dtype_tuple) {
@@ -31,11 +31,15 @@ SOFTWARE.
 #include "waterslide.h"
 #include "waterslidedata.h"
 #include "waterslide_io.h"
+#include "wsjobring.h"
 #include "mimo.h"
 #include "wsprocess.h"
 #include "init.h"
 #include "shared/getrank.h"
 #include "wsperf.h"
+#include "wsplan.h"
+#include "wsmem.h"
+#include "sysutil.h"
 #include "setup_exit.h"
 #include "shared/wsprocess_shared.h"
 #include "shared/shared_queue.h"
@@ -48,39 +52,81 @@ extern uint32_t deadlock_firehose_shutoff;
 
 
 int ws_add_local_job_source(mimo_t * mimo, wsdata_t * data, ws_subscriber_t * sub) {
-     ws_job_t * job;
-
      const int nrank = GETRANK();
-     if ((job = queue_remove(mimo->jobq_freeq[nrank])) == NULL)
-     {
+     // okay with pthreads too!
+     return jobring_add(mimo->jobq[nrank], data, sub);
+}
+
+// hand a run of queued jobs for one subscriber to its batch function; the
+// first job has already been removed from the queue.  Returns the number of
+// jobs consumed.
+static int ws_do_batch_jobs(ws_jobring_t * jobq, ws_job_t * job,
+                            ws_subscriber_t * sub) {
+     wsdata_t * held[WS_BATCH_MAX];
+     wsdata_t * batch[WS_BATCH_MAX];
+     ws_job_t * next;
+     int nheld = 0;
+     int n = 0;
+     int i;
+     WSPERF_NRANK();
+     WSPERF_LOCAL_INIT();
+     WSPLAN_LOCAL_INIT();
 
-          // okay with pthreads too!
-          job = (ws_job_t*)malloc(sizeof(ws_job_t));
-          if (!job) {
-               error_print("failed ws_add_local_job_source malloc of job");
-               return 0;
+     held[nheld++] = job->data;
+     while ((nheld < WS_BATCH_MAX) && (next = jobring_peek(jobq)) &&
+            (next->subscribers == sub)) {
+          held[nheld++] = next->data;
+          jobring_remove(jobq, job);
+     }
+
+     for (i = 0; i < nheld; i++) {
+          if (!sub->src_label || wsdata_check_label(held[i], sub->src_label)) {
+               batch[n++] = held[i];
           }
      }
-     job->data = data;
-     job->subscribers = sub;
-     if (!queue_add(mimo->jobq[nrank], job)) 
-     {
-          return 0;
+
+     if (n) {
+          dprint("running %d data thru %s", n, sub->proc_instance->name);
+          WSPERF_TIME0_N(sub->proc_instance->kid.uid-1, n);
+          WSPLAN_TIME0_N(sub->proc_instance, n);
+          sub->proc_batch_func(sub->local_instance, batch, n, sub->doutput,
+                               sub->input_index);
+          WSPLAN_TIME_N(sub->proc_instance, n);
+          WSPERF_PROC_COUNT_N(sub->proc_instance->kid.uid-1, n);
+          WSPERF_TIME_N(sub->proc_instance->kid.uid-1, n);
      }
-     return 1;
+
+     //remove references to data
+     for (i = 0; i < nheld; i++) {
+          wsdata_delete(held[i]);
+     }
+     return nheld;
 }
 
-static int ws_do_local_jobs(mimo_t * mimo, nhqueue_t * jobq, nhqueue_t * jobq_freeq) {
+static int ws_do_local_jobs(mimo_t * mimo, ws_jobring_t * jobq) {
      //fprintf(stderr,"wsprocess: do_job\n");
-     ws_job_t * job;
+     ws_job_t jobrec;
+     ws_job_t * job = &jobrec;
      ws_subscriber_t * sub;
      int cnt = 0;
      WSPERF_NRANK();
      WSPERF_LOCAL_INIT();
+     WSPLAN_LOCAL_INIT();
 
      //fprintf(stderr,"walking jobs\n");
-     while ((job = queue_remove(jobq)) !=NULL)
+     while (jobring_remove(jobq, job))
      {
+          // a lone subscriber with a batch form takes every job queued
+          // behind this one for it in a single call
+          sub = job->subscribers;
+          if (sub && !sub->next && sub->proc_batch_func) {
+               ws_job_t * next = jobring_peek(jobq);
+               if (next && (next->subscribers == sub)) {
+                    cnt += ws_do_batch_jobs(jobq, job, sub);
+                    continue;
+               }
+          }
+
           cnt++;
           // call processor
           // each job is dequeued from the appropriate thread's jobq
@@ -95,8 +141,10 @@ static int ws_do_local_jobs(mimo_t * mimo, nhqueue_t * jobq, nhqueue_t * jobq_fr
                                  sub->proc_instance->name);
                     //fprintf(stderr,"wsprocess: do_job sub\n");
                     WSPERF_TIME0(sub->proc_instance->kid.uid-1);
+                    WSPLAN_TIME0(sub->proc_instance);
                     sub->proc_func(sub->local_instance, job->data,
                                        sub->doutput, sub->input_index);
+                    WSPLAN_TIME(sub->proc_instance);
                     WSPERF_PROC_COUNT(sub->proc_instance->kid.uid-1);
                     WSPERF_TIME(sub->proc_instance->kid.uid-1);
                     //fprintf(stderr,"wsprocess: do_job sub addjob\n");
@@ -107,17 +155,27 @@ static int ws_do_local_jobs(mimo_t * mimo, nhqueue_t * jobq, nhqueue_t * jobq_fr
 
           //remove reference to data
           wsdata_delete(job->data);
-
-          //if (!queue_add(mimo->jobq_freeq, job)) 
-          if (!queue_add(jobq_freeq, job)) 
-          {
-               error_print("failed queue_add alloc");
-               return 0;
-          }
      }
      return cnt;
 }
 
+// whether this thread still has queued work.  Only the calling thread's
+// own queues are sampled: it is their sole consumer and drains them later
+// in the same pass, so the throttle always releases once they are empty.
+// Data handed to other threads is bounded by their shared queues, which
+// push back on full
+static int ws_jobs_in_flight(mimo_t * mimo, const int nrank) {
+     if (mimo->jobq[nrank]->size) {
+          return 1;
+     }
+#ifdef WS_PTHREADS
+     if (!shared_queue_empty(mimo->shared_jobq[nrank])) {
+          return 1;
+     }
+#endif // WS_PTHREADS
+     return 0;
+}
+
 //return 0 if no sources had data..
 int ws_execute_graph(mimo_t * mimo) {
      //process all mimo sources
@@ -134,6 +192,10 @@ int ws_execute_graph(mimo_t * mimo) {
      //see if mimo external source was added
      const int nrank = GETRANK();
      WSPERF_LOCAL_INIT();
+     WSPLAN_LOCAL_INIT();
+
+     //one clock read serves every kid run on this pass
+     sysutil_clock_tick();
 
 #ifdef WS_PTHREADS
      ws_subscriber_t * scursor = NULL;
@@ -173,6 +235,19 @@ int ws_execute_graph(mimo_t * mimo) {
      }
 #endif // WS_PTHREADS
 
+     if (0 == nrank && wsmem_report_pending) {
+          wsmem_report_pending = 0;
+          wsmem_print(stderr);
+     }
+
+     // over the memory budget, sources wait for what they already emitted
+     // to drain so that pooled data is recycled rather than the pools grown
+     int mem_throttle = 0;
+     if (wsmem_budget && mimo->proc_sources && wsmem_over_budget() &&
+         ws_jobs_in_flight(mimo, nrank)) {
+          mem_throttle = 1;
+     }
+
      //fprintf(stderr,"wsprocess: walking sources\n");
      for (cursor = mimo->proc_sources; cursor; cursor = cursor->next) {
 #ifdef WS_PTHREADS
@@ -186,6 +261,12 @@ int ws_execute_graph(mimo_t * mimo) {
           }
           if (cursor->pinstance->thread_id != nrank) continue;
 #endif // WS_PTHREADS
+          if (mem_throttle) {
+               // as with the deadlock shutoff, keep the graph from exiting
+               (void)__sync_fetch_and_add(&wsmem_throttled, 1);
+               src_out = 1;
+               break;
+          }
           if (cursor->proc_func) {
                //alloc a data type
                data = wsdata_alloc(cursor->outtype.dtype);
@@ -198,11 +279,13 @@ int ws_execute_graph(mimo_t * mimo) {
                rank_has_valid_source = 1;
 #endif // WS_PTHREADS
                WSPERF_TIME0(cursor->pinstance->kid.uid-1);
+               WSPLAN_TIME0(cursor->pinstance);
                if (cursor->proc_func(cursor->pinstance->instance, data,
                                      &cursor->pinstance->doutput,
                                      cursor->input_index)) {
                     src_out++;
                }
+               WSPLAN_TIME(cursor->pinstance);
                WSPERF_PROC_COUNT(cursor->pinstance->kid.uid-1);
                WSPERF_TIME(cursor->pinstance->kid.uid-1);
                //fprintf(stderr,"wsprocess: dereferencing data\n");
@@ -244,7 +327,7 @@ int ws_execute_graph(mimo_t * mimo) {
           int jcnt = 0;
 
           //pop and handle local jobq until empty...
-          jcnt += ws_do_local_jobs(mimo, mimo->jobq[nrank], mimo->jobq_freeq[nrank]);
+          jcnt += ws_do_local_jobs(mimo, mimo->jobq[nrank]);
 
           //pop and handle external (shared) jobq until empty...
           jcnt += WS_DO_EXTERNAL_JOBS(mimo, mimo->shared_jobq[nrank]);
@@ -291,6 +374,8 @@ int ws_execute_exiting_graph(mimo_t * mimo) {
      int jobs_cnt = 0;
      const int nrank = GETRANK();
 
+     sysutil_clock_tick();
+
 #ifdef WS_PTHREADS
      if(mimo->mgc) {
           ws_subscriber_t * scursor = NULL;
@@ -307,7 +392,7 @@ int ws_execute_exiting_graph(mimo_t * mimo) {
 #endif // WS_PTHREADS
 
      //pop and handle local jobq until empty...
-     jobs_cnt += ws_do_local_jobs(mimo, mimo->jobq[nrank], mimo->jobq_freeq[nrank]);
+     jobs_cnt += ws_do_local_jobs(mimo, mimo->jobq[nrank]);
 
      //pop and handle external (shared) jobq until empty...
      jobs_cnt += WS_DO_EXTERNAL_JOBS(mimo, mimo->shared_jobq[nrank]);
@@ -333,6 +418,8 @@ int mimo_flush_graph(mimo_t * mimo) {
      const int nrank = GETRANK();
      WSPERF_LOCAL_INIT();
 
+     sysutil_clock_tick();
+
      wsdata_t * wsd_flush = wsdata_alloc(mimo->flush.outtype_flush.dtype);
      if (!wsd_flush) {
           return 0;
@@ -364,7 +451,7 @@ int mimo_flush_graph(mimo_t * mimo) {
  
                //pop from jobq until empty...
                while(mimo->jobq[nrank]->size) {
-                    jobs += ws_do_local_jobs(mimo, mimo->jobq[nrank], mimo->jobq_freeq[nrank]);
+                    jobs += ws_do_local_jobs(mimo, mimo->jobq[nrank]);
                }
           } while((jobs >= 1) && (flushes < MAX_FLUSHES));
 
@@ -40,6 +40,7 @@ SOFTWARE.
 #include "wstypes.h"
 
 #define LOCAL_OPTIONS "J:V:M:"
+#define WSPKS_BATCH 64
 
 typedef struct _wsprockeystate_inst_t {
      stringhash5_t * state_table;
@@ -69,6 +70,12 @@ typedef struct _wsprockeystate_inst_t {
      int core_len;
      wsdata_t * current_key;
      wsdata_t * current_tuple;
+
+     //keys of a batch hashed and prefetched ahead of their lookups
+     wsdata_t * pf_keys[WSPKS_BATCH];
+     sh5_prefetch_t pf[WSPKS_BATCH];
+     int pf_len;
+     int pf_next;
 } wsprockeystate_inst_t;
 
 //function prototypes for local functions
@@ -338,6 +345,10 @@ int wsprockeystate_init(int argc, char * const * argv, void ** vinstance,
           if (kid->expire_func || kid->expire_multi_func) {
                stringhash5_set_callback(proc->state_table, wsprockeystate_expire, proc);
           }
+          // gradual expiry walks the table, which would miss spilled state
+          if (!kid->gradual_expire) {
+               stringhash5_enable_spill(proc->state_table);
+          }
      }
 
      if (kid->gradual_expire && proc->state_table) {
@@ -428,6 +439,18 @@ static inline void wspks_check_expire_loop(wsprockeystate_inst_t * proc) {
      }
 }
 
+//use the hash worked out when the batch was prefetched, as long as this is
+// the key it was worked out for
+static inline void * wspks_find_attach(wsprockeystate_inst_t * proc,
+                                       wsdata_t * key) {
+     if ((proc->pf_next < proc->pf_len) &&
+         (proc->pf_keys[proc->pf_next] == key)) {
+          return stringhash5_find_attach_prefetched(proc->state_table,
+                                                    &proc->pf[proc->pf_next++]);
+     }
+     return stringhash5_find_attach_wsdata(proc->state_table, key);
+}
+
 //only select first key found as key to use
 static int wspks_nest_search_key(void * vproc, void * vkey,
                            wsdata_t * tdata, wsdata_t * member) {
@@ -496,7 +519,7 @@ static int wsprockeystate_process_multivalue(void * vinstance, wsdata_t* input_d
           return 0;
      }
 
-     void * sdata = stringhash5_find_attach_wsdata(proc->state_table, key);
+     void * sdata = wspks_find_attach(proc, key);
      if (!sdata) {
           return 0;
      }
@@ -577,7 +600,7 @@ static int wsprockeystate_process_key(void * vinstance, wsdata_t* input_data,
                           &mset_len, &mset)) {
           for (j = 0; j < mset_len; j++ ) {
                int found = 0;
-               void * sdata = stringhash5_find_attach_wsdata(proc->state_table, mset[j]);
+               void * sdata = wspks_find_attach(proc, mset[j]);
                if (sdata) {
                     found = 1;
                }
@@ -632,7 +655,7 @@ static int wsprockeystate_process_keyvalue(void * vinstance, wsdata_t* input_dat
      }
 
      int found = 0;
-     void * sdata = stringhash5_find_attach_wsdata(proc->state_table, key);
+     void * sdata = wspks_find_attach(proc, key);
      if (sdata) {
           found = 1;
      }
@@ -670,6 +693,95 @@ static int wsprockeystate_process_keyvalue(void * vinstance, wsdata_t* input_dat
      return 1;
 }
 
+//collect the keys the processing function will look up for a tuple, in the
+// order it looks them up
+static int wspks_batch_keys(wsprockeystate_inst_t * proc, wsdata_t * tdata,
+                            wsdata_t ** keys, int room) {
+     wsdata_t ** mset;
+     int mset_len;
+     int j;
+     wsdata_t * key = NULL;
+
+     if (proc->multivalue) {
+          tuple_nested_search(tdata, &proc->nest_key,
+                              wspks_nest_search_key,
+                              proc, &key);
+          if (key && room) {
+               keys[0] = key;
+               return 1;
+          }
+          return 0;
+     }
+     if (!tuple_find_label(tdata, proc->label_key, &mset_len, &mset)) {
+          return 0;
+     }
+     if (proc->label_value) {
+          mset_len = 1;
+     }
+     for (j = 0; (j < mset_len) && (j < room); j++) {
+          keys[j] = mset[j];
+     }
+     return j;
+}
+
+//hash and prefetch the keys of as many tuples as fit, then run each through
+// the single-event function, which picks up the prefetched keys in turn
+static int wspks_batch(wsprockeystate_inst_t * proc, proc_process_t func,
+                       wsdata_t ** input_data, int len,
+                       ws_doutput_t * dout, int type_index) {
+     int i, start;
+
+     for (i = 0; i < len; ) {
+          proc->pf_len = 0;
+          for (start = i; (i < len) && (proc->pf_len < WSPKS_BATCH); i++) {
+               proc->pf_len += wspks_batch_keys(proc, input_data[i],
+                                                proc->pf_keys + proc->pf_len,
+                                                WSPKS_BATCH - proc->pf_len);
+          }
+          stringhash5_prefetch_wsdata_batch(proc->state_table, proc->pf_keys,
+                                            proc->pf_len, proc->pf);
+          proc->pf_next = 0;
+          for (; start < i; start++) {
+               func(proc, input_data[start], dout, type_index);
+          }
+     }
+     proc->pf_len = 0;
+     proc->pf_next = 0;
+
+     return len;
+}
+
+static int wsprockeystate_process_key_batch(void * vinstance, wsdata_t** input_data,
+                                            int len, ws_doutput_t * dout,
+                                            int type_index) {
+     return wspks_batch((wsprockeystate_inst_t*)vinstance,
+                        wsprockeystate_process_key,
+                        input_data, len, dout, type_index);
+}
+
+static int wsprockeystate_process_keyvalue_batch(void * vinstance, wsdata_t** input_data,
+                                                 int len, ws_doutput_t * dout,
+                                                 int type_index) {
+     return wspks_batch((wsprockeystate_inst_t*)vinstance,
+                        wsprockeystate_process_keyvalue,
+                        input_data, len, dout, type_index);
+}
+
+static int wsprockeystate_process_multivalue_batch(void * vinstance, wsdata_t** input_data,
+                                                   int len, ws_doutput_t * dout,
+                                                   int type_index) {
+     return wspks_batch((wsprockeystate_inst_t*)vinstance,
+                        wsprockeystate_process_multivalue,
+                        input_data, len, dout, type_index);
+}
+
+proc_batch_t wsprockeystate_batch[] = {
+     {wsprockeystate_process_key, wsprockeystate_process_key_batch},
+     {wsprockeystate_process_keyvalue, wsprockeystate_process_keyvalue_batch},
+     {wsprockeystate_process_multivalue, wsprockeystate_process_multivalue_batch},
+     {NULL, NULL}
+};
+
 //triggered when any tuple is set ot the expire port
 static int wsprockeystate_expire_port(void * vinstance, wsdata_t* input_data,
                                       ws_doutput_t * dout, int type_index) {
@@ -48,6 +48,7 @@ wsdatatype_t * dtype_label;
 wsdatatype_t * dtype_massivestring;
 wsdatatype_t * dtype_hugeblock;
 wsdatatype_t * dtype_mmap;
+wsdatatype_t * dtype_extbuf;
 wsdatatype_t * dtype_flush;
 wsdatatype_t * dtype_array_uint;
 wsdatatype_t * dtype_array_double;
@@ -81,6 +82,7 @@ void init_wstypes(void * tl) {
      dtype_massivestring = wsdatatype_get(tl, "MASSIVESTRING_TYPE");
      dtype_hugeblock = wsdatatype_get(tl, "HUGEBLOCK_TYPE");
      dtype_mmap = wsdatatype_get(tl, "MMAP_TYPE");
+     dtype_extbuf = wsdatatype_get(tl, "EXTBUF_TYPE");
      dtype_flush = wsdatatype_get(tl, "FLUSH_TYPE");
      dtype_array_double = wsdatatype_get(tl, "ARRAY_DOUBLE_TYPE");
      dtype_array_uint = wsdatatype_get(tl, "ARRAY_UINT_TYPE");
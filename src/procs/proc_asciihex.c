@@ -29,11 +29,12 @@ SOFTWARE.
 #include <stdio.h>
 #include <unistd.h>
 #include "procloader_buffer.h"
+#include "wsstrsimd.h"
 
 int is_procbuffer = 1;
 int procbuffer_pass_not_found = 1;
 
-char proc_version[] = "1.2";
+char proc_version[] = "1.3";
 char proc_requires[]     = "";
 const char *proc_tags[] = { "decoder", NULL };
 char proc_name[] = PROC_NAME;
@@ -188,6 +189,23 @@ int procbuffer_decode(void * vproc, wsdata_t * tdata,
           }
           if (i < (buflen - 1)) {
                if (isxdigit(buf[i]) && isxdigit(buf[i+1])) {
+                    //bulk decode long runs of hex digits
+                    int vlen = proc->ignore_len ? 0 :
+                         wsstr_hexdecode_blocks(buf + i, buflen - i,
+                                                (uint8_t *)bin->buf + blen);
+                    if (vlen) {
+                         if (proc->string_only) {
+                              int j;
+                              for (j = blen; j < blen + (vlen >> 1); j++) {
+                                   if (!isprint(bin->buf[j])) {
+                                        bin->buf[j] = proc->nonprint_char;
+                                   }
+                              }
+                         }
+                         blen += vlen >> 1;
+                         i += vlen - 1;
+                         continue;
+                    }
                     bin->buf[blen] = (get_xdigit(buf[i]) << 4) + get_xdigit(buf[i+1]);
                     if (proc->string_only && !isprint(bin->buf[blen])) {
                          bin->buf[blen] = proc->nonprint_char;
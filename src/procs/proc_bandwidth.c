@@ -31,6 +31,7 @@ SOFTWARE.
 #include "waterslide.h"
 #include "waterslidedata.h"
 #include "datatypes/wsdt_tuple.h"
+#include "sysutil.h"
 #include "procloader.h"
 
 char proc_name[]               =  PROC_NAME;
@@ -183,9 +184,9 @@ static int proc_binary(void * vinstance, wsdata_t* input_data,
 
      if (!proc->do_init) {
           proc->do_init=1;
-          gettimeofday(&proc->real_start_time, NULL);
+          sysutil_getwalltime(&proc->real_start_time);
      }
-     gettimeofday(&proc->real_end_time, NULL);
+     sysutil_getwalltime(&proc->real_end_time);
 
      return 0;
 }
@@ -197,9 +198,9 @@ static int proc_meta(void * vinstance, wsdata_t* input_data,
 
      if (!proc->do_init) {
           proc->do_init=1;
-          gettimeofday(&proc->real_start_time, NULL);
+          sysutil_getwalltime(&proc->real_start_time);
      }
-     gettimeofday(&proc->real_end_time, NULL);
+     sysutil_getwalltime(&proc->real_end_time);
 
      return 0;
 }
@@ -346,7 +347,7 @@ static int proc_flush(void * vinstance, wsdata_t* input_data,
           return 0;
      }
      if(proc->do_timestamp) {
-         time_t sec = time(NULL);
+         time_t sec = sysutil_time();
          tuple_member_create_sec(tdata, sec, proc->label_datetime); 
      }
      if (proc->event_cnt) {
@@ -0,0 +1,197 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#define PROC_NAME "bench_in"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include "waterslide.h"
+#include "waterslidedata.h"
+#include "procloader.h"
+#include "datatypes/wsdt_tuple.h"
+
+char proc_version[]     = "1.0";
+char *proc_tags[]     = { "source", "input", NULL };
+char *proc_alias[]     = { NULL };
+char proc_name[]       = PROC_NAME;
+char proc_purpose[]    = "emit empty tuples as fast as possible to measure framework overhead";
+char *proc_synopsis[] = {"bench_in [-c <count>] [-m]", NULL};
+char proc_description[] = "Benchmark source.  Emits a fixed number of tuples with as little work per "
+     "tuple as possible so that the cost measured downstream is the cost of moving events through the "
+     "graph.  Pair with bench_out at the end of a chain of kids (e.g. noop) to get events per second "
+     "through the chain.  With -m each tuple carries a single uint member.";
+char proc_requires[] = "";
+proc_example_t proc_examples[] = {
+	{"bench_in -c 10000000 | noop | noop | noop | noop | bench_out", "measure events per second through a 4 kid noop chain"},
+	{NULL, NULL}
+};
+
+proc_option_t proc_opts[] = {
+     /*  'option character', "long option string", "option argument",
+	 "option description", <allow multiple>, <required>*/
+     {'c',"","count",
+     "number of tuples to emit (default 10000000)",0,0},
+     {'m',"","",
+     "add a uint member to each tuple",0,0},
+     //the following must be left as-is to signify the end of the array
+     {' ',"","",
+     "",0,0}
+};
+
+char *proc_input_types[] = {"None", NULL};
+char *proc_output_types[] = {"tuple", NULL};
+proc_port_t proc_input_ports[] = {{NULL, NULL}};
+char *proc_tuple_container_labels[] = {NULL};
+char *proc_tuple_conditional_container_labels[] = {NULL};
+char *proc_tuple_member_labels[] = {"SEQ", NULL};
+char proc_nonswitch_opts[] = "";
+
+//function prototypes for local functions
+static int proc_source(void * , wsdata_t*, ws_doutput_t *, int);
+
+typedef struct _proc_instance_t {
+     uint64_t outcnt;
+     uint64_t max;
+     int add_member;
+     struct timespec start;
+     struct timespec stop;
+
+     ws_outtype_t *outtype_tuple;
+     wslabel_t * label_seq;
+} proc_instance_t;
+
+static int proc_cmd_options(int argc, char ** argv, 
+                             proc_instance_t * proc) {
+     int op;
+
+     while ((op = getopt(argc, argv, "c:m")) != EOF) {
+          switch (op) {
+          case 'c':
+               proc->max = (uint64_t)strtoull(optarg, NULL, 0);
+               break;
+          case 'm':
+               proc->add_member = 1;
+               break;
+          default:
+               return 0;
+          }
+     }
+     
+     return 1;
+}
+
+// the following is a function to take in command arguments and initalize
+// this processor's instance..
+//  also register as a source here..
+// return 1 if ok
+// return 0 if fail
+int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourcev_t * sv,
+              void * type_table) {
+     
+     //allocate proc instance of this processor
+     proc_instance_t * proc =
+          (proc_instance_t*)calloc(1,sizeof(proc_instance_t));
+     *vinstance = proc;
+
+     proc->max = 10000000;
+     proc->label_seq = wsregister_label(type_table, "SEQ");
+
+     //read in command options
+     if (!proc_cmd_options(argc, argv, proc)) {
+          return 0;
+     }
+ 
+     proc->outtype_tuple =
+          ws_register_source_byname(type_table,
+                                    "TUPLE_TYPE", proc_source, sv);
+
+     if (proc->outtype_tuple ==NULL) {
+          error_print("Error attempting to register source");
+          return 0;
+     }
+
+     return 1; 
+}
+
+// this function needs to decide on processing function based on datatype
+// given.. also set output types as needed (unless a sink)
+//return 1 if ok
+// return 0 if problem
+proc_process_t proc_input_set(void * vinstance, wsdatatype_t * dtype,
+                              wslabel_t * port,
+                              ws_outlist_t* olist, int type_index,
+                              void * type_table) {
+     // this is a source, so we are expecting no inputs..
+     return NULL;
+}
+
+//// proc source function assigned to a specific data type
+//return 1 if output is available
+// return 0 if not output
+static int proc_source(void * vinstance, wsdata_t* source_data,
+                       ws_doutput_t * dout, int type_index) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+
+     if (proc->outcnt >= proc->max) {
+          if (proc->outcnt && !proc->stop.tv_sec) {
+               clock_gettime(CLOCK_MONOTONIC, &proc->stop);
+          }
+          return 0;
+     }
+     if (!proc->outcnt) {
+          clock_gettime(CLOCK_MONOTONIC, &proc->start);
+     }
+
+     if (proc->add_member) {
+          tuple_member_create_uint(source_data, (uint32_t)proc->outcnt,
+                                   proc->label_seq);
+     }
+
+     ws_set_outdata(source_data, proc->outtype_tuple, dout);
+     proc->outcnt++;
+     
+     return 1;
+}
+
+//return 1 if successful
+//return 0 if no..
+int proc_destroy(void * vinstance) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     tool_print("output cnt %" PRIu64, proc->outcnt);
+
+     if (proc->stop.tv_sec) {
+          double secs = (double)(proc->stop.tv_sec - proc->start.tv_sec) +
+               (double)(proc->stop.tv_nsec - proc->start.tv_nsec) / 1e9;
+          if (secs > 0) {
+               tool_print("emitted %" PRIu64 " events in %.3f sec, %.0f events/sec",
+                          proc->outcnt, secs, (double)proc->outcnt / secs);
+          }
+     }
+
+     //free dynamic allocations
+     free(proc);
+
+     return 1;
+}
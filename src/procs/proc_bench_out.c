@@ -0,0 +1,197 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#define PROC_NAME "bench_out"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include "waterslide.h"
+#include "waterslidedata.h"
+#include "procloader.h"
+
+char proc_name[]               =  PROC_NAME;
+char proc_version[]            =  "1.0";
+char *proc_tags[]              =  {"output", NULL};
+char *proc_alias[]             =  { NULL };
+char proc_purpose[]            =  "count events and report events per second";
+char *proc_synopsis[]          =  {"bench_out [-i <count>]", NULL};
+char proc_description[] = "Benchmark sink.  Counts every event it receives and reports the event "
+     "rate from the first event to the exit flush (or to shutdown when flushing is off).  With -i it also reports the rate of each "
+     "interval of that many events while running.  Pair with bench_in to measure events per second "
+     "through a chain of kids."; 
+proc_example_t proc_examples[] = {
+	{"bench_in -c 10000000 | noop | noop | bench_out", "measure events per second through a 2 kid noop chain"},
+	{"... | bench_out -i 1000000", "report the event rate after every million events"},
+	{NULL, NULL}
+};
+
+proc_option_t proc_opts[]      =  {
+     /*  'option character', "long option string", "option argument",
+	 "option description", <allow multiple>, <required>*/
+     {'i',"","count",
+     "report rate every count events",0,0},
+     //the following must be left as-is to signify the end of the array
+     {' ',"","",
+     "",0,0}
+};
+char proc_nonswitch_opts[]     =  "None";
+char *proc_input_types[]       =  {"any", NULL};
+char *proc_output_types[]      =  {NULL};
+char proc_requires[]           =  "None";
+proc_port_t proc_input_ports[] =  {{NULL, NULL}};
+char *proc_tuple_container_labels[] =  {NULL};
+char *proc_tuple_conditional_container_labels[] =  {NULL};
+char *proc_tuple_member_labels[] =  {NULL};
+
+//function prototypes for local functions
+static int proc_process_meta(void *, wsdata_t*, ws_doutput_t*, int);
+static int proc_flush(void *, wsdata_t*, ws_doutput_t*, int);
+
+typedef struct _proc_instance_t {
+     uint64_t meta_process_cnt;
+     uint64_t interval;
+     uint64_t interval_cnt;
+     struct timespec first;
+     struct timespec last;
+     struct timespec interval_start;
+} proc_instance_t;
+
+static double bench_elapsed(struct timespec * start, struct timespec * stop) {
+     return (double)(stop->tv_sec - start->tv_sec) +
+          (double)(stop->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int proc_cmd_options(int argc, char ** argv, 
+                            proc_instance_t * proc, void * type_table) {
+     int op;
+
+     while ((op = getopt(argc, argv, "i:")) != EOF) {
+          switch (op) {
+          case 'i':
+               proc->interval = (uint64_t)strtoull(optarg, NULL, 0);
+               break;
+          default:
+               return 0;
+          }
+     }
+     return 1;
+}
+
+// the following is a function to take in command arguments and initalize
+// this processor's instance..
+//  also register as a source here..
+// return 1 if ok
+// return 0 if fail
+int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourcev_t * sv,
+              void * type_table) {
+     
+     //allocate proc instance of this processor
+     proc_instance_t * proc =
+          (proc_instance_t*)calloc(1,sizeof(proc_instance_t));
+     *vinstance = proc;
+
+     //read in command options
+     if (!proc_cmd_options(argc, argv, proc, type_table)) {
+          return 0;
+     }
+
+     return 1; 
+}
+
+// this function needs to decide on processing function based on datatype
+// given.. also set output types as needed (unless a sink)
+//return 1 if ok
+// return 0 if problem
+proc_process_t proc_input_set(void * vinstance, wsdatatype_t * meta_type,
+                              wslabel_t * port,
+                              ws_outlist_t* olist, int type_index,
+                              void * type_table) {
+     if (wsdatatype_match(type_table, meta_type, "FLUSH_TYPE")) {
+          return proc_flush;
+     }
+     return proc_process_meta;
+}
+
+static int proc_process_meta(void * vinstance, wsdata_t* input_data,
+                        ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+
+     if (!proc->meta_process_cnt) {
+          clock_gettime(CLOCK_MONOTONIC, &proc->first);
+          proc->interval_start = proc->first;
+     }
+     proc->meta_process_cnt++;
+
+     if (proc->interval && (++proc->interval_cnt >= proc->interval)) {
+          struct timespec now;
+          clock_gettime(CLOCK_MONOTONIC, &now);
+          double secs = bench_elapsed(&proc->interval_start, &now);
+          if (secs > 0) {
+               tool_print("%" PRIu64 " events, %.0f events/sec",
+                          proc->meta_process_cnt,
+                          (double)proc->interval_cnt / secs);
+          }
+          proc->interval_cnt = 0;
+          proc->interval_start = now;
+     }
+
+     return 1;
+}
+
+//the run is over once sources are done and the graph flushes
+static int proc_flush(void * vinstance, wsdata_t* input_data,
+                      ws_doutput_t * dout, int type_index) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+
+     if (proc->meta_process_cnt && !proc->last.tv_sec) {
+          clock_gettime(CLOCK_MONOTONIC, &proc->last);
+     }
+     return 1;
+}
+
+//return 1 if successful
+//return 0 if no..
+int proc_destroy(void * vinstance) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     tool_print("meta_proc cnt %" PRIu64, proc->meta_process_cnt);
+
+     if (proc->meta_process_cnt && !proc->last.tv_sec) {
+          clock_gettime(CLOCK_MONOTONIC, &proc->last);
+     }
+     if (proc->meta_process_cnt) {
+          double secs = bench_elapsed(&proc->first, &proc->last);
+          if (secs > 0) {
+               tool_print("received %" PRIu64 " events in %.3f sec, %.0f events/sec",
+                          proc->meta_process_cnt, secs,
+                          (double)proc->meta_process_cnt / secs);
+          }
+     }
+
+     //free dynamic allocations
+     free(proc);
+
+     return 1;
+}
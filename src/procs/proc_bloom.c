@@ -109,6 +109,7 @@ typedef struct _proc_instance_t {
      int do_heartbeat;
      wslabel_t * label_heartbeat;
      char * outfilename;
+     char * infilename;
 } proc_instance_t;
 
 static int proc_cmd_options(int argc, char ** argv, 
@@ -135,11 +136,9 @@ static int proc_cmd_options(int argc, char ** argv,
                tool_print("bloom filter rounds %u", proc->bloom_rounds);
                break;
           case 'F':
-               proc->uniq_table = bloomfilter_import(optarg);
-               if (!proc->uniq_table) {
-                    error_print("unable to open bloom filter file");
-                    return 0;
-               }
+               //read in proc_init_finish
+               free(proc->infilename);
+               proc->infilename = strdup(optarg);
                break;
           case 'O':
                proc->outfilename = strdup(optarg);
@@ -178,13 +177,31 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
      }
      
      //other init 
-     if (!proc->uniq_table) {
+     if (!proc->infilename) {
           proc->uniq_table = bloomfilter_init(proc->bloom_rounds, proc->bloom_bits);
      }
 
      return 1; 
 }
 
+// a saved filter is read here on the kid's own thread, concurrently with
+// kids on other threads
+int proc_init_finish(void * vinstance) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+
+     if (proc->infilename) {
+          proc->uniq_table = bloomfilter_import(proc->infilename);
+          if (!proc->uniq_table) {
+               error_print("unable to open bloom filter file");
+               return 0;
+          }
+          free(proc->infilename);
+          proc->infilename = NULL;
+     }
+
+     return 1;
+}
+
 // this function needs to decide on processing function based on datatype
 // given.. also set output types as needed (unless a sink)
 //return 1 if ok
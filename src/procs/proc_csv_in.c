@@ -531,10 +531,9 @@ static inline int read_csv_file(proc_instance_t * proc, wsdata_t * tdata) {
  * POLL A FILE
  */
 
+//polling follows the wall clock, even when replaying
 static inline time_t local_get_time(void) {
-     struct timeval tv;
-     gettimeofday(&tv, NULL);
-     return tv.tv_sec;
+     return sysutil_walltime();
 }
 
 static int data_source_filepoll(void * vinstance, wsdata_t* source_data,
@@ -743,9 +742,31 @@ static inline void set_default_label(proc_instance_t * proc, int rec) {
      }
 }
 
+// skip typing and allocating fields whose labels nothing downstream reads
+static inline int field_wanted(proc_instance_t * proc, int rec) {
+     ws_label_demand_t * demand = proc->outtype_tuple->demand;
+     if (!demand) {
+          return 1;
+     }
+     if (proc->inline_labels) {
+          int i;
+          for (i = 0; i < proc->label_inline_cnt; i++) {
+               if (wslabel_demanded(demand, proc->label_inline[i])) {
+                    return 1;
+               }
+          }
+          return 0;
+     }
+     return (rec < proc->lset.len) &&
+          wslabel_demanded(demand, proc->lset.labels[rec]);
+}
+
 static inline void add_timestamp_dt(proc_instance_t * proc, wsdata_t * tdata,
                                     char * str, char * str2, int str2len,
                                     int rec) {
+     if (!field_wanted(proc, rec)) {
+          return;
+     }
      char buffer[30];
      memcpy(buffer, str, 10);
      buffer[10] = ' ';
@@ -774,6 +795,9 @@ static inline int detect_strtype (proc_instance_t * proc, wsdata_t * tdata,
      if (len <= 0) {
           return 0;
      }
+     if (!field_wanted(proc, rec)) {
+          return 1;
+     }
      wsdata_t * wsd = NULL;
      if(proc->no_autodatatyping) {
           // all data members are interpreted as string types
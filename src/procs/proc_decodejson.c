@@ -79,6 +79,7 @@ typedef struct _proc_instance_t {
      void * type_table;
      wslabel_t * label_parseme;
      ws_outtype_t * outtype_tuple;
+     wsdata_t * tdata_top;
 } proc_instance_t;
 
 //function prototypes for local functions
@@ -135,6 +136,7 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance,
           dprint("A label is required!");
           return 0;
      }
+     kid->reads = WSKID_READS_LABELS;
 
      return 1; 
 }
@@ -203,6 +205,7 @@ static int proc_tuple(void * vinstance, wsdata_t* input_data,
      }
 
      // Walk the JSON object.
+     proc->tdata_top = input_data;
      walk_cjson_object(proc, input_data, cjson, NULL, 0);
 
      // Set the outdata. Clone the tuple as necessary to deal with newly
@@ -298,6 +301,14 @@ static inline void walk_cjson(proc_instance_t * proc, wsdata_t * tdata,
      }
 }
 
+// top level values that nothing downstream reads are skipped; values in
+// nested tuples are kept since a kid reading the container sees them all
+static inline int json_value_wanted(proc_instance_t * proc, wsdata_t * tdata,
+                                    wslabel_t * label) {
+     return (tdata != proc->tdata_top) ||
+          wslabel_demanded(proc->outtype_tuple->demand, label);
+}
+
 static inline void walk_cjson_string_literal(proc_instance_t * proc, 
           wsdata_t * tdata, cJSON *item, char * name, char * string_literal) {
      wslabel_t * string_label;
@@ -306,6 +317,9 @@ static inline void walk_cjson_string_literal(proc_instance_t * proc,
      } else {
           string_label = wsregister_label(proc->type_table, name);
      }
+     if (!json_value_wanted(proc, tdata, string_label)) {
+          return;
+     }
 
      tuple_dupe_string(tdata, string_label, string_literal,
           strlen(string_literal)); 
@@ -319,6 +333,9 @@ static inline void walk_cjson_number(proc_instance_t * proc, wsdata_t * tdata,
      } else {
           number_label = wsregister_label(proc->type_table, name);
      }
+     if (!json_value_wanted(proc, tdata, number_label)) {
+          return;
+     }
      tuple_member_create_double(tdata, item->valuedouble, number_label);
 }
 
@@ -330,6 +347,9 @@ static inline void walk_cjson_string(proc_instance_t * proc, wsdata_t * tdata,
      } else {
           string_label = wsregister_label(proc->type_table, name);
      }
+     if (!json_value_wanted(proc, tdata, string_label)) {
+          return;
+     }
      tuple_dupe_string(tdata, string_label, item->valuestring,
           strlen(item->valuestring)); 
 }
@@ -71,6 +71,28 @@ proc_port_t proc_input_ports[]     = {{NULL, NULL}};
 char *proc_tuple_container_labels[]     = {NULL};
 char *proc_tuple_conditional_container_labels[]   = {NULL};
 
+// room reserved for one decoded name; longer (malformed) names take the
+// slower two pass path
+#define DNS_NAME_ROOM 256
+#define DNS_NAME_CACHE 64
+#define DNS_NAME_LABELS 128
+
+//a name already decoded in this packet, keyed by where it starts
+typedef struct _dns_name_t {
+     uint16_t offset;
+     uint16_t len;
+     char * str;
+} dns_name_t;
+
+//result of decoding one name
+typedef struct _dns_namebuf_t {
+     char * str;   // NULL if the name did not fit in the arena
+     int len;
+     wsdata_t * arena;
+     uint8_t * buf; // where the encoded name starts, for the slow path
+     int buflen;
+} dns_namebuf_t;
+
 //function prototypes for local functions
 typedef struct _proc_instance_t {
      wslabel_t * label_parent;
@@ -132,9 +154,22 @@ typedef struct _proc_instance_t {
      wslabel_t * label_invaliddns;
      int tcpdns;
 
+     ws_label_demand_t ** demand;
+     int want;
+
+     //per packet name cache, decoded into a shared arena buffer that
+     // the name members depend on
+     dns_name_t names[DNS_NAME_CACHE];
+     int name_count;
+     wsdata_t * arena;
+     char * arena_buf;
+     int arena_len;
+     int arena_used;
+
 } proc_instance_t;
    
 int procbuffer_instance_size = sizeof(proc_instance_t);
+int procbuffer_demand_offset = offsetof(proc_instance_t, demand);
 
 proc_labeloffset_t proc_labeloffset[] =
 {
@@ -214,6 +249,86 @@ int procbuffer_option(void * vproc, void * type_table, int c, const char * str)
      return 1;
 }
 
+// message sections that something downstream reads, in wire order
+#define DNS_WANT_QD   0x1
+#define DNS_WANT_AN   0x2
+#define DNS_WANT_NS   0x4
+#define DNS_WANT_AR   0x8
+#define DNS_WANT_RECS (DNS_WANT_QD | DNS_WANT_AN | DNS_WANT_NS | DNS_WANT_AR)
+#define DNS_WANT_SET  0x10
+
+static inline int any_demanded(ws_label_demand_t * demand,
+                               wslabel_t ** labels, int len) {
+     int i;
+     for (i = 0; i < len; i++) {
+          if (wslabel_demanded(demand, labels[i])) {
+               return 1;
+          }
+     }
+     return 0;
+}
+
+// work out once which sections are worth decoding; header fields are
+// always decoded, and a section is skipped when none of the labels it
+// could produce are read downstream.  Containers are always built whole:
+// a kid reading the -P parent sees the full message, and one reading a
+// QREC/ANREC/NSREC/ARREC tuple sees every record in that section
+static int dns_sections_wanted(proc_instance_t * proc) {
+     ws_label_demand_t * demand = proc->demand ? *proc->demand : NULL;
+     if (!demand) {
+          return DNS_WANT_SET | DNS_WANT_RECS;
+     }
+     if (proc->label_parent && wslabel_demanded(demand, proc->label_parent)) {
+          tool_print("decoding all sections for %s", proc->label_parent->name);
+          return DNS_WANT_SET | DNS_WANT_RECS;
+     }
+     wslabel_t * qlabels[] = {
+          proc->label_qrec, proc->label_name, proc->label_type,
+          proc->label_class
+     };
+     wslabel_t * rlabels[] = {
+          proc->label_name, proc->label_type, proc->label_class,
+          proc->label_ttl, proc->label_rdata, proc->label_a,
+          proc->label_aaaa, proc->label_ipv4, proc->label_ptr,
+          proc->label_ns, proc->label_cname, proc->label_soa,
+          proc->label_mailbox, proc->label_serial, proc->label_refresh,
+          proc->label_retry, proc->label_expire, proc->label_minimum,
+          proc->label_txt, proc->label_mx, proc->label_mxpref,
+          proc->label_caa, proc->label_caaflag, proc->label_caatag,
+          proc->label_caavalue
+     };
+     wslabel_t * elabels[] = {
+          proc->label_edns, proc->label_payload, proc->label_exrcode,
+          proc->label_version, proc->label_dnssecok, proc->label_option,
+          proc->label_optcode, proc->label_optdata, proc->label_z
+     };
+     int nq = sizeof(qlabels) / sizeof(wslabel_t *);
+     int nr = sizeof(rlabels) / sizeof(wslabel_t *);
+     int ne = sizeof(elabels) / sizeof(wslabel_t *);
+     int anyrec = any_demanded(demand, rlabels, nr);
+
+     int want = DNS_WANT_SET;
+     if (any_demanded(demand, qlabels, nq)) {
+          want |= DNS_WANT_QD;
+     }
+     if (anyrec || wslabel_demanded(demand, proc->label_anrec)) {
+          want |= DNS_WANT_AN;
+     }
+     if (anyrec || wslabel_demanded(demand, proc->label_nsrec)) {
+          want |= DNS_WANT_NS;
+     }
+     if (anyrec || wslabel_demanded(demand, proc->label_arrec) ||
+         any_demanded(demand, elabels, ne)) {
+          want |= DNS_WANT_AR;
+     }
+     tool_print("decoding sections:%s%s%s%s",
+                (want & DNS_WANT_QD) ? " query" : "",
+                (want & DNS_WANT_AN) ? " answer" : "",
+                (want & DNS_WANT_NS) ? " authority" : "",
+                (want & DNS_WANT_AR) ? " additional" : "");
+     return want;
+}
+
 typedef struct _dnsheader_t {
      uint16_t id;
    
@@ -370,25 +485,266 @@ static int dupe_dns_name(wsdt_string_t * dest, int namelen, uint8_t * buf, int b
      return nlen;
 }
 
+static void dns_arena_release(proc_instance_t * proc) {
+     if (proc->arena) {
+          wsdata_delete(proc->arena);
+          proc->arena = NULL;
+     }
+     proc->name_count = 0;
+}
+
+//returns space for a name in the current arena, starting a new arena
+// when the current one is full
+static char * dns_arena_reserve(proc_instance_t * proc, int room) {
+     if (!proc->arena || ((proc->arena_used + room) > proc->arena_len)) {
+          //cached names point into the old arena
+          dns_arena_release(proc);
+          proc->arena = wsdata_create_buffer(WSDT_SMALLSTRING_LEN,
+                                             &proc->arena_buf,
+                                             &proc->arena_len);
+          if (!proc->arena) {
+               return NULL;
+          }
+          wsdata_add_reference(proc->arena);
+          proc->arena_used = 0;
+     }
+     return proc->arena_buf + proc->arena_used;
+}
+
+static inline dns_name_t * dns_name_cached(proc_instance_t * proc,
+                                           int offset) {
+     int i;
+     for (i = 0; i < proc->name_count; i++) {
+          if (proc->names[i].offset == offset) {
+               return &proc->names[i];
+          }
+     }
+     return NULL;
+}
+
+//decode a name in one pass into the packet arena, following compression
+// pointers.  Every label start is remembered so that later names pointing
+// at it are copied from the cache instead of walked again.
+// returns -1 on error, 0 on root name, otherwise length
+static int dns_name_decode(proc_instance_t * proc, uint8_t * buf, int buflen,
+                           uint8_t * entire, int entirelen, int * roffset,
+                           int remember, dns_namebuf_t * name) {
+     uint16_t loffset[DNS_NAME_LABELS];
+     uint16_t lpos[DNS_NAME_LABELS];
+     int labels = 0;
+     uint8_t * cur = buf;
+     int curlen = buflen;
+     int offset = 0;
+     int used = -1;
+     int depth = 0;
+     int nlen = 0;
+
+     name->buf = buf;
+     name->buflen = buflen;
+     name->str = NULL;
+     name->len = 0;
+
+     char * dest = dns_arena_reserve(proc, DNS_NAME_ROOM + 1);
+     if (!dest) {
+          return get_name_length(buf, buflen, entire, entirelen, roffset, 0);
+     }
+
+     while (offset < curlen) {
+          uint8_t llen = cur[offset];
+          if (llen == 0) {
+               offset += 1;
+               break;
+          }
+          if (((llen & 0xC0) == 0xC0) && ((offset + 1) < curlen)) {
+               uint16_t poffset =
+                    (((uint16_t)llen & 0x3f) << 8) + (uint16_t)cur[offset + 1];
+               if (poffset >= entirelen) {
+                    dprint("pointer offset exceeds length");
+                    return -1;
+               }
+               if (used < 0) {
+                    used = offset + 2;
+               }
+               dns_name_t * prev = dns_name_cached(proc, poffset);
+               if (prev) {
+                    if (nlen) {
+                         dest[nlen] = '.';
+                         nlen++;
+                    }
+                    if ((nlen + prev->len) > DNS_NAME_ROOM) {
+                         goto toolong;
+                    }
+                    memcpy(dest + nlen, prev->str, prev->len);
+                    nlen += prev->len;
+                    offset = curlen;
+                    break;
+               }
+               depth++;
+               if (depth > 3) {
+                    dprint("too much recursion");
+                    return -1;
+               }
+               cur = entire + poffset;
+               curlen = entirelen - poffset;
+               offset = 0;
+               continue;
+          }
+          if (llen > 63) {
+               dprint("invalid length that is not an pointer %u", llen);
+               return -1;
+          }
+          if ((llen + offset + 1) > curlen) {
+               dprint("exceeded buffer");
+               return -1;
+          }
+          if (nlen) {
+               dest[nlen] = '.';
+               nlen++;
+          }
+          if ((nlen + llen) > DNS_NAME_ROOM) {
+               goto toolong;
+          }
+          //only offsets a compression pointer can reach
+          if ((labels < DNS_NAME_LABELS) && ((cur + offset - entire) < 0x4000)) {
+               loffset[labels] = (uint16_t)(cur + offset - entire);
+               lpos[labels] = nlen;
+               labels++;
+          }
+          memcpy(dest + nlen, cur + offset + 1, llen);
+          nlen += llen;
+          offset += llen + 1;
+     }
+     if (used < 0) {
+          used = offset;
+     }
+     if (roffset) {
+          *roffset = used;
+     }
+
+     name->arena = proc->arena;
+     name->str = dest;
+     if (nlen) {
+          name->len = nlen;
+     }
+     else {
+          dest[0] = '.';
+          name->len = 1;
+     }
+     proc->arena_used += name->len;
+
+     if (remember) {
+          int i;
+          for (i = 0; (i < labels) && (proc->name_count < DNS_NAME_CACHE); i++) {
+               if (dns_name_cached(proc, loffset[i])) {
+                    continue;
+               }
+               dns_name_t * entry = &proc->names[proc->name_count];
+               entry->offset = loffset[i];
+               entry->str = dest + lpos[i];
+               entry->len = nlen - lpos[i];
+               proc->name_count++;
+          }
+     }
+     return nlen;
+
+toolong:
+     return get_name_length(buf, buflen, entire, entirelen, roffset, 0);
+}
+
+//add a decoded name to a record
+static void dns_name_member(wsdata_t * rec, wslabel_t * label, int nlen,
+                            dns_namebuf_t * name,
+                            uint8_t * entire, int entirelen) {
+     if (name->str) {
+          tuple_member_create_dep_string(rec, name->arena, label,
+                                         name->str, name->len);
+     }
+     else if (!nlen) {
+          char * nullstring = ".";
+          tuple_dupe_string(rec, label, nullstring, 1);
+     }
+     else {
+          wsdt_string_t * str = tuple_create_string(rec, label, nlen);
+          if (str) {
+               int dlen = dupe_dns_name(str, nlen, name->buf, name->buflen,
+                                        entire, entirelen, 0, 0);
+               if (dlen <= 0) {
+                    dprint("error getting dns name");
+                    str->len = 0;
+               }
+               if (dlen != nlen) {
+                    tool_print("unexpected length mismatch %d %d", dlen,
+                               nlen);
+               }
+          }
+     }
+}
+
+// step over an encoded name without following compression pointers,
+// returns bytes used or -1 on error
+static int skip_name(uint8_t * buf, int buflen) {
+     int offset = 0;
+     while (offset < buflen) {
+          if (buf[offset] == 0) {
+               return offset + 1;
+          }
+          if ((buf[offset] & 0xC0) == 0xC0) {
+               return ((offset + 2) <= buflen) ? offset + 2 : -1;
+          }
+          if (buf[offset] > 63) {
+               return -1;
+          }
+          offset += buf[offset] + 1;
+     }
+     return -1;
+}
+
+//find the end of records that are not decoded,
+// returns offset after the records or 0 on error
+static int skip_records(uint16_t count, int is_query,
+                        uint8_t * buf, int buflen) {
+     uint16_t i;
+     int offset = 0;
+     for (i = 0; i < count; i++) {
+          int nlen = skip_name(buf + offset, buflen - offset);
+          if (nlen < 0) {
+               return 0;
+          }
+          offset += nlen;
+          if (is_query) {
+               offset += 4;
+          }
+          else {
+               if ((offset + 10) > buflen) {
+                    return 0;
+               }
+               offset += 10 + ((buf[offset+8]<<8) + buf[offset+9]);
+          }
+          if (offset > buflen) {
+               return 0;
+          }
+     }
+     return offset;
+}
+
 #define MIN_QREC (5)
 //returns offset after record processing
 static int process_query(proc_instance_t * proc, wsdata_t * tdata,
                          wsdata_t * member, uint16_t qdcount,
                          uint8_t * buf, int buflen,
-                         uint8_t * entire, int entirelen) {
+                         uint8_t * entire, int entirelen, int remember) {
      uint16_t i;
      int offset = 0;
-     int startoffset;
+     dns_namebuf_t name;
 
      for (i = 0; i < qdcount; i++) {
           if ((buflen - offset) < MIN_QREC) {
                dprint("too small to be a qrec");
                return 0; //too small to continue
           }
-          startoffset = offset;
           int newoffset = 0;
-          int nlen = get_name_length(buf + offset, buflen - offset, entire,
-                                     entirelen, &newoffset, 0);
+          int nlen = dns_name_decode(proc, buf + offset, buflen - offset, entire,
+                                     entirelen, &newoffset, remember, &name);
           dprint("returned get_name_length  nlen: %d, offset %d", nlen, offset);
 
           if (nlen < 0) {
@@ -417,38 +773,16 @@ static int process_query(proc_instance_t * proc, wsdata_t * tdata,
           if (qrec) {
                tuple_member_create_uint16(qrec, qtype, proc->label_type);
                tuple_member_create_uint16(qrec, qclass, proc->label_class);
-               if (!nlen) {
-                    char * nullstring = ".";
-                    tuple_dupe_string(qrec, proc->label_name, nullstring, 1);
-               }
-               else {
-                    wsdt_string_t * str = tuple_create_string(qrec,
-                                                              proc->label_name, nlen);
-                    if (str) {
-                         int dlen = dupe_dns_name(str, nlen, buf + startoffset,
-                                                  buflen - startoffset,
-                                                  entire, entirelen, 0, 0);
-                         if (dlen <= 0) {
-                              dprint("error getting dns name");
-                              str->len = 0;
-                         }
-                         if (dlen != nlen) {
-                              tool_print("unexpected length mismatch %d %d", dlen,
-                                     nlen);
-                         }
-                    }
-               }
+               dns_name_member(qrec, proc->label_name, nlen, &name,
+                               entire, entirelen);
           }
-
-          //extract out name from startoffset
-
      }
 
      return offset;
 }
 
 //returns offset of name or 0 if error
-static int extract_rdname(wsdata_t * rrec,
+static int extract_rdname(proc_instance_t * proc, wsdata_t * rrec,
                           wslabel_t * label_name,
                           uint8_t * rdbuf, int rdlen,
                           uint8_t * entire, int entirelen) {
@@ -457,8 +791,9 @@ static int extract_rdname(wsdata_t * rrec,
           return 0;
      }
      int rdoffset = 0;
-     int namelen = get_name_length(rdbuf, rdlen, entire,
-                                   entirelen, &rdoffset, 0);
+     dns_namebuf_t name;
+     int namelen = dns_name_decode(proc, rdbuf, rdlen, entire,
+                                   entirelen, &rdoffset, 1, &name);
      dprint("rd get_name_length  namelen: %d, rdoffset %d",
             namelen, rdoffset);
      if (namelen < 0) {
@@ -466,24 +801,7 @@ static int extract_rdname(wsdata_t * rrec,
           dprint("invalid ns name");
           return 0;
      }
-     if (namelen == 0) {
-          char * nullstring = ".";
-          tuple_dupe_string(rrec, label_name, nullstring, 1);
-     }
-     else {
-          wsdt_string_t * str = tuple_create_string(rrec,
-                                                    label_name,
-                                                    namelen);
-          int dupelen = 
-               dupe_dns_name(str, namelen, rdbuf, rdlen,
-                             entire, entirelen, 0, 0);
-          if (dupelen != namelen) {
-
-               tool_print("unexpected NS length mismatch %d %d",
-                          dupelen,
-                          namelen);
-          }
-     }
+     dns_name_member(rrec, label_name, namelen, &name, entire, entirelen);
      return rdoffset;
 }
 
@@ -578,7 +896,7 @@ static int process_rrec(proc_instance_t * proc, wsdata_t * tdata, wsdata_t * mem
      dprint("process_rrec");
      uint16_t i;
      int offset = 0;
-     int startoffset;
+     dns_namebuf_t name;
 
      for (i = 0; i < rcount; i++) {
           if ((buflen - offset) < MIN_RREC) {
@@ -586,10 +904,9 @@ static int process_rrec(proc_instance_t * proc, wsdata_t * tdata, wsdata_t * mem
                return 0; //too small to continue
           }
           //read name...
-          startoffset = offset;
           int newoffset = 0;
-          int nlen = get_name_length(buf + offset, buflen - offset, entire,
-                                     entirelen, &newoffset, 0);
+          int nlen = dns_name_decode(proc, buf + offset, buflen - offset, entire,
+                                     entirelen, &newoffset, 1, &name);
           dprint("returned get_name_length  nlen: %d, offset %d", nlen, offset);
 
           if (nlen < 0) {
@@ -645,27 +962,8 @@ static int process_rrec(proc_instance_t * proc, wsdata_t * tdata, wsdata_t * mem
                tuple_member_create_uint16(rrec, rtype, proc->label_type);
                tuple_member_create_uint16(rrec, rclass, proc->label_class);
                tuple_member_create_uint(rrec, ttl, proc->label_ttl);
-               if (!nlen) {
-                    char * nullstring = ".";
-                    tuple_dupe_string(rrec, proc->label_name, nullstring, 1);
-               }
-               else {
-                    wsdt_string_t * str = tuple_create_string(rrec,
-                                                              proc->label_name, nlen);
-                    if (str) {
-                         int dlen = dupe_dns_name(str, nlen, buf + startoffset,
-                                                  buflen - startoffset,
-                                                  entire, entirelen, 0, 0);
-                         if (dlen <= 0) {
-                              dprint("error getting dns name");
-                              str->len = 0;
-                         }
-                         if (dlen != nlen) {
-                              tool_print("unexpected length mismatch %d %d", dlen,
-                                     nlen);
-                         }
-                    }
-               }
+               dns_name_member(rrec, proc->label_name, nlen, &name,
+                               entire, entirelen);
                switch(rtype) {
                case 1: //  IPv4 address
                     if (rdlen == 4) {
@@ -682,21 +980,21 @@ static int process_rrec(proc_instance_t * proc, wsdata_t * tdata, wsdata_t * mem
 
                case 2:  //NS
                     tuple_add_member_label(tdata, rrec, proc->label_ns);
-                    extract_rdname(rrec, proc->label_ns,
+                    extract_rdname(proc, rrec, proc->label_ns,
                                    rdbuf, rdlen, entire, entirelen);
                     break;
                case 5: //cname
                     tuple_add_member_label(tdata, rrec, proc->label_cname);
-                    extract_rdname(rrec, proc->label_cname,
+                    extract_rdname(proc, rrec, proc->label_cname,
                                    rdbuf, rdlen, entire, entirelen);
                     break;
                case 12: //ptr
                     tuple_add_member_label(tdata, rrec, proc->label_ptr);
-                    extract_rdname(rrec, proc->label_ptr,
+                    extract_rdname(proc, rrec, proc->label_ptr,
                                    rdbuf, rdlen, entire, entirelen);
                     break;
                case 16: //txt
-                    if (extract_rdname(rrec, proc->label_txt,
+                    if (extract_rdname(proc, rrec, proc->label_txt,
                                    rdbuf, rdlen, entire, entirelen) <= 0) {
                          //if name decoding fails -- try binary buffer
                          if (rdlen) {
@@ -740,14 +1038,14 @@ static int process_rrec(proc_instance_t * proc, wsdata_t * tdata, wsdata_t * mem
                                                     proc->label_mxpref);
                          rdbuf+=2;
                          rdlen-=2;
-                         extract_rdname(rrec, proc->label_mx,
+                         extract_rdname(proc, rrec, proc->label_mx,
                                         rdbuf, rdlen, entire, entirelen);
                     break;
                     }
                case 6: //SOA
                     {
                          tuple_add_member_label(tdata, rrec, proc->label_soa);
-                         int nameoffset = extract_rdname(rrec, proc->label_soa,
+                         int nameoffset = extract_rdname(proc, rrec, proc->label_soa,
                                                          rdbuf, rdlen, entire, entirelen);
                          if (nameoffset <= 0) {
                               break;
@@ -757,7 +1055,7 @@ static int process_rrec(proc_instance_t * proc, wsdata_t * tdata, wsdata_t * mem
                          }
                          rdbuf += nameoffset;
                          rdlen -= nameoffset;
-                         nameoffset = extract_rdname(rrec, proc->label_mailbox,
+                         nameoffset = extract_rdname(proc, rrec, proc->label_mailbox,
                                                      rdbuf, rdlen, entire, entirelen);
                          if (nameoffset <= 0) {
                               break;
@@ -808,9 +1106,8 @@ static inline void local_add_label(wsdata_t * base, wsdata_t * tdata, wslabel_t
      }
 }
 
-int procbuffer_decode(void * vproc, wsdata_t * tdata,
+static int dns_decode(proc_instance_t * proc, wsdata_t * tdata,
                       wsdata_t * member, uint8_t * buf, int buflen) {
-     proc_instance_t * proc = (proc_instance_t*)vproc;
      wsdata_t * base = NULL;
 
      if (proc->label_parent) {
@@ -922,10 +1219,32 @@ int procbuffer_decode(void * vproc, wsdata_t * tdata,
      //now start processing queries and resource records..
 
    
+     if (!proc->want) {
+          proc->want = dns_sections_wanted(proc);
+     }
+     int want = proc->want;
+
      int rlen = 0; 
+     if (!(want & DNS_WANT_RECS)) {
+          return 1;
+     }
+     //a plain query: nothing later can point back at its one name, so
+     // there is no need to remember it
+     if ((qdcount == 1) && !ancount && !nscount && !arcount) {
+          if (want & DNS_WANT_QD) {
+               process_query(proc, tdata, member, qdcount, remain, remainlen,
+                             buf, buflen, 0);
+          }
+          return 1;
+     }
      if (qdcount) {
-          rlen = process_query(proc, tdata, member, qdcount, remain,
-                                   remainlen, buf, buflen);
+          if (want & DNS_WANT_QD) {
+               rlen = process_query(proc, tdata, member, qdcount, remain,
+                                    remainlen, buf, buflen, 1);
+          }
+          else {
+               rlen = skip_records(qdcount, 1, remain, remainlen);
+          }
           if (rlen <= 0) { 
                dprint("exit early from process_query");
                return 1;
@@ -937,9 +1256,17 @@ int procbuffer_decode(void * vproc, wsdata_t * tdata,
           remainlen -= rlen;
      }
      
+     if (!(want & (DNS_WANT_AN | DNS_WANT_NS | DNS_WANT_AR))) {
+          return 1;
+     }
      if (ancount) {
-          rlen = process_rrec(proc, tdata, member, ancount, remain, remainlen, buf,
-                              buflen, proc->label_anrec);
+          if (want & DNS_WANT_AN) {
+               rlen = process_rrec(proc, tdata, member, ancount, remain, remainlen,
+                                   buf, buflen, proc->label_anrec);
+          }
+          else {
+               rlen = skip_records(ancount, 0, remain, remainlen);
+          }
           if (rlen <= 0) { 
                dprint("exit early from anrec process_rrec");
                return 1;
@@ -950,9 +1277,17 @@ int procbuffer_decode(void * vproc, wsdata_t * tdata,
           remain += rlen;
           remainlen -= rlen;
      }
+     if (!(want & (DNS_WANT_NS | DNS_WANT_AR))) {
+          return 1;
+     }
      if (nscount) {
-          rlen = process_rrec(proc, tdata, member, nscount, remain, remainlen, buf,
-                              buflen, proc->label_nsrec);
+          if (want & DNS_WANT_NS) {
+               rlen = process_rrec(proc, tdata, member, nscount, remain, remainlen,
+                                   buf, buflen, proc->label_nsrec);
+          }
+          else {
+               rlen = skip_records(nscount, 0, remain, remainlen);
+          }
           if (rlen <= 0) { 
                dprint("exit early from nsrec process_rrec");
                return 1;
@@ -963,6 +1298,9 @@ int procbuffer_decode(void * vproc, wsdata_t * tdata,
           remain += rlen;
           remainlen -= rlen;
      }
+     if (!(want & DNS_WANT_AR)) {
+          return 1;
+     }
      if (arcount) {
           rlen = process_rrec(proc, tdata, member, arcount, remain, remainlen, buf,
                               buflen, proc->label_arrec);
@@ -980,3 +1318,11 @@ int procbuffer_decode(void * vproc, wsdata_t * tdata,
      return 1;
 }
 
+int procbuffer_decode(void * vproc, wsdata_t * tdata,
+                      wsdata_t * member, uint8_t * buf, int buflen) {
+     proc_instance_t * proc = (proc_instance_t*)vproc;
+     int rtn = dns_decode(proc, tdata, member, buf, buflen);
+     //names decoded from this packet hold their own references to the arena
+     dns_arena_release(proc);
+     return rtn;
+}
@@ -24,20 +24,32 @@ OTHER REQUIRED LICENSE TERMS
 #include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <string.h>
 #include <math.h>
 #include "waterslide.h"
 #include "waterslidedata.h"
 #include "procloader.h"
 #include "stringhash5.h"
+#include "sysutil.h"
 #include "datatypes/wsdt_tuple.h"
 
-char proc_version[]     = "1.5";
+char proc_version[]     = "1.6";
 char *proc_tags[]	= {"annotation", NULL};
 char *proc_menus[]     = { "Annotate", NULL };
 char *proc_alias[]     = { "levenshtein", "editdist", NULL};
 char proc_name[]       = PROC_NAME;
 char proc_purpose[]    = "compair strings and measure edit distance";
-char proc_description[] = "Utilize the levenshtein algorithm to measure edit distance between two strings";
+char proc_description[] = "Utilize the levenshtein algorithm to measure edit distance between two strings. "
+     "Distances are computed bit-parallel, one machine word per 64 characters of the compared value. "
+     "Values can be compared to a reference string (-S), to the prior value at a key (-K) or to a list "
+     "of reference strings (-F), in which case the nearest reference is labeled EDITMATCH. "
+     "With a threshold (-T) only distances at or below the threshold are labeled; the computation stops "
+     "early and references are skipped by length difference and shared character pairs.";
+proc_example_t proc_examples[] = {
+     {"... | editdistance -S google.com DOMAIN | ...", "label the edit distance between DOMAIN and google.com"},
+     {"... | editdistance -F topdomains.txt -T 2 DOMAIN | ...", "label DOMAIN values within 2 edits of a listed domain with the nearest listed domain and its distance"},
+     {NULL, ""}
+};
 char proc_requires[] = "none";
 
 
@@ -54,6 +66,10 @@ proc_option_t proc_opts[] = {
      "maximum buffer size for edit distance (2047 default)",0,0},
      {'M',"","records",
      "maximum keystate table size",0,0},
+     {'F',"","file",
+     "file of reference strings to find nearest match in (not with -K)",0,0},
+     {'T',"","distance",
+     "only label distances at or below threshold",0,0},
      //the following must be left as-is to signify the end of the array
      {' ',"","",
      "",0,0}
@@ -68,10 +84,17 @@ char *proc_tuple_conditional_container_labels[] = {NULL};
 char *proc_tuple_member_labels[] = {NULL};
 
 
+#define ED_WORD_BITS 64
+#define ED_NO_LIMIT  UINT32_MAX
+
 typedef struct _editdistance_t {
-     uint32_t *v0;
-     uint32_t *v1;
+     uint64_t *peq;     //per-character match bitvectors, nblocks per character
+     uint64_t *pv;      //vertical positive deltas, one word per block
+     uint64_t *mv;      //vertical negative deltas, one word per block
+     uint32_t nblocks;
      uint32_t maxbuf;
+     uint8_t *pattern;  //copy of current pattern, used to clear peq on reset
+     uint32_t plen;
 } editdistance_t;
 
 //allocated memory for doing edit distance computations
@@ -85,15 +108,16 @@ static editdistance_t * editdistance_init(uint32_t maxbuf) {
           return NULL;
      }
      ed->maxbuf = maxbuf;
-     maxbuf +=1;
-     ed->v0 = (uint32_t *)calloc(1, sizeof(uint32_t) * maxbuf);
-     if (!ed->v0) {
-          free(ed);
-          return NULL;
-     }
-     ed->v1 = (uint32_t *)calloc(1, sizeof(uint32_t) * maxbuf);
-     if (!ed->v1) {
-          free(ed->v0);
+     ed->nblocks = (maxbuf + ED_WORD_BITS - 1) / ED_WORD_BITS;
+     ed->peq = (uint64_t *)calloc(256 * ed->nblocks, sizeof(uint64_t));
+     ed->pv = (uint64_t *)calloc(ed->nblocks, sizeof(uint64_t));
+     ed->mv = (uint64_t *)calloc(ed->nblocks, sizeof(uint64_t));
+     ed->pattern = (uint8_t *)malloc(maxbuf);
+     if (!ed->peq || !ed->pv || !ed->mv || !ed->pattern) {
+          free(ed->pattern);
+          free(ed->peq);
+          free(ed->pv);
+          free(ed->mv);
           free(ed);
           return NULL;
      }
@@ -101,71 +125,157 @@ static editdistance_t * editdistance_init(uint32_t maxbuf) {
      return ed;
 }
 
-//compute levenshtein distance using two-matrix rows method
-static uint32_t editdistance_compair(editdistance_t * ed,
-                                 uint8_t * buf0, uint32_t len0,
-                                 uint8_t * buf1, uint32_t len1 ) {
-
-     uint32_t * v0 = ed->v0;
-     uint32_t * v1 = ed->v1;
-
-     if ((len1+1) > ed->maxbuf) {
-          len1 = ed->maxbuf;
+//load the string whose characters form the rows of the distance matrix;
+//strings longer than maxbuf are truncated
+static void editdistance_set_pattern(editdistance_t * ed, uint8_t * buf,
+                                     uint32_t len) {
+     uint32_t nb = ed->nblocks;
+     uint32_t i;
+     for (i = 0; i < ed->plen; i++) {
+          ed->peq[ed->pattern[i] * nb + (i / ED_WORD_BITS)] = 0;
      }
+     if (len > ed->maxbuf) {
+          len = ed->maxbuf;
+     }
+     for (i = 0; i < len; i++) {
+          ed->peq[buf[i] * nb + (i / ED_WORD_BITS)] |=
+               (uint64_t)1 << (i % ED_WORD_BITS);
+     }
+     memcpy(ed->pattern, buf, len);
+     ed->plen = len;
+}
 
-     uint32_t i;
+//bit-parallel levenshtein distance between the current pattern and text.
+//Each text character updates the whole column one word at a time
+//(Myers 1999, Hyyro 2003).  If the distance provably exceeds limit the
+//scan stops and limit + 1 is returned.
+static uint32_t editdistance_text(editdistance_t * ed, uint8_t * text,
+                                  uint32_t tlen, uint32_t limit) {
+     uint32_t m = ed->plen;
+     uint32_t score = m;
      uint32_t j;
-     //inialize base matrix score
-     for (i = 0; i <= len1; i++) {
-          v0[i] = i;
-     }
 
-     for (i = 0; i < len0; i++) {
-          v1[0] = i + 1;
+     if (!m) {
+          return (tlen > limit) ? limit + 1 : tlen;
+     }
+     if (((m > tlen) ? m - tlen : tlen - m) > limit) {
+          return limit + 1;
+     }
 
-          for (j = 0; j < len1; j++) {
-               uint32_t scost;
-               uint32_t dcost = v0[j + 1] + 1;
-               uint32_t icost = v1[j] + 1;
-               if (buf0[i] == buf1[j]) {
-                    scost = v0[j];
+     if (m <= ED_WORD_BITS) {
+          uint64_t pv = ~(uint64_t)0;
+          uint64_t mv = 0;
+          uint64_t last = (uint64_t)1 << (m - 1);
+          for (j = 0; j < tlen; j++) {
+               uint64_t eq = ed->peq[text[j] * ed->nblocks];
+               uint64_t xv = eq | mv;
+               uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+               uint64_t ph = mv | ~(xh | pv);
+               uint64_t mh = pv & xh;
+               if (ph & last) {
+                    score++;
+               }
+               else if (mh & last) {
+                    score--;
                }
-               else {
-                    scost = v0[j] + 1;
+               ph = (ph << 1) | 1;
+               mh <<= 1;
+               pv = mh | ~(xv | ph);
+               mv = ph & xv;
+               //score can drop at most one per remaining text character
+               if ((score > limit) && ((score - limit) > (tlen - j - 1))) {
+                    return limit + 1;
                }
+          }
+          return score;
+     }
 
-               //get minimum of (dcost, icost and scost)
-               uint32_t mcost = dcost;
-               if (mcost > icost) {
-                    mcost = icost;
+     uint32_t nb = (m + ED_WORD_BITS - 1) / ED_WORD_BITS;
+     uint32_t lastblock = nb - 1;
+     uint64_t last = (uint64_t)1 << ((m - 1) % ED_WORD_BITS);
+     uint64_t high = (uint64_t)1 << (ED_WORD_BITS - 1);
+     uint32_t b;
+     for (b = 0; b < nb; b++) {
+          ed->pv[b] = ~(uint64_t)0;
+          ed->mv[b] = 0;
+     }
+     for (j = 0; j < tlen; j++) {
+          uint64_t * peq = ed->peq + text[j] * ed->nblocks;
+          //horizontal delta carried down from the block above, row 0 is +1
+          int hin = 1;
+          for (b = 0; b < nb; b++) {
+               uint64_t pv = ed->pv[b];
+               uint64_t mv = ed->mv[b];
+               uint64_t eq = peq[b];
+               uint64_t xv = eq | mv;
+               if (hin < 0) {
+                    eq |= 1;
+               }
+               uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+               uint64_t ph = mv | ~(xh | pv);
+               uint64_t mh = pv & xh;
+               uint64_t outbit = (b == lastblock) ? last : high;
+               int hout = (ph & outbit) ? 1 : ((mh & outbit) ? -1 : 0);
+               ph <<= 1;
+               mh <<= 1;
+               if (hin < 0) {
+                    mh |= 1;
                }
-               if (mcost > scost) {
-                    mcost = scost;
+               else if (hin > 0) {
+                    ph |= 1;
                }
-               
-               v1[j + 1] = mcost; 
+               ed->pv[b] = mh | ~(xv | ph);
+               ed->mv[b] = ph & xv;
+               hin = hout;
+          }
+          score += hin;
+          if ((score > limit) && ((score - limit) > (tlen - j - 1))) {
+               return limit + 1;
           }
-          //swap v0 and v1
-          uint32_t * tmp = v0;
-          v0 = v1;
-          v1 = tmp;
      }
-     return v0[len1];
+     return score;
+}
+
+//compute levenshtein distance between two strings, buf1 is truncated to
+//maxbuf
+static uint32_t editdistance_compair(editdistance_t * ed,
+                                 uint8_t * buf0, uint32_t len0,
+                                 uint8_t * buf1, uint32_t len1,
+                                 uint32_t limit) {
+     editdistance_set_pattern(ed, buf1, len1);
+     return editdistance_text(ed, buf0, len0, limit);
 }
 
 //free up allocated memory for doing edit distance computations
 static void editdistance_destroy(editdistance_t * ed) {
      if (ed) {
-          if (ed->v0) {
-               free(ed->v0);
-          }
-          if (ed->v1) {
-               free(ed->v1);
-          }
+          free(ed->pattern);
+          free(ed->peq);
+          free(ed->pv);
+          free(ed->mv);
           free(ed);
      }
 }
 
+//character pair (q=2 gram) counts used to rule out distant references;
+//colliding pairs only overcount shared pairs so the filter stays safe
+#define ED_QGRAM_BUCKETS 4096
+#define ED_QGRAM_HASH(a, b) ((((uint32_t)(a) << 4) ^ (uint32_t)(b)) & (ED_QGRAM_BUCKETS - 1))
+
+typedef struct _edref_t {
+     uint8_t * buf;
+     uint32_t len;
+} edref_t;
+
+static int edref_cmp(const void * va, const void * vb) {
+     const edref_t * a = (const edref_t *)va;
+     const edref_t * b = (const edref_t *)vb;
+     if (a->len < b->len) {
+          return -1;
+     }
+     return (a->len > b->len) ? 1 : 0;
+}
+
 typedef struct _key_data_t {
      wsdata_t * prior;
 } key_data_t;
@@ -201,15 +311,177 @@ typedef struct _proc_instance_t {
      uint32_t reference_len;
      editdistance_t * edist;
 
+     uint32_t threshold;
+     wslabel_t * label_ematch;
+     edref_t * refs;         // reference list, sorted by length
+     uint32_t ref_cnt;
+     uint32_t ref_alloc;
+     uint32_t ref_maxlen;
+     uint32_t qgrams[ED_QGRAM_BUCKETS];
+     uint32_t * qtouched;
+
 
      uint32_t maxbuf;  // for edit distance
 } proc_instance_t;
 
+static int edref_add(proc_instance_t * proc, uint8_t * buf, uint32_t len) {
+     if (proc->ref_cnt == proc->ref_alloc) {
+          uint32_t alloc = proc->ref_alloc ? proc->ref_alloc * 2 : 64;
+          edref_t * refs = (edref_t *)realloc(proc->refs, alloc * sizeof(edref_t));
+          if (!refs) {
+               error_print("failed realloc of reference list");
+               return 0;
+          }
+          proc->refs = refs;
+          proc->ref_alloc = alloc;
+     }
+     proc->refs[proc->ref_cnt].buf = (uint8_t *)malloc(len);
+     if (!proc->refs[proc->ref_cnt].buf) {
+          error_print("failed malloc of reference string");
+          return 0;
+     }
+     memcpy(proc->refs[proc->ref_cnt].buf, buf, len);
+     proc->refs[proc->ref_cnt].len = len;
+     proc->ref_cnt++;
+     if (len > proc->ref_maxlen) {
+          proc->ref_maxlen = len;
+     }
+     return 1;
+}
+
+#define LOCAL_INPUT_BUF 1024
+static int edref_loadfile(proc_instance_t * proc, char * filename) {
+     FILE * fp;
+     char line[LOCAL_INPUT_BUF+1];
+     int len;
+
+     if ((fp = sysutil_config_fopen(filename, "r")) == NULL) {
+          error_print("unable to open reference file %s", filename);
+          return 0;
+     }
+     while (fgets(line, LOCAL_INPUT_BUF, fp)) {
+          len = strlen(line);
+          // strip return
+          if (len && (line[len - 1] == '\n')) {
+               line[--len] = '\0';
+          }
+          if (len && (line[len - 1] == '\r')) {
+               line[--len] = '\0';
+          }
+          // ignore empty lines and comments
+          if ((len <= 0) || (line[0] == '#')) {
+               continue;
+          }
+          sysutil_decode_hex_escapes(line, &len);
+          if ((len > 0) && !edref_add(proc, (uint8_t *)line, len)) {
+               sysutil_config_fclose(fp);
+               return 0;
+          }
+     }
+     sysutil_config_fclose(fp);
+     tool_print("loaded %u reference strings from %s", proc->ref_cnt, filename);
+     return 1;
+}
+
+static void edref_qgram_set(proc_instance_t * proc, uint8_t * buf, uint32_t len,
+                            int add) {
+     uint32_t i;
+     for (i = 1; i < len; i++) {
+          proc->qgrams[ED_QGRAM_HASH(buf[i - 1], buf[i])] += add;
+     }
+}
+
+//check whether the reference shares at least needed character pairs with
+//the current value
+static int edref_qgram_check(proc_instance_t * proc, edref_t * ref,
+                             uint64_t needed) {
+     uint32_t common = 0;
+     uint32_t ntouched = 0;
+     uint32_t i;
+     for (i = 1; (i < ref->len) && (common < needed); i++) {
+          uint32_t h = ED_QGRAM_HASH(ref->buf[i - 1], ref->buf[i]);
+          if (proc->qgrams[h]) {
+               proc->qgrams[h]--;
+               proc->qtouched[ntouched++] = h;
+               common++;
+          }
+     }
+     for (i = 0; i < ntouched; i++) {
+          proc->qgrams[proc->qtouched[i]]++;
+     }
+     return (common >= needed);
+}
+
+//find the nearest reference to buf within the threshold, searching
+//outward from references of the same length so the best distance found
+//so far tightens the bound for the rest.  Each edit changes at most two
+//character pairs, which gives the pair-count lower bound.
+static edref_t * edref_nearest(proc_instance_t * proc, uint8_t * buf,
+                               uint32_t len, uint32_t * pdist) {
+     editdistance_t * ed = proc->edist;
+     edref_t * best = NULL;
+     uint32_t limit = proc->threshold;
+
+     editdistance_set_pattern(ed, buf, len);
+     uint32_t m = ed->plen;
+     edref_qgram_set(proc, buf, m, 1);
+
+     //first reference at least as long as the value
+     uint32_t lo = 0;
+     uint32_t hi = proc->ref_cnt;
+     while (lo < hi) {
+          uint32_t mid = lo + (hi - lo) / 2;
+          if (proc->refs[mid].len < m) {
+               lo = mid + 1;
+          }
+          else {
+               hi = mid;
+          }
+     }
+     uint32_t up = lo;
+     uint32_t down = lo;
+
+     while ((up < proc->ref_cnt) || down) {
+          uint32_t du = (up < proc->ref_cnt) ? proc->refs[up].len - m : ED_NO_LIMIT;
+          uint32_t dd = down ? m - proc->refs[down - 1].len : ED_NO_LIMIT;
+          edref_t * ref;
+          uint32_t diff;
+          if (du <= dd) {
+               ref = &proc->refs[up++];
+               diff = du;
+          }
+          else {
+               ref = &proc->refs[--down];
+               diff = dd;
+          }
+          if (diff > limit) {
+               break;
+          }
+          uint64_t maxlen = (ref->len > m) ? ref->len : m;
+          if ((maxlen > 2 * (uint64_t)limit + 1) &&
+              !edref_qgram_check(proc, ref, maxlen - 1 - 2 * (uint64_t)limit)) {
+               continue;
+          }
+          uint32_t dist = editdistance_text(ed, ref->buf, ref->len, limit);
+          if (dist <= limit) {
+               best = ref;
+               *pdist = dist;
+               if (!dist) {
+                    break;
+               }
+               limit = dist - 1;
+          }
+     }
+
+     edref_qgram_set(proc, buf, m, -1);
+     return best;
+}
+
 static int proc_cmd_options(int argc, char ** argv, 
                             proc_instance_t * proc, void * type_table) {
      int op;
 
-     while ((op = getopt(argc, argv, "B:M:k:K:s:S:L:")) != EOF) {
+     while ((op = getopt(argc, argv, "F:T:B:M:k:K:s:S:L:")) != EOF) {
           switch (op) {
           case 'B':
                proc->maxbuf = atoi(optarg);
@@ -231,6 +503,14 @@ static int proc_cmd_options(int argc, char ** argv,
           case 'M':
                proc->buflen = atoi(optarg);
                break;
+          case 'F':
+               if (!edref_loadfile(proc, optarg)) {
+                    return 0;
+               }
+               break;
+          case 'T':
+               proc->threshold = strtoul(optarg, NULL, 10);
+               break;
           default:
                return 0;
           }
@@ -258,6 +538,7 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
      *vinstance = proc;
 
      proc->maxbuf = 2047;
+     proc->threshold = ED_NO_LIMIT;
 
 
      ws_default_statestore(&proc->buflen);
@@ -265,6 +546,7 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
 
      proc->label_edist = wsregister_label(type_table, "EDITDISTANCE");
      proc->label_enorm = wsregister_label(type_table, "EDITNORM");
+     proc->label_ematch = wsregister_label(type_table, "EDITMATCH");
 
      //read in command options
      if (!proc_cmd_options(argc, argv, proc, type_table)) {
@@ -282,6 +564,12 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
                error_print("need to specify label for key to seach for");
                return 0;
           }
+          // keyed mode compares against the value last seen per key, so a
+          // fixed reference list has nothing to apply to
+          if (proc->ref_cnt) {
+               error_print("-F reference file cannot be combined with -K keys");
+               return 0;
+          }
           proc->keytable = stringhash5_create(0, proc->buflen,
                                               sizeof(key_data_t));
           if (!proc->keytable) {
@@ -289,6 +577,19 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
           }
           stringhash5_set_callback(proc->keytable, evict_state, proc);
      }
+     else if (proc->ref_cnt) {
+          if (proc->reference && proc->reference_len &&
+              !edref_add(proc, proc->reference, proc->reference_len)) {
+               return 0;
+          }
+          qsort(proc->refs, proc->ref_cnt, sizeof(edref_t), edref_cmp);
+          proc->qtouched = (uint32_t *)malloc(sizeof(uint32_t) *
+                                              (proc->ref_maxlen + 1));
+          if (!proc->qtouched) {
+               error_print("failed malloc of proc->qtouched");
+               return 0;
+          }
+     }
      else if (!proc->reference || !proc->reference_len) {
           tool_print("must have a reference string");
           return 0;
@@ -331,11 +632,30 @@ static int proc_nest_match_callback(void * vproc, void * vignore,
      char * buf;
      int blen;
 
-     if (dtype_string_buffer(member, &buf, &blen)) {
+     if (proc->ref_cnt && dtype_string_buffer(member, &buf, &blen)) {
+          uint32_t distance = 0;
+          edref_t * ref = edref_nearest(proc, (uint8_t*)buf, blen, &distance);
+          if (ref) {
+               tuple_dupe_string(tdata, proc->label_ematch,
+                                 (char*)ref->buf, ref->len);
+               tuple_member_create_uint(tdata, distance,
+                                        proc->label_edist);
+               int max = (blen > ref->len) ? blen : ref->len;
+               if (max) {
+                    tuple_member_create_double(tdata, (double)distance/(double)max,
+                                               proc->label_enorm);
+               }
+          }
+     }
+     else if (dtype_string_buffer(member, &buf, &blen)) {
           uint32_t distance = editdistance_compair(proc->edist,
                                                    proc->reference,
                                                    proc->reference_len,
-                                                   (uint8_t*)buf, blen);
+                                                   (uint8_t*)buf, blen,
+                                                   proc->threshold);
+          if (distance > proc->threshold) {
+               return 1;
+          }
           tuple_member_create_uint(tdata, distance,
                                      proc->label_edist);
           int max = (blen > proc->reference_len) ? blen : proc->reference_len;
@@ -385,11 +705,15 @@ static int proc_nest_key_value_callback(void * vproc, void * vkdata,
           char * ref;
           int rlen = 0;
           
+          uint32_t distance = ED_NO_LIMIT;
           if (dtype_string_buffer(kdata->prior, &ref, &rlen)) {
-               uint32_t distance = editdistance_compair(proc->edist,
-                                                        (uint8_t*)ref,
-                                                        rlen,
-                                                        (uint8_t*)buf, blen);
+               distance = editdistance_compair(proc->edist,
+                                               (uint8_t*)ref,
+                                               rlen,
+                                               (uint8_t*)buf, blen,
+                                               proc->threshold);
+          }
+          if (distance <= proc->threshold) {
                tuple_member_create_uint(tdata, distance,
                                         proc->label_edist);
 
@@ -464,6 +788,13 @@ int proc_destroy(void * vinstance) {
      tool_print("output cnt %" PRIu64, proc->outcnt);
 
      editdistance_destroy(proc->edist);
+     uint32_t i;
+     for (i = 0; i < proc->ref_cnt; i++) {
+          free(proc->refs[i].buf);
+     }
+     free(proc->refs);
+     free(proc->qtouched);
+     free(proc->reference);
      if (proc->keytable) {
           stringhash5_destroy(proc->keytable);
      }
@@ -131,6 +131,9 @@ typedef struct _proc_instance_t {
 
      char * sharelabel;
      int sharer_id;
+
+     char ** load_files; // -F files, read in proc_init_finish
+     int load_cnt;
 } proc_instance_t;
 
 
@@ -240,7 +243,17 @@ static int proc_cmd_options(int argc, char ** argv,
                     proc->max_table = proc->exactmatch_table->max_records;
 
                }
-               exact_match_loadfile(proc, optarg);
+               {
+                    char ** files = (char **)realloc(proc->load_files,
+                                                     (proc->load_cnt + 1) *
+                                                     sizeof(char *));
+                    if (!files) {
+                         error_print("failed realloc of load_files");
+                         return 0;
+                    }
+                    proc->load_files = files;
+                    proc->load_files[proc->load_cnt++] = strdup(optarg);
+               }
                break;
           case 'L': // register label for matched string
                proc->label_match = wsregister_label(type_table, optarg);
@@ -396,12 +409,29 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance,
 
           free(proc->open_table);
      }
-     
-     tool_print("matching items %d", proc->items);
 
      return 1; 
 }
 
+// match files are read here on the kid's own thread, concurrently with
+// kids on other threads
+int proc_init_finish(void * vinstance) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     int i;
+
+     for (i = 0; i < proc->load_cnt; i++) {
+          exact_match_loadfile(proc, proc->load_files[i]);
+          free(proc->load_files[i]);
+     }
+     free(proc->load_files);
+     proc->load_files = NULL;
+     proc->load_cnt = 0;
+
+     tool_print("matching items %d", proc->items);
+
+     return 1;
+}
+
 // this function needs to decide on processing function based on datatype
 // given.. also set output types as needed (unless a sink)
 //return 1 if ok
@@ -0,0 +1,896 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//evaluate a boolean expression over labels and values
+#define PROC_NAME "filter"
+//#define DEBUG 1
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <unistd.h>
+#include "waterslide.h"
+#include "waterslidedata.h"
+#include "waterslide_io.h"
+#include "procloader.h"
+#include "wstypes.h"
+#include "datatypes/wsdt_tuple.h"
+
+char proc_version[]     = "1.0";
+char *proc_tags[]     = { "Filtering", "Matching", NULL };
+char *proc_alias[]     = { "where", "predicate", NULL };
+char proc_name[]       = PROC_NAME;
+char proc_purpose[]    = "filters tuples with a boolean expression over labels and values";
+char *proc_synopsis[] = { "filter [-L <LABEL>] [-r <count>] \"<expression>\"", NULL};
+char proc_description[] =
+     "Passes tuples for which a boolean expression is true. The expression "
+     "combines clauses with 'and', 'or' and 'not' (or '&&', '||' and '!') "
+     "and parentheses. A clause is a label, true if a member (or the tuple "
+     "itself) has that label; a label compared to a value with ==, !=, <, "
+     "<=, >, >= or ~ (contains), true if any member with that label matches; "
+     "or #LABEL compared to a number, which tests how many members have the "
+     "label. Nested labels are given as PARENT.CHILD and string values are "
+     "single quoted. Quote the whole expression so the graph parser passes "
+     "it through unchanged.\n"
+     "The expression is compiled once at startup. While running, the clauses "
+     "under each 'and'/'or' are reordered so that the cheapest clauses that "
+     "most often decide the outcome are tried first. A single filter can "
+     "replace a chain of haslabel, match_uint, equal and countlabels kids.";
+proc_example_t proc_examples[] = {
+     {"... | filter \"DNS and not INVALIDDNS\" | ...",
+     "pass tuples with a DNS member that are not labeled INVALIDDNS"},
+     {"... | filter \"DPORT == 53 or SPORT == 53\" | ...",
+     "pass tuples with either port equal to 53"},
+     {"... | filter \"QREC.TYPE == 28 && #ANREC >= 2\" | ...",
+     "pass AAAA queries with at least two answers"},
+     {"... | filter \"NAME ~ 'example' || (TTL < 60 && !AA)\" | ...",
+     "pass names containing example, or short lived non-authoritative records"},
+     {"... | TAG:filter -L HIT \"TTL > 3600\" | ...",
+     "pass everything, labeling tuples that match with HIT"},
+     {"... | NOT:filter \"DNS and #ANREC == 0\" | ...",
+     "drop DNS tuples without answers"},
+     {NULL,""}
+};
+char proc_requires[] = "";
+char *proc_input_types[]    = {"tuple", NULL};
+char *proc_output_types[]    = {"tuple", NULL};
+proc_port_t proc_input_ports[] = {
+     {"none","pass if expression is true"},
+     {"NOT","pass if expression is false"},
+     {"INVERSE","pass if expression is false"},
+     {"TAG","pass all, label tuple if expression is true (requires -L)"},
+     {NULL, NULL}
+};
+char *proc_tuple_container_labels[] = {NULL};
+char *proc_tuple_conditional_container_labels[] = {NULL};
+char *proc_tuple_member_labels[] = {NULL};
+
+proc_option_t proc_opts[] = {
+     /*  'option character', "long option string", "option argument",
+	 "option description", <allow multiple>, <required>*/
+     {'L',"","LABEL",
+     "label to add to tuples that match (TAG port)",0,0},
+     {'r',"","count",
+     "evaluations between clause reordering, 0 to keep the written order "
+     "(default 4096)",0,0},
+     //the following must be left as-is to signify the end of the array
+     {' ',"","",
+     "",0,0}
+};
+char proc_nonswitch_opts[]    = "boolean expression";
+
+//function prototypes for local functions
+static int process_tuple(void *, wsdata_t*, ws_doutput_t*, int);
+static int process_not(void *, wsdata_t*, ws_doutput_t*, int);
+static int process_tag(void *, wsdata_t*, ws_doutput_t*, int);
+static int process_tuple_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+static int process_not_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+
+//batch forms of the filters
+proc_batch_t proc_batch[] = {
+     {process_tuple, process_tuple_batch},
+     {process_not, process_not_batch},
+     {NULL, NULL}
+};
+
+#define PRED_LEAF 0
+#define PRED_AND  1
+#define PRED_OR   2
+
+#define PRED_EXISTS   0
+#define PRED_EQ       1
+#define PRED_NE       2
+#define PRED_LT       3
+#define PRED_LE       4
+#define PRED_GT       5
+#define PRED_GE       6
+#define PRED_CONTAINS 7
+
+#define PRED_MAX_DEPTH 8
+#define PRED_MAX_EXPR 4096
+#define PRED_DEFAULT_REORDER 4096
+
+struct _pred_node_t;
+
+//a clause under an and/or, with what it has cost and decided so far
+typedef struct _pred_branch_t {
+     struct _pred_node_t * node;
+     uint64_t evals;
+     uint64_t decided; // times it short circuited its parent
+     uint64_t work;    // members examined
+} pred_branch_t;
+
+typedef struct _pred_node_t {
+     int type;
+     int negate;
+
+     //leaf
+     wslabel_t * path[PRED_MAX_DEPTH];
+     int depth;
+     int op;
+     int count;    // compare number of members rather than their values
+     int is_str;
+     int is_int;
+     int64_t ival;
+     double dval;
+     char * str;
+     int slen;
+     char * text;
+
+     //and/or
+     pred_branch_t * kids;
+     int nkids;
+     uint64_t evals;
+} pred_node_t;
+
+typedef struct _pred_parser_t {
+     const char * expr;
+     const char * pos;
+     void * type_table;
+} pred_parser_t;
+
+typedef struct _proc_instance_t {
+     uint64_t meta_process_cnt;
+     uint64_t outcnt;
+     uint64_t reorders;
+
+     ws_outtype_t * outtype_tuple;
+     wslabel_t * label_match;
+     pred_node_t * root;
+     char expr[PRED_MAX_EXPR];
+     uint64_t reorder_interval;
+     uint64_t work;
+} proc_instance_t;
+
+static pred_node_t * parse_or(pred_parser_t *);
+
+static void pred_skip_space(pred_parser_t * p) {
+     while (*p->pos && isspace((unsigned char)*p->pos)) {
+          p->pos++;
+     }
+}
+
+//match a symbol or a case-insensitive keyword at the current position
+static int pred_accept(pred_parser_t * p, const char * sym) {
+     pred_skip_space(p);
+     int len = strlen(sym);
+     if (strncasecmp(p->pos, sym, len) != 0) {
+          return 0;
+     }
+     if (isalpha((unsigned char)sym[0]) &&
+         (isalnum((unsigned char)p->pos[len]) || (p->pos[len] == '_'))) {
+          return 0;
+     }
+     p->pos += len;
+     return 1;
+}
+
+static void pred_error(pred_parser_t * p, const char * msg) {
+     error_print("filter: %s at offset %d of \"%s\"", msg,
+                 (int)(p->pos - p->expr), p->expr);
+}
+
+static pred_node_t * pred_new(int type) {
+     pred_node_t * node = (pred_node_t *)calloc(1, sizeof(pred_node_t));
+     if (!node) {
+          error_print("failed calloc of predicate node");
+          return NULL;
+     }
+     node->type = type;
+     return node;
+}
+
+static void pred_free(pred_node_t * node) {
+     int i;
+     if (!node) {
+          return;
+     }
+     for (i = 0; i < node->nkids; i++) {
+          pred_free(node->kids[i].node);
+     }
+     free(node->kids);
+     free(node->str);
+     free(node->text);
+     free(node);
+}
+
+static int pred_label_char(char c) {
+     return isalnum((unsigned char)c) || (c == '_') || (c == '-') || (c == ':');
+}
+
+//parse a value to compare against
+static int parse_value(pred_parser_t * p, pred_node_t * leaf) {
+     pred_skip_space(p);
+     if (*p->pos == '\'') {
+          const char * start = ++p->pos;
+          while (*p->pos && (*p->pos != '\'')) {
+               p->pos++;
+          }
+          if (*p->pos != '\'') {
+               pred_error(p, "unterminated string");
+               return 0;
+          }
+          leaf->slen = p->pos - start;
+          leaf->str = strndup(start, leaf->slen);
+          leaf->is_str = 1;
+          p->pos++;
+          return 1;
+     }
+     char * end = NULL;
+     leaf->dval = strtod(p->pos, &end);
+     if (end == p->pos) {
+          pred_error(p, "expected a number or 'string'");
+          return 0;
+     }
+     //decimal, or hex with an explicit 0x; a leading 0 is not octal
+     const char * digits = p->pos;
+     if ((*digits == '-') || (*digits == '+')) {
+          digits++;
+     }
+     int base = ((digits[0] == '0') && ((digits[1] == 'x') || (digits[1] == 'X'))) ?
+          16 : 10;
+     char * iend = NULL;
+     long long ival = strtoll(p->pos, &iend, base);
+     if (iend == end) {
+          leaf->is_int = 1;
+          leaf->ival = ival;
+     }
+     p->pos = end;
+     return 1;
+}
+
+static pred_node_t * parse_leaf(pred_parser_t * p) {
+     pred_skip_space(p);
+     const char * start = p->pos;
+     pred_node_t * leaf = pred_new(PRED_LEAF);
+     if (!leaf) {
+          return NULL;
+     }
+     if (*p->pos == '#') {
+          leaf->count = 1;
+          p->pos++;
+     }
+
+     //dotted label path
+     while (1) {
+          const char * lstart = p->pos;
+          while (pred_label_char(*p->pos)) {
+               p->pos++;
+          }
+          if (p->pos == lstart) {
+               pred_error(p, "expected a label");
+               pred_free(leaf);
+               return NULL;
+          }
+          if (leaf->depth >= PRED_MAX_DEPTH) {
+               pred_error(p, "label nested too deep");
+               pred_free(leaf);
+               return NULL;
+          }
+          char name[256];
+          int len = p->pos - lstart;
+          if (len >= (int)sizeof(name)) {
+               len = sizeof(name) - 1;
+          }
+          memcpy(name, lstart, len);
+          name[len] = 0;
+          leaf->path[leaf->depth++] = wssearch_label(p->type_table, name);
+          if (*p->pos != '.') {
+               break;
+          }
+          p->pos++;
+     }
+
+     const char * end = p->pos;
+
+     static const struct {
+          const char * sym;
+          int op;
+     } ops[] = {
+          {"==", PRED_EQ}, {"!=", PRED_NE}, {"<=", PRED_LE}, {">=", PRED_GE},
+          {"<", PRED_LT}, {">", PRED_GT}, {"=", PRED_EQ}, {"~", PRED_CONTAINS},
+          {NULL, 0}
+     };
+     int i;
+     for (i = 0; ops[i].sym; i++) {
+          if (pred_accept(p, ops[i].sym)) {
+               leaf->op = ops[i].op;
+               break;
+          }
+     }
+     if (leaf->op != PRED_EXISTS) {
+          if (!parse_value(p, leaf)) {
+               pred_free(leaf);
+               return NULL;
+          }
+          if (leaf->is_str && (leaf->op != PRED_EQ) && (leaf->op != PRED_NE) &&
+              (leaf->op != PRED_CONTAINS)) {
+               pred_error(p, "strings only compare with ==, != or ~");
+               pred_free(leaf);
+               return NULL;
+          }
+          if (!leaf->is_str && (leaf->op == PRED_CONTAINS)) {
+               pred_error(p, "~ needs a 'string'");
+               pred_free(leaf);
+               return NULL;
+          }
+     }
+     if (leaf->count && (!leaf->is_int || (leaf->op == PRED_EXISTS) ||
+                         (leaf->op == PRED_CONTAINS))) {
+          pred_error(p, "#LABEL needs a numeric comparison");
+          pred_free(leaf);
+          return NULL;
+     }
+     if (leaf->op != PRED_EXISTS) {
+          end = p->pos;
+     }
+     leaf->text = strndup(start, end - start);
+     return leaf;
+}
+
+static pred_node_t * parse_not(pred_parser_t * p) {
+     if (pred_accept(p, "not") || pred_accept(p, "!")) {
+          pred_node_t * node = parse_not(p);
+          if (node) {
+               node->negate = !node->negate;
+          }
+          return node;
+     }
+     if (pred_accept(p, "(")) {
+          pred_node_t * node = parse_or(p);
+          if (node && !pred_accept(p, ")")) {
+               pred_error(p, "expected )");
+               pred_free(node);
+               return NULL;
+          }
+          return node;
+     }
+     return parse_leaf(p);
+}
+
+//add a clause to an and/or, pulling up the clauses of a child of the same
+// kind so the whole run can be reordered together
+static int pred_add_kid(pred_node_t * parent, pred_node_t * kid) {
+     if ((kid->type == parent->type) && !kid->negate) {
+          int i;
+          for (i = 0; i < kid->nkids; i++) {
+               if (!pred_add_kid(parent, kid->kids[i].node)) {
+                    return 0;
+               }
+          }
+          kid->nkids = 0;
+          pred_free(kid);
+          return 1;
+     }
+     pred_branch_t * kids = (pred_branch_t *)realloc(parent->kids,
+                                                     sizeof(pred_branch_t) *
+                                                     (parent->nkids + 1));
+     if (!kids) {
+          error_print("failed realloc of predicate clauses");
+          return 0;
+     }
+     parent->kids = kids;
+     memset(&kids[parent->nkids], 0, sizeof(pred_branch_t));
+     kids[parent->nkids].node = kid;
+     parent->nkids++;
+     return 1;
+}
+
+static pred_node_t * parse_list(pred_parser_t * p, int type,
+                                pred_node_t * (*parse_sub)(pred_parser_t *),
+                                const char * word, const char * sym) {
+     pred_node_t * first = parse_sub(p);
+     if (!first) {
+          return NULL;
+     }
+     if (!pred_accept(p, word) && !pred_accept(p, sym)) {
+          return first;
+     }
+     pred_node_t * list = pred_new(type);
+     if (!list || !pred_add_kid(list, first)) {
+          pred_free(first);
+          pred_free(list);
+          return NULL;
+     }
+     do {
+          pred_node_t * next = parse_sub(p);
+          if (!next) {
+               pred_free(list);
+               return NULL;
+          }
+          if (!pred_add_kid(list, next)) {
+               pred_free(next);
+               pred_free(list);
+               return NULL;
+          }
+     } while (pred_accept(p, word) || pred_accept(p, sym));
+     return list;
+}
+
+static pred_node_t * parse_and(pred_parser_t * p) {
+     return parse_list(p, PRED_AND, parse_not, "and", "&&");
+}
+
+static pred_node_t * parse_or(pred_parser_t * p) {
+     return parse_list(p, PRED_OR, parse_and, "or", "||");
+}
+
+static pred_node_t * pred_compile(const char * expr, void * type_table) {
+     pred_parser_t p;
+     p.expr = expr;
+     p.pos = expr;
+     p.type_table = type_table;
+
+     pred_node_t * root = parse_or(&p);
+     if (!root) {
+          return NULL;
+     }
+     pred_skip_space(&p);
+     if (*p.pos) {
+          pred_error(&p, "unexpected text");
+          pred_free(root);
+          return NULL;
+     }
+     return root;
+}
+
+static int pred_snprint(char * buf, int len, pred_node_t * node) {
+     int out = 0;
+     int i;
+     if (len <= 0) {
+          return 0;
+     }
+     if (node->type == PRED_LEAF) {
+          return snprintf(buf, len, "%s%s", node->negate ? "!" : "",
+                          node->text);
+     }
+     out += snprintf(buf, len, "%s(", node->negate ? "!" : "");
+     for (i = 0; (i < node->nkids) && (out < len); i++) {
+          if (i) {
+               out += snprintf(buf + out, len - out, "%s",
+                               (node->type == PRED_AND) ? " and " : " or ");
+          }
+          if (out < len) {
+               out += pred_snprint(buf + out, len - out, node->kids[i].node);
+          }
+     }
+     if (out < len) {
+          out += snprintf(buf + out, len - out, ")");
+     }
+     return out;
+}
+
+static inline int pred_cmp_int(int op, int64_t a, int64_t b) {
+     switch (op) {
+     case PRED_EQ: return a == b;
+     case PRED_NE: return a != b;
+     case PRED_LT: return a < b;
+     case PRED_LE: return a <= b;
+     case PRED_GT: return a > b;
+     case PRED_GE: return a >= b;
+     }
+     return 0;
+}
+
+static inline int pred_cmp_uint(int op, uint64_t a, uint64_t b) {
+     switch (op) {
+     case PRED_EQ: return a == b;
+     case PRED_NE: return a != b;
+     case PRED_LT: return a < b;
+     case PRED_LE: return a <= b;
+     case PRED_GT: return a > b;
+     case PRED_GE: return a >= b;
+     }
+     return 0;
+}
+
+static inline int pred_cmp_double(int op, double a, double b) {
+     switch (op) {
+     case PRED_EQ: return a == b;
+     case PRED_NE: return a != b;
+     case PRED_LT: return a < b;
+     case PRED_LE: return a <= b;
+     case PRED_GT: return a > b;
+     case PRED_GE: return a >= b;
+     }
+     return 0;
+}
+
+static int pred_member_match(pred_node_t * leaf, wsdata_t * member) {
+     if (leaf->is_str) {
+          char * buf;
+          int len;
+          if (!dtype_string_buffer(member, &buf, &len)) {
+               return 0;
+          }
+          switch (leaf->op) {
+          case PRED_EQ:
+               return (len == leaf->slen) && (memcmp(buf, leaf->str, len) == 0);
+          case PRED_NE:
+               return (len != leaf->slen) || (memcmp(buf, leaf->str, len) != 0);
+          case PRED_CONTAINS:
+               return memmem(buf, len, leaf->str, leaf->slen) != NULL;
+          }
+          return 0;
+     }
+     if (leaf->is_int) {
+          uint64_t u64;
+          int64_t i64;
+          if ((leaf->ival >= 0) && dtype_get_uint64(member, &u64)) {
+               return pred_cmp_uint(leaf->op, u64, (uint64_t)leaf->ival);
+          }
+          if (dtype_get_int64(member, &i64)) {
+               return pred_cmp_int(leaf->op, i64, leaf->ival);
+          }
+     }
+     double dbl;
+     if (dtype_get_double(member, &dbl)) {
+          return pred_cmp_double(leaf->op, dbl, leaf->dval);
+     }
+     return 0;
+}
+
+//walk the label path; returns 1 once a member satisfies the clause, adding
+// the number of matching members to *count when counting
+static int pred_leaf_search(proc_instance_t * proc, pred_node_t * leaf,
+                            wsdata_t * tdata, int level, int64_t * count) {
+     wsdata_t ** mset;
+     int mlen;
+     int i;
+
+     if (!tuple_find_label(tdata, leaf->path[level], &mlen, &mset)) {
+          return 0;
+     }
+     proc->work += mlen;
+     if (level == (leaf->depth - 1)) {
+          if (leaf->count) {
+               *count += mlen;
+               return 0;
+          }
+          if (leaf->op == PRED_EXISTS) {
+               return 1;
+          }
+          for (i = 0; i < mlen; i++) {
+               if (pred_member_match(leaf, mset[i])) {
+                    return 1;
+               }
+          }
+          return 0;
+     }
+     for (i = 0; i < mlen; i++) {
+          if ((mset[i]->dtype == dtype_tuple) &&
+              pred_leaf_search(proc, leaf, mset[i], level + 1, count)) {
+               return 1;
+          }
+     }
+     return 0;
+}
+
+static int pred_leaf_eval(proc_instance_t * proc, pred_node_t * leaf,
+                          wsdata_t * tdata) {
+     proc->work++;
+     if (leaf->count) {
+          int64_t count = 0;
+          pred_leaf_search(proc, leaf, tdata, 0, &count);
+          return pred_cmp_int(leaf->op, count, leaf->ival);
+     }
+     if (pred_leaf_search(proc, leaf, tdata, 0, NULL)) {
+          return 1;
+     }
+     //a bare label may also be on the tuple itself
+     if ((leaf->op == PRED_EXISTS) && (leaf->depth == 1)) {
+          return wsdata_check_label(tdata, leaf->path[0]);
+     }
+     return 0;
+}
+
+static int pred_branch_cmp(const void * va, const void * vb) {
+     const pred_branch_t * a = (const pred_branch_t *)va;
+     const pred_branch_t * b = (const pred_branch_t *)vb;
+     //expected work before the parent is decided: cost / P(decides),
+     // smoothed so unseen clauses are not ranked at the extremes
+     double ra = ((double)a->work + 1.0) / ((double)a->decided + 1.0);
+     double rb = ((double)b->work + 1.0) / ((double)b->decided + 1.0);
+     if (ra < rb) {
+          return -1;
+     }
+     return (ra > rb) ? 1 : 0;
+}
+
+//put the clauses that are cheap and usually decide the outcome first,
+// then age the counts so the order keeps tracking the stream
+static void pred_reorder(proc_instance_t * proc, pred_node_t * node) {
+     int i;
+     qsort(node->kids, node->nkids, sizeof(pred_branch_t), pred_branch_cmp);
+     for (i = 0; i < node->nkids; i++) {
+          node->kids[i].evals >>= 1;
+          node->kids[i].decided >>= 1;
+          node->kids[i].work >>= 1;
+     }
+     proc->reorders++;
+}
+
+static int pred_eval(proc_instance_t * proc, pred_node_t * node,
+                     wsdata_t * tdata) {
+     int rtn;
+     if (node->type == PRED_LEAF) {
+          rtn = pred_leaf_eval(proc, node, tdata);
+     }
+     else {
+          //and is decided by a false clause, or by a true one
+          int decide = (node->type == PRED_OR);
+          int i;
+          rtn = !decide;
+          for (i = 0; i < node->nkids; i++) {
+               pred_branch_t * kid = &node->kids[i];
+               uint64_t start = proc->work;
+               int r = pred_eval(proc, kid->node, tdata);
+               kid->evals++;
+               kid->work += proc->work - start;
+               if (r == decide) {
+                    kid->decided++;
+                    rtn = decide;
+                    break;
+               }
+          }
+          node->evals++;
+          if (proc->reorder_interval &&
+              ((node->evals % proc->reorder_interval) == 0)) {
+               pred_reorder(proc, node);
+          }
+     }
+     return node->negate ? !rtn : rtn;
+}
+
+static int proc_cmd_options(int argc, char ** argv, 
+                            proc_instance_t * proc,
+                            void * type_table) {
+     int op;
+
+     while ((op = getopt(argc, argv, "L:r:")) != EOF) {
+          switch (op) {
+          case 'L':
+               proc->label_match = wsregister_label(type_table, optarg);
+               tool_print("labeling matches with %s", optarg);
+               break;
+          case 'r':
+               proc->reorder_interval = strtoull(optarg, NULL, 10);
+               break;
+          default:
+               return 0;
+          }
+     }
+
+     //the expression may arrive as one quoted argument or as several words
+     int len = 0;
+     while (optind < argc) {
+          int alen = strlen(argv[optind]);
+          if ((len + alen + 2) > PRED_MAX_EXPR) {
+               error_print("expression too long");
+               return 0;
+          }
+          if (len) {
+               proc->expr[len++] = ' ';
+          }
+          memcpy(proc->expr + len, argv[optind], alen);
+          len += alen;
+          optind++;
+     }
+     proc->expr[len] = 0;
+     return 1;
+}
+
+// the following is a function to take in command arguments and initalize
+// this processor's instance..
+//  also register as a source here..
+// return 1 if ok
+// return 0 if fail
+int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourcev_t * sv,
+              void * type_table) {
+     
+     //allocate proc instance of this processor
+     proc_instance_t * proc =
+          (proc_instance_t*)calloc(1,sizeof(proc_instance_t));
+     *vinstance = proc;
+
+     proc->reorder_interval = PRED_DEFAULT_REORDER;
+
+     //read in command options
+     if (!proc_cmd_options(argc, argv, proc, type_table)) {
+          return 0;
+     }
+     if (!proc->expr[0]) {
+          error_print("need an expression");
+          return 0;
+     }
+
+     proc->root = pred_compile(proc->expr, type_table);
+     if (!proc->root) {
+          return 0;
+     }
+
+     char buf[PRED_MAX_EXPR];
+     pred_snprint(buf, PRED_MAX_EXPR, proc->root);
+     tool_print("compiled %s", buf);
+
+     kid->reads = WSKID_READS_LABELS;
+     return 1; 
+}
+
+// this function needs to decide on processing function based on datatype
+// given.. also set output types as needed (unless a sink)
+//return 1 if ok
+// return 0 if problem
+proc_process_t proc_input_set(void * vinstance, wsdatatype_t * meta_type,
+                              wslabel_t * port,
+                              ws_outlist_t* olist, int type_index,
+                              void * type_table) {
+     proc_instance_t * proc = (proc_instance_t *)vinstance;
+
+     if (!wsdatatype_match(type_table, meta_type, "TUPLE_TYPE")) {
+          return NULL;
+     }
+     proc->outtype_tuple = ws_add_outtype(olist, meta_type, NULL);
+
+     if (wslabel_match(type_table, port, "NOT") ||
+         wslabel_match(type_table, port, "INVERSE")) {
+          return process_not;
+     }
+     if (wslabel_match(type_table, port, "TAG")) {
+          if (!proc->label_match) {
+               error_print("TAG port requires -L");
+               return NULL;
+          }
+          return process_tag;
+     }
+     return process_tuple;
+}
+
+//// proc processing function assigned to a specific data type in proc_io_init
+//return 1 if output is available
+// return 0 if not output
+static int process_tuple(void * vinstance, wsdata_t* input_data,
+                         ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+
+     proc->meta_process_cnt++;
+
+     if (pred_eval(proc, proc->root, input_data)) {
+          proc->outcnt++;
+          ws_set_outdata(input_data, proc->outtype_tuple, dout);
+          return 1;
+     }
+     return 0;
+}
+
+static int process_not(void * vinstance, wsdata_t* input_data,
+                       ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+
+     proc->meta_process_cnt++;
+
+     if (!pred_eval(proc, proc->root, input_data)) {
+          proc->outcnt++;
+          ws_set_outdata(input_data, proc->outtype_tuple, dout);
+          return 1;
+     }
+     return 0;
+}
+
+static int process_tag(void * vinstance, wsdata_t* input_data,
+                       ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+
+     proc->meta_process_cnt++;
+
+     if (pred_eval(proc, proc->root, input_data)) {
+          wsdata_add_label(input_data, proc->label_match);
+     }
+     proc->outcnt++;
+     ws_set_outdata(input_data, proc->outtype_tuple, dout);
+     return 1;
+}
+
+//returns number of tuples passed
+static int process_tuple_batch(void * vinstance, wsdata_t** input_data,
+                               int len, ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     int i;
+     int out = 0;
+
+     proc->meta_process_cnt += len;
+
+     for (i = 0; i < len; i++) {
+          if (pred_eval(proc, proc->root, input_data[i])) {
+               ws_set_outdata(input_data[i], proc->outtype_tuple, dout);
+               out++;
+          }
+     }
+     proc->outcnt += out;
+     return out;
+}
+
+static int process_not_batch(void * vinstance, wsdata_t** input_data,
+                             int len, ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     int i;
+     int out = 0;
+
+     proc->meta_process_cnt += len;
+
+     for (i = 0; i < len; i++) {
+          if (!pred_eval(proc, proc->root, input_data[i])) {
+               ws_set_outdata(input_data[i], proc->outtype_tuple, dout);
+               out++;
+          }
+     }
+     proc->outcnt += out;
+     return out;
+}
+
+//return 1 if successful
+//return 0 if no..
+int proc_destroy(void * vinstance) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     tool_print("input cnt %" PRIu64, proc->meta_process_cnt);
+     tool_print("output cnt %" PRIu64, proc->outcnt);
+     if (proc->root) {
+          char buf[PRED_MAX_EXPR];
+          pred_snprint(buf, PRED_MAX_EXPR, proc->root);
+          tool_print("final order %s after %" PRIu64 " reorders", buf,
+                     proc->reorders);
+     }
+
+     //free dynamic allocations
+     pred_free(proc->root);
+     free(proc);
+
+     return 1;
+}
@@ -279,11 +279,12 @@ static int proc_tuple(void * vinstance, wsdata_t* input_data,
                                &mset_len, &mset)) {
                if (mset_len && (mset[0]->dtype == dtype_ts)) {
                     wsdt_ts_t * ts = (wsdt_ts_t*)mset[0]->data;
+                    sysutil_clock_observe(ts->sec, ts->usec);
                     current_time = ts->sec;
                }
           }
           if (!current_time) {
-               current_time = time(NULL);
+               current_time = sysutil_time();
           }
      }
 
@@ -116,6 +116,17 @@ typedef struct _fixedmatchlist_t {
      struct _fixedmatchlist_t * next;
 } fixedmatchlist_t;
 
+//a -F file or -R string, read in proc_init_finish in option order
+typedef struct _fixedmatch_src_t {
+     char * file;
+     char * str;
+     int len;
+     int atend;
+     int offset;
+     wslabel_t * label;
+     struct _fixedmatch_src_t * next;
+} fixedmatch_src_t;
+
 typedef struct _proc_instance_t {
      uint64_t meta_process_cnt;
      uint64_t meta_flow_cnt;
@@ -127,6 +138,9 @@ typedef struct _proc_instance_t {
      wslabel_t * label_match;
      wslabel_nested_set_t nest;
      int add_parent_label;
+     void * type_table;
+     fixedmatch_src_t * src_head;
+     fixedmatch_src_t * src_tail;
 } proc_instance_t;
 
 static int add_fixedmatch_string(proc_instance_t * proc, const char * str, int len,
@@ -179,7 +193,8 @@ static int add_fixedmatch_string(proc_instance_t * proc, const char * str, int l
      return 1;
 }
 
-static int fixedmatch_loadfile(proc_instance_t * proc, void * type_table, char * thefile) {
+static int fixedmatch_loadfile(proc_instance_t * proc, void * type_table,
+                               char * thefile, wslabel_t * default_label) {
      FILE * fp;
      char line [2001];
      int linelen;
@@ -273,7 +288,7 @@ static int fixedmatch_loadfile(proc_instance_t * proc, void * type_table, char *
                     add_fixedmatch_string(proc, matchstr, matchlen, atend, offset, label);
                }
                else  {
-                    add_fixedmatch_string(proc, matchstr, matchlen, atend, offset, proc->label_match);
+                    add_fixedmatch_string(proc, matchstr, matchlen, atend, offset, default_label);
                }
           }
      }
@@ -282,6 +297,23 @@ static int fixedmatch_loadfile(proc_instance_t * proc, void * type_table, char *
 }
 
 
+static fixedmatch_src_t * queue_fixedmatch_src(proc_instance_t * proc) {
+     fixedmatch_src_t * src =
+          (fixedmatch_src_t *)calloc(1, sizeof(fixedmatch_src_t));
+     if (!src) {
+          error_print("failed queue_fixedmatch_src calloc of src");
+          return NULL;
+     }
+     if (proc->src_tail) {
+          proc->src_tail->next = src;
+     }
+     else {
+          proc->src_head = src;
+     }
+     proc->src_tail = src;
+     return src;
+}
+
 static int proc_cmd_options(int argc, char ** argv, 
                             proc_instance_t * proc, void * type_table) {
      int op;
@@ -294,7 +326,14 @@ static int proc_cmd_options(int argc, char ** argv,
                proc->add_parent_label = 1;
                break;
           case 'F':
-			fixedmatch_loadfile(proc, type_table, optarg);
+               {
+                    fixedmatch_src_t * src = queue_fixedmatch_src(proc);
+                    if (!src) {
+                         return 0;
+                    }
+                    src->file = strdup(optarg);
+                    src->label = proc->label_match;
+               }
                break;
           case 'e': //fallthrough
           case 'E': 
@@ -312,13 +351,17 @@ static int proc_cmd_options(int argc, char ** argv,
                break;
           case 'R':
                {
-                    char *buf = strdup(optarg);
-                    int len = strlen(buf);
-                    sysutil_decode_hex_escapes(buf, &len);  //destructive 
-                    add_fixedmatch_string(proc, buf, len, atend, offset,
-                                          proc->label_match);
+                    fixedmatch_src_t * src = queue_fixedmatch_src(proc);
+                    if (!src) {
+                         return 0;
+                    }
+                    src->str = strdup(optarg);
+                    src->len = strlen(src->str);
+                    sysutil_decode_hex_escapes(src->str, &src->len);  //destructive 
+                    src->atend = atend;
+                    src->offset = offset;
+                    src->label = proc->label_match;
                     tool_print("added match string '%s'", optarg);
-                    free(buf);
                }
                break;
           default:
@@ -349,12 +392,14 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
 
      proc->label_match = wsregister_label(type_table, "FMATCH");
 
+     proc->type_table = type_table;
+
      //read in command options
      if (!proc_cmd_options(argc, argv, proc, type_table)) {
           return 0;
      }
 
-     if (!proc->matchlist) {
+     if (!proc->src_head) {
           tool_print("no matched defined");
           return 0;
      }
@@ -362,6 +407,38 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
      return 1; 
 }
 
+// match tables are built here on the kid's own thread, concurrently with
+// kids on other threads
+int proc_init_finish(void * vinstance) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     fixedmatch_src_t * src = proc->src_head;
+
+     while (src) {
+          fixedmatch_src_t * next = src->next;
+          if (src->file) {
+               fixedmatch_loadfile(proc, proc->type_table, src->file,
+                                   src->label);
+               free(src->file);
+          }
+          else {
+               add_fixedmatch_string(proc, src->str, src->len, src->atend,
+                                     src->offset, src->label);
+               free(src->str);
+          }
+          free(src);
+          src = next;
+     }
+     proc->src_head = NULL;
+     proc->src_tail = NULL;
+
+     if (!proc->matchlist) {
+          tool_print("no matched defined");
+          return 0;
+     }
+
+     return 1;
+}
+
 // this function needs to decide on processing function based on datatype
 // given.. also set output types as needed (unless a sink)
 //return 1 if ok
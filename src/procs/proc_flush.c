@@ -238,12 +238,13 @@ static int proc_process_tuple(void * vinstance, wsdata_t* input_data,
                if (mset_len && (mset[0]->dtype == dtype_ts)) {
                     //just choose first match key name
                     wsdt_ts_t * ts = (wsdt_ts_t*)mset[0]->data;
+                    sysutil_clock_observe(ts->sec, ts->usec);
                     do_flush_time(proc, ts->sec, dout);
                     found = 1;
                }
           }
           if (!found) {
-               do_flush_time(proc, time(NULL), dout);
+               do_flush_time(proc, sysutil_time(), dout);
           }
      }
 
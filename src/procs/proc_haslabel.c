@@ -90,6 +90,17 @@ static int process_tuple_multicnt(void *, wsdata_t*, ws_doutput_t*, int);
 static int process_meta(void *, wsdata_t*, ws_doutput_t*, int);
 static int process_meta_not(void *, wsdata_t*, ws_doutput_t*, int);
 static int process_not(void *, wsdata_t*, ws_doutput_t*, int);
+static int process_tuple_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+static int process_meta_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+static int process_not_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+
+//batch forms of the common filters
+proc_batch_t proc_batch[] = {
+     {process_tuple, process_tuple_batch},
+     {process_meta, process_meta_batch},
+     {process_not, process_not_batch},
+     {NULL, NULL}
+};
 
 #define LOCAL_MAX_TYPES 64
 typedef struct _proc_instance_t {
@@ -176,6 +187,7 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
           error_print("need labels");
           return 0;
      }  
+     kid->reads = WSKID_READS_LABELS;
      return 1; 
 }
 
@@ -277,6 +289,19 @@ static inline int local_nested_search(proc_instance_t * proc,
 //// proc processing function assigned to a specific data type in proc_io_init
 //return 1 if output is available
 // return 0 if not output
+static inline int tuple_match(proc_instance_t * proc, wsdata_t * tdata) {
+     int uniq_labels;
+
+     uniq_labels = local_nested_search(proc, tdata, 0);
+
+     if (uniq_labels < proc->nest.cnt) {
+          uniq_labels += container_search(proc, tdata);
+     }
+
+     return ((proc->any_match && uniq_labels) ||
+             (uniq_labels >= proc->nest.cnt));
+}
+
 static int process_tuple(void * vinstance, wsdata_t* input_data,
                          ws_doutput_t * dout, int type_index) {
 
@@ -285,15 +310,7 @@ static int process_tuple(void * vinstance, wsdata_t* input_data,
 
      proc->meta_process_cnt++;
 
-     int uniq_labels;
-
-     uniq_labels = local_nested_search(proc, input_data, 0);
-
-     if (uniq_labels < proc->nest.cnt) {
-          uniq_labels += container_search(proc, input_data);
-     }
-    
-     if ((proc->any_match && uniq_labels) || (uniq_labels >= proc->nest.cnt)) { 
+     if (tuple_match(proc, input_data)) { 
           proc->outcnt++;
           ws_set_outdata(input_data, proc->outtype_tuple, dout);
           return 1;
@@ -301,6 +318,26 @@ static int process_tuple(void * vinstance, wsdata_t* input_data,
      return 0;
 }
 
+//returns number of tuples passed
+static int process_tuple_batch(void * vinstance, wsdata_t** input_data,
+                               int len, ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     int i;
+     int out = 0;
+
+     proc->meta_process_cnt += len;
+
+     for (i = 0; i < len; i++) {
+          if (tuple_match(proc, input_data[i])) {
+               ws_set_outdata(input_data[i], proc->outtype_tuple, dout);
+               out++;
+          }
+     }
+     proc->outcnt += out;
+     return out;
+}
+
 static inline int local_nested_multicnt_search(proc_instance_t * proc,
                                                wsdata_t * tdata, int sid) {
      int i, j;
@@ -364,6 +401,13 @@ static int process_tuple_multicnt(void * vinstance, wsdata_t* input_data,
 }
 
 
+static inline int meta_match(proc_instance_t * proc, wsdata_t * input_data) {
+     int uniq_labels = container_search(proc, input_data);
+
+     return ((proc->any_match && uniq_labels) ||
+             (uniq_labels >= proc->nest.cnt));
+}
+
 static int process_meta(void * vinstance, wsdata_t* input_data,
                         ws_doutput_t * dout, int type_index) {
 
@@ -372,11 +416,7 @@ static int process_meta(void * vinstance, wsdata_t* input_data,
 
      proc->meta_process_cnt++;
 
-     int uniq_labels = 0;
-
-     uniq_labels += container_search(proc, input_data);
-    
-     if ((proc->any_match && uniq_labels) || (uniq_labels >= proc->nest.cnt)) { 
+     if (meta_match(proc, input_data)) { 
           proc->outcnt++;
           ws_set_outdata(input_data, proc->outtype_meta[type_index], dout);
           return 1;
@@ -384,6 +424,27 @@ static int process_meta(void * vinstance, wsdata_t* input_data,
      return 0;
 }
 
+//returns number of records passed
+static int process_meta_batch(void * vinstance, wsdata_t** input_data,
+                              int len, ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     ws_outtype_t * outtype = proc->outtype_meta[type_index];
+     int i;
+     int out = 0;
+
+     proc->meta_process_cnt += len;
+
+     for (i = 0; i < len; i++) {
+          if (meta_match(proc, input_data[i])) {
+               ws_set_outdata(input_data[i], outtype, dout);
+               out++;
+          }
+     }
+     proc->outcnt += out;
+     return out;
+}
+
 static int process_meta_not(void * vinstance, wsdata_t* input_data,
                                                     ws_doutput_t * dout,
                                                     int type_index) {
@@ -439,6 +500,17 @@ static inline int local_nested_not_search(proc_instance_t * proc,
 //// proc processing function assigned to a specific data type in proc_io_init
 //return 1 if output is available
 // return 0 if not output
+static inline int not_match(proc_instance_t * proc, wsdata_t * tdata) {
+     if (container_search(proc, tdata)) {
+          return 0;
+     }
+
+     if (local_nested_not_search(proc, tdata, 0)) {
+          return 0; 
+     }
+     return 1;
+}
+
 static int process_not(void * vinstance, wsdata_t* input_data,
                          ws_doutput_t * dout, int type_index) {
 
@@ -446,19 +518,35 @@ static int process_not(void * vinstance, wsdata_t* input_data,
 
      proc->meta_process_cnt++;
 
-     if (container_search(proc, input_data)) {
+     if (!not_match(proc, input_data)) {
           return 0;
      }
-
-     if (local_nested_not_search(proc, input_data, 0)) {
-          return 0; 
-     }
     
      proc->outcnt++;
      ws_set_outdata(input_data, proc->outtype_tuple, dout);
      return 1;
 }
 
+//returns number of tuples passed
+static int process_not_batch(void * vinstance, wsdata_t** input_data,
+                             int len, ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     int i;
+     int out = 0;
+
+     proc->meta_process_cnt += len;
+
+     for (i = 0; i < len; i++) {
+          if (not_match(proc, input_data[i])) {
+               ws_set_outdata(input_data[i], proc->outtype_tuple, dout);
+               out++;
+          }
+     }
+     proc->outcnt += out;
+     return out;
+}
+
 //used for making monitoring re-fire at each t-interval
 //this makes little sense to me but it's how bandwidth was doing it so we'll try doing
 //it here too and see what happens...
@@ -43,14 +43,16 @@
 #include "heavyhitters.h"
 #include "wstypes.h"
 #include "procloader.h"
+#include "shared/kidshare.h"
+#include "shared/lock_init.h"
 
-char proc_version[]     = "1.5";
+char proc_version[]     = "1.6";
 char *proc_menus[]     = { "Filters", NULL };
 char *proc_alias[]     = { NULL };
 char proc_name[]       = PROC_NAME;
 char proc_purpose[]    = "keeps track of top items";
 
-char *proc_synopsis[] = { "heavyhitters <LABEL> [-1 ] [-K <label>] [-V <label>] [-L <label>] [-R] [-N <records>] [-S] [-h]", NULL};
+char *proc_synopsis[] = { "heavyhitters <LABEL> [-1 ] [-K <label>] [-V <label>] [-L <label>] [-R] [-N <records>] [-S] [-J <label>] [-h]", NULL};
 char *proc_tags[] = {"Statistics", "State", "Tracking", NULL};
 char proc_description[] = {"The heavyhitters kid will track the top hits using a specified label (-K explicitly sets that label). For example, if provided the "
 	"WORD label, this kid will return the top words seen within the data. It tracks the number of tuples it sees with "
@@ -61,6 +63,9 @@ char proc_description[] = {"The heavyhitters kid will track the top hits using a
 	"Using -V <label>, heavyhitters will use the value in <label> to determine the top items by adding that value to the global count (instead "
 	"of the default of 1). "
 	"Also, using the -N option, heavy hitters can be told how many records to output: e.g. -N 5 will give the top 5. 10 is the default output. "
+	"With -J <label>, every heavyhitters kid sharing that label (typically one per thread) keeps its own sketch "
+	"and, at flush, folds it into a common sketch; the last sharer to flush emits the merged top items. "
+	"All sharers must receive the flush. "
 	"Lastly, heavyhitters adds the label ACC that "
      "contains the accumulated value used to determine the top hits (to specify a different label, use -L). "
 	"The heavyhitters kid is based on the 'Efficient Computation of Frequent and Top-k Elements in Data Streams,' by Metwally, Agrawal and Abbadi; 2005.  The algorithm does an approximate frequency estimation using a fixed amount of memory.  On heavily skewed data sets, the approximation will have extremely tight error bounds and the results will be highly accurate.  However, if the distribution of items is all unique (i.e., single or low counts; low skew), the output counts may appear to be dramatically incorrect.  Error bounds are not printed in current output, and will be much higher for low skew distributions."};
@@ -68,6 +73,7 @@ proc_example_t proc_examples[] = {
           {"... | heavyhitters WORD | ...", "determines the most used words"},
           {"... | heavyhitters WORD -R | ...", "determines the most used words and only keep the words, not the whole tuple"},
           {"... | heavyhitters SENTENCE -V WORDLENGTH | ...", "determines the longest sentences by accumulating the work length"},
+          {"... | thread(4) { heavyhitters WORD -J words } | ...", "per-thread sketches merged into one top 10 at flush"},
 
           {NULL,""}
 };
@@ -99,6 +105,8 @@ proc_option_t proc_opts[] = {
      "maximum internal-space records",0,0},
      {'S',"","",
      "store last instance of key rather than first",0,0},
+     {'J',"","label",
+     "merge with sketches of other kids sharing label at flush",0,0},
      //the following must be left as-is to signify the end of the array
      {' ',"","",
      "",0,0}
@@ -116,10 +124,28 @@ static void kdata_release(void * vkdata) {
      }
 }
 
+//carry a representative over to the merged sketch
+static void kdata_merge(void * vdst, void * vsrc) {
+     key_data_t * dst = (key_data_t*)vdst;
+     key_data_t * src = (key_data_t*)vsrc;
+     if (dst && src && !dst->wsd && src->wsd) {
+          dst->wsd = src->wsd;
+          wsdata_add_reference(dst->wsd);
+     }
+}
+
 //function prototypes for local functions
 static int proc_tuple(void *, wsdata_t*, ws_doutput_t*, int);
 static int proc_flush(void *, wsdata_t*, ws_doutput_t*, int);
 
+//sketch shared by all kids at the same -J label
+typedef struct _proc_share_t {
+     int cnt;      //number of sharers
+     int flushed;  //sharers merged in during current flush
+     heavyhitters_t * merged;
+     WS_MUTEX_DECL(lock)
+} proc_share_t;
+
 typedef struct _proc_instance_t {
      uint64_t meta_process_cnt;
      uint64_t outcnt;
@@ -135,13 +161,17 @@ typedef struct _proc_instance_t {
      int flush_once;
      int flushes;
      int swap_lastkey;
+
+     proc_share_t * sharedata;
+     char * sharelabel;
+     void * v_type_table;
 } proc_instance_t;
 
 static int proc_cmd_options(int argc, char ** argv, 
                             proc_instance_t * proc, void * type_table) {
      int op;
 
-     while ((op = getopt(argc, argv, "S1RL:M:V:N:")) != EOF) {
+     while ((op = getopt(argc, argv, "S1RL:M:V:N:J:")) != EOF) {
           switch (op) {
           case 'S':
                proc->swap_lastkey = 1;
@@ -167,6 +197,9 @@ static int proc_cmd_options(int argc, char ** argv,
           case 'M':
                proc->max_buffers = strtoul(optarg, NULL, 0);
                break;
+          case 'J':
+               proc->sharelabel = strdup(optarg);
+               break;
           default:
                return 0;
           }
@@ -214,6 +247,38 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
 
      proc->hitters = heavyhitters_init(proc->max_buffers, sizeof(key_data_t),
                                        kdata_release);
+     if (!proc->hitters) {
+          return 0;
+     }
+
+     if (proc->sharelabel) {
+          proc->v_type_table = type_table;
+          //see if structure is already available at label
+          proc->sharedata = ws_kidshare_get(type_table, proc->sharelabel);
+
+          if (!proc->sharedata) {
+               tool_print("this kid is shared at label %s", proc->sharelabel);
+               proc->sharedata = (proc_share_t *)calloc(1, sizeof(proc_share_t));
+               if (!proc->sharedata) {
+                    error_print("failed calloc of proc->sharedata");
+                    return 0;
+               }
+               proc->sharedata->merged = heavyhitters_init(proc->max_buffers,
+                                                           sizeof(key_data_t),
+                                                           kdata_release);
+               if (!proc->sharedata->merged) {
+                    return 0;
+               }
+               WS_MUTEX_INIT(&proc->sharedata->lock, mutex_attr)
+
+               //actually share structure
+               ws_kidshare_put(type_table, proc->sharelabel, proc->sharedata);
+          }
+          proc->sharedata->cnt++;
+          tool_print("this is kid #%d to share sketch at label %s",
+                     proc->sharedata->cnt, proc->sharelabel);
+          heavyhitters_set_seed(proc->hitters, proc->sharedata->merged->seed);
+     }
 
      return 1; 
 }
@@ -318,18 +383,11 @@ static int proc_tuple(void * vinstance, wsdata_t* input_data,
      return 1;
 }
 
-static int proc_flush(void * vinstance, wsdata_t* input_data,
-                      ws_doutput_t * dout, int type_index) {
-     proc_instance_t * proc = (proc_instance_t*)vinstance;
-     //tool_print("flushing heavy hitters");
-     proc->flushes++;
-
-     if (proc->flush_once && (proc->flushes > 1)) {
-          heavyhitters_reset(proc->hitters);
-          return 0;
-     }
+//emit the top items of a sketch and reset it
+static void emit_hitters(proc_instance_t * proc, heavyhitters_t * hitters,
+                         ws_doutput_t * dout) {
      uint64_t count = 0;
-     hh_node_t ** list = heavyhitters_sort(proc->hitters, proc->max_out, &count);
+     hh_node_t ** list = heavyhitters_sort(hitters, proc->max_out, &count);
      dprint("flushing %"PRIu64, count);
 
      uint64_t i;
@@ -360,7 +418,34 @@ static int proc_flush(void * vinstance, wsdata_t* input_data,
           }
      }
 
-     heavyhitters_reset(proc->hitters);
+     heavyhitters_reset(hitters);
+}
+
+static int proc_flush(void * vinstance, wsdata_t* input_data,
+                      ws_doutput_t * dout, int type_index) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     //tool_print("flushing heavy hitters");
+     proc->flushes++;
+
+     if (proc->flush_once && (proc->flushes > 1)) {
+          heavyhitters_reset(proc->hitters);
+          return 0;
+     }
+     if (proc->sharedata) {
+          proc_share_t * share = proc->sharedata;
+          WS_MUTEX_LOCK(&share->lock)
+          heavyhitters_merge(share->merged, proc->hitters, kdata_merge);
+          heavyhitters_reset(proc->hitters);
+          share->flushed++;
+          if (share->flushed == share->cnt) {
+               share->flushed = 0;
+               emit_hitters(proc, share->merged, dout);
+          }
+          WS_MUTEX_UNLOCK(&share->lock)
+          return 1;
+     }
+
+     emit_hitters(proc, proc->hitters, dout);
 
      return 1;
 }
@@ -374,9 +459,18 @@ int proc_destroy(void * vinstance) {
 
      heavyhitters_destroy(proc->hitters);
 
+     if (proc->sharedata) {
+          //last sharer out destroys the merged sketch
+          if (ws_kidshare_unshare(proc->v_type_table, proc->sharelabel) == 0) {
+               heavyhitters_destroy(proc->sharedata->merged);
+               WS_MUTEX_DESTROY(&proc->sharedata->lock)
+               free(proc->sharedata);
+          }
+     }
+     free(proc->sharelabel);
+
      //free dynamic allocations
      free(proc);
 
      return 1;
 }
-
@@ -32,15 +32,17 @@ SOFTWARE.
 #include "waterslidedata.h"
 #include "datatypes/wsdt_tuple.h"
 #include "stringhash5.h"
+#include "wsheap.h"
+#include "wstypes.h"
 #include "procloader.h"
 
-char proc_version[]    = "1.5";
+char proc_version[]    = "1.6";
 char *proc_menus[]     = { "Filters", NULL };
 char *proc_tags[]      = { "Stream manipulation", NULL };
 char *proc_alias[]     = { "join", "jointuples", NULL };
 char proc_name[]       = PROC_NAME;
 char proc_purpose[]    = "joins tuples from two input streams and combines their members";
-char *proc_synopsis[] = { "$left:LEFT, $right:RIGHT | jointuple -K <label> -L <label> -R <label> [-M <number>]", NULL };
+char *proc_synopsis[] = { "$left:LEFT, $right:RIGHT | jointuple -K <label> -L <label> -R <label> [-M <number>] [-T <label> -W <seconds> [-A <seconds>]] [-P <label>]", NULL };
 char proc_description[] = "The jointuple kid implements a streaming join over "
 	"two input ports (LEFT and RIGHT). For each incoming tuple on a port, "
 	"the values for the KEYLABEL specified with the -K option are checked "
@@ -72,9 +74,19 @@ char proc_description[] = "The jointuple kid implements a streaming join over "
 	"because a newer tuple with the same key value arrives, or the "
 	"table runs out of free slots, then only that value expires.  The "
 	"tuple remains in the table until it is matched or all of its key "
-	"values have expired. ";
+	"values have expired. "
+	"With -T LABEL the join is windowed on event time instead: the "
+	"timestamp under LABEL (a TS_TYPE or a count of seconds) must be "
+	"within the -W window of the stored tuple for the two to join. "
+	"A watermark trails the newest event time seen on either port by "
+	"the -A allowed lateness; stored tuples expire once the watermark "
+	"passes the end of their window, and tuples arriving behind the "
+	"watermark, or without a timestamp, are dropped and counted. "
+	"The -P option limits the members kept while a tuple waits in the "
+	"table to the key and the listed labels. ";
 proc_example_t proc_examples[] = {
 	{"... | $left:LEFT, $right:RIGHT | jointuple -K KEYLABEL -L COMMON -R RIGHT_A -L RIGHT_B | ...", "Joins tuples from the right and left stream variables into a common tuple using the KEYLABEL to identify events to join."},
+	{"... | $flow:LEFT, $dns:RIGHT | jointuple -K IP -T DATETIME -W 60 -A 5 -P QNAME | ...", "Joins flows with DNS answers for the same IP seen within 60 seconds of each other, allowing events to arrive up to 5 seconds late, and keeps only QNAME from waiting DNS tuples."},
 	{NULL, ""}
 };
 char proc_requires[] = "";
@@ -97,6 +109,14 @@ proc_option_t proc_opts[] = {
      "members with LABEL are taken from RIGHT port only",0,0},
      {'M',"","records",
      "maximum table size",0,0},
+     {'T',"","LABEL",
+     "join on event time found at LABEL",0,0},
+     {'W',"","seconds",
+     "event time window (default 60)",0,0},
+     {'A',"","seconds",
+     "allowed lateness behind the newest event time (default 0)",0,0},
+     {'P',"","LABEL",
+     "keep only the key and LABEL members of waiting tuples",1,0},
      //the following must be left as-is to signify the end of the array
      {' ',"","",
      "",0,0}
@@ -112,9 +132,19 @@ char *proc_tuple_conditional_container_labels[] = {NULL};
 char *proc_tuple_member_labels[] = {NULL};
 char proc_nonswitch_opts[]    = "";
 
+// a tuple waiting in a port table, ordered by the end of its window;
+// tuple is NULL once it has been matched and emitted
+typedef struct _wait_entry_t {
+     uint64_t expire;
+     wsdata_t * tuple;
+     enum PortName port;
+} wait_entry_t;
+
 typedef struct _key_data_t {
      uint16_t cnt; // not needed?
      wsdata_t * tuple;
+     uint64_t ts; // event time in usec, when joining on time
+     wait_entry_t * wait; // heap slot of tuple, when joining on time
 } key_data_t;
 
 //function prototypes for local functions
@@ -136,13 +166,25 @@ typedef struct _proc_instance_t {
 
      char * sharelabel;
      char * sharelabel5;
+
+     wslabel_t * label_time;
+     uint64_t window; // usec
+     uint64_t lateness; // usec
+     uint64_t max_ts; // newest event time seen
+     wsheap_t * waiting;
+     uint64_t matched_cnt; // matched entries still in the waiting heap
+     wslabel_set_t proj;
+     uint64_t late_cnt;
+     uint64_t notime_cnt;
+     uint64_t expire_cnt;
+     uint64_t evict_cnt;
 } proc_instance_t;
 
 static int proc_cmd_options(int argc, char ** argv, 
                             proc_instance_t * proc, void * type_table) {
      int op;
 
-     while ((op = getopt(argc, argv, "J:j:L:R:K:M:")) != EOF) {
+     while ((op = getopt(argc, argv, "J:j:L:R:K:M:T:W:A:P:")) != EOF) {
           switch (op) {
           case 'J':
                proc->sharelabel = strdup(optarg);
@@ -165,6 +207,20 @@ static int proc_cmd_options(int argc, char ** argv,
           case 'M':
                proc->buflen = atoi(optarg);
                break;
+          case 'T':
+               proc->label_time = wssearch_label(type_table, optarg);
+               tool_print("joining on event time at label %s", optarg);
+               break;
+          case 'W':
+               proc->window = (uint64_t)(atof(optarg) * 1000000);
+               break;
+          case 'A':
+               proc->lateness = (uint64_t)(atof(optarg) * 1000000);
+               break;
+          case 'P':
+               wslabel_set_add(type_table, &proc->proj, optarg);
+               tool_print("keeping label %s in waiting tuples", optarg);
+               break;
           default:
                return 0;
           }
@@ -188,6 +244,19 @@ static void last_destroy(void * vdata, void * vproc) {
      }
 }
 
+static int wait_cmp(void * vfirst, void * vsecond) {
+     wait_entry_t * first = (wait_entry_t *)vfirst;
+     wait_entry_t * second = (wait_entry_t *)vsecond;
+     if (first->expire < second->expire) {
+          return -1;
+     }
+     return (first->expire > second->expire) ? 1 : 0;
+}
+
+static void wait_replace(void * vold, void * vnew, void * aux) {
+     memcpy(vold, vnew, sizeof(wait_entry_t));
+}
+
 // the following is a function to take in command arguments and initalize
 // this processor's instance..
 // return 1 if ok
@@ -210,6 +279,9 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
           tool_print("must specify key");
           return 0;
      }
+     if (proc->label_time && !proc->window) {
+          proc->window = 60 * 1000000ULL;
+     }
 
      //other init - init the stringhash tables
 
@@ -274,6 +346,16 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
           stringhash5_set_callback(proc->port_table[RIGHT], last_destroy, proc);
      }
 
+     // one window per stored tuple, bounded by what both tables can hold
+     if (proc->label_time) {
+          proc->waiting = wsheap_init(2 * (uint64_t)proc->buflen,
+                                      sizeof(wait_entry_t), wait_cmp,
+                                      wait_replace, NULL);
+          if (!proc->waiting) {
+               return 0;
+          }
+     }
+
      return 1; 
 }
 
@@ -307,8 +389,15 @@ proc_process_t proc_input_set(void * vinstance, wsdatatype_t * meta_type,
      return NULL; // a function pointer
 }
 
+static inline int in_window(proc_instance_t * proc, uint64_t ts,
+                            uint64_t stored_ts) {
+     uint64_t diff = (ts > stored_ts) ? (ts - stored_ts) : (stored_ts - ts);
+     return !proc->label_time || (diff <= proc->window);
+}
+
 static inline key_data_t * get_keydata(proc_instance_t * proc, wsdata_t * key,
-                                       wsdata_t * tdata, enum PortName port) {
+                                       wsdata_t * tdata, enum PortName port,
+                                       uint64_t ts) {
      key_data_t * kdata = NULL;
      ws_hashloc_t * hashloc = key->dtype->hash_func(key);
      // if the hash of the key is valid, look it up in the table
@@ -319,7 +408,7 @@ static inline key_data_t * get_keydata(proc_instance_t * proc, wsdata_t * key,
 
      // Did we find the key? (kdata->tuple should always be set if
      // kdata is valid)
-     if( kdata && kdata->tuple ) {
+     if( kdata && kdata->tuple && in_window(proc, ts, kdata->ts) ) {
        
        // Delete the found tuple from the hash table so we don't match it again
        stringhash5_delete(proc->port_table[port],
@@ -388,8 +477,169 @@ static inline void copy_members_except( proc_instance_t * proc,
 
 }
 
-static inline void store_keydata(proc_instance_t * proc, 
-    wsdata_t * input_data, enum PortName port )
+// Copy only the key and projected members from source tuple to dest
+// tuple, except those given in the omit set. All tuple labels are copied.
+static inline void copy_projected_members(proc_instance_t * proc,
+                                          wsdata_t * src_tuple,
+                                          wsdata_t * dest_tuple,
+                                          wslabel_set_t omit) {
+     wsdata_duplicate_labels(src_tuple, dest_tuple);
+     wsdata_t ** mset;
+     int mset_len;
+     int i, j;
+     for (i = 0; i < omit.len; i++) {
+          if (tuple_find_label(src_tuple, omit.labels[i], &mset_len, &mset)) {
+               for (j = 0; j < mset_len; j++) {
+                    add_rmember(proc, mset[j]);
+               }
+          }
+     }
+     for (i = -1; i < proc->proj.len; i++) {
+          wslabel_t * label = (i < 0) ? proc->label_key : proc->proj.labels[i];
+          if (tuple_find_label(src_tuple, label, &mset_len, &mset)) {
+               for (j = 0; j < mset_len; j++) {
+                    // members under several kept labels are added once
+                    if (not_removed(proc, mset[j])) {
+                         add_tuple_member(dest_tuple, mset[j]);
+                         add_rmember(proc, mset[j]);
+                    }
+               }
+          }
+     }
+}
+
+// Drop a waiting tuple whose window has closed, along with any table
+// entries that still point at it.
+static void expire_waiting(proc_instance_t * proc, wait_entry_t * w) {
+     wsdata_t ** mset;
+     int mset_len;
+     int j;
+     int unmatched = 0;
+     // a matched tuple was already emitted and released at match time
+     if (!w->tuple) {
+          proc->matched_cnt--;
+          return;
+     }
+     if (tuple_find_label(w->tuple, proc->label_key, &mset_len, &mset)) {
+          for (j = 0; j < mset_len; j++) {
+               ws_hashloc_t * hashloc = mset[j]->dtype->hash_func(mset[j]);
+               if (!hashloc || !hashloc->len) {
+                    continue;
+               }
+               key_data_t * kdata = (key_data_t *)stringhash5_find(
+                    proc->port_table[w->port], (uint8_t*)hashloc->offset,
+                    hashloc->len);
+               if (!kdata) {
+                    continue;
+               }
+               if (kdata->tuple == w->tuple) {
+                    kdata->tuple = NULL;
+                    wsdata_delete(w->tuple);
+                    stringhash5_delete(proc->port_table[w->port],
+                                       (uint8_t*)hashloc->offset,
+                                       hashloc->len);
+                    unmatched = 1;
+               }
+               stringhash5_unlock(proc->port_table[w->port]);
+          }
+     }
+     proc->expire_cnt += unmatched;
+     wsdata_delete(w->tuple);
+}
+
+// Expire every waiting tuple whose window ends behind the watermark.
+static inline void advance_watermark(proc_instance_t * proc, uint64_t ts) {
+     if (ts <= proc->max_ts) {
+          return;
+     }
+     proc->max_ts = ts;
+     if (ts < proc->lateness) {
+          return;
+     }
+     uint64_t watermark = ts - proc->lateness;
+     while (proc->waiting->count) {
+          wait_entry_t * w = (wait_entry_t *)proc->waiting->heap[0];
+          if (w->expire >= watermark) {
+               break;
+          }
+          expire_waiting(proc, (wait_entry_t *)wsheap_remove_root(proc->waiting));
+     }
+}
+
+// Drop matched entries from the waiting heap so they do not take the
+// place of tuples still waiting for a match.  Only the heap's pointers
+// are reordered, so slots held in the port tables stay valid.
+static void compact_waiting(proc_instance_t * proc) {
+     wsheap_t * h = proc->waiting;
+     uint64_t i = 0;
+     while (i < h->count) {
+          if (!((wait_entry_t *)h->heap[i])->tuple) {
+               h->count--;
+               wsheap_swap(&h->heap[i], &h->heap[h->count]);
+          }
+          else {
+               i++;
+          }
+     }
+     for (i = h->count / 2; i > 0; i--) {
+          wsheap_demote(h, i - 1);
+     }
+     proc->matched_cnt = 0;
+}
+
+// returns the heap slot of the waiting tuple
+static inline wait_entry_t * add_waiting(proc_instance_t * proc,
+                                         wsdata_t * tuple, uint64_t ts,
+                                         enum PortName port) {
+     wait_entry_t w;
+     w.expire = ts + proc->window;
+     w.tuple = tuple;
+     w.port = port;
+
+     if ((proc->waiting->count >= proc->waiting->max) && proc->matched_cnt) {
+          compact_waiting(proc);
+     }
+     // memory is bounded: make room by closing the oldest window early
+     if (proc->waiting->count >= proc->waiting->max) {
+          expire_waiting(proc, (wait_entry_t *)wsheap_remove_root(proc->waiting));
+          proc->evict_cnt++;
+     }
+     wsdata_add_reference(tuple);
+     return (wait_entry_t *)wsheap_insert(proc->waiting, &w);
+}
+
+// A matched tuple is about to be emitted: release the waiting heap's
+// reference now so expiry never touches a tuple owned downstream.
+static inline void release_waiting(proc_instance_t * proc,
+                                   key_data_t * kdata) {
+     wait_entry_t * w = kdata->wait;
+     // the slot may have been expired and reused by another tuple
+     if (w && (w->tuple == kdata->tuple)) {
+          w->tuple = NULL;
+          proc->matched_cnt++;
+          wsdata_delete(kdata->tuple);
+     }
+}
+
+// returns event time in usec, 0 if none found
+static inline uint64_t get_event_time(proc_instance_t * proc,
+                                      wsdata_t * tuple) {
+     wsdata_t ** mset;
+     int mset_len;
+     if (!tuple_find_label(tuple, proc->label_time, &mset_len, &mset)) {
+          return 0;
+     }
+     if (mset[0]->dtype == dtype_ts) {
+          wsdt_ts_t * ts = (wsdt_ts_t *)mset[0]->data;
+          return (uint64_t)ts->sec * 1000000 + ts->usec;
+     }
+     uint64_t sec = 0;
+     dtype_get_uint64(mset[0], &sec);
+     return sec * 1000000;
+}
+
+static inline wsdata_t * store_keydata(proc_instance_t * proc, 
+    wsdata_t * input_data, enum PortName port, uint64_t ts )
 {
   int mset_len;
   wsdata_t ** mset;
@@ -400,12 +650,22 @@ static inline void store_keydata(proc_instance_t * proc,
     wsdata_t * newtuple = ws_get_outdata(proc->outtype_tuple);
 
     if( ! newtuple ) {
-      return;  // No one is listening
+      return NULL;  // No one is listening
     }
 
     proc->rmember_len = 0;  // reset the list of items to exclude
-    copy_members_except( proc, input_data, newtuple,
-	proc->lset[OTHER_PORT(port)] );
+    if (proc->proj.len) {
+      copy_projected_members( proc, input_data, newtuple,
+	  proc->lset[OTHER_PORT(port)] );
+    } else {
+      copy_members_except( proc, input_data, newtuple,
+	  proc->lset[OTHER_PORT(port)] );
+    }
+
+    wait_entry_t * wait = NULL;
+    if (proc->label_time) {
+      wait = add_waiting(proc, newtuple, ts, port);
+    }
 
     // Now store a pointer to this tuple for each key value that
     // has the key label. We'll use the reference counter to
@@ -426,7 +686,7 @@ static inline void store_keydata(proc_instance_t * proc,
 
       if( ! kdata ) {  // should never happen
 	 tool_print( "got null pointer for hash table entry!" );
-	 return;
+	 return NULL;
       }
 
       // There's already a tuple with this key; delete it and reuse
@@ -437,22 +697,29 @@ static inline void store_keydata(proc_instance_t * proc,
 
       // Store the tuple pointer and increment the reference counter
       kdata->tuple = newtuple;
+      kdata->ts = ts;
+      kdata->wait = wait;
       wsdata_add_reference( newtuple );
       stringhash5_unlock(proc->port_table[port]);
     }
+    return newtuple;
   }
+  return NULL;
 }    
 
 // Remove the hash table entry and delete the tuple for a given
-// key value.
+// key value, if the entry still points at that tuple.
 static inline void remove_keydata( proc_instance_t * proc,
-    wsdata_t * key, enum PortName port )
+    wsdata_t * key, wsdata_t * tuple, enum PortName port )
 {
   ws_hashloc_t * hashloc = key->dtype->hash_func(key);
+  if (!hashloc || !hashloc->len) {
+    return;
+  }
   key_data_t * kdata = (key_data_t *) stringhash5_find(
       proc->port_table[port],
       (uint8_t*)hashloc->offset, hashloc->len );
-  if( kdata && kdata->tuple ) {	// should always be true
+  if( kdata && (kdata->tuple == tuple) ) {
     // This should decrement the reference counter but not
     // necessarily delete the tuple, which we are probably
     // sending to the output.
@@ -460,7 +727,7 @@ static inline void remove_keydata( proc_instance_t * proc,
 
     // Remove the hash table entry
     stringhash5_delete( proc->port_table[port],
-      hashloc, hashloc->len );
+      (uint8_t*)hashloc->offset, hashloc->len );
     stringhash5_unlock(proc->port_table[port]);
   }
   else if (kdata) {
@@ -483,12 +750,26 @@ static inline int proc_tuple(void * vinstance, wsdata_t* input_data,
      int j;
      enum PortName other_port = OTHER_PORT(port);
 
+     uint64_t ts = 0;
+     if (proc->label_time) {
+          ts = get_event_time(proc, input_data);
+          if (!ts) {
+               proc->notime_cnt++;
+               return 0;
+          }
+          if (ts + proc->lateness < proc->max_ts) {
+               proc->late_cnt++;
+               return 0;
+          }
+          advance_watermark(proc, ts);
+     }
+
      //get value
      key_data_t * kdata = NULL;
      if (tuple_find_label(input_data, proc->label_key, &mset_len, &mset)) {
        // Look for matching key in the OPPOSITE table
        for (j = 0; j < mset_len; j++ ) {
-	 if ((kdata = get_keydata(proc, mset[j], input_data, other_port))
+	 if ((kdata = get_keydata(proc, mset[j], input_data, other_port, ts))
 	     != NULL) {
 	   matched_member = mset[j];
 	   break; // Found a match!
@@ -498,7 +779,7 @@ static inline int proc_tuple(void * vinstance, wsdata_t* input_data,
 
      // If no match on opposite port, store the tuple in this port's table
      if (!kdata) {
-          store_keydata(proc, input_data, port);
+          store_keydata(proc, input_data, port, ts);
           return 0;
      }
 
@@ -535,7 +816,7 @@ static inline int proc_tuple(void * vinstance, wsdata_t* input_data,
            //must unlock here as remove_data calls stringhash5_find and
            //sets a new lock
            stringhash5_unlock(proc->port_table[other_port]);
-	   remove_keydata( proc, matched_member, other_port );
+	   remove_keydata( proc, mset[j], kdata->tuple, other_port );
 	 }
        }
      }
@@ -543,6 +824,7 @@ static inline int proc_tuple(void * vinstance, wsdata_t* input_data,
      // Make this merged tuple the output tuple, then decrement
      // the reference count (which was used to keep this tuple
      // alive while it waited to be joined).
+     release_waiting(proc, kdata);
      ws_set_outdata(kdata->tuple, proc->outtype_tuple, dout);
      proc->outcnt[port]++;
      wsdata_delete(kdata->tuple);
@@ -578,10 +860,25 @@ int proc_destroy(void * vinstance) {
      tool_print("meta_proc right cnt %" PRIu64, proc->meta_process_cnt[RIGHT]);
      tool_print("output left cnt %" PRIu64, proc->outcnt[LEFT]);
      tool_print("output right cnt %" PRIu64, proc->outcnt[RIGHT]);
+     if (proc->label_time) {
+          tool_print("late cnt %" PRIu64, proc->late_cnt);
+          tool_print("no time cnt %" PRIu64, proc->notime_cnt);
+          tool_print("expired cnt %" PRIu64, proc->expire_cnt);
+          tool_print("evicted cnt %" PRIu64, proc->evict_cnt);
+     }
 
      //destroy table
      stringhash5_scour_and_destroy(proc->port_table[LEFT], last_destroy, proc);
      stringhash5_scour_and_destroy(proc->port_table[RIGHT], last_destroy, proc);
+     if (proc->waiting) {
+          wait_entry_t * w;
+          while ((w = (wait_entry_t *)wsheap_remove_root(proc->waiting)) != NULL) {
+               if (w->tuple) {
+                    wsdata_delete(w->tuple);
+               }
+          }
+          wsheap_destroy(proc->waiting);
+     }
 
      //free dynamic allocations
      if (proc->sharelabel) {
@@ -72,6 +72,8 @@ proc_option_t proc_opts[] = {
      "detect if buffer is ascii strings",0,0},
      {'X',"","key=value",
      "specify a special kafka configuration parameter",0,0},
+     {'B',"","count",
+     "consume up to count messages per poll, passing payloads without a copy",0,0},
      //the following must be left as-is to signify the end of the array
      {' ',"","",
      "",0,0}
@@ -104,6 +106,10 @@ typedef struct _proc_instance_t {
 
      wsdata_t * wsd_topic;
      int stringdetect;
+
+     int batch;
+     rd_kafka_message_t ** batch_msgs;
+     uint64_t batch_cnt;
 } proc_instance_t;
 
 static int handle_kafka_config_option(proc_instance_t * proc, char * kv) {
@@ -139,7 +145,7 @@ static int proc_cmd_options(int argc, char ** argv,
 
      int op;
 
-     while ((op = getopt(argc, argv, "X:Sb:p:L:")) != EOF) {
+     while ((op = getopt(argc, argv, "B:X:Sb:p:L:")) != EOF) {
           switch (op) {
           case 'b':
                proc->brokers = optarg;
@@ -155,6 +161,13 @@ static int proc_cmd_options(int argc, char ** argv,
           case 'S':
                proc->stringdetect = 1;
                break;
+          case 'B':
+               proc->batch = atoi(optarg);
+               if (proc->batch > 0) {
+                    tool_print("consuming in batches of up to %d messages",
+                               proc->batch);
+               }
+               break;
           case 'X':
                if (!handle_kafka_config_option(proc, optarg)) {
                     error_print("invalid kafka option");
@@ -242,6 +255,21 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
           tool_print("ERROR: kafka topic needs to be specified");
           return 0;
      }
+     if (proc->batch > 0) {
+          proc->batch_msgs = (rd_kafka_message_t **)calloc(proc->batch,
+                                                           sizeof(rd_kafka_message_t *));
+          if (!proc->batch_msgs) {
+               error_print("failed calloc of proc->batch_msgs");
+               return 0;
+          }
+          // offsets are stored once per batch instead of per message
+          if (rd_kafka_conf_set(proc->conf, "enable.auto.offset.store", "false",
+                                proc->errstr, sizeof(proc->errstr)) !=
+              RD_KAFKA_CONF_OK) {
+               tool_print("%s", proc->errstr);
+               return 0;
+          }
+     }
      proc->wsd_topic = wsdata_create_string(proc->topic, strlen(proc->topic));
      if (!proc->wsd_topic) {
           tool_print("unable to create topic");
@@ -303,9 +331,8 @@ proc_process_t proc_input_set(void * vinstance, wsdatatype_t * input_type,
      return NULL;
 }
 
-//callback per kafka message
-static void msg_consume (rd_kafka_message_t *rkmessage, void *vproc) {
-     proc_instance_t * proc = (proc_instance_t*)vproc;
+//returns 1 if the message carries data, 0 if it was an error or EOF
+static int msg_check (rd_kafka_message_t *rkmessage) {
 	if (rkmessage->err) {
 		if (rkmessage->err == RD_KAFKA_RESP_ERR__PARTITION_EOF) {
                dprint("%% Consumer reached end of "
@@ -313,7 +340,7 @@ static void msg_consume (rd_kafka_message_t *rkmessage, void *vproc) {
                       "message queue at offset %"PRId64"\n",
                       rd_kafka_topic_name(rkmessage->rkt),
                       rkmessage->partition, rkmessage->offset);
-               return;
+               return 0;
           }
 
 		printf("%% Consume error for topic \"%s\" [%"PRId32"] "
@@ -329,8 +356,17 @@ static void msg_consume (rd_kafka_message_t *rkmessage, void *vproc) {
                     rkmessage->err == RD_KAFKA_RESP_ERR__UNKNOWN_TOPIC)
                         run = 0;
                  */
-		return;
+		return 0;
 	}
+     return 1;
+}
+
+//callback per kafka message
+static void msg_consume (rd_kafka_message_t *rkmessage, void *vproc) {
+     proc_instance_t * proc = (proc_instance_t*)vproc;
+     if (!msg_check(rkmessage)) {
+          return;
+     }
      if (rkmessage->len) {
           //allocate tuple
           wsdata_t * tuple = wsdata_alloc(dtype_tuple);
@@ -372,6 +408,76 @@ static void msg_consume (rd_kafka_message_t *rkmessage, void *vproc) {
             (char *)rkmessage->payload);
 }
 
+//wrap the payload in place; the message is destroyed once the last
+// reference to the payload is gone.  takes ownership of the message
+static void msg_consume_nocopy (proc_instance_t * proc,
+                                rd_kafka_message_t *rkmessage) {
+     if (!msg_check(rkmessage) || !rkmessage->len) {
+          rd_kafka_message_destroy(rkmessage);
+          return;
+     }
+     wsdata_t * wsd_msg = wsdata_alloc(dtype_extbuf);
+     if (!wsd_msg) {
+          rd_kafka_message_destroy(rkmessage);
+          return;
+     }
+     wsdt_extbuf_t * eb = (wsdt_extbuf_t*)wsd_msg->data;
+     eb->buf = (char *)rkmessage->payload;
+     eb->len = (int)rkmessage->len;
+     eb->release = (wsdt_extbuf_release)rd_kafka_message_destroy;
+     eb->owner = rkmessage;
+
+     wsdata_t * tuple = wsdata_alloc(dtype_tuple);
+     if (!tuple) {
+          wsdata_delete(wsd_msg);
+          return;
+     }
+     add_tuple_member(tuple, proc->wsd_topic);
+     if (proc->stringdetect) {
+          tuple_member_create_dep_strdetect(tuple, wsd_msg, proc->label_buf,
+                                            eb->buf, eb->len);
+     }
+     else {
+          tuple_member_create_dep_binary(tuple, wsd_msg, proc->label_buf,
+                                         eb->buf, eb->len);
+     }
+     //no member took a reference
+     if (!wsdata_get_reference(wsd_msg)) {
+          wsdata_delete(wsd_msg);
+     }
+
+     ws_set_outdata(tuple, proc->outtype_tuple, proc->dout);
+     proc->outcnt++;
+}
+
+//emit everything queued up to the batch size, then store the offset of
+// the last message once for the whole batch
+static void consume_batch(proc_instance_t * proc) {
+     ssize_t n = rd_kafka_consume_batch_queue(proc->rkqu, 1000,
+                                              proc->batch_msgs, proc->batch);
+     if (n < 0) {
+          fprintf(stderr, "%% Error: %s\n",
+                  rd_kafka_err2str(rd_kafka_last_error()));
+          return;
+     }
+     if (!n) {
+          return;
+     }
+     proc->batch_cnt++;
+
+     int64_t offset = -1;
+     ssize_t i;
+     for (i = 0; i < n; i++) {
+          if (!proc->batch_msgs[i]->err) {
+               offset = proc->batch_msgs[i]->offset;
+          }
+          msg_consume_nocopy(proc, proc->batch_msgs[i]);
+     }
+     if (offset >= 0) {
+          rd_kafka_offset_store(proc->rkt, proc->partition, offset);
+     }
+}
+
 //// proc processing function assigned to a specific data type in proc_io_init
 //return 1 if output is available
 // return 0 if not output
@@ -384,6 +490,11 @@ static int data_source(void * vinstance, wsdata_t* source_data,
 
      proc->meta_process_cnt++;
 
+     if (proc->batch_msgs) {
+          consume_batch(proc);
+          return 1;
+     }
+
      int r = rd_kafka_consume_callback_queue(proc->rkqu, 1000,
                                          msg_consume,
                                          proc);
@@ -401,6 +512,9 @@ int proc_destroy(void * vinstance) {
      proc_instance_t * proc = (proc_instance_t*)vinstance;
      tool_print("meta_proc cnt %" PRIu64, proc->meta_process_cnt);
      tool_print("output cnt %" PRIu64, proc->outcnt);
+     if (proc->batch_msgs) {
+          tool_print("batch cnt %" PRIu64, proc->batch_cnt);
+     }
 
      if (proc->rkt) {
           tool_print("kafka stopping consumer");
@@ -425,6 +539,7 @@ int proc_destroy(void * vinstance) {
           wsdata_delete(proc->wsd_topic);
      }
      //free dynamic allocations
+     free(proc->batch_msgs);
      free(proc);
      return 1;
 }
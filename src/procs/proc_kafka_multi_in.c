@@ -81,6 +81,8 @@ proc_option_t proc_opts[] = {
      "set kafka config option",0,0},
      {'V',"","",
      "send logs in output tagged with LOG label",0,0},
+     {'B',"","count",
+     "consume up to count messages per poll, passing payloads without a copy",0,0},
      //the following must be left as-is to signify the end of the array
      {' ',"","",
      "",0,0}
@@ -130,6 +132,11 @@ typedef struct _proc_instance_t {
 
      int stringdetect;
      int tuple_logs;
+
+     int batch;
+     rd_kafka_message_t ** batch_msgs;
+     rd_kafka_queue_t * rkqu;
+     uint64_t batch_cnt;
 } proc_instance_t;
 
 
@@ -167,7 +174,7 @@ static int proc_cmd_options(int argc, char ** argv,
 
      int op;
 
-     while ((op = getopt(argc, argv, "vVX:g:Sb:p:L:")) != EOF) {
+     while ((op = getopt(argc, argv, "B:vVX:g:Sb:p:L:")) != EOF) {
           switch (op) {
           case 'v':
           case 'V':
@@ -190,6 +197,13 @@ static int proc_cmd_options(int argc, char ** argv,
           case 'S':
                proc->stringdetect = 1;
                break;
+          case 'B':
+               proc->batch = atoi(optarg);
+               if (proc->batch > 0) {
+                    tool_print("consuming in batches of up to %d messages",
+                               proc->batch);
+               }
+               break;
           case 'X':
                if (!handle_kafka_config_option(proc, optarg)) {
                     error_print("invalid kafka option");
@@ -538,6 +552,22 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
      }
      tool_print("using subscriber group %s", proc->group);
 
+     if (proc->batch > 0) {
+          proc->batch_msgs = (rd_kafka_message_t **)calloc(proc->batch,
+                                                           sizeof(rd_kafka_message_t *));
+          if (!proc->batch_msgs) {
+               error_print("failed calloc of proc->batch_msgs");
+               return 0;
+          }
+          // offsets are stored once per batch instead of per message
+          if (rd_kafka_conf_set(proc->conf, "enable.auto.offset.store", "false",
+                                proc->errstr, sizeof(proc->errstr)) !=
+              RD_KAFKA_CONF_OK) {
+               tool_print("%s", proc->errstr);
+               return 0;
+          }
+     }
+
      if (rd_kafka_conf_set(proc->conf, "group.id", proc->group,
                            proc->errstr, sizeof(proc->errstr)) !=
          RD_KAFKA_CONF_OK) {
@@ -573,6 +603,13 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
                   rd_kafka_err2str(err));
           return 0;
      }
+     if (proc->batch_msgs) {
+          proc->rkqu = rd_kafka_queue_get_consumer(proc->rk);
+          if (!proc->rkqu) {
+               tool_print("unable to get consumer queue");
+               return 0;
+          }
+     }
 
 
      proc->outtype_tuple =
@@ -662,9 +699,8 @@ static void consume_error_print(proc_instance_t * proc,
 		       rd_kafka_message_errstr(rkmessage));
 }
 
-//callback per kafka message
-static void msg_consume (rd_kafka_message_t *rkmessage, void *vproc) {
-     proc_instance_t * proc = (proc_instance_t*)vproc;
+//returns 1 if the message carries data, 0 if it was an error or EOF
+static int msg_check (proc_instance_t * proc, rd_kafka_message_t *rkmessage) {
 	if (rkmessage->err) {
 		if (rkmessage->err == RD_KAFKA_RESP_ERR__PARTITION_EOF) {
                dprint("%% Consumer reached end of "
@@ -672,7 +708,7 @@ static void msg_consume (rd_kafka_message_t *rkmessage, void *vproc) {
                       "message queue at offset %"PRId64"\n",
                       rd_kafka_topic_name(rkmessage->rkt),
                       rkmessage->partition, rkmessage->offset);
-               return;
+               return 0;
           }
 
           consume_error_print(proc, rkmessage);
@@ -683,8 +719,17 @@ static void msg_consume (rd_kafka_message_t *rkmessage, void *vproc) {
                     rkmessage->err == RD_KAFKA_RESP_ERR__UNKNOWN_TOPIC)
                         run = 0;
                  */
-		return;
+		return 0;
 	}
+     return 1;
+}
+
+//callback per kafka message
+static void msg_consume (rd_kafka_message_t *rkmessage, void *vproc) {
+     proc_instance_t * proc = (proc_instance_t*)vproc;
+     if (!msg_check(proc, rkmessage)) {
+          return;
+     }
      if (rkmessage->len) {
 
           //allocate tuple
@@ -736,6 +781,99 @@ static void msg_consume (rd_kafka_message_t *rkmessage, void *vproc) {
             (char *)rkmessage->payload);
 }
 
+//wrap the payload in place; the message is destroyed once the last
+// reference to the payload is gone.  takes ownership of the message
+static void msg_consume_nocopy (proc_instance_t * proc,
+                                rd_kafka_message_t *rkmessage) {
+     if (!msg_check(proc, rkmessage) || !rkmessage->len) {
+          rd_kafka_message_destroy(rkmessage);
+          return;
+     }
+     wsdata_t * wsd_msg = wsdata_alloc(dtype_extbuf);
+     if (!wsd_msg) {
+          rd_kafka_message_destroy(rkmessage);
+          return;
+     }
+     wsdt_extbuf_t * eb = (wsdt_extbuf_t*)wsd_msg->data;
+     eb->buf = (char *)rkmessage->payload;
+     eb->len = (int)rkmessage->len;
+     eb->release = (wsdt_extbuf_release)rd_kafka_message_destroy;
+     eb->owner = rkmessage;
+
+     wsdata_t * tuple = wsdata_alloc(dtype_tuple);
+     if (!tuple) {
+          wsdata_delete(wsd_msg);
+          return;
+     }
+     wsdata_add_label(tuple, proc->label_kafka);
+     wsdata_add_label(tuple, proc->label_data);
+     const char * topic = rd_kafka_topic_name(rkmessage->rkt);
+     if (topic) {
+          tuple_dupe_string(tuple, proc->label_topic, topic,
+                            strlen(topic));
+     }
+     if (proc->stringdetect) {
+          tuple_member_create_dep_strdetect(tuple, wsd_msg, proc->label_buf,
+                                            eb->buf, eb->len);
+     }
+     else {
+          tuple_member_create_dep_binary(tuple, wsd_msg, proc->label_buf,
+                                         eb->buf, eb->len);
+     }
+     tuple_member_create_int(tuple, rkmessage->partition,
+                             proc->label_partition);
+     proc->outlen += eb->len;
+     //no member took a reference
+     if (!wsdata_get_reference(wsd_msg)) {
+          wsdata_delete(wsd_msg);
+     }
+
+     ws_set_outdata(tuple, proc->outtype_tuple, proc->dout);
+     proc->outcnt++;
+}
+
+//emit everything queued up to the batch size, then store the next offset
+// of each partition seen once for the whole batch
+static void consume_batch(proc_instance_t * proc) {
+     ssize_t n = rd_kafka_consume_batch_queue(proc->rkqu, 1000,
+                                              proc->batch_msgs, proc->batch);
+     if (n < 0) {
+          fprintf(stderr, "%% Error: %s\n",
+                  rd_kafka_err2str(rd_kafka_last_error()));
+          return;
+     }
+     if (!n) {
+          return;
+     }
+     proc->batch_cnt++;
+
+     rd_kafka_topic_partition_list_t * offsets =
+          rd_kafka_topic_partition_list_new(1);
+     ssize_t i;
+     for (i = 0; i < n; i++) {
+          rd_kafka_message_t * rkmessage = proc->batch_msgs[i];
+          if (!rkmessage->err && rkmessage->rkt) {
+               const char * topic = rd_kafka_topic_name(rkmessage->rkt);
+               rd_kafka_topic_partition_t * tp =
+                    rd_kafka_topic_partition_list_find(offsets, topic,
+                                                       rkmessage->partition);
+               if (!tp) {
+                    tp = rd_kafka_topic_partition_list_add(offsets, topic,
+                                                           rkmessage->partition);
+               }
+               tp->offset = rkmessage->offset + 1;
+          }
+          msg_consume_nocopy(proc, rkmessage);
+     }
+     if (offsets->cnt) {
+          rd_kafka_resp_err_t err = rd_kafka_offsets_store(proc->rk, offsets);
+          if (err) {
+               dprint("offset store failed: %s", rd_kafka_err2str(err));
+          }
+     }
+     rd_kafka_topic_partition_list_destroy(offsets);
+}
+
 //// proc processing function assigned to a specific data type in proc_io_init
 //return 1 if output is available
 // return 0 if not output
@@ -747,6 +885,12 @@ static int data_source(void * vinstance, wsdata_t* source_data,
      proc->dout = dout;
 
      proc->meta_process_cnt++;
+
+     if (proc->batch_msgs) {
+          consume_batch(proc);
+          return 1;
+     }
+
      rd_kafka_message_t *rkmessage;
 
      rkmessage = rd_kafka_consumer_poll(proc->rk, 1000);
@@ -778,12 +922,18 @@ int proc_destroy(void * vinstance) {
      proc_instance_t * proc = (proc_instance_t*)vinstance;
      tool_print("polling loop cnt %" PRIu64, proc->meta_process_cnt);
      tool_print("output cnt %" PRIu64, proc->outcnt);
+     if (proc->batch_msgs) {
+          tool_print("batch cnt %" PRIu64, proc->batch_cnt);
+     }
 
 
      //turn off logging to tuples
      proc->tuple_logs = 0;
      proc->dout = NULL;
 
+     if (proc->rkqu) {
+          rd_kafka_queue_destroy(proc->rkqu);
+     }
      if (proc->rk) {
           rd_kafka_resp_err_t err;
           err = rd_kafka_consumer_close(proc->rk);
@@ -804,6 +954,7 @@ int proc_destroy(void * vinstance) {
      rd_kafka_wait_destroyed(2000);
 
      //free dynamic allocations
+     free(proc->batch_msgs);
      free(proc);
      return 1;
 }
@@ -94,6 +94,12 @@ typedef struct _key_data_t {
 static int proc_tuple(void *, wsdata_t*, ws_doutput_t*, int);
 static int proc_tuple_query(void *, wsdata_t*, ws_doutput_t*, int);
 static int proc_flush(void *, wsdata_t*, ws_doutput_t*, int);
+static int proc_tuple_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+
+proc_batch_t proc_batch[] = {
+     {proc_tuple, proc_tuple_batch},
+     {NULL, NULL}
+};
 
 typedef struct _proc_instance_t {
      uint64_t meta_process_cnt;
@@ -258,10 +264,12 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
                return 0;
           }
           stringhash5_set_callback(proc->key_table, last_destroy, proc);
+          stringhash5_enable_spill(proc->key_table);
      }
 
      //use the stringhash5-adjusted value of max_records to reset buflen
      proc->buflen = proc->key_table->max_records;
+     kid->reads = WSKID_READS_LABELS;
 
      return 1; 
 }
@@ -295,10 +303,8 @@ proc_process_t proc_input_set(void * vinstance, wsdatatype_t * meta_type,
      return NULL; // a function pointer
 }
 
-static inline void add_member(proc_instance_t * proc, wsdata_t * tdata, wsdata_t * member) {
-     key_data_t * kdata;
-     kdata = (key_data_t*)stringhash5_find_attach_wsdata(proc->key_table, member);
-
+static inline void count_member(proc_instance_t * proc, wsdata_t * tdata,
+                                wsdata_t * member, key_data_t * kdata) {
      if (kdata) {
           if (!kdata->wsd) {
                if (proc->keepOnlyMember) {
@@ -315,6 +321,39 @@ static inline void add_member(proc_instance_t * proc, wsdata_t * tdata, wsdata_t
      }
 }
 
+static inline void add_member(proc_instance_t * proc, wsdata_t * tdata, wsdata_t * member) {
+     count_member(proc, tdata, member,
+                  (key_data_t*)stringhash5_find_attach_wsdata(proc->key_table, member));
+}
+
+//search for items in tuples
+static inline void count_tuple(proc_instance_t * proc, wsdata_t * tdata) {
+     wsdata_t ** mset;
+     int mset_len;
+     int i, j;
+     for (i = 0; i < proc->lset.len; i++) {
+          if (tuple_find_label(tdata, proc->lset.labels[i],
+                               &mset_len, &mset)) {
+               for (j = 0; j < mset_len; j++ ) {
+                    add_member(proc, tdata, mset[j]);
+               }
+          }
+     }
+}
+
+#define KEYCOUNT_BATCH 64
+
+static inline void count_prefetched(proc_instance_t * proc, wsdata_t ** tuples,
+                                    wsdata_t ** keys, sh5_prefetch_t * pf, int n) {
+     int i;
+     stringhash5_prefetch_wsdata_batch(proc->key_table, keys, n, pf);
+     for (i = 0; i < n; i++) {
+          count_member(proc, tuples[i], keys[i],
+                       (key_data_t*)stringhash5_find_attach_prefetched(proc->key_table,
+                                                                       &pf[i]));
+     }
+}
+
 //// proc processing function assigned to a specific data type in proc_io_init
 //return 1 if output is available
 // return 0 if not output
@@ -325,21 +364,48 @@ static int proc_tuple(void * vinstance, wsdata_t* input_data,
      proc->dout = dout;
      proc->meta_process_cnt++;
 
-     //search for items in tuples
+     count_tuple(proc, input_data);
+
+     //always return 1 since we don't know if table will flush old data
+     return 1;
+}
+
+static int proc_tuple_batch(void * vinstance, wsdata_t** input_data,
+                            int len, ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     int i;
+     proc->dout = dout;
+     proc->meta_process_cnt += len;
+
+     //gather keys across the batch so their table lookups overlap
+     wsdata_t * tuples[KEYCOUNT_BATCH];
+     wsdata_t * keys[KEYCOUNT_BATCH];
+     sh5_prefetch_t pf[KEYCOUNT_BATCH];
      wsdata_t ** mset;
      int mset_len;
-     int i, j;
-     for (i = 0; i < proc->lset.len; i++) {
-          if (tuple_find_label(input_data, proc->lset.labels[i],
-                               &mset_len, &mset)) {
-               for (j = 0; j < mset_len; j++ ) {
-                    add_member(proc, input_data, mset[j]);
+     int j, k;
+     int n = 0;
+
+     for (i = 0; i < len; i++) {
+          for (j = 0; j < proc->lset.len; j++) {
+               if (tuple_find_label(input_data[i], proc->lset.labels[j],
+                                    &mset_len, &mset)) {
+                    for (k = 0; k < mset_len; k++) {
+                         if (n == KEYCOUNT_BATCH) {
+                              count_prefetched(proc, tuples, keys, pf, n);
+                              n = 0;
+                         }
+                         tuples[n] = input_data[i];
+                         keys[n] = mset[k];
+                         n++;
+                    }
                }
           }
      }
+     count_prefetched(proc, tuples, keys, pf, n);
 
-     //always return 1 since we don't know if table will flush old data
-     return 1;
+     return len;
 }
 
 static inline int query_append_key(proc_instance_t * proc, wsdata_t * query, wsdata_t * member) {
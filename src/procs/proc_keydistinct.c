@@ -0,0 +1,235 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+//approximate count of distinct values per key using a HyperLogLog sketch
+#define PROC_NAME "keydistinct"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "waterslide.h"
+#include "waterslidedata.h"
+#include "datatypes/wsdt_tuple.h"
+#include "datatypes/wsdt_uint64.h"
+#include "datatypes/wsdt_binary.h"
+#include "hyperloglog.h"
+#include "procloader_keystate.h"
+
+int is_prockeystate = 1;
+int prockeystate_gradual_expire = 1;
+
+char proc_version[]     = "1.0";
+char *proc_menus[] = { "Count", NULL };
+char *proc_alias[]     = { "keyhll", "keycardinality", NULL };
+char proc_name[]       = PROC_NAME;
+char proc_purpose[]    = "estimates the number of distinct values seen at each key";
+char *proc_synopsis[] = { "keydistinct <LABEL> -V <LABEL> [-S] [-B] [-R] [-M <size>] [-L <LABEL>]", NULL};
+char *proc_tags[] = {"key", "count", "sketch", NULL};
+char proc_description[] = {"The keydistinct kid keeps a fixed-size HyperLogLog sketch "
+     "(1024 registers, about 3% standard error) for each LABEL-KEY and adds every "
+     "LABEL-VALUE to it.  At flush or expiration it appends the estimated number of "
+     "distinct values as DISTINCT and the number of values (or sketches) added as COUNT.  "
+     "With -B the sketch itself is appended as a binary SKETCH member; with -S the "
+     "values are taken to be such sketches and are merged, so per-thread or "
+     "per-process results can be combined downstream."
+     ""};
+proc_example_t proc_examples[] = {
+     {"... | keydistinct SRCIP -V DSTIP | ...", "estimates the number of destinations contacted by each source"},
+     {"... | keydistinct SRCIP -V DSTIP -B | ... | keydistinct SRCIP -V SKETCH -S | ...",
+      "builds partial sketches and merges them downstream"},
+     {NULL,""}
+};
+
+proc_option_t proc_opts[] = {
+     /*  'option character', "long option string", "option argument",
+	 "option description", <allow multiple>, <required>*/
+     {'V',"","label",
+     "LABEL of value to count distinct at key",0,0},
+     {'M',"","records",
+     "maximum table size",0,0},
+     {'L',"","LABEL",
+     "label the estimate as LABEL",0,0},
+     {'B',"","",
+     "append the serialized sketch as SKETCH",0,0},
+     {'S',"","",
+     "values are serialized sketches to merge",0,0},
+     {'R',"","",
+      "keep only the member that matches, not the whole tuple",0,0},
+     //the following must be left as-is to signify the end of the array
+     {' ',"","",
+     "",0,0}
+};
+
+char proc_requires[] = "none";
+char proc_nonswitch_opts[]    = "LABEL of key";
+char *proc_input_types[]    = {"tuple", NULL};
+char *proc_output_types[]    = {"tuple", NULL};
+char *proc_tuple_member_labels[] = {"DISTINCT", "COUNT", "SKETCH", NULL};
+proc_port_t proc_input_ports[] =  {
+     {"none","normal operation"},
+     {"EXPIRE","trigger gradual expiration of buffered states"},
+     {"DELETE","expire specific key, flush state"},
+     {"REMOVE","expire specific key, flush state"},
+     {NULL, NULL}
+};
+
+char *proc_tuple_conditional_container_labels[] = {NULL};
+
+typedef struct _key_data_t {
+     wsdata_t * wsd;
+     uint64_t cnt;
+     hll_t hll;
+} key_data_t;
+
+int prockeystate_state_size = sizeof(key_data_t);
+
+typedef struct _proc_instance_t {
+     uint64_t outcnt;
+
+     wslabel_t * label_distinct;
+     wslabel_t * label_cnt;
+     wslabel_t * label_sketch;
+     int keep_only_key;
+     int emit_sketch;
+     int merge_sketch;
+} proc_instance_t;
+
+int prockeystate_instance_size = sizeof(proc_instance_t);
+
+proc_labeloffset_t proc_labeloffset[] =
+{
+     {"DISTINCT",offsetof(proc_instance_t, label_distinct)},
+     {"COUNT",offsetof(proc_instance_t, label_cnt)},
+     {"SKETCH",offsetof(proc_instance_t, label_sketch)},
+     {"",0}
+};
+
+char prockeystate_option_str[]    = "RBSL:";
+
+int prockeystate_option(void * vproc, void * type_table, int c, const char * str) {
+     proc_instance_t * proc = (proc_instance_t *)vproc;
+
+     switch(c) {
+     case 'R':
+          proc->keep_only_key = 1;
+          break;
+     case 'B':
+          proc->emit_sketch = 1;
+          break;
+     case 'S':
+          proc->merge_sketch = 1;
+          tool_print("merging serialized sketches");
+          break;
+     case 'L':
+          proc->label_distinct = wsregister_label(type_table, str);
+          break;
+     }
+     return 1;
+}
+
+static inline void add_estimate(proc_instance_t * proc, wsdata_t * tup,
+                                key_data_t * kd, ws_doutput_t * dout,
+                                ws_outtype_t * outtype_tuple) {
+     tuple_member_create_uint64(tup, (uint64_t)(hll_estimate(&kd->hll) + 0.5),
+                                proc->label_distinct);
+     tuple_member_create_uint64(tup, kd->cnt, proc->label_cnt);
+     if (proc->emit_sketch) {
+          wsdt_binary_t * bin = tuple_create_binary(tup, proc->label_sketch,
+                                                    HLL_SERIAL_LEN);
+          if (bin) {
+               hll_serialize(&kd->hll, bin->buf);
+          }
+     }
+     ws_set_outdata(tup, outtype_tuple, dout);
+     proc->outcnt++;
+}
+
+void prockeystate_expire(void * vproc, void * vdata, ws_doutput_t * dout,
+                         ws_outtype_t * outtype_tuple) {
+     proc_instance_t * proc = (proc_instance_t *)vproc;
+     key_data_t * kd = (key_data_t*)vdata;
+     if (kd->wsd) {
+          if (proc->keep_only_key) {
+               wsdata_t * tup = wsdata_alloc(dtype_tuple);
+               if (tup) {
+                    add_tuple_member(tup, kd->wsd);
+                    add_estimate(proc, tup, kd, dout, outtype_tuple);
+               }
+          }
+          else {
+               add_estimate(proc, kd->wsd, kd, dout, outtype_tuple);
+          }
+          wsdata_delete(kd->wsd);
+          kd->wsd = NULL;
+     }
+     kd->cnt = 0;
+     memset(&kd->hll, 0, sizeof(hll_t));
+}
+
+int prockeystate_update_value(void * vproc, void * vstate, wsdata_t * tuple,
+                              wsdata_t *key, wsdata_t * value) {
+     proc_instance_t * proc = (proc_instance_t*)vproc;
+     key_data_t * kd = (key_data_t *) vstate;
+
+     if (proc->merge_sketch) {
+          char * buf;
+          int len;
+          if (!dtype_string_buffer(value, &buf, &len) ||
+              !hll_merge_serialized(&kd->hll, buf, len)) {
+               return 0;
+          }
+     }
+     else {
+          ws_hashloc_t * hashloc = value->dtype->hash_func(value);
+          if (!hashloc || !hashloc->len) {
+               return 0;
+          }
+          hll_add(&kd->hll, hashloc->offset, hashloc->len);
+     }
+     kd->cnt++;
+
+     if (!kd->wsd) {
+          if (proc->keep_only_key) {
+               kd->wsd = key;
+               wsdata_add_reference(key);
+          }
+          else {
+               kd->wsd = tuple;
+               wsdata_add_reference(tuple);
+          }
+     }
+     return 0;
+}
+
+//return 1 if successful
+//return 0 if no..
+int prockeystate_destroy(void * vinstance) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     tool_print("output cnt %" PRIu64, proc->outcnt);
+
+     //free dynamic allocations
+     //free(proc); // free this in the calling function
+
+     return 1;
+}
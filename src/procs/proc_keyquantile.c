@@ -0,0 +1,280 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+//approximate quantiles of a value per key using a t-digest sketch
+#define PROC_NAME "keyquantile"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "waterslide.h"
+#include "waterslidedata.h"
+#include "datatypes/wsdt_tuple.h"
+#include "datatypes/wsdt_uint64.h"
+#include "datatypes/wsdt_double.h"
+#include "datatypes/wsdt_binary.h"
+#include "tdigest.h"
+#include "procloader_keystate.h"
+
+int is_prockeystate = 1;
+int prockeystate_gradual_expire = 1;
+
+char proc_version[]     = "1.0";
+char *proc_menus[] = { "Count", NULL };
+char *proc_alias[]     = { "keypercentile", "keytdigest", NULL };
+char proc_name[]       = PROC_NAME;
+char proc_purpose[]    = "estimates quantiles of a value at each key";
+char *proc_synopsis[] = { "keyquantile <LABEL> -V <LABEL> [-q <quantile>] [-S] [-B] [-R] [-M <size>]", NULL};
+char *proc_tags[] = {"key", "statistics", "sketch", NULL};
+char proc_description[] = {"The keyquantile kid keeps a fixed-size t-digest (at most 64 "
+     "centroids) of LABEL-VALUE for each LABEL-KEY.  At flush or expiration it appends "
+     "COUNT, MIN, MAX and one member per requested quantile, labeled P followed by the "
+     "percentile with '.' replaced by '_' (e.g. -q 0.99 gives P99, -q 0.999 gives P99_9).  "
+     "The default quantiles are 0.5, 0.9 and 0.99.  Accuracy is best near the tails.  "
+     "With -B the digest itself is appended as a binary SKETCH member; with -S the "
+     "values are taken to be such digests and are merged, so per-thread or "
+     "per-process results can be combined downstream (digests use native byte order)."
+     ""};
+proc_example_t proc_examples[] = {
+     {"... | keyquantile HOST -V LATENCY | ...", "reports median, p90 and p99 LATENCY per HOST"},
+     {"... | keyquantile HOST -V LATENCY -q 0.999 | ...", "reports p99.9 LATENCY per HOST as P99_9"},
+     {"... | keyquantile HOST -V LATENCY -B | ... | keyquantile HOST -V SKETCH -S | ...",
+      "builds partial digests and merges them downstream"},
+     {NULL,""}
+};
+
+proc_option_t proc_opts[] = {
+     /*  'option character', "long option string", "option argument",
+	 "option description", <allow multiple>, <required>*/
+     {'V',"","label",
+     "LABEL of value at key",0,0},
+     {'q',"","quantile",
+     "quantile to report, between 0 and 1 (can specify multiple)",1,0},
+     {'M',"","records",
+     "maximum table size",0,0},
+     {'B',"","",
+     "append the serialized digest as SKETCH",0,0},
+     {'S',"","",
+     "values are serialized digests to merge",0,0},
+     {'R',"","",
+      "keep only the member that matches, not the whole tuple",0,0},
+     //the following must be left as-is to signify the end of the array
+     {' ',"","",
+     "",0,0}
+};
+
+char proc_requires[] = "none";
+char proc_nonswitch_opts[]    = "LABEL of key";
+char *proc_input_types[]    = {"tuple", NULL};
+char *proc_output_types[]    = {"tuple", NULL};
+char *proc_tuple_member_labels[] = {"COUNT", "MIN", "MAX", "SKETCH", NULL};
+proc_port_t proc_input_ports[] =  {
+     {"none","normal operation"},
+     {"EXPIRE","trigger gradual expiration of buffered states"},
+     {"DELETE","expire specific key, flush state"},
+     {"REMOVE","expire specific key, flush state"},
+     {NULL, NULL}
+};
+
+char *proc_tuple_conditional_container_labels[] = {NULL};
+
+typedef struct _key_data_t {
+     wsdata_t * wsd;
+     tdigest_t td;
+} key_data_t;
+
+int prockeystate_state_size = sizeof(key_data_t);
+
+#define MAX_QUANTILES (16)
+
+typedef struct _proc_instance_t {
+     uint64_t outcnt;
+
+     wslabel_t * label_cnt;
+     wslabel_t * label_min;
+     wslabel_t * label_max;
+     wslabel_t * label_sketch;
+     double quantile[MAX_QUANTILES];
+     wslabel_t * label_quantile[MAX_QUANTILES];
+     int nquantiles;
+     int keep_only_key;
+     int emit_sketch;
+     int merge_sketch;
+} proc_instance_t;
+
+int prockeystate_instance_size = sizeof(proc_instance_t);
+
+proc_labeloffset_t proc_labeloffset[] =
+{
+     {"COUNT",offsetof(proc_instance_t, label_cnt)},
+     {"MIN",offsetof(proc_instance_t, label_min)},
+     {"MAX",offsetof(proc_instance_t, label_max)},
+     {"SKETCH",offsetof(proc_instance_t, label_sketch)},
+     {"",0}
+};
+
+char prockeystate_option_str[]    = "RBSq:";
+
+static int add_quantile(proc_instance_t * proc, void * type_table, double q) {
+     if ((q < 0) || (q > 1)) {
+          error_print("quantile %g must be between 0 and 1", q);
+          return 0;
+     }
+     if (proc->nquantiles >= MAX_QUANTILES) {
+          error_print("at most %d quantiles can be requested", MAX_QUANTILES);
+          return 0;
+     }
+     char lbuf[64];
+     snprintf(lbuf, sizeof(lbuf), "P%g", q * 100.0);
+     char * dot = strchr(lbuf, '.');
+     if (dot) {
+          *dot = '_';
+     }
+     proc->quantile[proc->nquantiles] = q;
+     proc->label_quantile[proc->nquantiles] = wsregister_label(type_table, lbuf);
+     proc->nquantiles++;
+     return 1;
+}
+
+int prockeystate_option(void * vproc, void * type_table, int c, const char * str) {
+     proc_instance_t * proc = (proc_instance_t *)vproc;
+
+     switch(c) {
+     case 'R':
+          proc->keep_only_key = 1;
+          break;
+     case 'B':
+          proc->emit_sketch = 1;
+          break;
+     case 'S':
+          proc->merge_sketch = 1;
+          tool_print("merging serialized digests");
+          break;
+     case 'q':
+          return add_quantile(proc, type_table, strtod(str, NULL));
+     }
+     return 1;
+}
+
+int prockeystate_init(void * vproc, void * type_table, int hasvalue) {
+     proc_instance_t * proc = (proc_instance_t *)vproc;
+
+     if (!proc->nquantiles) {
+          add_quantile(proc, type_table, 0.5);
+          add_quantile(proc, type_table, 0.9);
+          add_quantile(proc, type_table, 0.99);
+     }
+     return 1;
+}
+
+static inline void add_quantiles(proc_instance_t * proc, wsdata_t * tup,
+                                 key_data_t * kd, ws_doutput_t * dout,
+                                 ws_outtype_t * outtype_tuple) {
+     tuple_member_create_uint64(tup, (uint64_t)tdigest_count(&kd->td),
+                                proc->label_cnt);
+     tuple_member_create_double(tup, kd->td.min, proc->label_min);
+     tuple_member_create_double(tup, kd->td.max, proc->label_max);
+     int i;
+     for (i = 0; i < proc->nquantiles; i++) {
+          tuple_member_create_double(tup,
+                                     tdigest_quantile(&kd->td, proc->quantile[i]),
+                                     proc->label_quantile[i]);
+     }
+     if (proc->emit_sketch) {
+          wsdt_binary_t * bin = tuple_create_binary(tup, proc->label_sketch,
+                                                    TDIGEST_SERIAL_LEN);
+          if (bin) {
+               tdigest_serialize(&kd->td, bin->buf);
+          }
+     }
+     ws_set_outdata(tup, outtype_tuple, dout);
+     proc->outcnt++;
+}
+
+void prockeystate_expire(void * vproc, void * vdata, ws_doutput_t * dout,
+                         ws_outtype_t * outtype_tuple) {
+     proc_instance_t * proc = (proc_instance_t *)vproc;
+     key_data_t * kd = (key_data_t*)vdata;
+     if (kd->wsd) {
+          if (proc->keep_only_key) {
+               wsdata_t * tup = wsdata_alloc(dtype_tuple);
+               if (tup) {
+                    add_tuple_member(tup, kd->wsd);
+                    add_quantiles(proc, tup, kd, dout, outtype_tuple);
+               }
+          }
+          else {
+               add_quantiles(proc, kd->wsd, kd, dout, outtype_tuple);
+          }
+          wsdata_delete(kd->wsd);
+          kd->wsd = NULL;
+     }
+     memset(&kd->td, 0, sizeof(tdigest_t));
+}
+
+int prockeystate_update_value(void * vproc, void * vstate, wsdata_t * tuple,
+                              wsdata_t *key, wsdata_t * value) {
+     proc_instance_t * proc = (proc_instance_t*)vproc;
+     key_data_t * kd = (key_data_t *) vstate;
+
+     if (proc->merge_sketch) {
+          char * buf;
+          int len;
+          if (!dtype_string_buffer(value, &buf, &len) ||
+              !tdigest_merge_serialized(&kd->td, buf, len)) {
+               return 0;
+          }
+     }
+     else {
+          double dbl = 0;
+          if (!dtype_get_double(value, &dbl)) {
+               return 0;
+          }
+          tdigest_add(&kd->td, dbl);
+     }
+
+     if (!kd->wsd) {
+          if (proc->keep_only_key) {
+               kd->wsd = key;
+               wsdata_add_reference(key);
+          }
+          else {
+               kd->wsd = tuple;
+               wsdata_add_reference(tuple);
+          }
+     }
+     return 0;
+}
+
+//return 1 if successful
+//return 0 if no..
+int prockeystate_destroy(void * vinstance) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     tool_print("output cnt %" PRIu64, proc->outcnt);
+
+     //free dynamic allocations
+     //free(proc); // free this in the calling function
+
+     return 1;
+}
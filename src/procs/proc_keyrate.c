@@ -176,11 +176,12 @@ static inline void update_epoch(proc_instance_t * proc, wsdata_t * tuple) {
                //just choose first
                wsdt_ts_t * ts = NULL;
                ts = mset[0]->data;
+               sysutil_clock_observe(ts->sec, ts->usec);
                tsec = ts->sec;
           }
      }
      if (!tsec) {
-          tsec = time(NULL);
+          tsec = sysutil_time();
      }
 
      if (sysutil_test_time_boundary(&proc->epoch_boundary, tsec)) {
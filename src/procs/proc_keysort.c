@@ -36,11 +36,15 @@ OTHER REQUIRED LICENSE TERMS
 #include "procloader.h"
 
 char proc_name[]               =  PROC_NAME;
-char proc_version[]            =  "1.5";
+char proc_version[]            =  "1.6";
 char *proc_tags[]              =  {"Sessionization", "State tracking", NULL};
 char *proc_alias[]             =  { "sortkey", "groupsort", "sortgroup", NULL };
 char proc_purpose[]            =  "sorts events about a key from lowest to highest value";
-char proc_description[] = "streaming window sort of events per key, pressure expiration";
+char proc_description[] = "streaming window sort of events per key, pressure expiration. "
+     "By default each key keeps a sorted ring of values, so out-of-order events cost a "
+     "shift of up to -n entries. With -H each key keeps a min-heap instead: an event is "
+     "emitted as soon as it is the lowest of the -n buffered values, and out-of-order "
+     "inserts cost O(log n).";
 
 proc_option_t proc_opts[]      =  {
      /*  'option character', "long option string", "option argument",
@@ -51,6 +55,8 @@ proc_option_t proc_opts[]      =  {
      "maximum number of events to store at key",0,0},
      {'M',"","records",
      "maximum table size",0,0},
+     {'H',"","",
+     "keep per-key values in a heap (for large -n)",0,0},
      //the following must be left as-is to signify the end of the array
      {' ',"","",
      "",0,0}
@@ -77,7 +83,7 @@ typedef struct _el_data_t {
 } el_data_t;
 
 typedef struct _key_data_t {
-     uint32_t next;
+     uint32_t next;   //ring position, or element count when using a heap
      uint32_t generation; //for expiration
      el_data_t el[0];
 } key_data_t;
@@ -100,6 +106,7 @@ typedef struct _proc_instance_t {
      ws_doutput_t * dout;
 
      uint32_t maxcnt;  //max number of events per key
+     int use_heap;
      size_t key_struct_size;
 
      key_data_t * global_key; //when not key is specified, use a global key table
@@ -113,7 +120,7 @@ static int proc_cmd_options(int argc, char ** argv,
      dprint("proc_cmd_options");
      int op;
 
-     while ((op = getopt(argc, argv, "v:V:N:n:M:")) != EOF) {
+     while ((op = getopt(argc, argv, "v:V:N:n:M:H")) != EOF) {
           switch (op) {
           case 'V':
           case 'v':
@@ -132,6 +139,10 @@ static int proc_cmd_options(int argc, char ** argv,
           case 'M':
                proc->buflen = atoi(optarg);
                break;
+          case 'H':
+               proc->use_heap = 1;
+               tool_print("using per-key heap");
+               break;
           default:
                return 0;
           }
@@ -145,11 +156,59 @@ static int proc_cmd_options(int argc, char ** argv,
      return 1;
 }
 
+static inline void keyheap_sift_up(el_data_t * el, uint32_t pos) {
+     el_data_t tmp;
+     while (pos > 0) {
+          uint32_t parent = (pos - 1) / 2;
+          if (el[parent].value <= el[pos].value) {
+               break;
+          }
+          tmp = el[parent]; el[parent] = el[pos]; el[pos] = tmp;
+          pos = parent;
+     }
+}
+
+static inline void keyheap_sift_down(el_data_t * el, uint32_t pos,
+                                     uint32_t len) {
+     el_data_t tmp;
+     while (1) {
+          uint32_t child = 2 * pos + 1;
+          if (child >= len) {
+               break;
+          }
+          if ((child + 1 < len) && (el[child + 1].value < el[child].value)) {
+               child++;
+          }
+          if (el[pos].value <= el[child].value) {
+               break;
+          }
+          tmp = el[pos]; el[pos] = el[child]; el[child] = tmp;
+          pos = child;
+     }
+}
+
+//pop the heap in order, lowest value first
+static void emit_state_heap(proc_instance_t * proc, key_data_t * kdata) {
+     uint32_t len = kdata->next;
+     while (len) {
+          ws_set_outdata(kdata->el[0].data, proc->outtype_tuple, proc->dout);
+          wsdata_delete(kdata->el[0].data);
+          len--;
+          kdata->el[0] = kdata->el[len];
+          keyheap_sift_down(kdata->el, 0, len);
+     }
+}
+
 static void emit_state(void * vdata, void * vproc) {
      proc_instance_t * proc = (proc_instance_t *)vproc;
      key_data_t * kdata = (key_data_t *)vdata;
 
      dprint("emit_state");
+     if (proc->use_heap) {
+          emit_state_heap(proc, kdata);
+          memset(kdata, 0, proc->key_struct_size);
+          return;
+     }
      //flush all stored content
      uint32_t i;
      for (i = 0; i < proc->maxcnt; i++) {
@@ -278,6 +337,33 @@ static inline void replace_kv(proc_instance_t * proc, key_data_t * kdata,
      kdata->next = (kdata->next + 1) % proc->maxcnt;
 }
 
+//root of the heap is the lowest buffered value; it is final once a full
+//heap sees anything at least as large
+static inline void insert_kv_heap(proc_instance_t * proc, key_data_t * kdata,
+                                  double dv, wsdata_t * tdata) {
+     el_data_t * el = kdata->el;
+     if (kdata->next < proc->maxcnt) {
+          uint32_t pos = kdata->next;
+          el[pos].value = dv;
+          el[pos].data = tdata;
+          wsdata_add_reference(tdata);
+          kdata->next++;
+          keyheap_sift_up(el, pos);
+          return;
+     }
+     if (dv < el[0].value) {
+          dprint("insert prior");
+          ws_set_outdata(tdata, proc->outtype_tuple, proc->dout);
+          return;
+     }
+     ws_set_outdata(el[0].data, proc->outtype_tuple, proc->dout);
+     wsdata_delete(el[0].data);
+     el[0].value = dv;
+     el[0].data = tdata;
+     wsdata_add_reference(tdata);
+     keyheap_sift_down(el, 0, kdata->next);
+}
+
 static void insert_kv(proc_instance_t * proc, key_data_t * kdata,
                      wsdata_t * value, wsdata_t * tdata) {
      dprint("insert kv");
@@ -289,6 +375,11 @@ static void insert_kv(proc_instance_t * proc, key_data_t * kdata,
      }
      dprint("current value %.0f", dv);
 
+     if (proc->use_heap) {
+          insert_kv_heap(proc, kdata, dv, tdata);
+          return;
+     }
+
      //check immediate prior values
      uint32_t p = (proc->maxcnt + kdata->next - 1) % proc->maxcnt;  
      if (!kdata->el[p].data || (kdata->el[p].value <= dv)) {
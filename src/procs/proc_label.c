@@ -83,6 +83,14 @@ static int proc_process_meta(void *, wsdata_t*, ws_doutput_t*, int);
 static int proc_relabel(void *, wsdata_t*, ws_doutput_t*, int);
 static int proc_process_tuple(void *, wsdata_t*, ws_doutput_t*, int);
 static int proc_add_to_empty(void *, wsdata_t*, ws_doutput_t*, int);
+static int proc_process_meta_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+static int proc_relabel_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+
+proc_batch_t proc_batch[] = {
+     {proc_process_meta, proc_process_meta_batch},
+     {proc_relabel, proc_relabel_batch},
+     {NULL, NULL}
+};
 
 typedef struct _proc_instance_t {
      uint64_t meta_process_cnt;
@@ -238,6 +246,27 @@ static int proc_process_meta(void * vinstance, wsdata_t* input_data,
      return 1;
 }
 
+static int proc_process_meta_batch(void * vinstance, wsdata_t** input_data,
+                                   int len, ws_doutput_t * dout,
+                                   int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     ws_outtype_t * outtype = proc->outtype_meta[type_index];
+     wslabel_t * label = proc->label;
+     int i;
+
+     proc->meta_process_cnt += len;
+
+     for (i = 0; i < len; i++) {
+          if (!wsdata_check_label(input_data[i], label)) {
+               wsdata_add_label(input_data[i], label);
+          }
+          ws_set_outdata(input_data[i], outtype, dout);
+     }
+     proc->outcnt += len;
+     return len;
+}
+
 static int proc_relabel(void * vinstance, wsdata_t* input_data,
                         ws_doutput_t * dout, int type_index) {
 
@@ -255,6 +284,24 @@ static int proc_relabel(void * vinstance, wsdata_t* input_data,
      return 1;
 }
 
+static int proc_relabel_batch(void * vinstance, wsdata_t** input_data,
+                              int len, ws_doutput_t * dout, int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     ws_outtype_t * outtype = proc->outtype_meta[type_index];
+     int i;
+
+     proc->meta_process_cnt += len;
+
+     for (i = 0; i < len; i++) {
+          wsdata_t * ptr = wsdata_ptr(input_data[i]);
+          wsdata_add_label(ptr, proc->label);
+          ws_set_outdata(ptr, outtype, dout);
+     }
+     proc->outcnt += len;
+     return len;
+}
+
 //callback when searching nested tuple
 static int proc_nest_match_callback(void * vproc, void * vroot,
                                     wsdata_t * subtdata, wsdata_t * member) {
@@ -533,6 +533,10 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
               }
           }
           stringhash5_set_callback(proc->last_table, last_destroy, proc);
+          // a dump would leave out spilled keys
+          if (!proc->outfile) {
+               stringhash5_enable_spill(proc->last_table);
+          }
      }
 
      //free shared sh5 option struct
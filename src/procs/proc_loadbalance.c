@@ -34,13 +34,13 @@ SOFTWARE.
 #include "datatypes/wsdt_tuple.h"
 #include "procloader.h"
 
-char proc_version[]     = "1.5";
+char proc_version[]     = "1.6";
 char *proc_tags[]     = { "Stream manipulation", NULL };
 char *proc_alias[]     = { NULL };
 char proc_name[]       = PROC_NAME;
 char proc_purpose[]    = "labels data for load balancing";
-char *proc_synopsis[] = {"loadbalance [<LABEL>] [-N <count>] [-L <prefix>] [-o]", NULL};
-char proc_description[] = "From a single stream, generate labels indicating how to split the stream in N ways to maintain load balance if the streams a parallelized.  The '-N' option is used to specify the number of load-balanced output channels to produce (default is 4).  The '-L' option allows some customization of the output labels (default is 'LB').  The '-o' options computes an ordered hash on the labels specified (useful for coalescing multidirectional traffic).";
+char *proc_synopsis[] = {"loadbalance [<LABEL>] [-N <count>] [-L <prefix>] [-o] [-s <seed>]", NULL};
+char proc_description[] = "From a single stream, generate labels indicating how to split the stream in N ways to maintain load balance if the streams a parallelized.  The '-N' option is used to specify the number of load-balanced output channels to produce (default is 4).  The '-L' option allows some customization of the output labels (default is 'LB').  The '-o' options computes an ordered hash on the labels specified (useful for coalescing multidirectional traffic).  The '-s' option fixes the hash seed so that several loadbalance kids send the same key to the same channel.";
 
 proc_example_t proc_examples[] = {
         {"... | loadbalance KEY1 KEY2 -o | ...", "Keeps the ordered hash of the KEY1 and KEY2 in the same load-balanced output channel in an effort to keep flows in the same channel."},
@@ -57,6 +57,8 @@ proc_option_t proc_opts[] = {
      "Label prefix",0,0},
      {'o',"","",
      "do ordered hashing",0,0},
+     {'s',"","seed",
+     "hash seed (default is random)",0,0},
      //the following must be left as-is to signify the end of the array
      {' ',"","",
      "",0,0}
@@ -101,7 +103,7 @@ static int proc_cmd_options(int argc, char ** argv,
                             proc_instance_t * proc, void * type_table) {
      int op;
 
-     while ((op = getopt(argc, argv, "oN:L:")) != EOF) {
+     while ((op = getopt(argc, argv, "oN:L:s:")) != EOF) {
           switch (op) {
           case 'N':
                proc->channels = atoi(optarg);
@@ -114,6 +116,9 @@ static int proc_cmd_options(int argc, char ** argv,
                proc->ordered_hash = 1;
                tool_print("ordered hashing");
                break;
+          case 's':
+               proc->seed = (uint32_t)strtoul(optarg, NULL, 0);
+               break;
           default:
                return 0;
           }
@@ -161,6 +166,7 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
           snprintf(lbuf, 256, "%s%d", proc->prefix, i);
           proc->lb_labels[i] = wsregister_label(type_table, lbuf);
      }
+     kid->reads = WSKID_READS_LABELS;
 
      return 1; 
 }
@@ -271,9 +277,9 @@ static inline int get_hashdata(proc_instance_t * proc,
           hashloc =
                member->dtype->hash_func(member);
           if (hashloc->offset) {
-               hash += evahash64(hashloc->offset,
-                                 hashloc->len,
-                                 proc->hmembers.id[i]);
+               hash += ws_table_hash64(hashloc->offset,
+                                       hashloc->len,
+                                       proc->hmembers.id[i]);
           }
      }
      proc->hmembers.hash = hash;
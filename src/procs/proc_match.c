@@ -142,7 +142,6 @@ typedef struct _proc_instance_t {
 static int proc_cmd_options(int argc, char ** argv, 
                             proc_instance_t * proc, void * type_table) {
      int op;
-     int lid;
 
      while ((op = getopt(argc, argv, "1S:s:U:u:M:tIR:F:L:B:b:")) != EOF) {
           switch (op) {
@@ -168,7 +167,7 @@ static int proc_cmd_options(int argc, char ** argv,
                proc->lmatch->ac_struct->case_insensitive = 1;
                break;
           case 'F':
-               if (label_match_loadfile(proc->lmatch, optarg)) {
+               if (label_match_queue_file(proc->lmatch, optarg)) {
                     tool_print("reading file %s", optarg);
                }
                break;
@@ -178,13 +177,11 @@ static int proc_cmd_options(int argc, char ** argv,
                break;
           case 'R':
                {
-                    lid =
-                         label_match_make_label(proc->lmatch,
-                                                proc->label_match->name);
                     char *buf = strdup(optarg);
                     int len = strlen(buf);
                     sysutil_decode_hex_escapes(buf, &len);
-                    ac_loadkeyword(proc->lmatch->ac_struct, buf, len, lid);
+                    label_match_queue_string(proc->lmatch, buf, len,
+                                             proc->label_match->name);
                     tool_print("added match string '%s'", optarg);
                     free(buf);
                }
@@ -223,11 +220,20 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
      if (!proc_cmd_options(argc, argv, proc, type_table)) {
           return 0;
      }
-     proc->ac_struct = label_match_finalize(proc->lmatch);
 
      return 1; 
 }
 
+// match strings are compiled here on the kid's own thread, concurrently
+// with kids on other threads
+int proc_init_finish(void * vinstance) {
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+
+     proc->ac_struct = label_match_build(proc->lmatch);
+
+     return (proc->ac_struct != NULL);
+}
+
 // this function needs to decide on processing function based on datatype
 // given.. also set output types as needed (unless a sink)
 //return 1 if ok
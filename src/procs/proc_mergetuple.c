@@ -212,6 +212,7 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
                return 0;
           }
           stringhash5_set_callback(proc->last_table, last_destroy, proc);
+          stringhash5_enable_spill(proc->last_table);
      }
 
      //use the stringhash5-adjusted value of max_records to reset buflen
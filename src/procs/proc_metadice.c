@@ -294,7 +294,7 @@ static inline char * create_prefix(char * fname, wslabel_t * label, char * env)
 
 static inline FILE * get_fp(proc_instance_t * proc, time_t sec, wsdata_t * wsd) {
      if (!sec) {
-          sec = time(NULL);
+          sec = sysutil_time();
      }
      sysutil_test_time_boundary(&proc->splittime, sec);
 
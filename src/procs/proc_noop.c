@@ -62,6 +62,12 @@ char *proc_tuple_member_labels[] =  {NULL};
 //function prototypes for local functions
 static int proc_process_meta(void *, wsdata_t*, ws_doutput_t*, int);
 static int proc_source(void *, wsdata_t*, ws_doutput_t*, int);
+static int proc_process_meta_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+
+proc_batch_t proc_batch[] = {
+     {proc_process_meta, proc_process_meta_batch},
+     {NULL, NULL}
+};
 
 typedef struct _proc_instance_t {
      uint64_t meta_process_cnt;
@@ -110,6 +116,7 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
      if (proc->do_source) {
           proc->outtype_tuple = ws_register_source(dtype_tuple, proc_source, sv);
      }
+     kid->reads = WSKID_READS_LABELS;
      
      return 1; 
 }
@@ -154,6 +161,24 @@ static int proc_process_meta(void * vinstance, wsdata_t* input_data,
      return 1;
 }
 
+static int proc_process_meta_batch(void * vinstance, wsdata_t** input_data,
+                                   int len, ws_doutput_t * dout,
+                                   int type_index) {
+
+     proc_instance_t * proc = (proc_instance_t*)vinstance;
+     ws_outtype_t * outtype = proc->outtype_meta[type_index];
+     int i;
+
+     proc->meta_process_cnt += len;
+
+     //pass through
+     for (i = 0; i < len; i++) {
+          ws_set_outdata(input_data[i], outtype, dout);
+     }
+     proc->outcnt += len;
+     return len;
+}
+
 //return 0 = no data left
 static int proc_source(void * vinstance, wsdata_t* input_data,
                        ws_doutput_t * dout, int type_index) {
@@ -171,13 +171,14 @@ static time_t get_datetime_msec(proc_instance_t * proc, wsdata_t * tdata) {
           if (mset_len && (mset[0]->dtype == dtype_ts)) {
                //just choose first
                ts = mset[0]->data;
+               sysutil_clock_observe(ts->sec, ts->usec);
                return WSDT_TS_MSEC(ts->sec, ts->usec);
           }
      }
      else {
           //get timestamp from clock
           struct timeval current;
-          gettimeofday(&current, NULL);
+          sysutil_gettime(&current);
           return WSDT_TS_MSEC(current.tv_sec, current.tv_usec);
      }
      return 0;
@@ -29,6 +29,7 @@ SOFTWARE.
 #include "waterslide.h"
 #include "waterslidedata.h"
 #include "datatypes/wsdt_flush.h"
+#include "sysutil.h"
 #include "procloader.h"
 
 char proc_name[]               =  PROC_NAME;
@@ -173,7 +174,7 @@ static inline int check_heartbeat(proc_instance_t * proc) {
           if(rand() <= proc->heartbeat_int)
                return 1;
      } else {
-          uint32_t t=time(NULL);
+          uint32_t t=sysutil_time();
           if(t>=proc->nexttime) {
                proc->nexttime=t+proc->heartbeat_time;
                return 1;
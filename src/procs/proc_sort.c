@@ -35,11 +35,11 @@ SOFTWARE.
 #include "datatypes/wsdt_int.h"
 #include "datatypes/wsdt_uint64.h"
 #include "datatypes/wsdt_double.h"
-#include "quicksort.h"
+#include "wsheap.h"
 #include "procloader.h"
 
 char proc_name[]               =  PROC_NAME;
-char proc_version[]            =  "1.5";
+char proc_version[]            =  "1.6";
 char *proc_tags[]              =  {"Profiling", "Stream manipulation", NULL};
 char *proc_alias[]             =  { NULL };
 char proc_purpose[]            =  "Performs a windowed sort from largest to smallest numeric LABEL value";
@@ -51,6 +51,8 @@ proc_option_t proc_opts[]      =  {
      "sort small to large aka in reverse",0,0},
      {'M',"","records",
      "maximum buffer size",0,0},
+     {'k',"","count",
+     "only emit the top count tuples of each window",0,0},
      //the following must be left as-is to signify the end of the array
      {' ',"","",
      "",0,0}
@@ -65,18 +67,22 @@ proc_port_t proc_input_ports[] =  {{NULL, NULL}};
 char *proc_tuple_container_labels[] =  {NULL};
 char *proc_tuple_conditional_container_labels[] =  {NULL};
 char *proc_tuple_member_labels[] =  {NULL};
-char *proc_synopsis[]          =  { "sort <LABEL> [-r ] [-M <SIZE>]", NULL};
+char *proc_synopsis[]          =  { "sort <LABEL> [-r ] [-M <SIZE>] [-k <COUNT>]", NULL};
 proc_example_t proc_examples[] =  {
           {"... | sort VALUE | ...", "sorts tuples from largest to smallest VALUE"},
 	  {"... | sort -r VALUE | ...", "sorts tuples from smallest to largest VALUE"},
 	  {"... | sort COUNT -M 50 | ...", "Sizes the table to 50 records (least recently used values will be dropped.)"},
+	  {"... | sort COUNT -k 10 | ...", "emits only the 10 largest COUNT tuples per window or flush"},
           {NULL,NULL}
 };
 char proc_description[] = "The sort kid sorts tuples from largest to smallest based on LABEL's value."
 		" It only sorts numeric values (any real number) and cannot sort alphabetically."
 		" Default is to sort from largest value to smallest; however, the -r option"
-		" will result in a sort from smallest to largest. This kid uses a quicksort algorithm"
-		" to perform sort."
+		" will result in a sort from smallest to largest. This kid heapifies the buffered"
+		" window at flush and emits tuples as they are popped off the heap, so output"
+		" starts after a linear-time build rather than after a full sort."
+		" The -k option keeps only the top COUNT tuples of each window in a bounded heap"
+		" (O(n log k)) and drops the rest as they arrive."
 		" Hashtable size is specified via the -M option, the default size is used of 350000 (specified in waterslide.h) or the"
 		" environment variable WS_STATESTORE_MAX. Note: if label specified does not exist, does"
 		" not sort or pass through anything.";
@@ -99,17 +105,47 @@ typedef struct _proc_instance_t {
 
      uint32_t maxlen;
      int len;
+     uint64_t topk;
+     wsheap_t * heap;
      wslabel_t * label_value;
      ws_outtype_t * outtype_tuple;
      int reverse;
 } proc_instance_t;
 
 
+static int sort_heap_cmp(void * vfirst, void * vsecond) {
+     sort_data_t * first = (sort_data_t*)vfirst;
+     sort_data_t * second = (sort_data_t*)vsecond;
+
+     if (first->value < second->value) {
+          return -1;
+     }
+     if (first->value == second->value) {
+          return 0;
+     }
+     return 1;
+}
+
+static int sort_heap_cmp_reverse(void * vfirst, void * vsecond) {
+     return sort_heap_cmp(vsecond, vfirst);
+}
+
+static void sort_heap_replace(void * vrec, void * vreplace, void * vproc) {
+     sort_data_t * rec = (sort_data_t*)vrec;
+     sort_data_t * replace = (sort_data_t*)vreplace;
+     if (rec->wsd) {
+          wsdata_delete(rec->wsd);
+     }
+     rec->wsd = replace->wsd;
+     rec->value = replace->value;
+     wsdata_add_reference(rec->wsd);
+}
+
 static int proc_cmd_options(int argc, char ** argv, 
                             proc_instance_t * proc, void * type_table) {
      int op;
 
-     while ((op = getopt(argc, argv, "rM:")) != EOF) {
+     while ((op = getopt(argc, argv, "rM:k:")) != EOF) {
           switch (op) {
           case 'r':
                proc->reverse = 1;
@@ -117,6 +153,9 @@ static int proc_cmd_options(int argc, char ** argv,
           case 'M':
                proc->maxlen = atoi(optarg);
                break;
+          case 'k':
+               proc->topk = strtoul(optarg, NULL, 0);
+               break;
           default:
                return 0;
           }
@@ -155,6 +194,23 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
           return 0;
      }
 
+     if (proc->topk) {
+          if (proc->topk > proc->maxlen) {
+               proc->topk = proc->maxlen;
+          }
+          tool_print("keeping top %" PRIu64 " of each window", proc->topk);
+          //the heap root is the weakest of the current top k
+          proc->heap = wsheap_init(proc->topk, sizeof(sort_data_t),
+                                   proc->reverse ? sort_heap_cmp_reverse :
+                                   sort_heap_cmp,
+                                   sort_heap_replace, proc);
+          if (!proc->heap) {
+               error_print("unable to create heap");
+               return 0;
+          }
+          return 1;
+     }
+
      //make an array of ptr
      proc->buf = (sort_data_t*)calloc(proc->maxlen, sizeof(sort_data_t));
      if (!proc->buf) {
@@ -199,40 +255,71 @@ proc_process_t proc_input_set(void * vinstance, wsdatatype_t * meta_type,
      return NULL; // a function pointer
 }
 
-static int local_cmp(void * d1, void *d2, void * ignore) {
-     sort_data_t * s1 = (sort_data_t*)d1;
-     sort_data_t * s2 = (sort_data_t*)d2;
+//returns 1 if d1 should be emitted before d2
+static inline int sort_before(proc_instance_t * proc, sort_data_t * d1,
+                              sort_data_t * d2) {
+     if (proc->reverse) {
+          return d1->value < d2->value;
+     }
+     return d1->value > d2->value;
+}
 
-     if (s2->value > s1->value) {
-          return 1;
+static inline void sort_sift_down(proc_instance_t * proc, int pos, int len) {
+     sort_data_t ** A = proc->sdata;
+     sort_data_t * tmp;
+     while (1) {
+          int child = 2 * pos + 1;
+          if (child >= len) {
+               break;
+          }
+          if ((child + 1 < len) && sort_before(proc, A[child + 1], A[child])) {
+               child++;
+          }
+          if (!sort_before(proc, A[child], A[pos])) {
+               break;
+          }
+          tmp = A[pos]; A[pos] = A[child]; A[child] = tmp;
+          pos = child;
      }
-     return 0;
 }
 
-static int local_cmp_reverse(void * d1, void *d2, void * ignore) {
-     sort_data_t * s1 = (sort_data_t*)d1;
-     sort_data_t * s2 = (sort_data_t*)d2;
+static inline void sort_dump_topk(proc_instance_t * proc, ws_doutput_t * dout) {
+     uint64_t count = proc->heap->count;
+     wsheap_sort_inplace(proc->heap);
 
-     if (s2->value < s1->value) {
-          return 1;
+     uint64_t i;
+     for (i = 0; i < count; i++) {
+          sort_data_t * sd = (sort_data_t*)proc->heap->heap[i];
+          ws_set_outdata(sd->wsd, proc->outtype_tuple, dout);
+          proc->outcnt++;
+          wsdata_delete(sd->wsd);
+          sd->wsd = NULL;
      }
-     return 0;
+     wsheap_reset(proc->heap);
+     proc->len = 0;
 }
 
+//build a heap over the window in O(n), then emit by popping the root so
+//output starts before the whole window is ordered
 static inline void sort_dump(proc_instance_t * proc, ws_doutput_t * dout) {
-     if (proc->len) {
-          if (proc->reverse) {
-               quicksort((void**)proc->sdata, proc->len, local_cmp_reverse, NULL);
-          }
-          else {
-               quicksort((void**)proc->sdata, proc->len, local_cmp, NULL);
-          }
+     if (proc->heap) {
+          sort_dump_topk(proc, dout);
+          return;
      }
+     int len = proc->len;
      int i;
-     for (i = 0; i < proc->len; i++) {
-          ws_set_outdata(proc->sdata[i]->wsd, proc->outtype_tuple, dout);
+     for (i = len / 2 - 1; i >= 0; i--) {
+          sort_sift_down(proc, i, len);
+     }
+     while (len > 0) {
+          sort_data_t * top = proc->sdata[0];
+          ws_set_outdata(top->wsd, proc->outtype_tuple, dout);
           proc->outcnt++;
-          wsdata_delete(proc->sdata[i]->wsd);
+          wsdata_delete(top->wsd);
+          len--;
+          proc->sdata[0] = proc->sdata[len];
+          proc->sdata[len] = top;
+          sort_sift_down(proc, 0, len);
      }
      proc->len = 0;
 }
@@ -266,9 +353,17 @@ static int proc_tuple(void * vinstance, wsdata_t* input_data,
           value = -1;
      }
 
-     proc->sdata[proc->len]->value = value;
-     proc->sdata[proc->len]->wsd = input_data;
-     wsdata_add_reference(input_data);
+     if (proc->heap) {
+          sort_data_t sd;
+          sd.value = value;
+          sd.wsd = input_data;
+          wsheap_insert_replace(proc->heap, (void *)&sd);
+     }
+     else {
+          proc->sdata[proc->len]->value = value;
+          proc->sdata[proc->len]->wsd = input_data;
+          wsdata_add_reference(input_data);
+     }
 
      proc->len++;
 
@@ -297,7 +392,17 @@ int proc_destroy(void * vinstance) {
      tool_print("meta_proc cnt %" PRIu64, proc->meta_process_cnt);
      tool_print("output cnt %" PRIu64, proc->outcnt);
 
-     if (proc->len) {
+     if (proc->heap) {
+	  if (proc->heap->count) {
+	       tool_print("ERROR - unflushed data %" PRIu64, proc->heap->count);
+	       uint64_t i;
+	       for (i = 0; i < proc->heap->count; i++) {
+		    wsdata_delete(((sort_data_t*)proc->heap->heap[i])->wsd);
+	       }
+	  }
+	  wsheap_destroy(proc->heap);
+     }
+     else if (proc->len) {
 	  tool_print("ERROR - unflushed data %d", proc->len);
 	  int i;
 	  for (i = 0; i < proc->len; i++) {
@@ -29,6 +29,7 @@ SOFTWARE.
 #include <stdio.h>
 #include <unistd.h>
 #include "procloader_buffer.h"
+#include "wsstrsimd.h"
 
 int is_procbuffer = 1;
 int procbuffer_pass_not_found = 1;
@@ -45,7 +46,7 @@ proc_example_t proc_examples[]  = {
 	{NULL,""} 
 };
 char *proc_alias[]      = { NULL };
-char proc_version[]     = "1.5";
+char proc_version[]     = "1.6";
 char proc_requires[]	= "";
 // proc_input_types and proc_output_types automatically set for procbuffer kids
 proc_port_t proc_input_ports[]  = {{NULL, NULL}};
@@ -140,15 +141,17 @@ int procbuffer_decode(void * vproc, wsdata_t * tdata,
 
      int seplen = 0;
 
-     for (i = 0; i < buflen; i++) {
-          if (isprint(buf[i])) {
-               if (!crun) {
-                    startp = &buf[i];
+     i = 0;
+     while (i < buflen) {
+          //scan whole printable and non-printable runs at a time
+          crun = wsstr_print_span(buf + i, buflen - i);
+          if (crun) {
+               startp = &buf[i];
+               i += crun;
+               if (i >= buflen) {
+                    break;
                }
-               crun++;
-          }
-          else {
-               if (startp && (crun >= proc->minrun) && 
+               if ((crun >= proc->minrun) && 
                    (buflen >= (blen + crun + seplen))) {
                     if (seplen) {
                          memcpy(str->buf + blen, proc->sep, seplen);
@@ -163,6 +166,7 @@ int procbuffer_decode(void * vproc, wsdata_t * tdata,
                crun = 0;
                startp = NULL;
           }
+          i += wsstr_nonprint_span(buf + i, buflen - i);
      }
      if (startp && (crun >= proc->minrun) && 
          (buflen >= (blen + crun + seplen))) {
@@ -178,6 +178,9 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
      //monitor_type labels 
      proc->label_process_cnt = wsregister_label(type_table, "PROCESS_CNT");
      proc->label_subtuple = wsregister_label(type_table, "SUBTUPLE");
+
+     // without labels the whole input is copied to the output
+     kid->reads = proc->nest.cnt ? WSKID_READS_OWN : WSKID_READS_LABELS;
      return 1; 
 }
 
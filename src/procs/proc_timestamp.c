@@ -364,7 +364,7 @@ static int proc_tuple(void * vinstance, wsdata_t* input_data,
      proc->meta_process_cnt++;
 
      struct timeval current;
-     gettimeofday(&current, NULL);
+     sysutil_gettime(&current);
 
      add_ts_to_tuple(proc, input_data, current.tv_sec, current.tv_usec);
 
@@ -34,6 +34,7 @@ OTHER REQUIRED LICENSE TERMS
 #include <assert.h>
 #include "waterslide.h"
 #include "waterslidedata.h"
+#include "waterslide_io.h"
 #include "datatypes/wsdt_binary.h"
 #include "datatypes/wsdt_string.h"
 #include "datatypes/wsdt_bigstring.h"
@@ -132,6 +133,7 @@ typedef struct _proc_instance_t {
 
      int do_extensions;
      int do_ja3;
+     int want;
      char jabuf[MAXJA3];
 } proc_instance_t;
 
@@ -228,6 +230,7 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
           //add a reasonable default
           wslabel_set_add(type_table, &proc->lset, "CONTENT");
      }
+     kid->reads = WSKID_READS_LABELS;
      return 1; 
 }
 
@@ -252,6 +255,85 @@ proc_process_t proc_input_set(void * vinstance, wsdatatype_t * input_type,
      return proc_process_label; // a function pointer
 }
 
+// parts of a record that something downstream reads
+#define TLS_WANT_HELLO   0x01
+#define TLS_WANT_SNI     0x02
+#define TLS_WANT_EXT     0x04
+#define TLS_WANT_JA3     0x08
+#define TLS_WANT_BUF     0x10
+#define TLS_WANT_APPDATA 0x20
+#define TLS_WANT_SET     0x40
+
+static inline int any_demanded(ws_label_demand_t * demand,
+                               wslabel_t ** labels, int len) {
+     int i;
+     for (i = 0; i < len; i++) {
+          if (wslabel_demanded(demand, labels[i])) {
+               return 1;
+          }
+     }
+     return 0;
+}
+
+// work out once which parts of a record are worth decoding; the record
+// subtuples and their type labels are always built, and a kid reading a
+// record subtuple by any of its labels sees every member of it
+static int tls_parts_wanted(proc_instance_t * proc) {
+     ws_label_demand_t * demand = proc->outtype_tuple->demand;
+     int want = TLS_WANT_SET;
+     wslabel_t * clabels[] = {
+          proc->label_tlsrec, proc->label_handshake, proc->label_appdata,
+          proc->label_changecipher, proc->label_alert,
+          proc->label_truncated, proc->label_clienthello,
+          proc->label_serverhello, proc->label_serverdone,
+          proc->label_finished, proc->label_clientkey,
+          proc->label_serverkey, proc->label_hellorequest,
+          proc->label_certificate, proc->label_certrequest,
+          proc->label_certverify
+     };
+     if (!demand ||
+         any_demanded(demand, clabels, sizeof(clabels) / sizeof(wslabel_t *))) {
+          want |= TLS_WANT_HELLO | TLS_WANT_SNI | TLS_WANT_BUF |
+               TLS_WANT_APPDATA;
+          if (proc->do_extensions) {
+               want |= TLS_WANT_EXT;
+          }
+          if (proc->do_ja3) {
+               want |= TLS_WANT_JA3;
+          }
+          return want;
+     }
+     wslabel_t * hlabels[] = {
+          proc->label_random, proc->label_sessionid,
+          proc->label_ciphersuites, proc->label_ciphersuite,
+          proc->label_compression, proc->label_version
+     };
+     wslabel_t * elabels[] = {
+          proc->label_extensions, proc->label_ext, proc->label_extid,
+          proc->label_extdata, proc->label_grease, proc->label_padding
+     };
+     if (any_demanded(demand, hlabels, sizeof(hlabels) / sizeof(wslabel_t *))) {
+          want |= TLS_WANT_HELLO;
+     }
+     if (wslabel_demanded(demand, proc->label_sni)) {
+          want |= TLS_WANT_SNI;
+     }
+     if (proc->do_extensions &&
+         any_demanded(demand, elabels, sizeof(elabels) / sizeof(wslabel_t *))) {
+          want |= TLS_WANT_EXT;
+     }
+     if (proc->do_ja3 && wslabel_demanded(demand, proc->label_ja3)) {
+          want |= TLS_WANT_JA3;
+     }
+     if (wslabel_demanded(demand, proc->label_buffer)) {
+          want |= TLS_WANT_BUF;
+     }
+     if (wslabel_demanded(demand, proc->label_appdatabuf)) {
+          want |= TLS_WANT_APPDATA;
+     }
+     return want;
+}
+
 #define HS_HELLOREQUEST 0
 #define HS_CLIENTHELLO 1
 #define HS_SERVERHELLO 2
@@ -531,9 +613,12 @@ static inline int parse_clienthello(proc_instance_t * proc,
           return 0;
      } 
      uint16_t version = (buf[0]<<8) + buf[1];
+     int hello = proc->want & TLS_WANT_HELLO;
      //tuple_member_create_uint16(tdata, version, proc->label_version);
-     tuple_member_create_dep_binary(tdata, dep, proc->label_random,
-                                    (char *)buf+2, CLIENTHELLO_RANDOMLEN);
+     if (hello) {
+          tuple_member_create_dep_binary(tdata, dep, proc->label_random,
+                                         (char *)buf+2, CLIENTHELLO_RANDOMLEN);
+     }
 
      uint8_t *offset = buf + 2 + CLIENTHELLO_RANDOMLEN;
      int offlen = buflen - 2 - CLIENTHELLO_RANDOMLEN;
@@ -548,7 +633,7 @@ static inline int parse_clienthello(proc_instance_t * proc,
           return 0;
      }
 
-     if (sid_len) {
+     if (sid_len && hello) {
           tuple_member_create_dep_binary(tdata, dep, proc->label_sessionid,
                                          (char *)offset + 1, sid_len);
      }
@@ -567,8 +652,10 @@ static inline int parse_clienthello(proc_instance_t * proc,
 
      uint8_t * ciphersuites = offset + 2;
      
-     tuple_member_create_dep_binary(tdata, dep, proc->label_ciphersuites,
-                                    (char *)offset + 2, cipherlen);
+     if (hello) {
+          tuple_member_create_dep_binary(tdata, dep, proc->label_ciphersuites,
+                                         (char *)offset + 2, cipherlen);
+     }
 
      offset += 2 + cipherlen;
      offlen -= 2 + cipherlen;
@@ -583,7 +670,7 @@ static inline int parse_clienthello(proc_instance_t * proc,
      if ((complen == 1) && (offset[1] == 0)) {
           //ignore this basic compression setting
      }
-     else {
+     else if (hello) {
           tuple_member_create_dep_binary(tdata, dep, proc->label_compression,
                                          (char *)offset + 1, complen);
      }
@@ -606,13 +693,15 @@ static inline int parse_clienthello(proc_instance_t * proc,
       */
 
 
-     get_sni(proc, tdata, dep, extbuf, extlen);
+     if (proc->want & TLS_WANT_SNI) {
+          get_sni(proc, tdata, dep, extbuf, extlen);
+     }
 
-     if (proc->do_extensions) {
+     if (proc->want & TLS_WANT_EXT) {
           parse_extensions(proc, tdata, dep, extbuf, extlen);
      }
 
-     if (proc->do_ja3) {
+     if (proc->want & TLS_WANT_JA3) {
           make_ja3(proc, tdata, version, ciphersuites, cipherlen, extbuf, extlen);
      }
 
@@ -627,9 +716,12 @@ static inline int parse_serverhello(proc_instance_t * proc,
           return 0;
      } 
      uint16_t version = (buf[0]<<8) + buf[1];
-     tuple_member_create_uint16(tdata, version, proc->label_version);
-     tuple_member_create_dep_binary(tdata, dep, proc->label_random,
-                                    (char *)buf+2, CLIENTHELLO_RANDOMLEN);
+     int hello = proc->want & TLS_WANT_HELLO;
+     if (hello) {
+          tuple_member_create_uint16(tdata, version, proc->label_version);
+          tuple_member_create_dep_binary(tdata, dep, proc->label_random,
+                                         (char *)buf+2, CLIENTHELLO_RANDOMLEN);
+     }
 
      uint8_t *offset = buf + 2 + CLIENTHELLO_RANDOMLEN;
      int offlen = buflen - 2 - CLIENTHELLO_RANDOMLEN;
@@ -644,7 +736,7 @@ static inline int parse_serverhello(proc_instance_t * proc,
           return 0;
      }
 
-     if (sid_len) {
+     if (sid_len && hello) {
           tuple_member_create_dep_binary(tdata, dep, proc->label_sessionid,
                                          (char *)offset + 1, sid_len);
      }
@@ -660,11 +752,13 @@ static inline int parse_serverhello(proc_instance_t * proc,
      //tuple_member_create_uint16(tdata, ciphersuite, proc->label_ciphersuites);
 
      
-     tuple_member_create_dep_binary(tdata, dep, proc->label_ciphersuite,
-                                    (char *)offset, 2);
+     if (hello) {
+          tuple_member_create_dep_binary(tdata, dep, proc->label_ciphersuite,
+                                         (char *)offset, 2);
 
-     uint16_t compression = offset[2];
-     tuple_member_create_uint16(tdata, compression, proc->label_compression);
+          uint16_t compression = offset[2];
+          tuple_member_create_uint16(tdata, compression, proc->label_compression);
+     }
 
 
      offset += 3;
@@ -680,7 +774,7 @@ static inline int parse_serverhello(proc_instance_t * proc,
      }
      uint8_t * extbuf = offset + 2;
 
-     if (proc->do_extensions) {
+     if (proc->want & TLS_WANT_EXT) {
           parse_extensions(proc, tdata, dep, extbuf, extlen);
      }
 
@@ -704,7 +798,7 @@ static inline int parse_handshake(proc_instance_t * proc,
                 datalen);
      if (len > (datalen-4)) {
           tuple_add_member_label(parenttuple, tdata, proc->label_encrypted);
-          if (buflen > 4) {
+          if ((buflen > 4) && (proc->want & TLS_WANT_BUF)) {
                tuple_member_create_dep_binary(tdata, dep, proc->label_buffer,
                                               (char*)buf + 4, buflen - 4);
           }
@@ -749,7 +843,7 @@ static inline int parse_handshake(proc_instance_t * proc,
           return 0;
      }
 
-     if (buflen > 4) { 
+     if ((buflen > 4) && (proc->want & TLS_WANT_BUF)) { 
           switch(htype) {
           case HS_HELLOREQUEST:
           case HS_CERTREQUEST:
@@ -871,15 +965,19 @@ static int decode_tls(proc_instance_t * proc,
      case TLS_CHANGECIPHER:  
           //wsdata_add_label(tdata, proc->label_changecipher);
           dprint("change cipher %d %u", nextlen, rlen);
-          tuple_member_create_dep_binary(subtuple, dep, proc->label_buffer,
-                                         (char*)next, nextlen);
+          if (proc->want & TLS_WANT_BUF) {
+               tuple_member_create_dep_binary(subtuple, dep, proc->label_buffer,
+                                              (char*)next, nextlen);
+          }
 
           break;
      case TLS_ALERT:
           //wsdata_add_label(tdata, proc->label_alert);
           dprint("change alert %d %u", nextlen, rlen);
-          tuple_member_create_dep_binary(subtuple, dep, proc->label_buffer,
-                                         (char*)next, nextlen);
+          if (proc->want & TLS_WANT_BUF) {
+               tuple_member_create_dep_binary(subtuple, dep, proc->label_buffer,
+                                              (char*)next, nextlen);
+          }
 
           break;
      case TLS_HANDSHAKE:
@@ -888,8 +986,10 @@ static int decode_tls(proc_instance_t * proc,
           break;
      case TLS_APPDATA:
           //wsdata_add_label(tdata, proc->label_appdata);
-          tuple_member_create_dep_binary(subtuple, dep, proc->label_appdatabuf,
-                                         (char*)next, nextlen);
+          if (proc->want & TLS_WANT_APPDATA) {
+               tuple_member_create_dep_binary(subtuple, dep, proc->label_appdatabuf,
+                                              (char*)next, nextlen);
+          }
           dprint("change appdata %d %u", nextlen, rlen);
           break;
      }
@@ -914,6 +1014,10 @@ static int proc_process_label(void * vinstance, wsdata_t* input_data,
                         ws_doutput_t * dout, int type_index) {
      proc_instance_t * proc = (proc_instance_t*)vinstance;
 
+     if (!proc->want) {
+          proc->want = tls_parts_wanted(proc);
+     }
+
      int id;
      wsdata_t * member;
      wslabel_t * label;
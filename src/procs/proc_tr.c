@@ -30,11 +30,12 @@ SOFTWARE.
 #include <unistd.h>
 #include "procloader_buffer.h"
 #include "sysutil.h"
+#include "wsstrsimd.h"
 
 int is_procbuffer = 1;
 int procbuffer_pass_not_found = 1;
 
-char proc_version[] = "1.5";
+char proc_version[] = "1.6";
 char proc_name[] = PROC_NAME;
 char proc_purpose[] = "translate characters into other characters - like unix tr command";
 char *proc_tags[] = { "decoder", NULL };
@@ -210,17 +211,14 @@ int procbuffer_decode(void * vproc, wsdata_t * tdata,
      if (!bin) {
           return 1; // tuple is full
      }
-     int blen = 0;
-     int i;
-     for (i = 0; i < buflen; i++) {
-          if ( proc->upper2lower ) {
-               bin->buf[blen] = tolower(buf[i]);
-               blen++;
-          } else {
-               bin->buf[blen] = proc->translate[buf[i]];
-               if ( !(proc->tr_is_remove && bin->buf[blen] == '\0') )
-                    blen++;
-          }
+     int blen = buflen;
+     if ( proc->upper2lower ) {
+          wsstr_tolower(buf, (uint8_t *)bin->buf, buflen);
+     } else if ( proc->tr_is_remove ) {
+          blen = wsstr_translate_remove(buf, (uint8_t *)bin->buf, buflen,
+                                        proc->translate);
+     } else {
+          wsstr_translate(buf, (uint8_t *)bin->buf, buflen, proc->translate);
      }
      bin->len = blen;
 
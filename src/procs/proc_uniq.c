@@ -134,6 +134,20 @@ static int tag_labeled_tuple(void *, wsdata_t*, ws_doutput_t*, int);
 static int set_labeled_tuple(void *, wsdata_t*, ws_doutput_t*, int);
 static int remove_labeled_tuple(void *, wsdata_t*, ws_doutput_t*, int);
 static int proc_flush(void *, wsdata_t*, ws_doutput_t*, int);
+static int process_labeled_tuple_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+static int query_labeled_tuple_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+static int invquery_labeled_tuple_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+static int dupes_labeled_tuple_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+static int set_labeled_tuple_batch(void *, wsdata_t**, int, ws_doutput_t*, int);
+
+proc_batch_t proc_batch[] = {
+     {process_labeled_tuple, process_labeled_tuple_batch},
+     {query_labeled_tuple, query_labeled_tuple_batch},
+     {invquery_labeled_tuple, invquery_labeled_tuple_batch},
+     {dupes_labeled_tuple, dupes_labeled_tuple_batch},
+     {set_labeled_tuple, set_labeled_tuple_batch},
+     {NULL, NULL}
+};
 
 typedef struct _hash_members_t {
      wsdata_t * member[WSDT_TUPLE_MAX];
@@ -272,8 +286,8 @@ int proc_init(wskid_t * kid, int argc, char ** argv, void ** vinstance, ws_sourc
           int i;
           for (i = 0; i < proc->label_cnt; i++) {
                uint64_t ref = i + 0x55336677;
-               proc->position_hash_additions[i] = evahash64((uint8_t*)&ref, sizeof(uint64_t),
-                                                            proc->hashkey);
+               proc->position_hash_additions[i] = ws_table_hash64(&ref, sizeof(uint64_t),
+                                                                  proc->hashkey);
           }
      }
      if (proc->tstr && proc->label_tag) {
@@ -477,7 +491,7 @@ static uint64_t local_hash_tuple(proc_instance_t * proc, wsdata_t * tdata) {
                hash += local_hash_tuple(proc, member);
           }
           else {
-               hash += evahash64_data(member, proc->hashkey);
+               hash += ws_table_hash64_data(member, proc->hashkey);
           }
      }
 
@@ -498,7 +512,7 @@ static int proc_nest_hash_element(void * vinstance, void * vhash,
           whash = local_hash_tuple(proc, attr);
      }
      else {
-          whash = evahash64_data(attr, proc->hashkey);
+          whash = ws_table_hash64_data(attr, proc->hashkey);
      }
 
      if (proc->ordered_hash) {
@@ -676,6 +690,108 @@ static int tag_labeled_tuple(void * vinstance, wsdata_t* input_data,
      return 0;
 }
 
+//batch forms of the tuple ports: hash the whole batch, then let the table
+// pull in all of the buckets at once before resolving them in order
+#define UNIQ_BATCH 32
+
+#define UNIQ_BATCH_UNIQUE   0
+#define UNIQ_BATCH_QUERY    1
+#define UNIQ_BATCH_INVQUERY 2
+#define UNIQ_BATCH_DUPES    3
+#define UNIQ_BATCH_SET      4
+
+static int uniq_batch(proc_instance_t * proc, wsdata_t ** input_data, int len,
+                      ws_doutput_t * dout, int type_index, int mode) {
+     wsdata_t * tuples[UNIQ_BATCH];
+     uint64_t hash[UNIQ_BATCH];
+     void * keys[UNIQ_BATCH];
+     int keylens[UNIQ_BATCH];
+     int found[UNIQ_BATCH];
+     int i, j, n, pass;
+     int out = 0;
+
+     proc->meta_process_cnt += len;
+
+     for (i = 0; i < len; ) {
+          n = 0;
+          for (; (i < len) && (n < UNIQ_BATCH); i++) {
+               hash[n] = 0;
+               if (get_hashdata(proc, input_data[i], &hash[n])) {
+                    tuples[n] = input_data[i];
+                    keys[n] = &hash[n];
+                    keylens[n] = sizeof(uint64_t);
+                    n++;
+               }
+          }
+
+          switch (mode) {
+          case UNIQ_BATCH_QUERY:
+          case UNIQ_BATCH_INVQUERY:
+               stringhash9a_check_batch(proc->uniq_table, keys, keylens, n, found);
+               break;
+          default:
+               stringhash9a_set_batch(proc->uniq_table, keys, keylens, n, found);
+          }
+
+          for (j = 0; j < n; j++) {
+               switch (mode) {
+               case UNIQ_BATCH_UNIQUE:
+                    pass = !found[j] || check_heartbeat(proc, tuples[j]);
+                    break;
+               case UNIQ_BATCH_QUERY:
+                    pass = !found[j];
+                    break;
+               case UNIQ_BATCH_INVQUERY:
+                    proc->iquery_cnt++;
+                    pass = found[j];
+                    break;
+               case UNIQ_BATCH_DUPES:
+                    pass = found[j];
+                    break;
+               default:
+                    proc->set_cnt++;
+                    pass = 0;
+               }
+               if (pass) {
+                    ws_set_outdata(tuples[j], proc->outtype_meta[type_index], dout);
+                    proc->outcnt++;
+                    out++;
+               }
+          }
+     }
+     return out;
+}
+
+static int process_labeled_tuple_batch(void * vinstance, wsdata_t** input_data,
+                                       int len, ws_doutput_t * dout, int type_index) {
+     return uniq_batch((proc_instance_t*)vinstance, input_data, len, dout,
+                       type_index, UNIQ_BATCH_UNIQUE);
+}
+
+static int query_labeled_tuple_batch(void * vinstance, wsdata_t** input_data,
+                                     int len, ws_doutput_t * dout, int type_index) {
+     return uniq_batch((proc_instance_t*)vinstance, input_data, len, dout,
+                       type_index, UNIQ_BATCH_QUERY);
+}
+
+static int invquery_labeled_tuple_batch(void * vinstance, wsdata_t** input_data,
+                                        int len, ws_doutput_t * dout, int type_index) {
+     return uniq_batch((proc_instance_t*)vinstance, input_data, len, dout,
+                       type_index, UNIQ_BATCH_INVQUERY);
+}
+
+static int dupes_labeled_tuple_batch(void * vinstance, wsdata_t** input_data,
+                                     int len, ws_doutput_t * dout, int type_index) {
+     return uniq_batch((proc_instance_t*)vinstance, input_data, len, dout,
+                       type_index, UNIQ_BATCH_DUPES);
+}
+
+static int set_labeled_tuple_batch(void * vinstance, wsdata_t** input_data,
+                                   int len, ws_doutput_t * dout, int type_index) {
+     return uniq_batch((proc_instance_t*)vinstance, input_data, len, dout,
+                       type_index, UNIQ_BATCH_SET);
+}
+
 static inline void proc_dump_existence_table(proc_instance_t * proc) {
      if (proc->dump_file) {
           tool_print("Writing uniq table to %s", proc->dump_file);
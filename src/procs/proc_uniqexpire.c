@@ -303,7 +303,7 @@ static int proc_process_meta(void * vinstance, wsdata_t* input_data,
      if (!check_hash(proc,
                      (uint8_t*)hashloc->offset,
                      hashloc->len,
-                     time(NULL))) {
+                     sysutil_time())) {
           return 0;
      }
 
@@ -329,6 +329,7 @@ static int process_labeled_tuple(void * vinstance, wsdata_t* input_data,
      for (i = 0; i < tuple->len; i++) {
           if (tuple->member[i]->dtype == dtype_ts) {
                ts = tuple->member[i]->data;
+               sysutil_clock_observe(ts->sec, ts->usec);
                break;
           }
      }
@@ -350,7 +351,7 @@ static int process_labeled_tuple(void * vinstance, wsdata_t* input_data,
           if (!hashtag || !check_hash(proc, 
                                       (uint8_t*)hashtag,
                                       sizeof(wsdt_uint64_t),
-                                      ts ? ts->sec : time(NULL))) {
+                                      ts ? ts->sec : sysutil_time())) {
                // we got a duplicate ... no output
                return 0;
           }
@@ -360,7 +361,7 @@ static int process_labeled_tuple(void * vinstance, wsdata_t* input_data,
           if (!hashloc || !check_hash(proc,
                                       (uint8_t*)hashloc->offset,
                                       hashloc->len,
-                                      ts ? ts->sec : time(NULL))) {
+                                      ts ? ts->sec : sysutil_time())) {
                return 0;
           }
      }
@@ -414,7 +415,7 @@ static int removefrom_labeled_tuple(void * vinstance, wsdata_t* input_data,
      if (tag_member->dtype == dtype_uint64) {
           hashtag = (wsdt_uint64_t*)tag_member->data;
 
-          if (!hashtag) {
+          if (hashtag) {
                remove_hash(proc, 
                            (uint8_t*)hashtag,
                            sizeof(wsdt_uint64_t));
@@ -422,7 +423,7 @@ static int removefrom_labeled_tuple(void * vinstance, wsdata_t* input_data,
      }
      else {
           ws_hashloc_t* hashloc = tag_member->dtype->hash_func(tag_member);
-          if (!hashloc) {
+          if (hashloc) {
                remove_hash(proc,
                            (uint8_t*)hashloc->offset,
                            hashloc->len);
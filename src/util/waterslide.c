@@ -27,6 +27,8 @@ SOFTWARE.
 #include "mimo.h"
 #include "graphBuilder.h"
 #include "setup_exit.h"
+#include "wsmem.h"
+#include "sysutil.h"
 
 // Globals
 mimo_t * mimo;
@@ -41,9 +43,16 @@ void print_cmd_help(FILE * fp) {
      status_print("  [-l <cnt>] loop graph n times");
      status_print("  [-L <file>] file capturing stderr output");
      status_print("  [-X] turn off flushing of kids");
+     status_print("  [-d] call kids on the same thread directly (depth-first) instead of queueing");
      status_print("  [-s <seed>] set random seed");
      status_print("  [-G <file>] save graphviz graph");
      status_print("  [-Z <file>] save graphviz graph with post-processing data.");
+     status_print("  [-O <file>] measure kid costs and save a thread placement graph");
+     status_print("  [-N <threads>] number of threads to place kids on (with -O)");
+     status_print("  [-I <file>] place from a saved -O profile without running (with -O)");
+     status_print("  [-M <size>[K|M|G]] memory budget; sources are held back when it is reached");
+     status_print("  [-H thp|2M|1G] back hash tables and data pools with huge pages");
+     status_print("  [-c tsc|replay] clock: calibrated cycle counter, or event time for replays");
      status_print("  [-C <path>] set config path");
      status_print("  [-D <path>] set datatype path");
      status_print("  [-P <path>] set procs path");
@@ -74,12 +83,18 @@ static int read_cmd_options(int argc, char ** argv, mimo_t * mimo,
      char * laststr = NULL;
      FILE * gfp;
      int rtn = 1;
+     FILE * plan_fp = NULL;
+     uint32_t plan_threads = 0;
 
-     while ((op = getopt(argc, argv, "Vvrt:C:D:A:P:p:G:Z:l:L:F:s:Xh?")) != EOF) {
+     while ((op = getopt(argc, argv, "dVvrt:C:D:A:P:p:G:Z:l:L:F:s:XO:N:I:M:H:c:h?")) != EOF) {
           switch (op) {
           case 'X':
                mimo_set_noexitflush(mimo);
                break;
+          case 'd':
+               mimo_set_direct_dispatch(mimo);
+               status_print("direct dispatch mode is set");
+               break;
           case 's':
                mimo_set_srand(mimo, atoi(optarg));
                break;
@@ -139,6 +154,34 @@ static int read_cmd_options(int argc, char ** argv, mimo_t * mimo,
                loop_limit = atoi(optarg);
                status_print("loop limit %u", loop_limit);
                break;
+          case 'O':
+               plan_fp = fopen(optarg, "w");
+               if (!plan_fp) {
+                    error_print("unable to open placement file %s", optarg);
+                    return 0;
+               }
+               break;
+          case 'N':
+               plan_threads = atoi(optarg);
+               break;
+          case 'I':
+               mimo_set_placement_profile(mimo, optarg);
+               break;
+          case 'M':
+               if (!wsmem_set_budget(optarg)) {
+                    return 0;
+               }
+               status_print("memory budget %s", optarg);
+               break;
+          case 'H':
+               setenv(ENV_WS_HUGEPAGES, optarg, 1);
+               break;
+          case 'c':
+               if (!sysutil_clock_set_mode(optarg)) {
+                    return 0;
+               }
+               status_print("clock mode %s", optarg);
+               break;
           case 'L':
                if (!(logfp = fopen(optarg, "w+"))) {
                     error_print("failed to open file '%s'", optarg);
@@ -158,6 +201,11 @@ static int read_cmd_options(int argc, char ** argv, mimo_t * mimo,
           }
      }
 
+     if (plan_fp) {
+          status_print("saving thread placement plan");
+          mimo_output_placement(mimo, plan_fp, plan_threads);
+     }
+
      while (optind < argc) {
           laststr = argv[optind];
           optind++;
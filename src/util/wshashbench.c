@@ -0,0 +1,166 @@
+/*
+No copyright is claimed in the United States under Title 17, U.S. Code.
+All Other Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+/* microbenchmark of the hash functions used for keys and tables */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "evahash64.h"
+#include "wshash64.h"
+
+#define BENCH_MAXLEN 65536
+#define BENCH_BUCKET_BITS 16
+
+typedef uint64_t (*bench_hash_t)(const uint8_t *, uint32_t, uint32_t);
+
+static uint64_t bench_evahash64(const uint8_t * k, uint32_t len, uint32_t seed) {
+     return evahash64((uint8_t *)k, len, seed);
+}
+
+static uint64_t bench_wshash64(const uint8_t * k, uint32_t len, uint32_t seed) {
+     return wshash64(k, len, seed);
+}
+
+static const struct {
+     const char * name;
+     bench_hash_t func;
+} hashes[] = {
+     {"evahash64", bench_evahash64},
+     {"wshash64", bench_wshash64},
+     {NULL, NULL}
+};
+
+static double now_sec(void) {
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+//fraction of a 2^16 bucket table left empty by sequential keys, compared
+// with the 1/e expected from a uniform hash
+static double empty_buckets(bench_hash_t func, uint8_t * key, uint32_t len) {
+     uint32_t nb = 1U << BENCH_BUCKET_BITS;
+     uint8_t * seen = (uint8_t *)calloc(nb, 1);
+     uint32_t i, empty = 0;
+     uint32_t n = len < sizeof(uint32_t) ? len : sizeof(uint32_t);
+     if (!seen) {
+          return 0;
+     }
+     for (i = 0; i < nb; i++) {
+          memcpy(key, &i, n);
+          seen[func(key, len, 0x5EED5EED) >> (64 - BENCH_BUCKET_BITS)] = 1;
+     }
+     for (i = 0; i < nb; i++) {
+          empty += !seen[i];
+     }
+     free(seen);
+     return (double)empty / nb;
+}
+
+static void usage(const char * prog) {
+     fprintf(stderr, "usage: %s [-n iterations] [key lengths ...]\n", prog);
+     fprintf(stderr, "  times each hash over keys of each length "
+             "(default 4 8 13 16 32 64 256 1500)\n");
+}
+
+int main(int argc, char ** argv) {
+     uint64_t iterations = 10000000;
+     uint32_t deflens[] = {4, 8, 13, 16, 32, 64, 256, 1500};
+     uint32_t * lens = deflens;
+     int nlens = sizeof(deflens) / sizeof(uint32_t);
+     int op, i, h;
+
+     while ((op = getopt(argc, argv, "n:h")) != EOF) {
+          switch (op) {
+          case 'n':
+               iterations = strtoull(optarg, NULL, 10);
+               break;
+          default:
+               usage(argv[0]);
+               return 1;
+          }
+     }
+     if (optind < argc) {
+          nlens = argc - optind;
+          lens = (uint32_t *)calloc(nlens, sizeof(uint32_t));
+          if (!lens) {
+               return 1;
+          }
+          for (i = 0; i < nlens; i++) {
+               lens[i] = strtoul(argv[optind + i], NULL, 10);
+               if (!lens[i] || (lens[i] > BENCH_MAXLEN)) {
+                    fprintf(stderr, "key length must be 1..%d\n", BENCH_MAXLEN);
+                    return 1;
+               }
+          }
+     }
+
+     uint8_t * key = (uint8_t *)malloc(BENCH_MAXLEN);
+     if (!key) {
+          return 1;
+     }
+     for (i = 0; i < BENCH_MAXLEN; i++) {
+          key[i] = (uint8_t)(i * 131 + 7);
+     }
+
+     printf("table hash: %s\n", WS_TABLE_HASH_NAME);
+     printf("%-10s %6s %10s %10s %8s\n", "hash", "len", "ns/hash", "MB/s",
+            "empty");
+     uint64_t sink = 0;
+     for (i = 0; i < nlens; i++) {
+          uint32_t len = lens[i];
+          //fewer rounds for long keys so every length takes similar time
+          uint64_t rounds = iterations / (1 + len / 64);
+          if (!rounds) {
+               rounds = 1;
+          }
+          for (h = 0; hashes[h].name; h++) {
+               uint64_t r;
+               uint64_t prev = 0;
+               double start = now_sec();
+               for (r = 0; r < rounds; r++) {
+                    //feed each result into the next key so the calls
+                    // cannot be hoisted or overlapped
+                    memcpy(key, &prev, len < sizeof(prev) ? len : sizeof(prev));
+                    prev = hashes[h].func(key, len, 0x5EED5EED);
+               }
+               double elapsed = now_sec() - start;
+               sink ^= prev;
+               printf("%-10s %6u %10.2f %10.1f %7.1f%%\n", hashes[h].name, len,
+                      elapsed * 1e9 / rounds,
+                      (double)len * rounds / elapsed / 1e6,
+                      100.0 * empty_buckets(hashes[h].func, key, len));
+          }
+     }
+     printf("(expect about 36.8%% empty for a uniform hash; checksum %016llx)\n",
+            (unsigned long long)sink);
+
+     free(key);
+     if (lens != deflens) {
+          free(lens);
+     }
+     return 0;
+}